@@ -2,7 +2,7 @@
 #define CONFIG_H
 
 // ============================================
-// PINES DE SENSORES DE NIVEL (7 boyas NA)
+// PINES DE SENSORES DE NIVEL (7 boyas NA por defecto)
 // ============================================
 #define SENSOR_1_PIN 34 // Nivel 1 (más bajo)
 #define SENSOR_2_PIN 35 // Nivel 2
@@ -12,7 +12,18 @@
 #define SENSOR_6_PIN 26 // Nivel 6
 #define SENSOR_7_PIN 27 // Nivel 7 (más alto - activa bomba)
 
+// Número de boyas y pines en orden de nivel. Los entornos de platformio.ini
+// para tanques más altos los redefinen con -DNUM_SENSORS / -DSENSOR_PINS;
+// tank_geometry.h valida la combinación al compilar.
+#ifndef NUM_SENSORS
 #define NUM_SENSORS 7
+#endif
+
+#ifndef SENSOR_PINS
+#define SENSOR_PINS                                                            \
+  SENSOR_1_PIN, SENSOR_2_PIN, SENSOR_3_PIN, SENSOR_4_PIN, SENSOR_5_PIN,        \
+      SENSOR_6_PIN, SENSOR_7_PIN
+#endif
 
 // ============================================
 // PINES DE CONTROL
@@ -22,6 +33,35 @@
 #define LED_ERROR_PIN 14   // LED indicador de error
 #define RESET_BUTTON_PIN 0 // Botón reset (GPIO 0 = BOOT en ESP32)
 
+// ============================================
+// MULTI-TANQUE (expansores I2C)
+// ============================================
+// Con MULTI_TANK_ENABLED cada tanque usa un expansor I2C propio en
+// EXPANDER_BASE_ADDR + n: boyas en los bits 0..NUM_SENSORS-1 (contacto a GND,
+// pull-up) y relé de la bomba en el bit más alto. Los GPIO SENSOR_x_PIN y
+// PUMP_RELAY_PIN no se usan en este modo. Se pueden redefinir con -D
+// (tools/expander_sim lo hace).
+#ifndef MULTI_TANK_ENABLED
+#define MULTI_TANK_ENABLED false
+#endif
+#ifndef NUM_TANKS
+#define NUM_TANKS 4 // Máximo 8 (direcciones 0x20-0x27)
+#endif
+
+#define EXPANDER_MCP23017 1 // 16 bits: hasta 15 boyas + relé (GPB7)
+#define EXPANDER_PCF8574 2  // 8 bits: hasta 7 boyas + relé (P7)
+#ifndef EXPANDER_TYPE
+#define EXPANDER_TYPE EXPANDER_MCP23017
+#endif
+#define EXPANDER_BASE_ADDR 0x20
+
+#define I2C_SDA_PIN 21
+#define I2C_SCL_PIN 22
+#define I2C_FREQUENCY 400000 // 400 kHz (fast mode)
+
+// Presupuesto de tiempo de un ciclo de control multi-tanque (µs)
+#define MULTI_TANK_CYCLE_BUDGET_US 10000
+
 // ============================================
 // PINES DISPLAY TFT ILI9341 (SPI)
 // Configurados en platformio.ini build_flags
@@ -31,20 +71,98 @@
 // TFT_DC    = 2
 // TFT_MOSI  = 23
 // TFT_SCLK  = 18
+#define TFT_RESERVED_PINS 15, 4, 2, 23, 18 // Los de arriba, para validar
 
 // ============================================
 // CONFIGURACIÓN DE TIEMPOS
 // ============================================
 #define SENSOR_READ_INTERVAL_MS 100    // Lectura de sensores cada 100ms
 #define DISPLAY_UPDATE_INTERVAL_MS 500 // Actualizar display cada 500ms
-#define DEBOUNCE_TIME_MS 50            // Debounce para sensores
-#define MQTT_PUBLISH_INTERVAL_MS 5000  // Publicar MQTT cada 5 segundos
+
+// Envío al TFT por DMA en segundo plano: display_update() compone y vuelve;
+// dos buffers se alternan entre copia y transferencia
+#define DISPLAY_USE_DMA true
+#define DISPLAY_DMA_CHUNK_PIXELS 2048 // Píxeles por buffer (2 buffers)
+#define DISPLAY_FLUSH_POLL_MS 1       // Revisión del DMA con un frame en curso
+#define DISPLAY_ANIM_FPS 12           // Animaciones (ondas, bomba) a tasa fija
+
+// Historial de nivel/bomba y pantalla de tendencia (pulsación corta del
+// botón). Memoria fija: HISTORY_SAMPLES * 6 bits (7 con NUM_SENSORS >= 16).
+#define HISTORY_SAMPLE_INTERVAL_MS 10000 // Una muestra cada 10 s
+#define HISTORY_SAMPLES 8640             // 24 h (6480 bytes; 7560 con 16 boyas)
+#define TREND_ROW_SAMPLES 32             // Muestras por fila (270 filas = 24 h)
+
+// Gobernador de refresco: rápido con llenado, bomba o error; lento en
+// reposo. Sin actividad atenúa y apaga el backlight (PWM).
+#define DISPLAY_IDLE_INTERVAL_MS 5000 // Refresco en STATE_IDLE
+#define DISPLAY_IDLE_ANIM_FPS 2       // Animaciones en reposo
+#define BACKLIGHT_PIN 19              // LED del módulo TFT (antes a 3.3V)
+#define BACKLIGHT_PWM_CHANNEL 0
+#define BACKLIGHT_PWM_FREQ 5000
+#define BACKLIGHT_FULL 255            // Duty de 8 bits
+#define BACKLIGHT_DIM 40
+#define BACKLIGHT_DIM_AFTER_MS 60000  // Sin actividad: atenuar...
+#define BACKLIGHT_OFF_AFTER_MS 300000 // ...y apagar
+#define DISPLAY_POWER_REPORT_MS 3600000 // Informe de SPI/CPU por hora
+
+// Captura de boyas por interrupción GPIO (flancos con timestamp en µs).
+// En false se vuelve al sondeo cada SENSOR_READ_INTERVAL_MS.
+#define SENSOR_USE_INTERRUPTS true
+#define SENSOR_EDGE_BUFFER_SIZE 64 // Flancos en cola (potencia de 2)
+
+// Debounce por contadores verticales (debounce.h): muestreo cada
+// DEBOUNCE_SAMPLE_MS, umbrales en muestras (1-15). Retardo máximo de
+// aceptación de un flanco limpio = umbral * DEBOUNCE_SAMPLE_MS.
+#define DEBOUNCE_SAMPLE_MS 10
+#define DEBOUNCE_ASSERT_SAMPLES 5  // 0→1 (boya sube): 50 ms
+#define DEBOUNCE_RELEASE_SAMPLES 5 // 1→0 (boya baja): 50 ms
+
+// Tareas FreeRTOS: control (boyas, estados, bomba, alarma) fijo en un core
+// con prioridad alta; display y MQTT en el otro con prioridad baja. Se
+// comunican solo por la foto de snapshot.h. En false todo corre en loop()
+// y MQTT no compila: su conexión bloquea segundos.
+#define RTOS_TASKS_ENABLED true
+#define CONTROL_PERIOD_MS 5 // Ciclo de control (boyas por interrupción)
+#define CONTROL_TASK_CORE 1 // Mismo core que las ISR de boyas
+#define CONTROL_TASK_PRIORITY 5
+#define UI_TASK_CORE 0 // Junto a la pila WiFi
+#define DISPLAY_TASK_PRIORITY 1
+#define MQTT_TASK_PRIORITY 2
+#define JITTER_REPORT_INTERVAL_MS 60000 // Informe de jitter por serial
+#define MQTT_LOOP_INTERVAL_MS 10        // Mantenimiento de la conexión
+
+// Light sleep automático mientras el planificador espera el próximo plazo.
+// Requiere un core con CONFIG_PM_ENABLE y tickless idle.
+#define SCHED_LIGHT_SLEEP false
+
+// Perfilador por etapa (profiler.h): duración de cada etapa de control,
+// display y MQTT con el contador de ciclos del CPU y jitter entre pasadas,
+// en histogramas de memoria fija (~7 KB). Comando serial "profile" y JSON
+// en MQTT_DIAG_TOPIC. En false no queda nada en el binario.
+#define PROFILER_ENABLED true
+#define PROFILER_PUBLISH_MS 60000 // JSON a MQTT_DIAG_TOPIC
 
 // Tiempo mínimo de funcionamiento de bomba en emergencia (segundos)
 #define MIN_EMERGENCY_PUMP_TIME_S 60 // 1 minuto mínimo
 // Factor de seguridad para cálculo de tiempo de vaciado
 #define SAFETY_TIME_FACTOR 1.5
 
+// Estadísticas de bomba en NVS (pumpstats.h): se guardan al completar un
+// ciclo y al cambiar de día; otros cambios esperan a lo sumo esto
+#define PUMP_STATS_COMMIT_MS 600000 // 10 minutos
+#define PUMP_STATS_POLL_MS 1000     // Revisión de cambios y de medianoche
+
+// ============================================
+// REINICIO EN CALIENTE
+// ============================================
+// Solo un reinicio por software, pánico o watchdog retoma el estado de los
+// tanques (ver src/warmstart.h); brownout, encendido o pin EN arrancan en
+// frío. Más de WARM_MAX_QUICK_RESTARTS reinicios seguidos, cada uno antes
+// de WARM_STABLE_MS de marcha, son un bucle: arranque en frío, sin volver
+// a encender la bomba.
+#define WARM_MAX_QUICK_RESTARTS 3
+#define WARM_STABLE_MS 600000 // 10 min de marcha cortan la racha
+
 // ============================================
 // CONFIGURACIÓN MQTT (Opcional)
 // ============================================
@@ -56,15 +174,78 @@
 #define MQTT_PASSWORD "nodered040873"
 #define MQTT_CLIENT_ID "ac-water-monitor"
 
+// Gestor de conexión: tiempos máximos por intento y backoff exponencial
+// con jitter entre reintentos
+#define MQTT_WIFI_TIMEOUT_MS 10000   // Espera de IP por intento
+#define MQTT_CONNECT_TIMEOUT_MS 2000 // TCP y CONNACK, cada uno
+#define MQTT_BACKOFF_MIN_MS 1000
+#define MQTT_BACKOFF_MAX_MS 60000
+
+// Publicación por excepción: enseguida al cambiar nivel, bomba, error o
+// ciclos (con rate limit por tanque) y un latido con el estado completo
+// si no hubo eventos
+#define MQTT_EVENT_POLL_MS 50        // Revisión de cambios en la foto
+#define MQTT_MIN_PUBLISH_GAP_MS 1000 // Mínimo entre publicaciones de un tanque
+#define MQTT_HEARTBEAT_MS 60000      // Estado completo sin eventos
+#define MQTT_PUBLISH_DELTAS false    // Eventos con solo los campos cambiados
+
+// Codificación por topic: TELEMETRY_JSON o TELEMETRY_CBOR (telemetry.h)
+#define MQTT_STATUS_FORMAT TELEMETRY_JSON      // MQTT_TOPIC
+#define MQTT_TANK_STATUS_FORMAT TELEMETRY_JSON // MQTT_TANK_TOPIC_PREFIX<n>/status
+#define TELEMETRY_CHUNK 64 // Bytes por write() al cliente
+
+// Registro de eventos en flash (ciclos, errores, emergencias): se guardan
+// antes de publicarse y se reenvían en lotes QoS1 al volver el broker
+#define EVENTLOG_PARTITION "eventlog" // Partición de datos (partitions.csv)
+#define EVENT_BATCH_SIZE 8            // Eventos por mensaje
+#define EVENT_MAX_IN_FLIGHT 4         // Mensajes sin PUBACK
+#define EVENT_ACK_TIMEOUT_MS 10000    // Sin PUBACK: reenviar
+
+// Flujo de flancos (edges.h): nivel, bomba, error y alarma con su instante
+// en ms, en lotes binarios por cantidad o por antigüedad
+#define EDGE_QUEUE_SIZE 256        // Flancos en RAM (potencia de 2)
+#define EDGE_BATCH_EVENTS 64       // Flancos por lote
+#define EDGE_BATCH_MAX_AGE_MS 2000 // Espera máxima de un flanco
+
+// Historial de ciclos en flash (cyclelog.h): un registro comprimido por
+// ciclo o emergencia, consultable por rango desde serial o MQTT
+#define CYCLELOG_PARTITION "cyclelog" // Partición de datos (partitions.csv)
+#define CYCLELOG_QUEUE_SIZE 8         // Ciclos anotados sin escribir (pot. de 2)
+#define CYCLELOG_POLL_MS 200          // Escritura y consultas en curso
+#define CYCLELOG_PAGE_BYTES 1024      // Bytes de CSV por mensaje de respuesta
+
 // Topic MQTT (único)
 #define MQTT_TOPIC "ac-monitor/status"
 
+// Multi-tanque: un subárbol por tanque, ac-monitor/tank/<n>/status
+#define MQTT_TANK_TOPIC_PREFIX "ac-monitor/tank/"
+
+// Lotes del registro de eventos (eventlog.h), QoS1
+#define MQTT_EVENT_TOPIC "ac-monitor/events"
+
+// Lotes binarios del flujo de flancos (edges.h)
+#define MQTT_EDGE_TOPIC "ac-monitor/edges"
+
+// Consultas al historial de ciclos (cyclelog.h): el pedido llega en texto
+// ("cycles FROM TO [TANK]" o "rollup FROM TO BUCKET [TANK]") y la
+// respuesta sale en páginas CSV; una vacía marca el final
+#define MQTT_HISTORY_REQUEST_TOPIC "ac-monitor/history/get"
+#define MQTT_HISTORY_TOPIC "ac-monitor/history"
+
+// Percentiles por etapa del perfilador (profiler.h), JSON cada
+// PROFILER_PUBLISH_MS
+#define MQTT_DIAG_TOPIC "ac-monitor/diag"
+
 // ============================================
 // CONFIGURACIÓN WiFi
 // ============================================
 #define WIFI_SSID "Darío WiFi_IoT"
 #define WIFI_PASSWORD "P!nch0C@st3ll4n0"
 
+// Hora por SNTP (cambio de día de las estadísticas de bomba)
+#define NTP_SERVER "pool.ntp.org"
+#define TIME_ZONE "<-03>3" // POSIX TZ: UTC-3 sin horario de verano
+
 // ============================================
 // COLORES TFT (RGB565)
 // ============================================
@@ -18,7 +18,7 @@ void alarm_init() {
 void alarm_set(AlarmState *state, AlarmPattern pattern) {
   if (state->pattern != pattern) {
     state->pattern = pattern;
-    state->lastToggle = millis();
+    state->lastToggle = clock_ms();
 
     if (pattern == ALARM_OFF) {
       digitalWrite(BUZZER_PIN, LOW);
@@ -38,8 +38,8 @@ void alarm_update(AlarmState *state) {
     return;
   }
 
-  unsigned long currentTime = millis();
-  unsigned long toggleTime = 0;
+  uint64_t currentTime = clock_ms();
+  uint32_t toggleTime = 0;
 
   switch (state->pattern) {
   case ALARM_ERROR:
@@ -72,6 +72,6 @@ void alarm_update(AlarmState *state) {
 
 void alarm_beep(AlarmState *state) {
   state->pattern = ALARM_BEEP_ONCE;
-  state->lastToggle = millis();
+  state->lastToggle = clock_ms();
   digitalWrite(BUZZER_PIN, HIGH);
 }
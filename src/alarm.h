@@ -1,6 +1,7 @@
 #ifndef ALARM_H
 #define ALARM_H
 
+#include "clock.h"
 #include "config.h"
 #include <Arduino.h>
 
@@ -17,7 +18,7 @@ struct AlarmState {
   AlarmPattern pattern;
   bool ledOn;
   bool buzzerOn;
-  unsigned long lastToggle;
+  uint64_t lastToggle; // clock_ms()
 };
 
 // Inicializar
@@ -0,0 +1,24 @@
+#include "clock.h"
+#include <esp_timer.h>
+
+static ClockSource source = nullptr;
+static volatile uint64_t fakeNowUs = 0;
+
+// En IRAM: la ISR de las boyas toma su timestamp de aquí
+uint64_t IRAM_ATTR clock_us() {
+  if (source) {
+    return source();
+  }
+  return (uint64_t)esp_timer_get_time();
+}
+
+void clock_set_source(ClockSource newSource) { source = newSource; }
+
+static uint64_t fakeSource() { return fakeNowUs; }
+
+void clock_fake_start(uint64_t startUs) {
+  fakeNowUs = startUs;
+  source = fakeSource;
+}
+
+void clock_fake_advance(uint64_t deltaUs) { fakeNowUs = fakeNowUs + deltaUs; }
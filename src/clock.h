@@ -0,0 +1,30 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <Arduino.h>
+
+// ============================================
+// BASE DE TIEMPO MONOTÓNICA (64 bits)
+// ============================================
+// Todos los módulos leen el tiempo aquí en lugar de millis()/micros().
+// La fuente es esp_timer_get_time(): µs desde el arranque en 64 bits, así
+// que no hay desborde en la vida del equipo (millis() desborda a los ~49
+// días, micros() a los ~71 minutos).
+//
+// Para pruebas o simulación se puede reemplazar la fuente por un reloj
+// falso que avanza a mano: meses de uptime corren en segundos.
+
+typedef uint64_t (*ClockSource)();
+
+// Tiempo actual en µs / ms
+uint64_t clock_us();
+static inline uint64_t clock_ms() { return clock_us() / 1000; }
+
+// Reemplazar la fuente del reloj (nullptr = esp_timer_get_time)
+void clock_set_source(ClockSource source);
+
+// Reloj falso: fijar el instante inicial y avanzarlo manualmente
+void clock_fake_start(uint64_t startUs);
+void clock_fake_advance(uint64_t deltaUs);
+
+#endif // CLOCK_H
@@ -0,0 +1,714 @@
+#include "cyclelog.h"
+#include "clock.h"
+#include "tank.h"
+#include <atomic>
+#include <time.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_partition.h>
+#endif
+
+// ============================================
+// FORMATO EN FLASH
+// ============================================
+// Cada sector: cabecera de 16 bytes (magic, nº de secuencia, hora del
+// primer registro, CRC escrito último) y registros seguidos hasta el
+// primer 0xFF. Registro:
+//
+//   u8     tipo (bit 0) | tanque (bits 1-3) | hora estimada (bit 4)
+//   varint zigzag(delta de la hora - delta anterior)
+//   normal:     varint zigzag(llenado - anterior del tanque) [0,1 s]
+//               varint zigzag(vaciado - anterior del tanque) [0,1 s]
+//   emergencia: u8 causa | fase << 2, u8 nivel, varint vaciado [0,1 s]
+//   u8     CRC-8 del registro (nunca 0xFF: 0xFF es "sin escribir")
+//
+// El primer registro de un sector usa como anterior la hora de la
+// cabecera y duraciones en 0: el sector se decodifica sin los demás.
+
+#define CYCLE_MAGIC 0x31435943UL // "CYC1"
+#define HEADER_SIZE 16
+#define HEADER_CRC_LENGTH 12
+#define MAX_RECORD_BYTES 18
+#define MIN_EPOCH 1600000000UL // Antes de esto la hora no está puesta
+
+#define FLAG_KIND 0x01
+#define FLAG_TANK_SHIFT 1
+#define FLAG_ESTIMATED 0x10
+
+static_assert(NUM_TANKS <= CYCLELOG_MAX_TANKS, "tanque fuera de 3 bits");
+static_assert(NUM_SENSORS <= 0xFF, "nivel fuera de 1 byte");
+
+struct SectorHeader {
+  uint32_t magic;
+  uint32_t seq;
+  uint32_t firstTime;
+  uint16_t crc;
+  uint16_t reserved;
+};
+
+static_assert(sizeof(SectorHeader) == HEADER_SIZE, "cabecera de 16 bytes");
+
+static const FlashDevice *flash = nullptr;
+static uint32_t headSector = 0;
+static uint32_t headSeq = 0;    // 0 = historial vacío
+static uint32_t headOffset = 0; // Próximo byte libre del sector
+static bool headSealed = true;  // Escribir en un sector nuevo
+static uint32_t oldestSector = 0;
+static CycleCodec encoder;
+static uint32_t lastTime = 0;
+static uint64_t lastRecordedMs = 0; // clock_ms() del último anotado
+static CycleLogStats stats;
+
+// ============================================
+// CODIFICACIÓN
+// ============================================
+
+static uint8_t crc8(const uint8_t *data, size_t length) {
+  uint8_t crc = 0;
+  while (length-- > 0) {
+    crc ^= *data++;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+  }
+  return crc == 0xFF ? 0x00 : crc;
+}
+
+static uint16_t crc16(const void *data, size_t length) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  uint16_t crc = 0x1D0F;
+  while (length-- > 0) {
+    crc ^= (uint16_t)*bytes++ << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc == 0xFFFF ? 0x0000 : crc;
+}
+
+static uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static size_t putVarint(uint8_t *out, uint32_t value) {
+  size_t n = 0;
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    out[n++] = value > 0 ? byte | 0x80 : byte;
+  } while (value > 0);
+  return n;
+}
+
+// Lee un varint de a lo sumo 5 bytes sin pasar de end
+static bool getVarint(const uint8_t **in, const uint8_t *end, uint32_t *out) {
+  *out = 0;
+  for (int shift = 0; shift < 35 && *in < end; shift += 7) {
+    uint8_t byte = *(*in)++;
+    *out |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void resetCodec(CycleCodec *codec, uint32_t firstTime) {
+  memset(codec, 0, sizeof(CycleCodec));
+  codec->prevTime = firstTime;
+}
+
+static uint32_t toTenths(uint32_t ms) { return (ms + 50) / 100; }
+
+static size_t encode(CycleCodec *codec, const CycleRecord *record,
+                     uint8_t *out) {
+  size_t n = 0;
+  out[n++] = (record->kind & FLAG_KIND) |
+             ((record->tank & 0x07) << FLAG_TANK_SHIFT) |
+             (record->estimated ? FLAG_ESTIMATED : 0);
+
+  int32_t delta = (int32_t)(record->time - codec->prevTime);
+  n += putVarint(out + n, zigzag(delta - codec->prevDelta));
+  codec->prevTime = record->time;
+  codec->prevDelta = delta;
+
+  if (record->kind == CYCLE_NORMAL) {
+    uint32_t fill = toTenths(record->fillMs);
+    uint32_t drain = toTenths(record->drainMs);
+    n += putVarint(out + n,
+                   zigzag((int32_t)(fill - codec->prevFill[record->tank])));
+    n += putVarint(out + n,
+                   zigzag((int32_t)(drain - codec->prevDrain[record->tank])));
+    codec->prevFill[record->tank] = fill;
+    codec->prevDrain[record->tank] = drain;
+  } else {
+    out[n++] = (record->cause & 0x03) | ((record->phase & 0x07) << 2);
+    out[n++] = record->level;
+    n += putVarint(out + n, toTenths(record->drainMs));
+  }
+
+  out[n] = crc8(out, n);
+  return n + 1;
+}
+
+enum DecodeResult { DECODE_OK, DECODE_END, DECODE_TORN };
+
+// Decodificar el registro que empieza en data (hasta end)
+static DecodeResult decode(CycleCodec *codec, const uint8_t *data,
+                           const uint8_t *end, CycleRecord *out,
+                           size_t *length) {
+  if (data >= end || data[0] == 0xFF) {
+    return DECODE_END;
+  }
+  if (data[0] & ~(FLAG_KIND | (0x07 << FLAG_TANK_SHIFT) | FLAG_ESTIMATED)) {
+    return DECODE_TORN;
+  }
+
+  const uint8_t *in = data + 1;
+  CycleCodec next = *codec;
+  memset(out, 0, sizeof(CycleRecord));
+  out->kind = (CycleKind)(data[0] & FLAG_KIND);
+  out->tank = (data[0] >> FLAG_TANK_SHIFT) & 0x07;
+  out->estimated = data[0] & FLAG_ESTIMATED;
+
+  uint32_t value;
+  if (!getVarint(&in, end, &value)) {
+    return DECODE_TORN;
+  }
+  next.prevDelta += unzigzag(value);
+  next.prevTime += next.prevDelta;
+  out->time = next.prevTime;
+
+  if (out->kind == CYCLE_NORMAL) {
+    uint32_t fill;
+    uint32_t drain;
+    if (!getVarint(&in, end, &fill) || !getVarint(&in, end, &drain)) {
+      return DECODE_TORN;
+    }
+    next.prevFill[out->tank] += unzigzag(fill);
+    next.prevDrain[out->tank] += unzigzag(drain);
+    out->fillMs = next.prevFill[out->tank] * 100;
+    out->drainMs = next.prevDrain[out->tank] * 100;
+  } else {
+    if (end - in < 2) {
+      return DECODE_TORN;
+    }
+    out->cause = (CycleCause)(in[0] & 0x03);
+    out->phase = (in[0] >> 2) & 0x07;
+    out->level = in[1];
+    in += 2;
+    if (!getVarint(&in, end, &value)) {
+      return DECODE_TORN;
+    }
+    out->drainMs = value * 100;
+  }
+
+  if (in >= end || *in != crc8(data, in - data)) {
+    return DECODE_TORN;
+  }
+  *codec = next;
+  *length = in - data + 1;
+  return DECODE_OK;
+}
+
+// ============================================
+// SECTORES
+// ============================================
+
+static uint32_t sectorAddress(uint32_t sector) {
+  return sector * flash->sectorSize;
+}
+
+static bool readHeader(uint32_t sector, SectorHeader *header) {
+  return flash->read(sectorAddress(sector), header, sizeof(SectorHeader)) &&
+         header->magic == CYCLE_MAGIC &&
+         header->crc == crc16(header, HEADER_CRC_LENGTH);
+}
+
+// Abrir el sector siguiente al más nuevo: se borra (perdiendo el más viejo
+// si el anillo está lleno) y se escribe la cabecera
+static bool startSector(uint32_t firstTime) {
+  uint32_t sector = headSeq == 0 ? 0 : (headSector + 1) % flash->sectorCount;
+
+  headSealed = true;
+  if (!flash->erase(sector)) {
+    return false;
+  }
+  stats.erases++;
+  if (headSeq != 0 && sector == oldestSector) {
+    // Anillo lleno: se perdió el sector más viejo
+    oldestSector = (oldestSector + 1) % flash->sectorCount;
+    SectorHeader oldest;
+    stats.oldest = readHeader(oldestSector, &oldest) ? oldest.firstTime : 0;
+    stats.sectors--;
+  }
+
+  SectorHeader header;
+  memset(&header, 0xFF, sizeof(header));
+  header.magic = CYCLE_MAGIC;
+  header.seq = headSeq + 1;
+  header.firstTime = firstTime;
+  header.crc = crc16(&header, HEADER_CRC_LENGTH);
+  // Datos primero y CRC al final: una cabecera cortada no es válida
+  if (!flash->write(sectorAddress(sector), &header, HEADER_CRC_LENGTH) ||
+      !flash->write(sectorAddress(sector) + HEADER_CRC_LENGTH, &header.crc,
+                    sizeof(header.crc))) {
+    return false;
+  }
+
+  if (headSeq == 0) {
+    oldestSector = sector;
+    stats.oldest = firstTime;
+  }
+  stats.sectors++;
+  headSector = sector;
+  headSeq = header.seq;
+  headOffset = HEADER_SIZE;
+  headSealed = false;
+  resetCodec(&encoder, firstTime);
+  return true;
+}
+
+bool cyclelog_mount(const FlashDevice *device) {
+  flash = device;
+  headSeq = 0;
+  headSealed = true;
+  lastTime = 0;
+  memset(&stats, 0, sizeof(stats));
+
+  // Sector más nuevo: el de secuencia más alta
+  SectorHeader header;
+  for (uint32_t sector = 0; sector < flash->sectorCount; sector++) {
+    if (readHeader(sector, &header) && header.seq > headSeq) {
+      headSeq = header.seq;
+      headSector = sector;
+    }
+  }
+  if (headSeq == 0) {
+    Serial.printf("[CYCLELOG] Empty, %lu sectors\n",
+                  (unsigned long)flash->sectorCount);
+    return true;
+  }
+
+  // Más viejo: hacia atrás mientras las secuencias sean consecutivas
+  oldestSector = headSector;
+  stats.sectors = 1;
+  uint32_t seq = headSeq;
+  for (uint32_t i = 1; i < flash->sectorCount; i++) {
+    uint32_t sector = (headSector + flash->sectorCount - i) % flash->sectorCount;
+    if (!readHeader(sector, &header) || header.seq != seq - 1) {
+      break;
+    }
+    oldestSector = sector;
+    seq = header.seq;
+    stats.sectors++;
+  }
+  readHeader(oldestSector, &header);
+  stats.oldest = header.firstTime;
+
+  // Final del sector más nuevo: decodificar hasta el primer hueco
+  readHeader(headSector, &header);
+  resetCodec(&encoder, header.firstTime);
+  uint8_t buffer[CYCLELOG_READ_BUFFER];
+  uint32_t offset = HEADER_SIZE;
+  DecodeResult result = DECODE_END;
+  for (;;) {
+    uint32_t length = min((uint32_t)sizeof(buffer),
+                          flash->sectorSize - offset);
+    if (length == 0 ||
+        !flash->read(sectorAddress(headSector) + offset, buffer, length)) {
+      break;
+    }
+    CycleRecord record;
+    size_t used;
+    result = decode(&encoder, buffer, buffer + length, &record, &used);
+    if (result != DECODE_OK) {
+      break;
+    }
+    offset += used;
+  }
+  headOffset = offset;
+  headSealed = result == DECODE_TORN;
+  lastTime = encoder.prevTime;
+  if (headSealed) {
+    stats.torn++;
+    Serial.println("[CYCLELOG] Torn record found, sealing sector");
+  }
+
+  Serial.printf("[CYCLELOG] %lu sectors in use, newest %lu, since %lu\n",
+                (unsigned long)stats.sectors, (unsigned long)lastTime,
+                (unsigned long)stats.oldest);
+  return true;
+}
+
+#ifdef ESP_PLATFORM
+
+static const esp_partition_t *partition = nullptr;
+
+static bool partitionRead(uint32_t address, void *data, size_t length) {
+  return esp_partition_read(partition, address, data, length) == ESP_OK;
+}
+
+static bool partitionWrite(uint32_t address, const void *data, size_t length) {
+  return esp_partition_write(partition, address, data, length) == ESP_OK;
+}
+
+static bool partitionErase(uint32_t sector) {
+  return esp_partition_erase_range(partition, sector * SPI_FLASH_SEC_SIZE,
+                                   SPI_FLASH_SEC_SIZE) == ESP_OK;
+}
+
+bool cyclelog_init() {
+  partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, CYCLELOG_PARTITION);
+  if (!partition) {
+    Serial.println("[CYCLELOG] Partition " CYCLELOG_PARTITION " not found");
+    return false;
+  }
+
+  static FlashDevice device;
+  device.sectorSize = SPI_FLASH_SEC_SIZE;
+  device.sectorCount = partition->size / SPI_FLASH_SEC_SIZE;
+  device.read = partitionRead;
+  device.write = partitionWrite;
+  device.erase = partitionErase;
+  return cyclelog_mount(&device);
+}
+
+#else
+
+bool cyclelog_init() {
+  Serial.println("[CYCLELOG] No flash partition on this platform");
+  return false;
+}
+
+#endif
+
+// ============================================
+// ESCRITURA
+// ============================================
+
+bool cyclelog_append(const CycleRecord *record) {
+  if (!flash) {
+    return false;
+  }
+
+  CycleRecord copy = *record;
+  copy.time = max(record->time, lastTime); // El tiempo no retrocede
+  copy.tank = min(record->tank, (uint8_t)(CYCLELOG_MAX_TANKS - 1));
+
+  if ((headSealed || headOffset + MAX_RECORD_BYTES > flash->sectorSize) &&
+      !startSector(copy.time)) {
+    stats.dropped++;
+    return false;
+  }
+
+  uint8_t data[MAX_RECORD_BYTES];
+  CycleCodec next = encoder;
+  size_t length = encode(&next, &copy, data);
+
+  // El CRC va después: un corte a mitad deja el registro inválido
+  uint32_t address = sectorAddress(headSector) + headOffset;
+  if (!flash->write(address, data, length - 1) ||
+      !flash->write(address + length - 1, data + length - 1, 1)) {
+    headSealed = true; // Lo que sigue va a un sector nuevo
+    stats.dropped++;
+    return false;
+  }
+
+  encoder = next;
+  headOffset += length;
+  lastTime = copy.time;
+  stats.appended++;
+  stats.bytes += length;
+  return true;
+}
+
+// Cola SPSC entre la tarea de control y la dueña del historial (como la
+// de flancos): un ciclo cada varios minutos, alcanza con pocos lugares
+struct QueuedCycle {
+  CycleRecord record;
+  uint64_t atMs; // clock_ms() al anotar
+};
+
+#define CYCLE_QUEUE_MASK (CYCLELOG_QUEUE_SIZE - 1)
+static_assert((CYCLELOG_QUEUE_SIZE & CYCLE_QUEUE_MASK) == 0,
+              "CYCLELOG_QUEUE_SIZE debe ser potencia de 2");
+
+static QueuedCycle queue[CYCLELOG_QUEUE_SIZE];
+static std::atomic<uint32_t> queueHead(0);
+static std::atomic<uint32_t> queueTail(0);
+static std::atomic<uint32_t> queueDrops(0);
+
+void cyclelog_record(const CycleRecord *record) {
+  uint32_t h = queueHead.load(std::memory_order_relaxed);
+  if (h - queueTail.load(std::memory_order_acquire) >= CYCLELOG_QUEUE_SIZE) {
+    queueDrops.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  queue[h & CYCLE_QUEUE_MASK].record = *record;
+  queue[h & CYCLE_QUEUE_MASK].atMs = clock_ms();
+  queueHead.store(h + 1, std::memory_order_release);
+}
+
+void cyclelog_poll() {
+  uint32_t t = queueTail.load(std::memory_order_relaxed);
+  uint32_t h = queueHead.load(std::memory_order_acquire);
+  time_t now = time(nullptr);
+  uint64_t nowMs = clock_ms();
+
+  for (; t != h; t++) {
+    QueuedCycle *queued = &queue[t & CYCLE_QUEUE_MASK];
+    CycleRecord record = queued->record;
+    if (now >= (time_t)MIN_EPOCH) {
+      record.time = (uint32_t)(now - (nowMs - queued->atMs) / 1000);
+      record.estimated = false;
+    } else {
+      // Sin hora: a continuación del último, según el uptime
+      uint32_t elapsed = lastRecordedMs != 0
+                             ? (uint32_t)((queued->atMs - lastRecordedMs) / 1000)
+                             : 0;
+      record.time = lastTime + elapsed;
+      record.estimated = true;
+    }
+    lastRecordedMs = queued->atMs;
+    cyclelog_append(&record);
+  }
+  queueTail.store(t, std::memory_order_release);
+}
+
+// ============================================
+// CONSULTAS
+// ============================================
+
+static void openSector(CycleQuery *query, uint32_t sector,
+                       const SectorHeader *header) {
+  query->sector = sector;
+  query->seq = header->seq;
+  query->offset = HEADER_SIZE;
+  query->bufferLength = 0;
+  resetCodec(&query->codec, header->firstTime);
+}
+
+void cyclelog_query_begin(CycleQuery *query, uint32_t from, uint32_t to,
+                          int tank, uint32_t bucketS) {
+  memset(query, 0, sizeof(CycleQuery));
+  query->from = from;
+  query->to = to == 0 ? UINT32_MAX : to;
+  query->tank = tank;
+  query->bucketS = bucketS;
+  if (!flash || headSeq == 0) {
+    query->done = true;
+    return;
+  }
+
+  // Búsqueda binaria del último sector que empieza antes de from: las
+  // cabeceras crecen en el orden del anillo
+  uint32_t count = stats.sectors;
+  uint32_t low = 0;
+  uint32_t high = count - 1;
+  while (low < high) {
+    uint32_t mid = (low + high + 1) / 2;
+    SectorHeader header;
+    uint32_t sector = (oldestSector + mid) % flash->sectorCount;
+    if (readHeader(sector, &header) && header.firstTime <= from) {
+      low = mid;
+    } else {
+      high = mid - 1;
+    }
+  }
+
+  SectorHeader header;
+  uint32_t sector = (oldestSector + low) % flash->sectorCount;
+  if (!readHeader(sector, &header)) {
+    query->done = true;
+    return;
+  }
+  openSector(query, sector, &header);
+}
+
+// Pasar al sector siguiente del anillo; false si no hay más
+static bool nextSector(CycleQuery *query) {
+  if (query->sector == headSector) {
+    return false;
+  }
+  uint32_t sector = (query->sector + 1) % flash->sectorCount;
+  SectorHeader header;
+  if (!readHeader(sector, &header) || header.seq != query->seq + 1) {
+    return false;
+  }
+  openSector(query, sector, &header);
+  return true;
+}
+
+// Siguiente registro del historial desde la posición de la consulta, sin
+// filtrar. Si el sector se reescribió entre llamadas, la consulta termina.
+static bool readNext(CycleQuery *query, CycleRecord *out) {
+  for (;;) {
+    uint32_t available = query->bufferLength -
+                         (query->offset - query->bufferStart);
+    if (query->bufferLength == 0 || query->offset < query->bufferStart ||
+        available < MAX_RECORD_BYTES) {
+      uint32_t length = min((uint32_t)CYCLELOG_READ_BUFFER,
+                            flash->sectorSize - query->offset);
+      SectorHeader header;
+      if (length == 0 || !readHeader(query->sector, &header) ||
+          header.seq != query->seq ||
+          !flash->read(sectorAddress(query->sector) + query->offset,
+                       query->buffer, length)) {
+        query->bufferLength = 0;
+        if (length > 0 && header.seq != query->seq) {
+          return false; // Sector pisado mientras se leía
+        }
+        if (!nextSector(query)) {
+          return false;
+        }
+        continue;
+      }
+      query->bufferStart = query->offset;
+      query->bufferLength = length;
+    }
+
+    const uint8_t *data = query->buffer + (query->offset - query->bufferStart);
+    const uint8_t *end = query->buffer + query->bufferLength;
+    size_t used;
+    if (decode(&query->codec, data, end, out, &used) == DECODE_OK) {
+      query->offset += used;
+      query->scanned++;
+      return true;
+    }
+    if (!nextSector(query)) {
+      return false;
+    }
+  }
+}
+
+bool cyclelog_query_next(CycleQuery *query, CycleRecord *out) {
+  while (!query->done) {
+    if (query->havePending) {
+      *out = query->pending;
+      query->havePending = false;
+    } else if (!readNext(query, out)) {
+      query->done = true;
+      break;
+    }
+    if (out->time > query->to) {
+      query->done = true;
+      break;
+    }
+    if (out->time >= query->from &&
+        (query->tank < 0 || out->tank == query->tank)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static const char *phaseName(uint8_t phase) {
+  switch (phase) {
+  case STATE_IDLE:
+    return "idle";
+  case STATE_FILLING:
+    return "filling";
+  case STATE_PUMPING:
+    return "pumping";
+  default:
+    return "unknown";
+  }
+}
+
+bool cyclelog_parse_query(const char *text, CycleQuery *query) {
+  unsigned long from;
+  unsigned long to;
+  unsigned long bucket;
+  int tank = -1;
+  if (sscanf(text, "cycles %lu %lu %d", &from, &to, &tank) >= 2) {
+    cyclelog_query_begin(query, from, to, tank, 0);
+    return true;
+  }
+  if (sscanf(text, "rollup %lu %lu %lu %d", &from, &to, &bucket, &tank) >=
+          3 &&
+      bucket > 0) {
+    cyclelog_query_begin(query, from, to, tank, bucket);
+    return true;
+  }
+  return false;
+}
+
+bool cyclelog_query_row(CycleQuery *query, char *row, size_t size) {
+  if (query->rows++ == 0) {
+    snprintf(row, size,
+             query->bucketS == 0
+                 ? "time,tank,kind,fill_ms,drain_ms,cause,phase,level,"
+                   "estimated"
+                 : "start,cycles,emergencies,fill_avg_ms,fill_max_ms,"
+                   "drain_avg_ms,drain_max_ms");
+    return true;
+  }
+
+  CycleRecord record;
+  if (query->bucketS == 0) {
+    if (!cyclelog_query_next(query, &record)) {
+      return false;
+    }
+    if (record.kind == CYCLE_NORMAL) {
+      snprintf(row, size, "%lu,%u,cycle,%lu,%lu,,,,%d",
+               (unsigned long)record.time, record.tank,
+               (unsigned long)record.fillMs, (unsigned long)record.drainMs,
+               record.estimated);
+    } else {
+      snprintf(row, size, "%lu,%u,emergency,,%lu,%s,%s,%u,%d",
+               (unsigned long)record.time, record.tank,
+               (unsigned long)record.drainMs,
+               record.cause == CAUSE_GAP ? "gap" : "direction",
+               phaseName(record.phase), record.level, record.estimated);
+    }
+    return true;
+  }
+
+  // Resumen: juntar los registros del intervalo; el primero del siguiente
+  // queda pendiente para la próxima fila
+  if (!cyclelog_query_next(query, &record)) {
+    return false;
+  }
+  uint32_t start = record.time - record.time % query->bucketS;
+  uint32_t cycles = 0;
+  uint32_t emergencies = 0;
+  uint64_t fillSum = 0;
+  uint64_t drainSum = 0;
+  uint32_t fillMax = 0;
+  uint32_t drainMax = 0;
+  do {
+    if (record.time - start >= query->bucketS) {
+      query->pending = record;
+      query->havePending = true;
+      break;
+    }
+    if (record.kind == CYCLE_NORMAL) {
+      cycles++;
+      fillSum += record.fillMs;
+      drainSum += record.drainMs;
+      fillMax = max(fillMax, record.fillMs);
+      drainMax = max(drainMax, record.drainMs);
+    } else {
+      emergencies++;
+    }
+  } while (cyclelog_query_next(query, &record));
+
+  snprintf(row, size, "%lu,%lu,%lu,%lu,%lu,%lu,%lu", (unsigned long)start,
+           (unsigned long)cycles, (unsigned long)emergencies,
+           (unsigned long)(cycles > 0 ? fillSum / cycles : 0),
+           (unsigned long)fillMax,
+           (unsigned long)(cycles > 0 ? drainSum / cycles : 0),
+           (unsigned long)drainMax);
+  return true;
+}
+
+void cyclelog_get_stats(CycleLogStats *out) {
+  memcpy(out, &stats, sizeof(stats));
+  out->dropped += queueDrops.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,134 @@
+#ifndef CYCLELOG_H
+#define CYCLELOG_H
+
+#include "config.h"
+#include "flash.h"
+#include <Arduino.h>
+
+// ============================================
+// HISTORIAL DE CICLOS EN FLASH
+// ============================================
+// Un registro por ciclo de bomba (llenado y vaciado) o por emergencia
+// (causa del error y duración), en la partición CYCLELOG_PARTITION. Se
+// escribe solo al final, en un anillo de sectores: con la partición llena
+// se borra el sector más viejo.
+//
+// Compresión: cada registro guarda el tiempo como delta de la delta
+// (ciclos a intervalos parecidos ocupan 1 byte) y llenado/vaciado como
+// diferencia con el ciclo anterior del mismo tanque, todo en varint con
+// zigzag. Resolución: 1 s en el tiempo, 0,1 s en las duraciones. Un ciclo
+// normal ocupa ~7 bytes. Cada sector se decodifica solo: la cabecera lleva
+// el tiempo de su primer registro, así una consulta por rango salta
+// directo al sector donde empieza.
+//
+// Cortes de energía: cada registro termina en un CRC que se escribe
+// último; uno roto cierra el sector y se sigue en el siguiente.
+//
+// Un solo dueño: la tarea de control anota con cyclelog_record() y la
+// tarea que llama a cyclelog_poll() escribe y atiende las consultas.
+
+#define CYCLELOG_MAX_TANKS 8     // 3 bits en el registro
+#define CYCLELOG_READ_BUFFER 128 // Lectura de la flash en las consultas
+
+enum CycleKind : uint8_t {
+  CYCLE_NORMAL,   // Ciclo completo: llenado + vaciado
+  CYCLE_EMERGENCY // Error de secuencia y bombeo de emergencia
+};
+
+// Causa del error (emergencias)
+enum CycleCause : uint8_t {
+  CAUSE_DIRECTION = 1, // Cambio de dirección inesperado
+  CAUSE_GAP            // Boyas no contiguas
+};
+
+struct CycleRecord {
+  uint32_t time;    // Hora UNIX (s) al terminar
+  bool estimated;   // Sin hora de SNTP: estimada con el uptime
+  uint8_t tank;
+  CycleKind kind;
+  CycleCause cause; // Emergencias
+  uint8_t phase;    // SystemState al detectar el error (emergencias)
+  uint8_t level;    // Nivel al detectar el error (emergencias)
+  uint32_t fillMs;  // Nivel 1 → bomba encendida (ciclos normales)
+  uint32_t drainMs; // Bomba encendida
+};
+
+// Estado de la compresión dentro de un sector: lo último visto de cada
+// serie (se reinicia en cada sector)
+struct CycleCodec {
+  uint32_t prevTime;
+  int32_t prevDelta;
+  uint32_t prevFill[CYCLELOG_MAX_TANKS];  // 0,1 s
+  uint32_t prevDrain[CYCLELOG_MAX_TANKS]; // 0,1 s
+};
+
+// Consulta en curso: registros sueltos o resúmenes por intervalo. Lee la
+// flash de a CYCLELOG_READ_BUFFER bytes; no carga nada más en RAM.
+struct CycleQuery {
+  uint32_t from;    // Hora UNIX, inclusive
+  uint32_t to;      // Hora UNIX, inclusive
+  int tank;         // -1 = todos
+  uint32_t bucketS; // 0 = registros sueltos
+  // Posición de lectura
+  uint32_t sector;
+  uint32_t seq;
+  uint32_t offset;
+  CycleCodec codec;
+  uint8_t buffer[CYCLELOG_READ_BUFFER];
+  uint32_t bufferStart;
+  uint32_t bufferLength;
+  uint32_t rows;    // Filas devueltas (la 0 es la cabecera)
+  bool done;
+  bool havePending; // Registro leído y sin usar (resúmenes)
+  CycleRecord pending;
+  uint32_t scanned; // Registros decodificados
+};
+
+struct CycleLogStats {
+  uint32_t appended; // Registros escritos desde el arranque
+  uint32_t bytes;    // Bytes escritos desde el arranque
+  uint32_t dropped;  // Registros perdidos (cola llena o flash)
+  uint32_t erases;   // Sectores borrados
+  uint32_t torn;     // Registros rotos encontrados al montar
+  uint32_t sectors;  // Sectores con datos
+  uint32_t oldest;   // Hora del primer registro guardado (0 = vacío)
+};
+
+// Montar sobre la partición CYCLELOG_PARTITION (solo en el ESP32)
+bool cyclelog_init();
+
+// Montar sobre un dispositivo: ubica el sector más nuevo y el final
+bool cyclelog_mount(const FlashDevice *flash);
+
+// Anotar el fin de un ciclo o de una emergencia (solo la tarea de
+// control; se escribe en cyclelog_poll()). time se completa al escribir.
+void cyclelog_record(const CycleRecord *record);
+
+// Escribir lo anotado (la tarea dueña del historial)
+void cyclelog_poll();
+
+// Agregar un registro ya con hora (el tiempo nunca retrocede: uno anterior
+// al último se guarda con la hora del último)
+bool cyclelog_append(const CycleRecord *record);
+
+// Preparar una consulta. Texto (serial o MQTT):
+//   cycles FROM TO [TANK]          registros sueltos
+//   rollup FROM TO BUCKET [TANK]   resumen cada BUCKET segundos
+// FROM y TO en hora UNIX; TO = 0 es "hasta ahora". Devuelve false si el
+// texto no es una consulta.
+bool cyclelog_parse_query(const char *text, CycleQuery *query);
+
+// Empezar una consulta armada a mano
+void cyclelog_query_begin(CycleQuery *query, uint32_t from, uint32_t to,
+                          int tank, uint32_t bucketS);
+
+// Siguiente registro de la consulta (registros sueltos)
+bool cyclelog_query_next(CycleQuery *query, CycleRecord *out);
+
+// Siguiente fila CSV de la consulta (registros o resúmenes, según
+// bucketS). La primera llamada devuelve la cabecera. false al terminar.
+bool cyclelog_query_row(CycleQuery *query, char *row, size_t size);
+
+void cyclelog_get_stats(CycleLogStats *out);
+
+#endif // CYCLELOG_H
@@ -0,0 +1,84 @@
+#include "debounce.h"
+
+static void fillPlanes(uint32_t *planes, uint8_t threshold) {
+  for (int k = 0; k < DEBOUNCE_COUNTER_BITS; k++) {
+    planes[k] = (threshold >> k) & 1 ? 0xFFFFFFFFUL : 0;
+  }
+}
+
+void debounce_init(DebounceState *db, uint8_t assertSamples,
+                   uint8_t releaseSamples, uint32_t initial) {
+  memset(db, 0, sizeof(DebounceState));
+  db->state = initial;
+  db->lastRaw = initial;
+
+  fillPlanes(db->assertPlanes, constrain(assertSamples, 1,
+                                         DEBOUNCE_MAX_THRESHOLD));
+  fillPlanes(db->releasePlanes, constrain(releaseSamples, 1,
+                                          DEBOUNCE_MAX_THRESHOLD));
+}
+
+uint32_t debounce_sample(DebounceState *db, uint32_t raw) {
+  uint32_t diff = raw ^ db->state; // Canales que quieren cambiar
+
+  uint32_t pending = 0;
+  for (int k = 0; k < DEBOUNCE_COUNTER_BITS; k++) {
+    pending |= db->count[k];
+  }
+
+  // +1 en los canales que difieren
+  uint32_t carry = diff;
+  for (int k = 0; k < DEBOUNCE_COUNTER_BITS; k++) {
+    uint32_t next = db->count[k] & carry;
+    db->count[k] ^= carry;
+    carry = next;
+  }
+
+  // -1 en los que coinciden y tienen cuenta pendiente
+  uint32_t borrow = ~diff & pending;
+  for (int k = 0; k < DEBOUNCE_COUNTER_BITS; k++) {
+    uint32_t next = ~db->count[k] & borrow;
+    db->count[k] ^= borrow;
+    borrow = next;
+  }
+
+  // Comparar contra el umbral según el sentido de cada canal
+  uint32_t reached = diff;
+  for (int k = 0; k < DEBOUNCE_COUNTER_BITS; k++) {
+    uint32_t threshold = (db->state & db->releasePlanes[k]) |
+                         (~db->state & db->assertPlanes[k]);
+    reached &= ~(db->count[k] ^ threshold);
+  }
+
+  db->state ^= reached;
+  for (int k = 0; k < DEBOUNCE_COUNTER_BITS; k++) {
+    db->count[k] &= ~reached;
+  }
+
+  // Rebote: la lectura volvió al valor aceptado con una cuenta en curso.
+  // Solo se recorren los canales que rebotaron (normalmente ninguno).
+  uint32_t glitches = (raw ^ db->lastRaw) & ~diff & pending;
+  while (glitches) {
+    int channel = __builtin_ctz(glitches);
+    if (db->bounces[channel] < 0xFFFF) {
+      db->bounces[channel]++;
+    }
+    glitches &= glitches - 1;
+  }
+  db->lastRaw = raw;
+
+  return reached;
+}
+
+uint32_t debounce_get_state(const DebounceState *db) { return db->state; }
+
+uint16_t debounce_get_bounces(const DebounceState *db, int channel) {
+  if (channel < 0 || channel >= DEBOUNCE_MAX_CHANNELS) {
+    return 0;
+  }
+  return db->bounces[channel];
+}
+
+void debounce_reset_bounces(DebounceState *db) {
+  memset(db->bounces, 0, sizeof(db->bounces));
+}
@@ -0,0 +1,53 @@
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <Arduino.h>
+
+// ============================================
+// DEBOUNCE PARALELO POR CONTADORES VERTICALES
+// ============================================
+// Filtra hasta 32 canales a la vez sobre una palabra empaquetada. Cada canal
+// tiene un contador de 4 bits guardado "en vertical": count[k] contiene el
+// bit k del contador de los 32 canales, así que una muestra cuesta un número
+// fijo de operaciones AND/XOR sin importar cuántos canales haya.
+//
+// Por muestra, un canal cuya lectura difiere de su salida suma 1; uno que
+// coincide resta 1 (sin bajar de 0). Al llegar al umbral (assert para 0→1,
+// release para 1→0) la salida cambia y el contador vuelve a 0. Un rebote
+// no reinicia la espera, solo la retrasa:
+//   - Transición limpia: se acepta en exactamente `umbral` muestras.
+//   - Con rebotes, si una fracción p > 1/2 de las muestras ya muestra el
+//     nuevo valor, se acepta en a lo sumo umbral / (2p - 1) muestras.
+
+#define DEBOUNCE_MAX_CHANNELS 32
+#define DEBOUNCE_COUNTER_BITS 4
+#define DEBOUNCE_MAX_THRESHOLD ((1 << DEBOUNCE_COUNTER_BITS) - 1)
+
+struct DebounceState {
+  uint32_t state;                        // Salida filtrada
+  uint32_t lastRaw;                      // Última muestra cruda
+  uint32_t count[DEBOUNCE_COUNTER_BITS]; // Contadores verticales
+  uint32_t assertPlanes[DEBOUNCE_COUNTER_BITS];  // Umbral 0→1 por bit
+  uint32_t releasePlanes[DEBOUNCE_COUNTER_BITS]; // Umbral 1→0 por bit
+  uint16_t bounces[DEBOUNCE_MAX_CHANNELS];       // Rebotes descartados
+};
+
+// Inicializar con umbrales en muestras (1..DEBOUNCE_MAX_THRESHOLD) y salida
+// inicial
+void debounce_init(DebounceState *db, uint8_t assertSamples,
+                   uint8_t releaseSamples, uint32_t initial);
+
+// Procesar una muestra cruda. Devuelve la máscara de canales que cambiaron.
+uint32_t debounce_sample(DebounceState *db, uint32_t raw);
+
+// Salida filtrada actual
+uint32_t debounce_get_state(const DebounceState *db);
+
+// Rebotes descartados en un canal (lectura que volvió al valor aceptado
+// antes de alcanzar el umbral)
+uint16_t debounce_get_bounces(const DebounceState *db, int channel);
+
+// Poner a cero los contadores de rebotes
+void debounce_reset_bounces(DebounceState *db);
+
+#endif // DEBOUNCE_H
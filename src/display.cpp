@@ -1,4 +1,8 @@
 #include "display.h"
+#include "clock.h"
+#include "fixed_trig.h"
+#include "history.h"
+#include <atomic>
 
 // Instancia global del display
 TFT_eSPI tft = TFT_eSPI();
@@ -16,36 +20,507 @@ static bool needsFullRedraw = true;
 #define TANK_X 30
 #define TANK_Y 48
 #define TANK_W 55
-#define TANK_H 154 // 22px por nivel (22*7=154)
+#define TANK_H_MAX 154 // Alto disponible, se ajusta a N franjas enteras
 #define INFO_X 100
 #define INFO_Y 48
 #define STATS_Y 265
 
-// Colores gradiente para nivel de agua
-static const uint16_t waterColors[] = {
-    0x5D7F, // Nivel 1 - Azul muy claro
-    0x4D5F, // Nivel 2
-    0x3D1F, // Nivel 3
-    0x2CBF, // Nivel 4
-    0x1C5F, // Nivel 5
-    0x0C1F, // Nivel 6
-    0x001F  // Nivel 7 - Azul oscuro
+// Franjas por nivel derivadas de NUM_SENSORS (22px con 7 boyas)
+using TankLayout = tank::Layout<TANK_H_MAX, NUM_SENSORS>;
+#define TANK_H (TankLayout::height)
+
+// Colores gradiente para nivel de agua (nivel 1 claro → nivel N oscuro)
+static constexpr const uint16_t *waterColors = tank::kWaterColors.color;
+
+// ============================================
+// COMPOSICIÓN FUERA DE PANTALLA
+// ============================================
+// Tanque, panel de bomba/estado y estadísticas se componen en sprites (RAM)
+// y al final de display_update() se envían al ILI9341 solo los rectángulos
+// que cambiaron. No hay parpadeo de borrar-y-dibujar y el tráfico SPI baja
+// a lo que realmente cambió. Si no hay RAM para un sprite, ese panel se
+// dibuja directo en pantalla como antes.
+
+// Paneles en pantalla (no se superponen)
+#define TANK_PANEL_X 8
+#define TANK_PANEL_Y (TANK_Y - 2)
+#define TANK_PANEL_W (INFO_X - 3 - TANK_PANEL_X)
+#define TANK_PANEL_H (TANK_H + 32)
+#define INFO_PANEL_X (INFO_X - 3) // Incluye el tubo de entrada de la bomba
+#define INFO_PANEL_Y INFO_Y
+#define INFO_PANEL_W (SCREEN_W - 5 - INFO_PANEL_X)
+#define INFO_PANEL_H 120
+#define STATS_PANEL_X 10
+#define STATS_PANEL_Y (STATS_Y - 10)
+#define STATS_PANEL_W (SCREEN_W - 20)
+#define STATS_PANEL_H (SCREEN_H - STATS_PANEL_Y)
+
+#define PANEL_MAX_DIRTY 4
+
+// Costo SPI de abrir una ventana: CASET, RASET y RAMWR con sus datos
+#define SPI_WINDOW_BYTES 11
+
+struct DirtyRect {
+  int16_t x, y, w, h; // Coordenadas locales del panel
 };
 
+struct Panel {
+  TFT_eSprite *sprite;
+  int16_t x, y, w, h; // Posición y tamaño en pantalla
+  bool buffered;      // Sprite creado (si no, dibujo directo)
+  uint8_t dirtyCount;
+  DirtyRect dirty[PANEL_MAX_DIRTY];
+};
+
+static TFT_eSprite tankSprite(&tft);
+static TFT_eSprite infoSprite(&tft);
+static TFT_eSprite statsSprite(&tft);
+
+static Panel tankPanel = {&tankSprite, TANK_PANEL_X, TANK_PANEL_Y,
+                          TANK_PANEL_W, TANK_PANEL_H, false, 0, {}};
+static Panel infoPanel = {&infoSprite, INFO_PANEL_X, INFO_PANEL_Y,
+                          INFO_PANEL_W, INFO_PANEL_H, false, 0, {}};
+static Panel statsPanel = {&statsSprite, STATS_PANEL_X, STATS_PANEL_Y,
+                           STATS_PANEL_W, STATS_PANEL_H, false, 0, {}};
+
+// Tráfico SPI y tiempos del frame en curso
+static uint32_t frameBytes = 0;
+static uint32_t frameDirectBytes = 0;
+static uint64_t frameStartUs = 0;
+static uint32_t frameCpuUs = 0;
+static bool frameInFlight = false;
+static DisplayStats stats;
+static DisplayFrameCallback frameCallback = nullptr;
+
+#if DISPLAY_USE_DMA
+
+// ============================================
+// ENVÍO POR DMA
+// ============================================
+// Los rectángulos sucios se copian por tandas de filas a uno de dos
+// buffers; mientras el DMA manda uno al ILI9341, la CPU prepara el otro.
+// display_poll() avanza la cola sin bloquear y cierra el frame cuando el
+// último envío termina.
+
+#if DISPLAY_DMA_CHUNK_PIXELS < SCREEN_W
+#error "DISPLAY_DMA_CHUNK_PIXELS debe alcanzar al menos una fila"
+#endif
+
+struct FlushRegion {
+  const Panel *panel;
+  DirtyRect rect;
+};
+
+// En RAM interna: accesible por DMA
+static uint16_t dmaBuffers[2][DISPLAY_DMA_CHUNK_PIXELS]
+    __attribute__((aligned(4)));
+static bool dmaReady = false;
+
+static FlushRegion flushQueue[3 * PANEL_MAX_DIRTY];
+static int flushCount = 0;
+static int flushIndex = 0;
+static int flushRow = 0;
+
+// Tanda preparada en dmaBuffers[prepBuffer], lista para enviar
+static int prepBuffer = 0;
+static bool chunkReady = false;
+static int16_t chunkX, chunkY, chunkW, chunkH;
+
+// Copiar la próxima tanda de filas al buffer libre
+static bool prepareChunk() {
+  if (chunkReady || flushIndex >= flushCount) {
+    return chunkReady;
+  }
+
+  const FlushRegion *region = &flushQueue[flushIndex];
+  const Panel *p = region->panel;
+  const DirtyRect *r = &region->rect;
+  int rows = min(DISPLAY_DMA_CHUNK_PIXELS / r->w, r->h - flushRow);
+
+  const uint16_t *src =
+      p->sprite->getPointer() + (r->y + flushRow) * p->w + r->x;
+  uint16_t *dst = dmaBuffers[prepBuffer];
+  for (int row = 0; row < rows; row++) {
+    memcpy(dst, src, r->w * sizeof(uint16_t));
+    dst += r->w;
+    src += p->w;
+  }
+
+  chunkX = p->x + r->x;
+  chunkY = p->y + r->y + flushRow;
+  chunkW = r->w;
+  chunkH = rows;
+  chunkReady = true;
+  frameBytes += (uint32_t)rows * r->w * 2 + SPI_WINDOW_BYTES;
+
+  flushRow += rows;
+  if (flushRow >= r->h) {
+    flushIndex++;
+    flushRow = 0;
+  }
+  return true;
+}
+
+static void startChunk() {
+  tft.pushImageDMA(chunkX, chunkY, chunkW, chunkH, dmaBuffers[prepBuffer]);
+  prepBuffer ^= 1;
+  chunkReady = false;
+}
+
+#endif
+
+// Cerrar el frame: estadísticas y aviso
+static void finishFrame() {
+  uint32_t frameUs = (uint32_t)(clock_us() - frameStartUs);
+
+  stats.frames++;
+  stats.lastBytes = frameBytes;
+  if (frameBytes > stats.maxBytes) {
+    stats.maxBytes = frameBytes;
+  }
+  stats.totalBytes += frameBytes;
+  stats.directBytes += frameDirectBytes;
+  stats.lastFrameUs = frameUs;
+  if (frameUs > stats.maxFrameUs) {
+    stats.maxFrameUs = frameUs;
+  }
+  stats.totalFrameUs += frameUs;
+  stats.lastCpuUs = frameCpuUs;
+  if (frameCpuUs > stats.maxCpuUs) {
+    stats.maxCpuUs = frameCpuUs;
+  }
+  stats.totalCpuUs += frameCpuUs;
+
+  frameInFlight = false;
+  if (frameCallback) {
+    frameCallback(frameUs, frameCpuUs);
+  }
+}
+
+static void panelInit(Panel *p) {
+  p->dirtyCount = 0;
+#if MULTI_TANK_ENABLED
+  // La vista de tarjetas no usa estos paneles: no reservar RAM
+  p->buffered = false;
+#else
+  p->buffered = p->sprite->createSprite(p->w, p->h) != nullptr;
+  if (p->buffered) {
+    p->sprite->fillSprite(COLOR_BG);
+  } else {
+    Serial.printf("[DISPLAY] No RAM for %dx%d sprite, drawing direct\n", p->w,
+                  p->h);
+  }
+#endif
+}
+
+// Superficie de dibujo del panel, en coordenadas locales
+static TFT_eSPI &panelBegin(Panel *p) {
+  if (p->buffered) {
+    return *p->sprite;
+  }
+  tft.setViewport(p->x, p->y, p->w, p->h);
+  return tft;
+}
+
+static void panelEnd(Panel *p) {
+  if (!p->buffered) {
+    tft.resetViewport();
+  }
+}
+
+// Marcar un rectángulo (local) del panel como cambiado
+static void panelMark(Panel *p, int x, int y, int w, int h) {
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  if (x + w > p->w) {
+    w = p->w - x;
+  }
+  if (y + h > p->h) {
+    h = p->h - y;
+  }
+  if (w <= 0 || h <= 0) {
+    return;
+  }
+
+  if (p->dirtyCount < PANEL_MAX_DIRTY) {
+    p->dirty[p->dirtyCount++] = {(int16_t)x, (int16_t)y, (int16_t)w,
+                                 (int16_t)h};
+    return;
+  }
+
+  // Sin lugar: unir con el último
+  DirtyRect *r = &p->dirty[PANEL_MAX_DIRTY - 1];
+  int x1 = max(r->x + r->w, x + w);
+  int y1 = max(r->y + r->h, y + h);
+  r->x = min((int)r->x, x);
+  r->y = min((int)r->y, y);
+  r->w = x1 - r->x;
+  r->h = y1 - r->y;
+}
+
+static void panelMarkAll(Panel *p) {
+  p->dirtyCount = 0;
+  panelMark(p, 0, 0, p->w, p->h);
+}
+
+// Área que el dibujo directo (sin sprites) borra y repinta
+static void accountDirect(const Panel *p, int w, int h) {
+  uint32_t bytes = (uint32_t)w * h * 2 + SPI_WINDOW_BYTES;
+  frameDirectBytes += bytes;
+  if (!p->buffered) {
+    frameBytes += bytes;
+  }
+}
+
+// Dibujo que siempre va directo a pantalla (header, fondo)
+static void accountScreen(int w, int h) {
+  uint32_t bytes = (uint32_t)w * h * 2 + SPI_WINDOW_BYTES;
+  frameDirectBytes += bytes;
+  frameBytes += bytes;
+}
+
+// Enviar los rectángulos cambiados del sprite a la pantalla (o encolarlos
+// para el DMA)
+static void panelFlush(Panel *p) {
+#if DISPLAY_USE_DMA
+  if (p->buffered && dmaReady) {
+    for (int i = 0; i < p->dirtyCount; i++) {
+      flushQueue[flushCount].panel = p;
+      flushQueue[flushCount].rect = p->dirty[i];
+      flushCount++;
+    }
+    p->dirtyCount = 0;
+    return;
+  }
+#endif
+
+  if (p->buffered) {
+    for (int i = 0; i < p->dirtyCount; i++) {
+      const DirtyRect *r = &p->dirty[i];
+      p->sprite->pushSprite(p->x + r->x, p->y + r->y, r->x, r->y, r->w, r->h);
+
+      // Ancho completo: un solo bloque; si no, una ventana por fila
+      if (r->w == p->w) {
+        frameBytes += (uint32_t)r->w * r->h * 2 + SPI_WINDOW_BYTES;
+      } else {
+        frameBytes += (uint32_t)r->h * (r->w * 2 + SPI_WINDOW_BYTES);
+      }
+    }
+  }
+  p->dirtyCount = 0;
+}
+
+// ============================================
+// ATLAS DE GLIFOS PARA CAMPOS NUMÉRICOS
+// ============================================
+// Nivel, cronómetro de la bomba y estadísticas cambian seguido. Sus glifos
+// se rasterizan una sola vez en display_init() (por fuente, texto sobre
+// fondo) y cada campo tiene celdas de ancho fijo: al cambiar un valor solo
+// se copian a memoria del sprite las celdas distintas, sin borrar ni
+// volver a rasterizar.
+#define GLYPH_SET " 0123456789:ms/-" // El espacio es la celda vacía
+#define GLYPH_COUNT ((int)sizeof(GLYPH_SET) - 1)
+#define FIELD_MAX_CELLS 8
+
+struct GlyphAtlas {
+  uint8_t font;
+  int16_t cellW, cellH;
+  uint16_t *pixels; // GLYPH_COUNT celdas seguidas, en formato del sprite
+};
+
+struct NumericField {
+  Panel *panel;
+  const GlyphAtlas *atlas;
+  int16_t x, y; // Coordenadas locales del panel
+  uint8_t cells;
+  char shown[FIELD_MAX_CELLS]; // '\0' = celda desconocida (redibujar)
+};
+
+static GlyphAtlas atlasFont2 = {2, 0, 0, nullptr};
+static GlyphAtlas atlasFont4 = {4, 0, 0, nullptr};
+
+// Dígitos del nivel (1 o 2) y el "/N" fijo a continuación
+#define LEVEL_CELLS (NUM_SENSORS >= 10 ? 2 : 1)
+
+static NumericField levelField;
+static NumericField levelMaxField;
+static NumericField pumpTimeField;
+static NumericField cyclesField;
+static NumericField lastCycleField;
+
+static void atlasInit(GlyphAtlas *a) {
+  char glyph[2] = {0, 0};
+
+  a->cellW = 0;
+  for (int i = 0; i < GLYPH_COUNT; i++) {
+    glyph[0] = GLYPH_SET[i];
+    a->cellW = max(a->cellW, (int16_t)tft.textWidth(glyph, a->font));
+  }
+  a->cellH = tft.fontHeight(a->font);
+
+  int cellPixels = a->cellW * a->cellH;
+  a->pixels = (uint16_t *)malloc(GLYPH_COUNT * cellPixels * sizeof(uint16_t));
+
+  TFT_eSprite cell(&tft);
+  if (!a->pixels || !cell.createSprite(a->cellW, a->cellH)) {
+    free(a->pixels);
+    a->pixels = nullptr;
+    Serial.printf("[DISPLAY] No RAM for font %d glyph atlas\n", a->font);
+    return;
+  }
+
+  cell.setTextFont(a->font);
+  cell.setTextColor(COLOR_TEXT, COLOR_BG);
+  for (int i = 0; i < GLYPH_COUNT; i++) {
+    glyph[0] = GLYPH_SET[i];
+    cell.fillSprite(COLOR_BG);
+    cell.setCursor((a->cellW - cell.textWidth(glyph)) / 2, 0);
+    cell.print(glyph);
+    memcpy(a->pixels + i * cellPixels, cell.getPointer(),
+           cellPixels * sizeof(uint16_t));
+  }
+  cell.deleteSprite();
+}
+
+static void fieldInit(NumericField *f, Panel *panel, const GlyphAtlas *atlas,
+                      int x, int y, int cells) {
+  f->panel = panel;
+  f->atlas = atlas;
+  f->x = x;
+  f->y = y;
+  f->cells = min(cells, FIELD_MAX_CELLS);
+  memset(f->shown, 0, sizeof(f->shown));
+}
+
+static void fieldInvalidate(NumericField *f) {
+  memset(f->shown, 0, sizeof(f->shown));
+}
+
+// Escribir una celda: copia del atlas al sprite, o texto si no hay atlas
+static void fieldCell(NumericField *f, int index, char c) {
+  Panel *p = f->panel;
+  const GlyphAtlas *a = f->atlas;
+  int cx = f->x + index * a->cellW;
+
+  const char *slot = strchr(GLYPH_SET, c);
+  int glyph = slot ? (int)(slot - GLYPH_SET) : 0;
+
+  if (p->buffered && a->pixels) {
+    const uint16_t *src = a->pixels + glyph * a->cellW * a->cellH;
+    uint16_t *dst = p->sprite->getPointer() + f->y * p->w + cx;
+    for (int row = 0; row < a->cellH; row++) {
+      memcpy(dst, src, a->cellW * sizeof(uint16_t));
+      src += a->cellW;
+      dst += p->w;
+    }
+  } else {
+    char text[2] = {GLYPH_SET[glyph], 0};
+    TFT_eSPI &g = panelBegin(p);
+    g.fillRect(cx, f->y, a->cellW, a->cellH, COLOR_BG);
+    g.setTextFont(a->font);
+    g.setTextColor(COLOR_TEXT, COLOR_BG);
+    g.setCursor(cx + (a->cellW - g.textWidth(text)) / 2, f->y);
+    g.print(text);
+    panelEnd(p);
+  }
+  panelMark(p, cx, f->y, a->cellW, a->cellH);
+}
+
+// Mostrar text (rellenado con espacios) tocando solo las celdas distintas
+static void fieldSet(NumericField *f, const char *text) {
+  bool ended = false;
+  for (int i = 0; i < f->cells; i++) {
+    ended = ended || text[i] == '\0';
+    char c = ended ? ' ' : text[i];
+    if (c != f->shown[i]) {
+      fieldCell(f, i, c);
+      f->shown[i] = c;
+    }
+  }
+}
+
+// Entero sin signo con al menos minDigits dígitos. Devuelve el largo.
+static int putUint(char *out, unsigned long value, int minDigits) {
+  char digits[12];
+  int n = 0;
+  do {
+    digits[n++] = '0' + value % 10;
+    value /= 10;
+  } while (value > 0 || n < minDigits);
+
+  for (int i = 0; i < n; i++) {
+    out[i] = digits[n - 1 - i];
+  }
+  out[n] = '\0';
+  return n;
+}
+
+static void fieldsInit() {
+  atlasInit(&atlasFont2);
+  atlasInit(&atlasFont4);
+
+  // Mismas posiciones que el texto que reemplazan
+  int levelX = TANK_X - TANK_PANEL_X + 5;
+  int levelY = TANK_Y - TANK_PANEL_Y + TANK_H + 8;
+  fieldInit(&levelField, &tankPanel, &atlasFont4, levelX, levelY,
+            LEVEL_CELLS);
+  fieldInit(&levelMaxField, &tankPanel, &atlasFont2,
+            levelX + LEVEL_CELLS * atlasFont4.cellW, levelY, 3);
+
+  fieldInit(&pumpTimeField, &infoPanel, &atlasFont2,
+            INFO_X - INFO_PANEL_X + 45, INFO_Y - INFO_PANEL_Y + 28, 6);
+
+  int statsY = STATS_Y - STATS_PANEL_Y;
+  fieldInit(&cyclesField, &statsPanel, &atlasFont2,
+            tft.textWidth("Ciclos hoy: ", 2), statsY, 5);
+  fieldInit(&lastCycleField, &statsPanel, &atlasFont2,
+            tft.textWidth("Ultimo ciclo: ", 2), statsY + 25, 8);
+}
+
+static void fieldsInvalidate() {
+  fieldInvalidate(&levelField);
+  fieldInvalidate(&levelMaxField);
+  fieldInvalidate(&pumpTimeField);
+  fieldInvalidate(&cyclesField);
+  fieldInvalidate(&lastCycleField);
+}
+
 void display_init() {
   tft.init();
   tft.setRotation(0); // Portrait
   tft.fillScreen(COLOR_BG);
 
+  panelInit(&tankPanel);
+  panelInit(&infoPanel);
+  panelInit(&statsPanel);
+#if !MULTI_TANK_ENABLED
+  fieldsInit();
+#endif
+
+#if DISPLAY_USE_DMA && !MULTI_TANK_ENABLED
+  dmaReady = tft.initDMA();
+  if (!dmaReady) {
+    Serial.println("[DISPLAY] DMA not available, flushing synchronously");
+  }
+#endif
+
   Serial.println("[DISPLAY] TFT ILI9341 initialized (240x320)");
 
   needsFullRedraw = true;
   memset(&lastData, 0, sizeof(lastData));
+  memset(&stats, 0, sizeof(stats));
 }
 
 void drawHeader(bool wifiConnected) {
   // Fondo header
   tft.fillRect(0, 0, SCREEN_W, HEADER_H, COLOR_HEADER);
+  accountScreen(SCREEN_W, HEADER_H);
 
   // Icono gota de agua
   tft.fillCircle(20, 20, 8, 0x5D7F);
@@ -65,130 +540,234 @@ void drawHeader(bool wifiConnected) {
   }
 }
 
-// Variable para animación
-static uint8_t animFrame = 0;
-
-void drawTank(int level) {
-  int levelHeight = TANK_H / 7;
-  int waterHeight = level * levelHeight;
-  int waterY = TANK_Y + TANK_H - waterHeight;
-
-  // Fondo del tanque (vacío) - con bordes redondeados
-  // Esto limpia todo incluyendo ondas anteriores
-  tft.fillRoundRect(TANK_X, TANK_Y, TANK_W, TANK_H, 8, 0x1082);
-
-  // Dibujar agua con gradiente
-  for (int i = 0; i < level; i++) {
-    int y = TANK_Y + TANK_H - (i + 1) * levelHeight;
+// ============================================
+// ANIMACIÓN A TASA FIJA
+// ============================================
+// Ondas, aspas y gotas dependen del tiempo, no de cuándo cambian los datos:
+// display_animate() corre a DISPLAY_ANIM_FPS y recompone solo esas regiones
+// chicas. Las fases salen de la tabla de seno en punto fijo (fixed_trig.h).
+#define WAVE_PERIOD_MS 1200  // Una ondulación completa
+#define WAVE_AMPLITUDE 3     // px
+#define WAVE_STEP_PER_PX 2   // Fase por píxel: longitud de onda de 32 px
+#define BLADE_PERIOD_MS 1000 // Una vuelta de las aspas
+#define BLADE_LENGTH 5       // px
+#define DROP_PERIOD_MS 800   // Subida de las gotas
+#define DROP_RISE 8          // px
+#define PUMP_ICON_DY 18      // Ícono más abajo: lugar para las gotas
+
+// Instante de la animación que se está componiendo
+static uint64_t animTimeMs = 0;
+
+// Franjas de agua desde el nivel from+1 hasta level (la superior redondeada)
+static void drawBands(TFT_eSPI &g, int tankX, int tankY, int from,
+                      int level) {
+  const int levelHeight = TankLayout::levelHeight;
+
+  for (int i = from; i < level; i++) {
+    int y = TankLayout::bandY(tankY, i + 1);
     uint16_t color = waterColors[i];
 
     if (i == level - 1) {
       // Nivel superior: con bordes redondeados arriba
-      tft.fillRoundRect(TANK_X + 2, y, TANK_W - 4, levelHeight, 4, color);
+      g.fillRoundRect(tankX + 2, y, TANK_W - 4, levelHeight, 4, color);
     } else {
-      tft.fillRect(TANK_X + 2, y, TANK_W - 4, levelHeight, color);
+      g.fillRect(tankX + 2, y, TANK_W - 4, levelHeight, color);
     }
   }
+}
 
-  // Ondas animadas en la superficie del agua (solo si hay agua)
-  if (level > 0 && level < 7) {
-    int waveY = waterY + 4;
-    uint16_t waveColor = waterColors[level - 1];
+// Ondas en la superficie del agua (solo si hay agua y no está lleno)
+static void drawWaves(TFT_eSPI &g, int tankX, int tankY, int level) {
+  if (level <= 0 || level >= NUM_SENSORS) {
+    return;
+  }
 
-    // Centrar ondas dentro del tanque
-    int startX = TANK_X + 6;
-    int endX = TANK_X + TANK_W - 6;
+  int waveY = TankLayout::bandY(tankY, level) + 4;
+  uint16_t waveColor = waterColors[level - 1];
+  int phase = trig::phaseAt(animTimeMs, WAVE_PERIOD_MS);
 
-    // Dibujar ondas sinusoidales
-    for (int x = startX; x < endX; x += 8) {
-      int offset = (animFrame + x) % 12;
-      int waveOffset = (offset < 6) ? offset - 3 : 3 - (offset - 6);
-      tft.fillCircle(x, waveY + waveOffset, 2, waveColor);
-    }
+  // Centrar ondas dentro del tanque
+  int startX = tankX + 6;
+  int endX = tankX + TANK_W - 6;
+
+  for (int x = startX; x < endX; x += 8) {
+    int waveOffset =
+        trig::sinScaled(phase + (x - startX) * WAVE_STEP_PER_PX,
+                        WAVE_AMPLITUDE);
+    g.fillCircle(x, waveY + waveOffset, 2, waveColor);
   }
+}
+
+void drawTank(int level, int previousLevel) {
+  TFT_eSPI &g = panelBegin(&tankPanel);
+  const int tankX = TANK_X - TANK_PANEL_X;
+  const int tankY = TANK_Y - TANK_PANEL_Y;
+  const int levelHeight = TankLayout::levelHeight;
+
+  // Fondo del tanque (vacío) - con bordes redondeados
+  // Esto limpia todo incluyendo ondas anteriores
+  g.fillRoundRect(tankX, tankY, TANK_W, TANK_H, 8, 0x1082);
+  accountDirect(&tankPanel, TANK_W, TANK_H);
+
+  // Dibujar agua con gradiente y ondas
+  drawBands(g, tankX, tankY, 0, level);
+  drawWaves(g, tankX, tankY, level);
 
   // Marco del tanque con bordes redondeados
-  tft.drawRoundRect(TANK_X - 1, TANK_Y - 1, TANK_W + 2, TANK_H + 2, 8,
-                    COLOR_TEXT);
-  tft.drawRoundRect(TANK_X - 2, TANK_Y - 2, TANK_W + 4, TANK_H + 4, 10,
-                    COLOR_TEXT_DIM);
+  g.drawRoundRect(tankX - 1, tankY - 1, TANK_W + 2, TANK_H + 2, 8, COLOR_TEXT);
+  g.drawRoundRect(tankX - 2, tankY - 2, TANK_W + 4, TANK_H + 4, 10,
+                  COLOR_TEXT_DIM);
 
   // Líneas de nivel (marcas) - centradas en cada sección
-  for (int i = 1; i <= 7; i++) {
-    int y = TANK_Y + TANK_H - (i * levelHeight) + (levelHeight / 2);
-    tft.drawFastHLine(TANK_X - 10, y, 8, COLOR_TEXT_DIM);
+  for (int i = 1; i <= NUM_SENSORS; i++) {
+    int y = TankLayout::tickY(tankY, i);
+    g.drawFastHLine(tankX - 10, y, 8, COLOR_TEXT_DIM);
 
     // Número de nivel
-    tft.setTextFont(1);
-    tft.setTextColor(COLOR_TEXT_DIM, COLOR_BG);
-    tft.setCursor(TANK_X - 20, y - 3);
-    tft.print(i);
+    g.setTextFont(1);
+    g.setTextColor(COLOR_TEXT_DIM, COLOR_BG);
+    g.setCursor(tankX - 20, y - 3);
+    g.print(i);
   }
 
-  // Indicador de nivel actual (debajo del tanque)
-  tft.fillRect(TANK_X - 5, TANK_Y + TANK_H + 5, TANK_W + 40, 25, COLOR_BG);
-  tft.setTextFont(4);
-  tft.setTextColor(COLOR_TEXT, COLOR_BG);
-  tft.setCursor(TANK_X + 5, TANK_Y + TANK_H + 8);
-  tft.print(level);
-  tft.setTextFont(2);
-  tft.print("/7");
-
-  // Incrementar frame de animación
-  animFrame = (animFrame + 1) % 12;
+  panelEnd(&tankPanel);
+
+  // Indicador de nivel actual (debajo del tanque): "N/MAX" en celdas fijas
+  char text[8] = " ";
+  putUint(text + (level >= 10 ? 0 : LEVEL_CELLS - 1), level, 1);
+  fieldSet(&levelField, text);
+
+  text[0] = '/';
+  putUint(text + 1, NUM_SENSORS, 1);
+  fieldSet(&levelMaxField, text);
+  accountDirect(&tankPanel, TANK_W + 40, 25); // Camino anterior: borrar
+
+  // Solo cambian las filas entre el nivel anterior y el nuevo (con margen
+  // para las ondas y el borde redondeado de la franja superior) y el número
+  int lowLevel = min(level, previousLevel);
+  int highLevel = max(level, previousLevel);
+  int topY = tankY + TANK_H - highLevel * levelHeight - 2;
+  int bottomY = tankY + TANK_H - lowLevel * levelHeight + levelHeight;
+  panelMark(&tankPanel, tankX, topY, TANK_W, bottomY - topY);
 }
 
-// Dibujar ícono de bomba
-void drawPumpIcon(int x, int y, bool running, uint16_t color) {
-  // Cuerpo de la bomba (cilindro)
-  tft.fillRoundRect(x, y + 8, 30, 20, 4, color);
+// Recomponer solo la franja de las ondas
+static void animateWaves(int level) {
+  if (level <= 0 || level >= NUM_SENSORS) {
+    return;
+  }
 
-  // Tubo de entrada (izquierda)
-  tft.fillRect(x - 8, y + 14, 10, 8, color);
+  TFT_eSPI &g = panelBegin(&tankPanel);
+  const int tankX = TANK_X - TANK_PANEL_X;
+  const int tankY = TANK_Y - TANK_PANEL_Y;
+  int waterY = TankLayout::bandY(tankY, level);
+
+  // Las ondas ocupan de waterY - 1 a waterY + 9: aire arriba, franjas
+  // superiores debajo (la de abajo por si la franja es más baja que la onda)
+  int stripY = waterY - 2;
+  int stripH = 2 * WAVE_AMPLITUDE + 6;
+  g.fillRect(tankX + 2, stripY, TANK_W - 4, waterY - stripY, 0x1082);
+  drawBands(g, tankX, tankY, max(level - 2, 0), level);
+  drawWaves(g, tankX, tankY, level);
+
+  panelEnd(&tankPanel);
+  panelMark(&tankPanel, tankX + 2, stripY, TANK_W - 4, stripH);
+}
 
-  // Tubo de salida (arriba)
-  tft.fillRect(x + 10, y, 10, 10, color);
+// Motor de la bomba: aspas girando o cruz estática
+static void drawMotor(TFT_eSPI &g, int x, int y, bool running) {
+  int cx = x + 15;
+  int cy = y + 18;
 
-  // Motor (círculo)
-  tft.fillCircle(x + 15, y + 18, 8, running ? COLOR_PUMP_ON : COLOR_TEXT_DIM);
+  g.fillCircle(cx, cy, 8, running ? COLOR_PUMP_ON : COLOR_TEXT_DIM);
 
-  // Aspas del motor (rotan si está activa)
   if (running) {
-    int angle = (animFrame * 30) % 360;
-    int cx = x + 15;
-    int cy = y + 18;
+    int phase = trig::phaseAt(animTimeMs, BLADE_PERIOD_MS);
 
     // Dibujar 4 aspas rotando
     for (int i = 0; i < 4; i++) {
-      int a = angle + (i * 90);
-      int dx = 5 * cos(a * 3.14159 / 180);
-      int dy = 5 * sin(a * 3.14159 / 180);
-      tft.drawLine(cx, cy, cx + dx, cy + dy, COLOR_TEXT);
+      int a = phase + i * (trig::kSinSteps / 4);
+      int dx = trig::cosScaled(a, BLADE_LENGTH);
+      int dy = trig::sinScaled(a, BLADE_LENGTH);
+      g.drawLine(cx, cy, cx + dx, cy + dy, COLOR_TEXT);
     }
   } else {
     // Cruz estática
-    tft.drawFastHLine(x + 11, y + 18, 8, COLOR_TEXT);
-    tft.drawFastVLine(x + 15, y + 14, 8, COLOR_TEXT);
+    g.drawFastHLine(x + 11, cy, 8, COLOR_TEXT);
+    g.drawFastVLine(cx, y + 14, 8, COLOR_TEXT);
   }
+}
+
+// Gotas de agua saliendo por el tubo de salida
+static void drawDrops(TFT_eSPI &g, int x, int y) {
+  int rise = (int)(animTimeMs % DROP_PERIOD_MS) * DROP_RISE / DROP_PERIOD_MS;
+  int dropY = y - 5 - rise;
+  g.fillCircle(x + 15, dropY, 2, 0x5D7F);
+  g.fillCircle(x + 12, dropY - 4, 1, 0x5D7F);
+  g.fillCircle(x + 18, dropY - 3, 1, 0x5D7F);
+}
+
+// Dibujar ícono de bomba
+void drawPumpIcon(TFT_eSPI &g, int x, int y, bool running, uint16_t color) {
+  // Cuerpo de la bomba (cilindro)
+  g.fillRoundRect(x, y + 8, 30, 20, 4, color);
+
+  // Tubo de entrada (izquierda)
+  g.fillRect(x - 8, y + 14, 10, 8, color);
+
+  // Tubo de salida (arriba)
+  g.fillRect(x + 10, y, 10, 10, color);
+
+  // Motor y aspas
+  drawMotor(g, x, y, running);
 
   // Gotas de agua saliendo (solo si está activa)
   if (running) {
-    int dropY = y - 5 - (animFrame % 8);
-    tft.fillCircle(x + 15, dropY, 2, 0x5D7F);
-    tft.fillCircle(x + 12, dropY - 4, 1, 0x5D7F);
-    tft.fillCircle(x + 18, dropY - 3, 1, 0x5D7F);
+    drawDrops(g, x, y);
   }
 }
 
-void drawPumpStatus(PumpState state, unsigned long runTime) {
-  int y = INFO_Y;
+// Recomponer solo motor y gotas de la bomba en marcha
+static void animatePump() {
+  TFT_eSPI &g = panelBegin(&infoPanel);
+  int x = INFO_X - INFO_PANEL_X + 5;
+  int y = INFO_Y - INFO_PANEL_Y + PUMP_ICON_DY;
+
+  // Zona de las gotas (sobre el tubo de salida) y círculo del motor
+  g.fillRect(x + 11, y - 17, 9, 15, COLOR_BG);
+  drawDrops(g, x, y);
+  drawMotor(g, x, y, true);
+
+  panelEnd(&infoPanel);
+  panelMark(&infoPanel, x + 11, y - 17, 9, 15);
+  panelMark(&infoPanel, x + 7, y + 10, 17, 17);
+}
+
+// Cronómetro "mm:ss": solo las celdas que cambiaron (cada segundo, las
+// unidades de segundo)
+static void setPumpTime(uint64_t runTime) {
+  unsigned long seconds = (unsigned long)(runTime / 1000);
+
+  char text[FIELD_MAX_CELLS + 1];
+  int n = putUint(text, seconds / 60, 2);
+  text[n++] = ':';
+  putUint(text + n, seconds % 60, 2);
+  fieldSet(&pumpTimeField, text);
+}
+
+void drawPumpStatus(PumpState state, uint64_t runTime) {
+  TFT_eSPI &g = panelBegin(&infoPanel);
+  int x = INFO_X - INFO_PANEL_X;
+  int y = INFO_Y - INFO_PANEL_Y;
+  int w = SCREEN_W - INFO_X - 5;
 
   // Limpiar área (reducida para no tapar ESTADO)
-  tft.fillRect(INFO_X, y, SCREEN_W - INFO_X - 5, 70, COLOR_BG);
+  g.fillRect(x, y, w, 70, COLOR_BG);
+  accountDirect(&infoPanel, w, 70);
 
   // Estado de la bomba
-  uint16_t statusColor;
-  const char *statusText;
+  uint16_t statusColor = COLOR_TEXT_DIM;
+  const char *statusText = "APAGADA";
   bool isRunning = false;
 
   switch (state) {
@@ -209,39 +788,45 @@ void drawPumpStatus(PumpState state, unsigned long runTime) {
   }
 
   // Dibujar ícono de bomba
-  drawPumpIcon(INFO_X + 5, y, isRunning, statusColor);
+  drawPumpIcon(g, x + 5, y + PUMP_ICON_DY, isRunning, statusColor);
 
   // Texto de estado
-  tft.setTextFont(2);
-  tft.setTextColor(statusColor, COLOR_BG);
-  tft.setCursor(INFO_X + 45, y + 10);
-  tft.print(statusText);
-
-  // Tiempo de ejecución si está activa
-  if (state != PUMP_OFF) {
-    tft.setTextColor(COLOR_TEXT, COLOR_BG);
-    tft.setCursor(INFO_X + 45, y + 28);
+  g.setTextFont(2);
+  g.setTextColor(statusColor, COLOR_BG);
+  g.setCursor(x + 45, y + 10);
+  g.print(statusText);
 
-    unsigned long seconds = runTime / 1000;
-    unsigned long minutes = seconds / 60;
-    seconds = seconds % 60;
+  panelEnd(&infoPanel);
+  panelMark(&infoPanel, x - 3, y, w + 3, 70);
 
-    char timeStr[16];
-    sprintf(timeStr, "%02lu:%02lu", minutes, seconds);
-    tft.print(timeStr);
+  // Tiempo de ejecución si está activa (el área se acaba de borrar)
+  fieldInvalidate(&pumpTimeField);
+  if (state != PUMP_OFF) {
+    setPumpTime(runTime);
   }
 }
 
+void drawPumpTime(uint64_t runTime) {
+  setPumpTime(runTime);
+  // Camino anterior: borrar y redibujar todo el panel de la bomba
+  accountDirect(&infoPanel, SCREEN_W - INFO_X - 5, 70);
+}
+
 void drawSequenceStatus(SequenceState state, bool hasError) {
-  int y = INFO_Y + 75; // Más arriba para no superponerse
+  TFT_eSPI &g = panelBegin(&infoPanel);
+  int x = INFO_X - INFO_PANEL_X;
+  int y = INFO_Y - INFO_PANEL_Y + 75; // Más arriba para no superponerse
+  int w = SCREEN_W - INFO_X - 5;
 
   // Limpiar área
-  tft.fillRect(INFO_X, y, SCREEN_W - INFO_X - 5, 45, COLOR_BG);
+  g.fillRect(x, y, w, 45, COLOR_BG);
+  accountDirect(&infoPanel, w, 45);
+  panelMark(&infoPanel, x, y, w, 45);
 
-  tft.setTextFont(2);
-  tft.setTextColor(COLOR_TEXT_DIM, COLOR_BG);
-  tft.setCursor(INFO_X, y);
-  tft.print("ESTADO:");
+  g.setTextFont(2);
+  g.setTextColor(COLOR_TEXT_DIM, COLOR_BG);
+  g.setCursor(x, y);
+  g.print("ESTADO:");
 
   y += 20;
 
@@ -271,82 +856,348 @@ void drawSequenceStatus(SequenceState state, bool hasError) {
     }
   }
 
-  tft.setTextColor(statusColor, COLOR_BG);
-  tft.setCursor(INFO_X, y);
-  tft.print(statusText);
+  g.setTextColor(statusColor, COLOR_BG);
+  g.setCursor(x, y);
+  g.print(statusText);
+
+  panelEnd(&infoPanel);
 }
 
-void drawStats(int cycles, unsigned long lastCycle) {
-  int y = STATS_Y;
+void drawStats(int cycles, uint64_t lastCycle, bool fullRedraw) {
+  int y = STATS_Y - STATS_PANEL_Y;
+  int w = SCREEN_W - 20;
 
-  // Línea separadora
-  tft.drawFastHLine(10, y - 10, SCREEN_W - 20, COLOR_HEADER);
+  // Etiquetas fijas: solo en el redibujado completo
+  if (fullRedraw) {
+    TFT_eSPI &g = panelBegin(&statsPanel);
 
-  // Limpiar área
-  tft.fillRect(10, y, SCREEN_W - 20, 80, COLOR_BG);
+    // Línea separadora
+    g.drawFastHLine(0, y - 10, w, COLOR_HEADER);
 
-  tft.setTextFont(2);
-  tft.setTextColor(COLOR_TEXT_DIM, COLOR_BG);
+    // Limpiar área (sin tapar el banner de error)
+    g.fillRect(0, y, w, 50, COLOR_BG);
 
-  // Ciclos hoy
-  tft.setCursor(10, y);
-  tft.print("Ciclos hoy: ");
-  tft.setTextColor(COLOR_TEXT, COLOR_BG);
-  tft.print(cycles);
+    g.setTextFont(2);
+    g.setTextColor(COLOR_TEXT_DIM, COLOR_BG);
+    g.setCursor(0, y);
+    g.print("Ciclos hoy: ");
+    g.setCursor(0, y + 25);
+    g.print("Ultimo ciclo: ");
 
-  // Último ciclo
-  y += 25;
-  tft.setTextColor(COLOR_TEXT_DIM, COLOR_BG);
-  tft.setCursor(10, y);
-  tft.print("Ultimo ciclo: ");
+    panelEnd(&statsPanel);
+    panelMark(&statsPanel, 0, y - 10, w, 60);
+  }
+  accountDirect(&statsPanel, w, 50); // Camino anterior: borrar y redibujar
 
-  if (lastCycle > 0) {
-    unsigned long seconds = lastCycle / 1000;
-    unsigned long minutes = seconds / 60;
-    seconds = seconds % 60;
+  // Valores en celdas fijas
+  char text[FIELD_MAX_CELLS + 1];
+  putUint(text, cycles, 1);
+  fieldSet(&cyclesField, text);
 
-    tft.setTextColor(COLOR_TEXT, COLOR_BG);
-    char timeStr[16];
-    sprintf(timeStr, "%lum %02lus", minutes, seconds);
-    tft.print(timeStr);
+  if (lastCycle > 0) {
+    unsigned long seconds = (unsigned long)(lastCycle / 1000);
+    int n = putUint(text, seconds / 60, 1);
+    text[n++] = 'm';
+    text[n++] = ' ';
+    n += putUint(text + n, seconds % 60, 2);
+    text[n++] = 's';
+    text[n] = '\0';
+    fieldSet(&lastCycleField, text);
   } else {
-    tft.setTextColor(COLOR_TEXT_DIM, COLOR_BG);
-    tft.print("---");
+    fieldSet(&lastCycleField, "---");
   }
 }
 
 void drawErrorBanner(bool show) {
-  int y = STATS_Y + 50; // Justo arriba del borde inferior
+  TFT_eSPI &g = panelBegin(&statsPanel);
+  int y = STATS_Y - STATS_PANEL_Y + 50; // Justo arriba del borde inferior
+  int w = SCREEN_W - 20;
 
   if (show) {
-    tft.fillRect(10, y, SCREEN_W - 20, 25, COLOR_ERROR);
-    tft.setTextFont(2);
-    tft.setTextColor(COLOR_TEXT, COLOR_ERROR);
-    tft.setCursor(30, y + 5);
-    tft.print("ERROR DE SECUENCIA");
+    g.fillRect(0, y, w, 25, COLOR_ERROR);
+    g.setTextFont(2);
+    g.setTextColor(COLOR_TEXT, COLOR_ERROR);
+    g.setCursor(20, y + 5);
+    g.print("ERROR DE SECUENCIA");
   } else {
-    tft.fillRect(10, y, SCREEN_W - 20, 25, COLOR_BG);
+    g.fillRect(0, y, w, 25, COLOR_BG);
+  }
+  accountDirect(&statsPanel, w, 25);
+  panelMark(&statsPanel, 0, y, w, 25);
+
+  panelEnd(&statsPanel);
+}
+
+// Esperar a que termine el frame en curso antes de dibujar directo
+static void waitFrame() {
+  while (frameInFlight) {
+    display_poll();
+  }
+}
+
+// Empezar a componer un frame
+static void beginFrame() {
+  frameStartUs = clock_us();
+  animTimeMs = frameStartUs / 1000;
+  frameBytes = 0;
+  frameDirectBytes = 0;
+#if DISPLAY_USE_DMA
+  flushCount = 0;
+  flushIndex = 0;
+  flushRow = 0;
+#endif
+}
+
+// Enviar los rectángulos cambiados: por DMA vuelve enseguida, si no el
+// frame termina aquí
+static void submitFrame() {
+  panelFlush(&tankPanel);
+  panelFlush(&infoPanel);
+  panelFlush(&statsPanel);
+
+  frameInFlight = true;
+  frameCpuUs = (uint32_t)(clock_us() - frameStartUs);
+
+#if DISPLAY_USE_DMA
+  if (flushCount > 0) {
+    // CS tomado durante todo el frame; el DMA arranca ya y sigue solo
+    tft.startWrite();
+    display_poll();
+    return;
+  }
+#endif
+
+  finishFrame();
+}
+
+// ============================================
+// PANTALLA DE TENDENCIA
+// ============================================
+// Cada fila de la zona de scroll resume TREND_ROW_SAMPLES muestras del
+// historial: nivel mínimo-máximo y si la bomba anduvo. Lo más viejo arriba,
+// lo último abajo. El gráfico avanza moviendo el inicio del scroll vertical
+// por hardware del ILI9341 y dibujando solo la fila nueva: nunca se
+// repinta. Costo fijo por muestra: una fila de SCREEN_W píxeles (dos al
+// cerrar una fila).
+
+#define TREND_TOP 30    // Zona fija superior (título)
+#define TREND_BOTTOM 20 // Zona fija inferior (escala)
+#define TREND_ROWS (SCREEN_H - TREND_TOP - TREND_BOTTOM)
+#define TREND_PUMP_X 4
+#define TREND_PUMP_W 12
+#define TREND_CHART_X 24
+#define TREND_CHART_W (SCREEN_W - TREND_CHART_X - 8)
+
+// Línea de grilla cada 4 h (45 filas con 10 s x 32)
+#define TREND_GRID_ROWS                                                        \
+  max(1UL, 4 * 3600000UL / ((unsigned long)HISTORY_SAMPLE_INTERVAL_MS *       \
+                            TREND_ROW_SAMPLES))
+
+// Comandos de scroll vertical del ILI9341
+#define ILI9341_VSCRDEF 0x33
+#define ILI9341_VSCRSADD 0x37
+
+enum DisplayPage { PAGE_MAIN, PAGE_TREND };
+
+static DisplayPage page = PAGE_MAIN;
+// Pedidos de otras tareas (botón): se aplican en el próximo display_update()
+static std::atomic<bool> pageToggleRequested(false);
+static std::atomic<bool> redrawRequested(false);
+static uint32_t trendRow = 0;     // Fila (grupo de muestras) más nueva
+static uint32_t trendSamples = 0; // history_total() del último dibujo
+
+static void scrollDefine(uint16_t top, uint16_t rows, uint16_t bottom) {
+  tft.writecommand(ILI9341_VSCRDEF);
+  tft.writedata(top >> 8);
+  tft.writedata(top & 0xFF);
+  tft.writedata(rows >> 8);
+  tft.writedata(rows & 0xFF);
+  tft.writedata(bottom >> 8);
+  tft.writedata(bottom & 0xFF);
+}
+
+static void scrollTo(uint16_t line) {
+  tft.writecommand(ILI9341_VSCRSADD);
+  tft.writedata(line >> 8);
+  tft.writedata(line & 0xFF);
+}
+
+static int trendLevelX(int level) {
+  return TREND_CHART_X + level * TREND_CHART_W / NUM_SENSORS;
+}
+
+// Dibujar la fila row en su línea de la memoria del TFT
+static void trendDrawRow(uint32_t row) {
+  int y = TREND_TOP + row % TREND_ROWS;
+  uint32_t first = row * TREND_ROW_SAMPLES;
+
+  int minLevel = NUM_SENSORS;
+  int maxLevel = -1;
+  PumpState pump = PUMP_OFF;
+  HistorySample sample;
+  for (int i = 0; i < TREND_ROW_SAMPLES; i++) {
+    if (history_get(first + i, &sample)) {
+      minLevel = min(minLevel, (int)sample.level);
+      maxLevel = max(maxLevel, (int)sample.level);
+      pump = max(pump, sample.pumpState);
+    }
+  }
+
+  uint16_t bg = row % TREND_GRID_ROWS == 0 ? COLOR_HEADER : COLOR_BG;
+  tft.drawFastHLine(0, y, SCREEN_W, bg);
+  if (maxLevel < 0) {
+    return; // Sin datos
+  }
+
+  if (pump != PUMP_OFF) {
+    tft.drawFastHLine(TREND_PUMP_X, y, TREND_PUMP_W,
+                      pump == PUMP_EMERGENCY ? COLOR_ERROR : COLOR_PUMP_ON);
+  }
+
+  // Nivel mínimo sólido y el rango hasta el máximo en claro
+  int minX = trendLevelX(minLevel);
+  int maxX = trendLevelX(maxLevel);
+  if (minLevel > 0) {
+    tft.drawFastHLine(TREND_CHART_X, y, minX - TREND_CHART_X,
+                      waterColors[minLevel - 1]);
+  }
+  if (maxX > minX) {
+    tft.drawFastHLine(minX, y, maxX - minX, COLOR_WATER_LOW);
+  }
+}
+
+// Fila de abajo de la zona de scroll = la más nueva
+static void trendScroll() {
+  scrollTo(TREND_TOP + (trendRow + 1) % TREND_ROWS);
+}
+
+static void trendEnter() {
+  uint64_t start = clock_us();
+
+  tft.fillScreen(COLOR_BG);
+  tft.fillRect(0, 0, SCREEN_W, TREND_TOP, COLOR_HEADER);
+  tft.setTextFont(2);
+  tft.setTextColor(COLOR_TEXT, COLOR_HEADER);
+  tft.setCursor(8, 7);
+  tft.print("TENDENCIA 24h");
+
+  // Escala: columna de bomba y nivel 0..N
+  int y = SCREEN_H - TREND_BOTTOM + 2;
+  tft.setTextColor(COLOR_TEXT_DIM, COLOR_BG);
+  tft.setCursor(TREND_PUMP_X, y);
+  tft.print("B");
+  tft.setCursor(TREND_CHART_X, y);
+  tft.print("0");
+  char top[4];
+  putUint(top, NUM_SENSORS, 1);
+  tft.setCursor(trendLevelX(NUM_SENSORS) - tft.textWidth(top, 2), y);
+  tft.print(top);
+
+  scrollDefine(TREND_TOP, TREND_ROWS, TREND_BOTTOM);
+
+  // Repintado completo solo al entrar
+  trendSamples = history_total();
+  trendRow = trendSamples > 0 ? (trendSamples - 1) / TREND_ROW_SAMPLES : 0;
+  uint32_t oldest = trendRow >= TREND_ROWS ? trendRow - TREND_ROWS + 1 : 0;
+  for (uint32_t row = oldest; row <= trendRow; row++) {
+    trendDrawRow(row);
+  }
+  trendScroll();
+
+  Serial.printf("[DISPLAY] Trend page: %lu samples, drawn in %lu us\n",
+                (unsigned long)history_count(),
+                (unsigned long)(clock_us() - start));
+}
+
+static void trendExit() {
+  scrollDefine(0, SCREEN_H, 0);
+  scrollTo(0);
+  needsFullRedraw = true;
+}
+
+// Muestras nuevas: cerrar la fila en curso y, si empezó otra, avanzar
+static void trendUpdate() {
+  uint32_t total = history_total();
+  if (total == trendSamples) {
+    return;
+  }
+  trendSamples = total;
+
+  uint32_t newest = (total - 1) / TREND_ROW_SAMPLES;
+  if (newest - trendRow >= TREND_ROWS) {
+    trendEnter(); // Demasiado atrasado: no debería pasar
+    return;
+  }
+
+  trendDrawRow(trendRow);
+  if (newest != trendRow) {
+    while (trendRow < newest) {
+      trendRow++;
+      trendDrawRow(trendRow);
+    }
+    trendScroll();
+  }
+}
+
+void display_toggle_page() {
+  pageToggleRequested.store(true, std::memory_order_release);
+}
+
+// Redibujado completo pedido por display_force_redraw()
+static void takeRedrawRequest() {
+  if (redrawRequested.exchange(false, std::memory_order_acquire)) {
+    needsFullRedraw = true;
   }
 }
 
 void display_update(const DisplayData *data) {
+  stats.updates++;
+
+  // Los sprites se están enviando: no tocarlos. Los cambios quedan en
+  // lastData y entran en el próximo frame.
+  if (frameInFlight) {
+    stats.skipped++;
+    return;
+  }
+
+  takeRedrawRequest();
+  if (pageToggleRequested.exchange(false, std::memory_order_acquire)) {
+    if (page == PAGE_MAIN) {
+      page = PAGE_TREND;
+      trendEnter();
+    } else {
+      page = PAGE_MAIN;
+      trendExit();
+    }
+  }
+
+  if (page == PAGE_TREND) {
+    trendUpdate();
+    return;
+  }
+
   bool doFullRedraw = needsFullRedraw;
+  beginFrame();
 
   if (doFullRedraw) {
     tft.fillScreen(COLOR_BG);
+    accountScreen(SCREEN_W, SCREEN_H);
     drawHeader(data->wifiConnected);
+    fieldsInvalidate();
     needsFullRedraw = false;
   }
 
-  // Actualizar solo lo que cambió (o todo si es full redraw)
+  // Componer solo lo que cambió (o todo si es full redraw)
   if (doFullRedraw || data->level != lastData.level) {
-    drawTank(data->level);
+    drawTank(data->level, lastData.level);
   }
 
-  if (doFullRedraw || data->pumpState != lastData.pumpState ||
-      (data->pumpState != PUMP_OFF &&
-       data->pumpRunTime / 1000 != lastData.pumpRunTime / 1000)) {
+  bool pumpChanged = data->pumpState != lastData.pumpState;
+  if (doFullRedraw || pumpChanged) {
     drawPumpStatus(data->pumpState, data->pumpRunTime);
+  } else if (data->pumpState != PUMP_OFF &&
+             data->pumpRunTime / 1000 != lastData.pumpRunTime / 1000) {
+    drawPumpTime(data->pumpRunTime);
   }
 
   if (doFullRedraw || data->sequenceState != lastData.sequenceState ||
@@ -356,7 +1207,7 @@ void display_update(const DisplayData *data) {
 
   if (doFullRedraw || data->cyclesCompleted != lastData.cyclesCompleted ||
       data->lastCycleDuration != lastData.lastCycleDuration) {
-    drawStats(data->cyclesCompleted, data->lastCycleDuration);
+    drawStats(data->cyclesCompleted, data->lastCycleDuration, doFullRedraw);
   }
 
   if (doFullRedraw || data->hasError != lastData.hasError) {
@@ -367,11 +1218,192 @@ void display_update(const DisplayData *data) {
     drawHeader(data->wifiConnected);
   }
 
+  if (doFullRedraw) {
+    panelMarkAll(&tankPanel);
+    panelMarkAll(&infoPanel);
+    panelMarkAll(&statsPanel);
+  }
+
   // Guardar estado actual
   memcpy(&lastData, data, sizeof(DisplayData));
+
+  submitFrame();
+}
+
+void display_animate() {
+  // Antes del primer frame completo (o en la tendencia) no hay nada que
+  // animar
+  if (needsFullRedraw || page != PAGE_MAIN) {
+    return;
+  }
+  if (frameInFlight) {
+    stats.skipped++;
+    return;
+  }
+
+  bool waves = lastData.level > 0 && lastData.level < NUM_SENSORS;
+  bool pump = lastData.pumpState != PUMP_OFF;
+  if (!waves && !pump) {
+    return;
+  }
+
+  beginFrame();
+  if (waves) {
+    animateWaves(lastData.level);
+  }
+  if (pump) {
+    animatePump();
+  }
+  stats.animFrames++;
+  submitFrame();
+}
+
+bool display_poll() {
+#if DISPLAY_USE_DMA
+  if (!frameInFlight || flushCount == 0) {
+    return frameInFlight;
+  }
+
+  uint64_t start = clock_us();
+  if (!tft.dmaBusy()) {
+    if (prepareChunk()) {
+      startChunk();
+      // Preparar la siguiente tanda mientras el DMA envía esta
+      prepareChunk();
+    } else {
+      tft.endWrite();
+      flushCount = 0;
+      frameCpuUs += (uint32_t)(clock_us() - start);
+      finishFrame();
+      return false;
+    }
+  } else {
+    prepareChunk();
+  }
+  frameCpuUs += (uint32_t)(clock_us() - start);
+#endif
+  return frameInFlight;
+}
+
+bool display_busy() { return frameInFlight; }
+
+void display_set_frame_callback(DisplayFrameCallback callback) {
+  frameCallback = callback;
+}
+
+void display_get_stats(DisplayStats *out) { memcpy(out, &stats, sizeof(stats)); }
+
+void display_reset_stats() { memset(&stats, 0, sizeof(stats)); }
+
+// ============================================
+// VISTA MULTI-TANQUE (una tarjeta por tanque)
+// ============================================
+#define TILE_COLS 2
+#define TILE_TOP (HEADER_H + 4)
+#define TILE_W (SCREEN_W / TILE_COLS)
+#define TILE_ROWS ((NUM_TANKS + TILE_COLS - 1) / TILE_COLS)
+#define TILE_H ((SCREEN_H - TILE_TOP) / TILE_ROWS)
+#define TILE_BAR_W 16
+
+static DisplayData tileCache[NUM_TANKS];
+static bool tileWifi = false;
+
+static bool tileChanged(const DisplayData *a, const DisplayData *b) {
+  return a->level != b->level || a->pumpState != b->pumpState ||
+         a->hasError != b->hasError ||
+         (a->pumpState != PUMP_OFF &&
+          a->pumpRunTime / 1000 != b->pumpRunTime / 1000) ||
+         a->cyclesCompleted != b->cyclesCompleted;
+}
+
+void drawTile(int index, const DisplayData *data) {
+  int x = (index % TILE_COLS) * TILE_W + 2;
+  int y = TILE_TOP + (index / TILE_COLS) * TILE_H + 2;
+  int w = TILE_W - 4;
+  int h = TILE_H - 4;
+
+  uint16_t frameColor = data->hasError ? COLOR_ERROR : COLOR_TEXT_DIM;
+  tft.fillRoundRect(x, y, w, h, 6, COLOR_BG);
+  tft.drawRoundRect(x, y, w, h, 6, frameColor);
+
+  // Barra de nivel
+  int barX = x + 6;
+  int barY = y + 6;
+  int barH = h - 12;
+  int waterH = barH * data->level / NUM_SENSORS;
+  tft.drawRect(barX - 1, barY - 1, TILE_BAR_W + 2, barH + 2, COLOR_TEXT_DIM);
+  if (waterH > 0) {
+    tft.fillRect(barX, barY + barH - waterH, TILE_BAR_W, waterH,
+                 waterColors[data->level - 1]);
+  }
+
+  // Nombre y nivel
+  int textX = barX + TILE_BAR_W + 8;
+  tft.setTextFont(2);
+  tft.setTextColor(COLOR_TEXT_DIM, COLOR_BG);
+  tft.setCursor(textX, y + 4);
+  tft.print("TANQUE ");
+  tft.print(index + 1);
+
+  tft.setTextColor(COLOR_TEXT, COLOR_BG);
+  tft.setCursor(textX, y + 22);
+  tft.print(data->level);
+  tft.print("/");
+  tft.print(NUM_SENSORS);
+
+  // Bomba
+  uint16_t pumpColor = COLOR_TEXT_DIM;
+  const char *pumpText = "APAGADA";
+  if (data->pumpState == PUMP_ON) {
+    pumpColor = COLOR_PUMP_ON;
+    pumpText = "ACTIVA";
+  } else if (data->pumpState == PUMP_EMERGENCY) {
+    pumpColor = COLOR_ERROR;
+    pumpText = "EMERG.";
+  }
+  tft.setTextColor(pumpColor, COLOR_BG);
+  tft.setCursor(textX, y + 40);
+  tft.print(pumpText);
+
+  if (data->pumpState != PUMP_OFF && h >= 76) {
+    unsigned long seconds = (unsigned long)(data->pumpRunTime / 1000);
+    unsigned long minutes = min(seconds / 60, 999UL); // Ancho de "ACTIVA"
+    char timeStr[16];
+    snprintf(timeStr, sizeof(timeStr), "%02lu:%02lu", minutes, seconds % 60);
+    tft.setTextColor(COLOR_TEXT, COLOR_BG);
+    tft.setCursor(textX, y + 58);
+    tft.print(timeStr);
+  }
+}
+
+void display_update_tiles(const DisplayData *tiles, int count) {
+  waitFrame();
+  takeRedrawRequest();
+  bool doFullRedraw = needsFullRedraw;
+  count = min(count, NUM_TANKS);
+
+  if (doFullRedraw) {
+    tft.fillScreen(COLOR_BG);
+    drawHeader(tiles[0].wifiConnected);
+    tileWifi = tiles[0].wifiConnected;
+    needsFullRedraw = false;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (doFullRedraw || tileChanged(&tiles[i], &tileCache[i])) {
+      drawTile(i, &tiles[i]);
+      memcpy(&tileCache[i], &tiles[i], sizeof(DisplayData));
+    }
+  }
+
+  if (tiles[0].wifiConnected != tileWifi) {
+    tileWifi = tiles[0].wifiConnected;
+    drawHeader(tileWifi);
+  }
 }
 
 void display_splash() {
+  waitFrame();
   tft.fillScreen(COLOR_HEADER);
 
   // Logo/Icono grande
@@ -398,7 +1430,24 @@ void display_splash() {
   tft.setTextDatum(TL_DATUM); // Volver a Top Left para el resto
 }
 
+void display_demo_banner() {
+  waitFrame();
+  tft.fillScreen(0x001F); // Fondo azul
+  tft.setTextDatum(MC_DATUM);
+  tft.setTextColor(0xFFFF, 0x001F);
+  tft.setTextFont(4);
+  tft.drawString("MODO DEMO", SCREEN_W / 2, 140);
+  tft.setTextFont(2);
+  tft.drawString("Simulacion activa", SCREEN_W / 2, 180);
+  tft.setTextDatum(TL_DATUM);
+}
+
 void display_error(const char *message) {
+  waitFrame();
+  if (page == PAGE_TREND) {
+    page = PAGE_MAIN;
+    trendExit();
+  }
   tft.fillScreen(COLOR_ERROR);
 
   tft.setTextFont(4);
@@ -411,4 +1460,6 @@ void display_error(const char *message) {
   tft.print(message);
 }
 
-void display_force_redraw() { needsFullRedraw = true; }
+void display_force_redraw() {
+  redrawRequested.store(true, std::memory_order_release);
+}
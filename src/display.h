@@ -9,29 +9,80 @@
 
 // Estructura para datos a mostrar
 struct DisplayData {
-  int level;                       // Nivel actual 0-7
+  int level;                       // Nivel actual 0-NUM_SENSORS
   PumpState pumpState;             // Estado de bomba
   bool hasError;                   // ¿Hay error?
   SequenceState sequenceState;     // Estado de secuencia
   int cyclesCompleted;             // Ciclos completados
-  unsigned long lastCycleDuration; // Duración último ciclo (ms)
-  unsigned long pumpRunTime;       // Tiempo bomba encendida
+  uint64_t lastCycleDuration;      // Duración último ciclo (ms)
+  uint64_t pumpRunTime;            // Tiempo bomba encendida (ms)
   bool wifiConnected;              // Estado WiFi
 };
 
+// Frames de display_update(): tráfico SPI (píxeles + apertura de
+// ventanas), tiempo hasta que el último byte llegó al TFT y tiempo de CPU
+// ocupado (composición, copias y armado de DMA)
+struct DisplayStats {
+  uint32_t updates;     // Llamadas a display_update()
+  uint32_t skipped;     // Llamadas con un frame aún en envío
+  uint32_t frames;      // Frames completados
+  uint32_t animFrames;  // De ellos, solo animación
+  uint32_t lastBytes;   // Bytes enviados en el último frame
+  uint32_t maxBytes;    // Máximo en un frame
+  uint64_t totalBytes;  // Total enviado
+  uint64_t directBytes; // Lo que habría costado borrar y redibujar directo
+  uint32_t lastFrameUs;
+  uint32_t maxFrameUs;
+  uint64_t totalFrameUs;
+  uint32_t lastCpuUs;
+  uint32_t maxCpuUs;
+  uint64_t totalCpuUs;
+};
+
+// Aviso de frame terminado (se llama desde display_poll())
+typedef void (*DisplayFrameCallback)(uint32_t frameUs, uint32_t cpuUs);
+
 // Inicializar display
 void display_init();
 
-// Actualizar toda la pantalla
+// Componer los cambios y empezar a enviarlos. Con DMA vuelve enseguida:
+// llamar display_poll() hasta que display_busy() sea false.
 void display_update(const DisplayData *data);
 
+// Avanzar ondas, aspas y gotas (llamar a DISPLAY_ANIM_FPS). Recompone y
+// envía solo las regiones animadas.
+void display_animate();
+
+// Avanzar el envío por DMA. Devuelve true si el frame sigue en curso.
+bool display_poll();
+
+// ¿Hay un frame enviándose?
+bool display_busy();
+
+// Registrar aviso de frame terminado
+void display_set_frame_callback(DisplayFrameCallback callback);
+
+// Alternar entre la vista principal y la tendencia de 24 h. Se puede
+// llamar desde otra tarea: se aplica en el próximo display_update().
+void display_toggle_page();
+
+// Vista multi-tanque: una tarjeta por tanque, redibuja solo las que cambian
+void display_update_tiles(const DisplayData *tiles, int count);
+
 // Mostrar pantalla de inicio
 void display_splash();
 
+// Mostrar el cartel de modo demo
+void display_demo_banner();
+
 // Mostrar error
 void display_error(const char *message);
 
 // Forzar redibujado completo
 void display_force_redraw();
 
+// Estadísticas de tráfico SPI
+void display_get_stats(DisplayStats *stats);
+void display_reset_stats();
+
 #endif // DISPLAY_H
@@ -0,0 +1,167 @@
+#include "edges.h"
+#include "clock.h"
+#include <atomic>
+#include <sys/time.h>
+
+#define EDGE_QUEUE_MASK (EDGE_QUEUE_SIZE - 1)
+#define MIN_EPOCH 1600000000UL // Antes de esto la hora no está puesta
+
+static_assert((EDGE_QUEUE_SIZE & EDGE_QUEUE_MASK) == 0,
+              "EDGE_QUEUE_SIZE debe ser potencia de 2");
+static_assert(EDGE_BATCH_EVENTS <= EDGE_QUEUE_SIZE,
+              "EDGE_BATCH_EVENTS no entra en la cola");
+
+struct Edge {
+  uint64_t timeMs;
+  EdgeType type;
+  uint8_t tank;
+  uint8_t value;
+};
+
+// Cola SPSC entre cores: la tarea de control solo escribe head y la de red
+// solo escribe tail. El release al publicar head hace visible el flanco
+// antes que el índice; el release de tail libera el lugar.
+static Edge queue[EDGE_QUEUE_SIZE];
+static std::atomic<uint32_t> head(0);
+static std::atomic<uint32_t> tail(0);
+static std::atomic<uint32_t> drops(0);
+static std::atomic<uint32_t> recorded(0);
+
+// Solo la tarea de red
+static uint32_t batchSeq = 0;
+static uint32_t reportedDrops = 0;
+static EdgeStats stats;
+
+// Pedido de edges_reset_stats() desde otra tarea
+static std::atomic<bool> statsResetPending(false);
+
+void edges_record(EdgeType type, int tank, int value, uint64_t timeMs) {
+  uint32_t h = head.load(std::memory_order_relaxed);
+  if (h - tail.load(std::memory_order_acquire) >= EDGE_QUEUE_SIZE) {
+    drops.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  Edge &edge = queue[h & EDGE_QUEUE_MASK];
+  edge.timeMs = timeMs;
+  edge.type = type;
+  edge.tank = (uint8_t)tank;
+  edge.value = (uint8_t)value;
+  head.store(h + 1, std::memory_order_release);
+  recorded.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t edges_pending() {
+  return head.load(std::memory_order_acquire) -
+         tail.load(std::memory_order_relaxed);
+}
+
+static size_t putVarint(uint8_t *out, uint64_t value) {
+  size_t n = 0;
+  do {
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    out[n++] = value > 0 ? byte | 0x80 : byte;
+  } while (value > 0);
+  return n;
+}
+
+static uint64_t epochMs() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  if (tv.tv_sec < (time_t)MIN_EPOCH) {
+    return 0;
+  }
+  return (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+// Codificar los primeros count flancos de la cola (ver formato en edges.h)
+static size_t encodeBatch(uint8_t *out, uint32_t first, uint32_t count,
+                          uint32_t lost, uint64_t now) {
+  uint64_t epoch = epochMs();
+  size_t n = 0;
+  out[n++] = EDGE_FORMAT_VERSION;
+  out[n++] = epoch != 0 ? EDGE_FLAG_EPOCH : 0;
+  n += putVarint(out + n, batchSeq);
+  n += putVarint(out + n, lost);
+  n += putVarint(out + n, now);
+  n += putVarint(out + n, epoch);
+  n += putVarint(out + n, queue[first & EDGE_QUEUE_MASK].timeMs);
+  n += putVarint(out + n, count);
+
+  uint64_t previous = queue[first & EDGE_QUEUE_MASK].timeMs;
+  for (uint32_t i = 0; i < count; i++) {
+    const Edge &edge = queue[(first + i) & EDGE_QUEUE_MASK];
+    // Los flancos se anotan en orden; por las dudas no codificar negativos
+    uint64_t delta = edge.timeMs > previous ? edge.timeMs - previous : 0;
+    n += putVarint(out + n, delta);
+    out[n++] = (uint8_t)((edge.type << 4) | (edge.tank & 0x0F));
+    out[n++] = edge.value;
+    previous = edge.timeMs > previous ? edge.timeMs : previous;
+  }
+  return n;
+}
+
+bool edges_flush(EdgeSender send) {
+  if (statsResetPending.load(std::memory_order_acquire)) {
+    memset(&stats, 0, sizeof(stats));
+    statsResetPending.store(false, std::memory_order_release);
+  }
+
+  uint32_t first = tail.load(std::memory_order_relaxed);
+  uint32_t pending = head.load(std::memory_order_acquire) - first;
+  if (pending == 0) {
+    return false;
+  }
+
+  uint64_t now = clock_ms();
+  uint64_t age = now - queue[first & EDGE_QUEUE_MASK].timeMs;
+  if (pending < EDGE_BATCH_EVENTS && age < EDGE_BATCH_MAX_AGE_MS) {
+    return false;
+  }
+
+  uint32_t count = min(pending, (uint32_t)EDGE_BATCH_EVENTS);
+  uint32_t dropped = drops.load(std::memory_order_relaxed);
+  static uint8_t batch[EDGE_BATCH_MAX_BYTES];
+  size_t length = encodeBatch(batch, first, count, dropped - reportedDrops,
+                              now);
+  if (!send(batch, length)) {
+    return false; // Sigue en cola; se vuelve a armar en la próxima llamada
+  }
+
+  tail.store(first + count, std::memory_order_release);
+  reportedDrops = dropped;
+  batchSeq++;
+  stats.batches++;
+  stats.bytes += length;
+  if (age > stats.maxAgeMs) {
+    stats.maxAgeMs = (uint32_t)age;
+  }
+  return true;
+}
+
+const char *edges_type_name(EdgeType type) {
+  switch (type) {
+  case EDGE_LEVEL:
+    return "level";
+  case EDGE_PUMP:
+    return "pump";
+  case EDGE_ERROR:
+    return "error";
+  case EDGE_ALARM:
+    return "alarm";
+  default:
+    return "unknown";
+  }
+}
+
+void edges_get_stats(EdgeStats *out) {
+  memcpy(out, &stats, sizeof(stats));
+  out->recorded = recorded.load(std::memory_order_relaxed);
+  out->dropped = drops.load(std::memory_order_relaxed);
+}
+
+// Se pide desde otra tarea: la de red lo aplica en el próximo edges_flush()
+void edges_reset_stats() {
+  statsResetPending.store(true, std::memory_order_release);
+}
@@ -0,0 +1,85 @@
+#ifndef EDGES_H
+#define EDGES_H
+
+#include "config.h"
+#include <Arduino.h>
+
+// ============================================
+// FLUJO DE FLANCOS CON TIMESTAMP
+// ============================================
+// Cada cambio de nivel filtrado, de relé de bomba, de error y de alarma se
+// anota con su clock_ms() en la tarea de control y sale por MQTT en lotes
+// binarios: cuando se juntan EDGE_BATCH_EVENTS o cuando el más viejo tiene
+// EDGE_BATCH_MAX_AGE_MS. Con esto se reconstruyen las curvas de llenado y
+// vaciado al milisegundo sin un mensaje por flanco.
+//
+// Control y red corren en cores distintos: la cola es SPSC sin locks. Si se
+// llena (broker caído un rato largo) se descartan los flancos nuevos y el
+// próximo lote lo avisa en el campo "perdidos".
+//
+// Formato del lote (versión EDGE_FORMAT_VERSION). Enteros sin signo en
+// varint LEB128 (7 bits por byte, el bit alto indica que sigue otro):
+//
+//   u8     versión
+//   u8     flags (EDGE_FLAG_*)
+//   varint nº de lote desde el arranque (0 = primer lote tras un reinicio)
+//   varint flancos perdidos antes de este lote
+//   varint clock_ms() al armar el lote
+//   varint hora UNIX en ms al armar el lote (0 sin hora)
+//   varint clock_ms() del primer flanco
+//   varint cantidad de flancos
+//   por flanco:
+//     varint ms desde el flanco anterior (0 en el primero)
+//     u8     tipo (4 bits altos) | tanque (4 bits bajos)
+//     u8     valor (según el tipo)
+//
+// La hora real de un flanco es hora_lote - (clock_lote - clock_flanco).
+// tools/edge_reader decodifica lotes y los imprime como CSV.
+
+#define EDGE_FORMAT_VERSION 1
+#define EDGE_FLAG_EPOCH 0x01 // La hora UNIX del lote es válida
+
+// Tamaño máximo de un lote codificado
+#define EDGE_HEADER_MAX_BYTES 48
+#define EDGE_EVENT_MAX_BYTES 7
+#define EDGE_BATCH_MAX_BYTES                                                   \
+  (EDGE_HEADER_MAX_BYTES + EDGE_BATCH_EVENTS * EDGE_EVENT_MAX_BYTES)
+
+enum EdgeType : uint8_t {
+  EDGE_LEVEL = 1, // Nivel filtrado (valor: 0-NUM_SENSORS)
+  EDGE_PUMP,      // Relé de bomba (valor: PumpState)
+  EDGE_ERROR,     // Error de secuencia (valor: 1 activo, 0 limpio)
+  EDGE_ALARM      // Patrón de la alarma compartida (valor: AlarmPattern)
+};
+
+// Envío de un lote ya codificado. Devuelve false si no salió (el lote se
+// vuelve a armar en la próxima llamada).
+typedef bool (*EdgeSender)(const uint8_t *batch, size_t length);
+
+struct EdgeStats {
+  uint32_t recorded; // Flancos anotados (desde el arranque)
+  uint32_t dropped;  // Descartados con la cola llena (desde el arranque)
+  uint32_t batches;  // Lotes enviados
+  uint32_t bytes;    // Bytes enviados
+  uint32_t maxAgeMs; // Mayor espera de un flanco hasta salir
+};
+
+// Anotar un flanco (solo la tarea de control). timeMs en la base de
+// clock_ms().
+void edges_record(EdgeType type, int tank, int value, uint64_t timeMs);
+
+// Flancos en cola
+uint32_t edges_pending();
+
+// Enviar un lote si hay EDGE_BATCH_EVENTS o el más viejo venció
+// (solo la tarea de red). Devuelve true si salió un lote.
+bool edges_flush(EdgeSender send);
+
+const char *edges_type_name(EdgeType type);
+
+// Reinicio de batches, bytes y maxAgeMs: se puede pedir desde otra tarea
+// y se aplica en el próximo edges_flush()
+void edges_get_stats(EdgeStats *out);
+void edges_reset_stats();
+
+#endif // EDGES_H
@@ -0,0 +1,540 @@
+#include "eventlog.h"
+#include "clock.h"
+#include <stddef.h>
+#include <time.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_partition.h>
+#endif
+
+// ============================================
+// FORMATO EN FLASH
+// ============================================
+// Cada sector: una cabecera y después registros de 32 bytes. La cabecera
+// lleva el número de secuencia del sector (el más alto es el que se está
+// escribiendo) y el id del primer registro. En los dos, el CRC se escribe
+// después de los datos que cubre, así una escritura cortada nunca queda
+// válida. El byte de confirmación queda fuera del CRC.
+//
+// Versión 2 ("EVL2"): uptime de 64 bits (antes 32, que daba la vuelta a los
+// 49 días). Los sectores "EVL1" no se reconocen y se borran al reusarlos.
+
+#define LOG_MAGIC 0x324C5645UL // "EVL2"
+#define RECORD_SIZE EVENT_RECORD_SIZE
+#define RECORD_CRC_LENGTH 29 // Bytes cubiertos por el CRC del registro
+#define ACK_OFFSET 29        // Byte de confirmación dentro del registro
+#define HEADER_CRC_LENGTH 8
+#define ACK_PENDING 0xFF
+#define CRC_UNWRITTEN 0xFFFF // Un CRC nunca vale esto
+#define MIN_EPOCH 1600000000UL // Antes de esto la hora no está puesta
+
+struct FlashRecord {
+  uint32_t id;
+  uint32_t epoch;
+  uint64_t uptimeMs;
+  uint32_t value;
+  uint16_t boot;
+  uint8_t type;
+  uint8_t tank;
+  uint8_t level;
+  uint8_t reserved[4];
+  uint8_t acked; // ACK_PENDING hasta el PUBACK; se programa sin borrar
+  uint16_t crc;  // CRC-16 de los campos anteriores a acked
+};
+
+struct SectorHeader {
+  uint32_t seq;
+  uint32_t firstId;
+  uint8_t reserved[18];
+  uint16_t crc;   // CRC-16 de seq y firstId
+  uint32_t magic; // Último en escribirse
+};
+
+static_assert(sizeof(FlashRecord) == RECORD_SIZE, "registro de 32 bytes");
+static_assert(offsetof(FlashRecord, acked) == ACK_OFFSET &&
+                  ACK_OFFSET == RECORD_CRC_LENGTH,
+              "el CRC cubre todo lo anterior a acked");
+static_assert(sizeof(SectorHeader) == RECORD_SIZE,
+              "la cabecera ocupa el slot 0");
+static_assert(EVENT_BATCH_SIZE >= 1 && EVENT_MAX_IN_FLIGHT >= 1,
+              "lote y ventana de al menos 1");
+
+enum SlotState { SLOT_EMPTY, SLOT_VALID, SLOT_TORN };
+
+// Posición de un registro. slot 0 es la cabecera.
+struct Pos {
+  uint32_t sector;
+  uint32_t slot;
+};
+
+// Lote enviado y todavía sin PUBACK
+struct InFlight {
+  uint16_t packetId;
+  Pos start; // Primer registro del lote
+  uint32_t firstId;
+  uint32_t lastId;
+  uint64_t sentAt;
+};
+
+static const FlashDevice *flash = nullptr;
+static uint32_t slotsPerSector = 0;
+static Pos head;    // Próximo slot a escribir
+static uint32_t headSeq = 0;
+static Pos tail;    // Primer registro sin confirmar (head si no hay)
+static Pos sendPos; // Próximo registro a enviar
+static uint32_t nextId = 1;
+static uint16_t boot = 0;
+static uint32_t pending = 0;
+static InFlight inFlight[EVENT_MAX_IN_FLIGHT];
+static int inFlightCount = 0;
+static uint16_t nextPacketId = 1;
+static EventLogStats stats;
+
+// CRC-16/CCITT. Nunca devuelve CRC_UNWRITTEN: un CRC todavía sin escribir
+// (cortado antes) no puede coincidir, y si llegó a escribirse es porque
+// todo lo anterior ya estaba completo.
+static uint16_t crc16(const void *data, size_t length) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  uint16_t crc = 0xFFFF;
+  while (length-- > 0) {
+    crc ^= (uint16_t)*bytes++ << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc == CRC_UNWRITTEN ? 0 : crc;
+}
+
+static uint32_t address(Pos pos) {
+  return pos.sector * flash->sectorSize + pos.slot * RECORD_SIZE;
+}
+
+// Al final de un sector lleno se sigue en el primer slot del siguiente
+static void normalize(Pos *pos) {
+  if (pos->slot >= slotsPerSector && pos->sector != head.sector) {
+    pos->sector = (pos->sector + 1) % flash->sectorCount;
+    pos->slot = 1;
+  }
+}
+
+static void advance(Pos *pos) {
+  pos->slot++;
+  normalize(pos);
+}
+
+static bool atHead(Pos pos) {
+  return pos.sector == head.sector && pos.slot >= head.slot;
+}
+
+static SlotState readSlot(Pos pos, FlashRecord *record) {
+  if (!flash->read(address(pos), record, RECORD_SIZE)) {
+    return SLOT_TORN;
+  }
+  const uint8_t *bytes = (const uint8_t *)record;
+  bool erased = true;
+  for (int i = 0; i < RECORD_SIZE && erased; i++) {
+    erased = bytes[i] == 0xFF;
+  }
+  if (erased) {
+    return SLOT_EMPTY;
+  }
+  return crc16(record, RECORD_CRC_LENGTH) == record->crc ? SLOT_VALID
+                                                          : SLOT_TORN;
+}
+
+static bool readHeader(uint32_t sector, SectorHeader *header) {
+  return flash->read(sector * flash->sectorSize, header, RECORD_SIZE) &&
+         header->magic == LOG_MAGIC &&
+         crc16(header, HEADER_CRC_LENGTH) == header->crc;
+}
+
+// Borrar un sector y dejarlo como cabeza con la secuencia seq
+static bool startSector(uint32_t sector, uint32_t seq) {
+  if (!flash->erase(sector)) {
+    Serial.printf("[EVENTLOG] Erase of sector %lu failed\n",
+                  (unsigned long)sector);
+    return false;
+  }
+  stats.erases++;
+
+  SectorHeader header;
+  memset(&header, 0xFF, sizeof(header));
+  header.seq = seq;
+  header.firstId = nextId;
+  header.crc = crc16(&header, HEADER_CRC_LENGTH);
+  header.magic = LOG_MAGIC;
+  if (!flash->write(sector * flash->sectorSize, &header, sizeof(header))) {
+    return false;
+  }
+
+  head.sector = sector;
+  head.slot = 1;
+  headSeq = seq;
+  return true;
+}
+
+static void resetInFlight() {
+  inFlightCount = 0;
+  sendPos = tail;
+}
+
+// Llevar tail al primer registro pendiente
+static void advanceTail() {
+  normalize(&tail);
+  while (!atHead(tail)) {
+    FlashRecord record;
+    if (readSlot(tail, &record) == SLOT_VALID &&
+        record.acked == ACK_PENDING) {
+      break;
+    }
+    advance(&tail);
+  }
+}
+
+// Cabeza llena: pasar al sector siguiente. Si es el más viejo y tiene
+// pendientes, se pierden.
+static bool nextSector() {
+  uint32_t next = (head.sector + 1) % flash->sectorCount;
+
+  normalize(&tail);
+  bool dropping = tail.sector == next;
+  if (dropping) {
+    uint32_t lost = 0;
+    for (Pos pos = tail; pos.slot < slotsPerSector; pos.slot++) {
+      FlashRecord record;
+      if (readSlot(pos, &record) == SLOT_VALID &&
+          record.acked == ACK_PENDING) {
+        lost++;
+      }
+    }
+    stats.dropped += lost;
+    pending -= lost;
+    Serial.printf("[EVENTLOG] Ring full: %lu pending events dropped\n",
+                  (unsigned long)lost);
+  }
+
+  if (!startSector(next, headSeq + 1)) {
+    return false;
+  }
+
+  if (dropping) {
+    // El más viejo pasa a ser el que seguía al borrado
+    tail.sector = (next + 1) % flash->sectorCount;
+    tail.slot = 1;
+    advanceTail();
+    resetInFlight();
+  }
+  return true;
+}
+
+bool eventlog_mount(const FlashDevice *device) {
+  flash = device;
+  slotsPerSector = device->sectorSize / RECORD_SIZE;
+  memset(&stats, 0, sizeof(stats));
+  inFlightCount = 0;
+  pending = 0;
+  nextId = 1;
+  boot = 1;
+
+  if (device->sectorCount < 2 || slotsPerSector < 2) {
+    Serial.println("[EVENTLOG] Flash too small");
+    flash = nullptr;
+    return false;
+  }
+
+  // La cabeza es el sector con la secuencia más alta
+  bool found = false;
+  SectorHeader header;
+  uint32_t headFirstId = 1;
+  for (uint32_t s = 0; s < device->sectorCount; s++) {
+    if (readHeader(s, &header) &&
+        (!found || (int32_t)(header.seq - headSeq) > 0)) {
+      found = true;
+      head.sector = s;
+      headSeq = header.seq;
+      headFirstId = header.firstId;
+    }
+  }
+
+  if (!found) {
+    if (!startSector(0, 1)) {
+      flash = nullptr;
+      return false;
+    }
+    tail = head;
+    sendPos = head;
+    Serial.println("[EVENTLOG] Formatted");
+    return true;
+  }
+
+  // Fin de lo escrito en la cabeza: después del último slot no vacío
+  uint32_t end = 1;
+  for (Pos pos = {head.sector, 1}; pos.slot < slotsPerSector; pos.slot++) {
+    FlashRecord record;
+    if (readSlot(pos, &record) != SLOT_EMPTY) {
+      end = pos.slot + 1;
+    }
+  }
+  head.slot = end;
+
+  // El más viejo: hacia atrás mientras las secuencias sean consecutivas
+  uint32_t oldest = head.sector;
+  uint32_t seq = headSeq;
+  for (uint32_t i = 1; i < device->sectorCount; i++) {
+    uint32_t prev = (oldest + device->sectorCount - 1) % device->sectorCount;
+    if (!readHeader(prev, &header) || header.seq != seq - 1) {
+      break;
+    }
+    oldest = prev;
+    seq--;
+  }
+
+  // Recorrer todo: último id y arranque, pendientes y registros rotos
+  uint32_t lastId = 0;
+  uint16_t lastBoot = 0;
+  bool tailFound = false;
+  Pos pos = {oldest, 1};
+  normalize(&pos);
+  while (!atHead(pos)) {
+    FlashRecord record;
+    SlotState state = readSlot(pos, &record);
+    if (state == SLOT_VALID) {
+      lastId = record.id;
+      lastBoot = record.boot;
+      if (record.acked == ACK_PENDING) {
+        pending++;
+        if (!tailFound) {
+          tail = pos;
+          tailFound = true;
+        }
+      }
+    } else if (state == SLOT_TORN) {
+      stats.torn++;
+    }
+    advance(&pos);
+  }
+  if (!tailFound) {
+    tail = head;
+  }
+  sendPos = tail;
+  nextId = max(lastId + 1, headFirstId);
+  boot = lastBoot + 1;
+
+  Serial.printf("[EVENTLOG] Mounted: %lu sectors, %lu pending, next id %lu, "
+                "boot %u, %lu torn\n",
+                (unsigned long)device->sectorCount, (unsigned long)pending,
+                (unsigned long)nextId, boot, (unsigned long)stats.torn);
+  return true;
+}
+
+#ifdef ESP_PLATFORM
+
+static const esp_partition_t *partition = nullptr;
+
+static bool partitionRead(uint32_t address, void *data, size_t length) {
+  return esp_partition_read(partition, address, data, length) == ESP_OK;
+}
+
+static bool partitionWrite(uint32_t address, const void *data, size_t length) {
+  return esp_partition_write(partition, address, data, length) == ESP_OK;
+}
+
+static bool partitionErase(uint32_t sector) {
+  return esp_partition_erase_range(partition, sector * SPI_FLASH_SEC_SIZE,
+                                   SPI_FLASH_SEC_SIZE) == ESP_OK;
+}
+
+bool eventlog_init() {
+  partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, EVENTLOG_PARTITION);
+  if (!partition) {
+    Serial.println("[EVENTLOG] Partition " EVENTLOG_PARTITION " not found");
+    return false;
+  }
+
+  static FlashDevice device;
+  device.sectorSize = SPI_FLASH_SEC_SIZE;
+  device.sectorCount = partition->size / SPI_FLASH_SEC_SIZE;
+  device.read = partitionRead;
+  device.write = partitionWrite;
+  device.erase = partitionErase;
+  return eventlog_mount(&device);
+}
+
+#else
+
+bool eventlog_init() {
+  Serial.println("[EVENTLOG] No flash partition on this platform");
+  return false;
+}
+
+#endif
+
+bool eventlog_append(EventType type, int tank, int level, uint32_t value) {
+  if (!flash) {
+    return false;
+  }
+  if (head.slot >= slotsPerSector && !nextSector()) {
+    return false;
+  }
+
+  FlashRecord record;
+  memset(&record, 0xFF, sizeof(record));
+  time_t now = time(nullptr);
+  record.id = nextId;
+  record.epoch = now >= (time_t)MIN_EPOCH ? (uint32_t)now : 0;
+  record.uptimeMs = clock_ms();
+  record.value = value;
+  record.boot = boot;
+  record.type = type;
+  record.tank = tank;
+  record.level = level;
+  record.crc = crc16(&record, RECORD_CRC_LENGTH);
+
+  // El slot se consume aunque falle: queda roto y se saltea
+  Pos at = head;
+  head.slot++;
+  nextId++;
+  if (!flash->write(address(at), &record, sizeof(record))) {
+    Serial.printf("[EVENTLOG] Write of event %lu failed\n",
+                  (unsigned long)record.id);
+    return false;
+  }
+
+  pending++;
+  stats.appended++;
+  return true;
+}
+
+uint32_t eventlog_pending() { return pending; }
+
+static void toEvent(const FlashRecord *record, LoggedEvent *event) {
+  event->id = record->id;
+  event->epoch = record->epoch;
+  event->uptimeMs = record->uptimeMs;
+  event->boot = record->boot;
+  event->type = (EventType)record->type;
+  event->tank = record->tank;
+  event->level = record->level;
+  event->value = record->value;
+}
+
+void eventlog_replay(EventSender send) {
+  if (!flash) {
+    return;
+  }
+  uint64_t now = clock_ms();
+
+  // Sin PUBACK del más viejo a tiempo: volver a enviar desde tail
+  if (inFlightCount > 0 &&
+      now - inFlight[0].sentAt >= EVENT_ACK_TIMEOUT_MS) {
+    Serial.printf("[EVENTLOG] No PUBACK for packet %u, resending %d "
+                  "batches\n",
+                  inFlight[0].packetId, inFlightCount);
+    stats.resent += inFlightCount;
+    resetInFlight();
+  }
+
+  while (inFlightCount < EVENT_MAX_IN_FLIGHT) {
+    LoggedEvent events[EVENT_BATCH_SIZE];
+    int count = 0;
+    Pos pos = sendPos;
+    normalize(&pos);
+    Pos start = pos;
+    while (count < EVENT_BATCH_SIZE && !atHead(pos)) {
+      FlashRecord record;
+      if (readSlot(pos, &record) == SLOT_VALID &&
+          record.acked == ACK_PENDING) {
+        if (count == 0) {
+          start = pos;
+        }
+        toEvent(&record, &events[count++]);
+      }
+      advance(&pos);
+    }
+    if (count == 0) {
+      sendPos = pos;
+      break;
+    }
+
+    uint16_t packetId = nextPacketId;
+    if (!send(packetId, events, count)) {
+      break; // Sigue desde el mismo lugar en la próxima llamada
+    }
+    nextPacketId = nextPacketId == 0xFFFF ? 1 : nextPacketId + 1;
+
+    InFlight *batch = &inFlight[inFlightCount++];
+    batch->packetId = packetId;
+    batch->start = start;
+    batch->firstId = events[0].id;
+    batch->lastId = events[count - 1].id;
+    batch->sentAt = now;
+    sendPos = pos;
+    stats.sent += count;
+  }
+}
+
+void eventlog_acked(uint16_t packetId) {
+  int index = -1;
+  for (int i = 0; i < inFlightCount; i++) {
+    if (inFlight[i].packetId == packetId) {
+      index = i;
+      break;
+    }
+  }
+  if (index < 0) {
+    return; // Tardío: el lote ya se reenvió con otro id
+  }
+
+  InFlight batch = inFlight[index];
+  for (int i = index + 1; i < inFlightCount; i++) {
+    inFlight[i - 1] = inFlight[i];
+  }
+  inFlightCount--;
+
+  // Marcar los registros del lote: todo lo pendiente entre firstId y
+  // lastId (lo que ya estaba confirmado no viajó). El id protege contra un
+  // sector que se borró y volvió a escribir con el lote en vuelo.
+  Pos pos = batch.start;
+  normalize(&pos);
+  while (!atHead(pos)) {
+    FlashRecord record;
+    if (readSlot(pos, &record) == SLOT_VALID) {
+      if (record.id > batch.lastId) {
+        break;
+      }
+      if (record.id >= batch.firstId && record.acked == ACK_PENDING) {
+        uint8_t mark = 0;
+        flash->write(address(pos) + ACK_OFFSET, &mark, 1);
+        pending--;
+        stats.acked++;
+      }
+    }
+    advance(&pos);
+  }
+
+  advanceTail();
+}
+
+void eventlog_link_down() {
+  if (flash) {
+    resetInFlight();
+  }
+}
+
+const char *eventlog_type_name(EventType type) {
+  switch (type) {
+  case EVENT_CYCLE:
+    return "cycle";
+  case EVENT_ERROR:
+    return "error";
+  case EVENT_EMERGENCY:
+    return "emergency";
+  default:
+    return "unknown";
+  }
+}
+
+void eventlog_get_stats(EventLogStats *out) {
+  memcpy(out, &stats, sizeof(stats));
+}
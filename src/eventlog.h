@@ -0,0 +1,89 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include "config.h"
+#include "flash.h"
+#include <Arduino.h>
+
+// ============================================
+// REGISTRO DE EVENTOS EN FLASH (STORE-AND-FORWARD)
+// ============================================
+// Ciclos completos, errores y emergencias se escriben en un anillo de
+// sectores de flash antes de publicarse, así sobreviven a cortes de red y
+// de energía. Al haber broker se reenvían en lotes de EVENT_BATCH_SIZE,
+// cada lote un PUBLISH QoS1, con a lo sumo EVENT_MAX_IN_FLIGHT lotes sin
+// PUBACK. Cada PUBACK marca sus registros como confirmados en la misma
+// flash (se programa un byte, sin borrar). Entrega al menos una vez: el
+// consumidor descarta repetidos por id.
+//
+// Desgaste: se escribe siempre en el sector siguiente y se borra uno
+// recién al llenarse el anterior, así todos rotan por igual. Con el
+// anillo lleno de pendientes se pierde el sector más viejo.
+//
+// Cortes de energía: cada registro lleva CRC; uno a medio escribir se
+// descarta al montar y la escritura sigue después de él. Un sector borrado
+// sin cabecera válida no cuenta y se vuelve a borrar al usarlo.
+
+// Bytes de cada registro en flash (la cabecera del sector ocupa uno)
+#define EVENT_RECORD_SIZE 32
+
+enum EventType : uint8_t {
+  EVENT_CYCLE = 1, // Ciclo completo (value: duración en ms)
+  EVENT_ERROR,     // Error de secuencia de boyas (value: SequenceState)
+  EVENT_EMERGENCY  // Bomba en modo emergencia (value: 0)
+};
+
+struct LoggedEvent {
+  uint32_t id;       // Creciente, único en la vida del registro
+  uint32_t epoch;    // Hora UNIX en s (0 si todavía no había hora)
+  uint64_t uptimeMs; // clock_ms() al ocurrir
+  uint16_t boot;     // Nº de arranque (para ordenar uptimes)
+  EventType type;
+  uint8_t tank;
+  uint8_t level;
+  uint32_t value; // Según el tipo
+};
+
+// Envío de un lote como PUBLISH QoS1 con ese packet id. Devuelve false si
+// no se pudo escribir (se reintenta en la próxima llamada).
+typedef bool (*EventSender)(uint16_t packetId, const LoggedEvent *events,
+                            int count);
+
+struct EventLogStats {
+  uint32_t appended; // Eventos escritos
+  uint32_t sent;     // Eventos enviados (con reenvíos)
+  uint32_t acked;    // Eventos confirmados por PUBACK
+  uint32_t resent;   // Lotes reenviados por falta de PUBACK
+  uint32_t dropped;  // Pendientes perdidos con el anillo lleno
+  uint32_t torn;     // Registros a medio escribir encontrados al montar
+  uint32_t erases;   // Sectores borrados
+};
+
+// Montar sobre la partición EVENTLOG_PARTITION (solo en el ESP32)
+bool eventlog_init();
+
+// Montar sobre un dispositivo: busca la cabecera más nueva, descarta
+// registros rotos y ubica el primer pendiente
+bool eventlog_mount(const FlashDevice *flash);
+
+// Agregar un evento (se escribe en el acto)
+bool eventlog_append(EventType type, int tank, int level, uint32_t value);
+
+// Eventos escritos y todavía sin confirmar
+uint32_t eventlog_pending();
+
+// Enviar lotes mientras haya ventana libre y reenviar los vencidos
+// (EVENT_ACK_TIMEOUT_MS). Llamar seguido con el broker conectado.
+void eventlog_replay(EventSender send);
+
+// PUBACK recibido para packetId
+void eventlog_acked(uint16_t packetId);
+
+// Se cayó la conexión: lo que estaba en vuelo se vuelve a enviar
+void eventlog_link_down();
+
+const char *eventlog_type_name(EventType type);
+
+void eventlog_get_stats(EventLogStats *out);
+
+#endif // EVENTLOG_H
@@ -0,0 +1,197 @@
+#include "expander.h"
+#include "clock.h"
+#include <Wire.h>
+
+#if MULTI_TANK_ENABLED
+
+static_assert(NUM_TANKS >= 1 && NUM_TANKS <= 8,
+              "NUM_TANKS: 1-8 expansores (0x20-0x27)");
+
+#if EXPANDER_TYPE == EXPANDER_MCP23017
+static_assert(NUM_SENSORS <= 15, "MCP23017: hasta 15 boyas + relé");
+
+// Registros MCP23017 (IOCON.BANK = 0, direcciones secuenciales)
+#define MCP_IODIRA 0x00
+#define MCP_GPPUA 0x0C
+#define MCP_GPIOA 0x12
+#define MCP_OLATB 0x15
+
+#define EXPANDER_RELAY_BIT 15
+typedef uint16_t ExpanderWord;
+#elif EXPANDER_TYPE == EXPANDER_PCF8574
+static_assert(NUM_SENSORS <= 7, "PCF8574: hasta 7 boyas + relé");
+
+#define EXPANDER_RELAY_BIT 7
+typedef uint8_t ExpanderWord;
+#else
+#error "EXPANDER_TYPE desconocido"
+#endif
+
+#define EXPANDER_FLOAT_MASK ((ExpanderWord)tank::kFullMask)
+
+static uint8_t relayState = 0; // Bit n = relé del tanque n
+static uint8_t relayDirty = 0; // Relés pendientes de escribir
+static ExpanderStats stats;
+
+static uint8_t addressOf(int tank) { return EXPANDER_BASE_ADDR + tank; }
+
+#if EXPANDER_TYPE == EXPANDER_MCP23017
+
+static bool writeRegisterPair(uint8_t addr, uint8_t reg, uint16_t value) {
+  Wire.beginTransmission(addr);
+  Wire.write(reg);
+  Wire.write((uint8_t)(value & 0xFF)); // Puerto A
+  Wire.write((uint8_t)(value >> 8));   // Puerto B
+  return Wire.endTransmission() == 0;
+}
+
+static bool configureChip(int tank) {
+  uint8_t addr = addressOf(tank);
+  // Boyas como entrada con pull-up, relé como salida (apagado)
+  uint16_t iodir = (uint16_t) ~(1U << EXPANDER_RELAY_BIT);
+  return writeRegisterPair(addr, MCP_IODIRA, iodir) &&
+         writeRegisterPair(addr, MCP_GPPUA, EXPANDER_FLOAT_MASK);
+}
+
+// GPIOA y GPIOB en una sola lectura secuencial
+static bool readChip(int tank, ExpanderWord *value) {
+  uint8_t addr = addressOf(tank);
+  Wire.beginTransmission(addr);
+  Wire.write(MCP_GPIOA);
+  if (Wire.endTransmission(false) != 0 || Wire.requestFrom(addr, (uint8_t)2) != 2) {
+    return false;
+  }
+  uint8_t portA = Wire.read();
+  uint8_t portB = Wire.read();
+  *value = (ExpanderWord)(portA | (portB << 8));
+  return true;
+}
+
+static bool writeRelay(int tank, bool on) {
+  Wire.beginTransmission(addressOf(tank));
+  Wire.write(MCP_OLATB);
+  Wire.write(on ? (1 << (EXPANDER_RELAY_BIT - 8)) : 0);
+  return Wire.endTransmission() == 0;
+}
+
+#else // EXPANDER_PCF8574
+
+// PCF8574 cuasi-bidireccional: las entradas se escriben en 1
+static bool writeRelay(int tank, bool on) {
+  uint8_t value = (uint8_t)(EXPANDER_FLOAT_MASK |
+                            (on ? (1 << EXPANDER_RELAY_BIT) : 0));
+  Wire.beginTransmission(addressOf(tank));
+  Wire.write(value);
+  return Wire.endTransmission() == 0;
+}
+
+static bool configureChip(int tank) { return writeRelay(tank, false); }
+
+static bool readChip(int tank, ExpanderWord *value) {
+  if (Wire.requestFrom(addressOf(tank), (uint8_t)1) != 1) {
+    return false;
+  }
+  *value = (ExpanderWord)Wire.read();
+  return true;
+}
+
+#endif
+
+bool expander_init() {
+  Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN, I2C_FREQUENCY);
+  memset(&stats, 0, sizeof(stats));
+  relayState = 0;
+  relayDirty = 0;
+
+  bool ok = true;
+  for (int i = 0; i < NUM_TANKS; i++) {
+    if (!configureChip(i)) {
+      Serial.printf("[EXPANDER] No responde 0x%02X (tanque %d)\n",
+                    addressOf(i), i);
+      stats.busErrors++;
+      ok = false;
+    }
+  }
+
+  Serial.printf("[EXPANDER] %d tanques en I2C (SDA %d, SCL %d, %lu Hz)\n",
+                NUM_TANKS, I2C_SDA_PIN, I2C_SCL_PIN,
+                (unsigned long)I2C_FREQUENCY);
+  return ok;
+}
+
+void expander_read_all(tank::SensorMask inputs[NUM_TANKS]) {
+  uint64_t start = clock_us();
+
+  for (int i = 0; i < NUM_TANKS; i++) {
+    ExpanderWord value;
+    if (readChip(i, &value)) {
+      // Contacto a GND: 0 = boya activa
+      inputs[i] = (tank::SensorMask)(~value & EXPANDER_FLOAT_MASK);
+    } else {
+      stats.busErrors++; // Se conserva la lectura anterior
+    }
+  }
+
+  stats.lastReadUs = (uint32_t)(clock_us() - start);
+  if (stats.lastReadUs > stats.maxReadUs) {
+    stats.maxReadUs = stats.lastReadUs;
+  }
+}
+
+void expander_set_relay(int tank, bool on) {
+  if (tank < 0 || tank >= NUM_TANKS) {
+    return;
+  }
+  uint8_t bit = 1 << tank;
+  if (((relayState & bit) != 0) != on) {
+    relayState ^= bit;
+    relayDirty |= bit;
+  }
+}
+
+void expander_flush() {
+  if (!relayDirty) {
+    return;
+  }
+
+  uint64_t start = clock_us();
+  uint8_t pending = relayDirty;
+  relayDirty = 0;
+
+  while (pending) {
+    int tank = __builtin_ctz(pending);
+    if (!writeRelay(tank, relayState & (1 << tank))) {
+      stats.busErrors++;
+      relayDirty |= 1 << tank; // Reintentar en el próximo ciclo
+    }
+    pending &= pending - 1;
+  }
+
+  stats.lastWriteUs = (uint32_t)(clock_us() - start);
+  if (stats.lastWriteUs > stats.maxWriteUs) {
+    stats.maxWriteUs = stats.lastWriteUs;
+  }
+}
+
+void expander_get_stats(ExpanderStats *out) {
+  memcpy(out, &stats, sizeof(ExpanderStats));
+}
+
+void expander_reset_stats() { memset(&stats, 0, sizeof(stats)); }
+
+#else
+
+// Stubs cuando el modo multi-tanque está deshabilitado
+bool expander_init() { return false; }
+void expander_read_all(tank::SensorMask inputs[NUM_TANKS]) { (void)inputs; }
+void expander_set_relay(int tank, bool on) {
+  (void)tank;
+  (void)on;
+}
+void expander_flush() {}
+void expander_get_stats(ExpanderStats *out) {
+  memset(out, 0, sizeof(ExpanderStats));
+}
+void expander_reset_stats() {}
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef EXPANDER_H
+#define EXPANDER_H
+
+#include "config.h"
+#include "tank_geometry.h"
+#include <Arduino.h>
+
+// Tiempos del bus I2C por ciclo (µs)
+struct ExpanderStats {
+  uint32_t lastReadUs;  // Lectura de todos los expansores (último ciclo)
+  uint32_t maxReadUs;   // Lectura de todos los expansores (máximo)
+  uint32_t lastWriteUs; // Escritura de relés cambiados (último ciclo)
+  uint32_t maxWriteUs;  // Escritura de relés cambiados (máximo)
+  uint32_t busErrors;   // Transacciones sin ACK / lecturas incompletas
+};
+
+// Inicializar bus I2C y configurar un expansor por tanque
+bool expander_init();
+
+// Leer las boyas de todos los tanques en una pasada: una transacción por
+// chip, todas seguidas al inicio del ciclo. inputs[n] = máscara del tanque n
+// (1 = boya activa).
+void expander_read_all(tank::SensorMask inputs[NUM_TANKS]);
+
+// Marcar el relé de un tanque (compatible con PumpRelayWriter). No toca el
+// bus: se escribe en expander_flush().
+void expander_set_relay(int tank, bool on);
+
+// Escribir los relés que cambiaron desde el último flush
+void expander_flush();
+
+// Obtener / reiniciar tiempos del bus
+void expander_get_stats(ExpanderStats *stats);
+void expander_reset_stats();
+
+#endif // EXPANDER_H
@@ -0,0 +1,77 @@
+#ifndef FIXED_TRIG_H
+#define FIXED_TRIG_H
+
+#include <stdint.h>
+
+// ============================================
+// SENO EN PUNTO FIJO (TABLA EN TIEMPO DE COMPILACIÓN)
+// ============================================
+// Las animaciones usan fases enteras (kSinSteps pasos por vuelta) y una
+// tabla Q14 generada por el compilador. En ejecución no hay float ni
+// llamadas a sin()/cos(): un acceso a la tabla, una multiplicación y un
+// corrimiento.
+
+namespace trig {
+
+constexpr int kSinSteps = 64; // Pasos por vuelta (potencia de 2)
+constexpr int kSinShift = 14; // Q14: 1.0 = 16384
+constexpr double kPi = 3.14159265358979323846;
+
+static_assert((kSinSteps & (kSinSteps - 1)) == 0,
+              "kSinSteps debe ser potencia de 2");
+
+// Serie de Taylor de sin(x) para x en [-pi, pi] (error < 1e-9)
+constexpr double taylorSin(double x) {
+  double term = x;
+  double sum = x;
+  for (int n = 1; n < 12; n++) {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+struct SinTable {
+  int16_t value[kSinSteps];
+};
+
+constexpr SinTable buildSinTable() {
+  SinTable table = {};
+  for (int i = 0; i < kSinSteps; i++) {
+    double x = 2 * kPi * i / kSinSteps;
+    if (x > kPi) {
+      x -= 2 * kPi;
+    }
+    double scaled = taylorSin(x) * (1 << kSinShift);
+    table.value[i] = (int16_t)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+  }
+  return table;
+}
+
+constexpr SinTable kSin = buildSinTable();
+
+static_assert(kSin.value[0] == 0, "tabla de seno");
+static_assert(kSin.value[kSinSteps / 4] == (1 << kSinShift), "tabla de seno");
+static_assert(kSin.value[kSinSteps / 2] == 0, "tabla de seno");
+static_assert(kSin.value[3 * kSinSteps / 4] == -(1 << kSinShift),
+              "tabla de seno");
+
+// amplitude * sin(phase), phase en pasos (se toma módulo kSinSteps)
+constexpr int sinScaled(int phase, int amplitude) {
+  return (kSin.value[phase & (kSinSteps - 1)] * amplitude +
+          (1 << (kSinShift - 1))) >>
+         kSinShift;
+}
+
+constexpr int cosScaled(int phase, int amplitude) {
+  return sinScaled(phase + kSinSteps / 4, amplitude);
+}
+
+// Fase (en pasos) de un movimiento periódico de periodMs en el instante tMs
+constexpr int phaseAt(uint64_t tMs, uint32_t periodMs) {
+  return (int)((tMs % periodMs) * kSinSteps / periodMs);
+}
+
+} // namespace trig
+
+#endif // FIXED_TRIG_H
@@ -0,0 +1,18 @@
+#ifndef FLASH_H
+#define FLASH_H
+
+#include <Arduino.h>
+
+// Dispositivo de flash para los registros en particiones propias
+// (eventlog.h, cyclelog.h): NOR, programar solo baja bits y borrar por
+// sector los deja en 0xFF. En el ESP32 es una partición; en el host, una
+// simulación.
+struct FlashDevice {
+  uint32_t sectorSize;
+  uint32_t sectorCount;
+  bool (*read)(uint32_t address, void *data, size_t length);
+  bool (*write)(uint32_t address, const void *data, size_t length);
+  bool (*erase)(uint32_t sector);
+};
+
+#endif // FLASH_H
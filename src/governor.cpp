@@ -0,0 +1,156 @@
+#include "governor.h"
+#include "clock.h"
+#include <atomic>
+
+static const char *const modeNames[UI_MODE_COUNT] = {"active", "idle", "dim",
+                                                     "blank"};
+static const uint8_t modeDuty[UI_MODE_COUNT] = {BACKLIGHT_FULL, BACKLIGHT_FULL,
+                                                BACKLIGHT_DIM, 0};
+
+// Lo que cuenta como actividad, por tanque
+struct TankActivity {
+  int level;
+  PumpState pumpState;
+  SystemState systemState;
+  bool sequenceError;
+};
+
+// Solo la tarea de display escribe el modo y el backlight; otras tareas
+// leen el modo y piden despertar con wakeRequested
+static std::atomic<UiMode> mode(UI_ACTIVE);
+static std::atomic<bool> wakeRequested(false);
+static TankActivity last[TANK_COUNT];
+static bool haveLast = false;
+static uint64_t lastActivity = 0;
+static uint64_t lastRefresh = 0;
+static uint64_t lastUpdate = 0;
+static GovernorStats stats;
+
+static void setBacklight(uint8_t duty) {
+  ledcWrite(BACKLIGHT_PWM_CHANNEL, duty);
+}
+
+void governor_init() {
+  ledcSetup(BACKLIGHT_PWM_CHANNEL, BACKLIGHT_PWM_FREQ, 8);
+  ledcAttachPin(BACKLIGHT_PIN, BACKLIGHT_PWM_CHANNEL);
+  setBacklight(BACKLIGHT_FULL);
+
+  mode.store(UI_ACTIVE, std::memory_order_relaxed);
+  haveLast = false;
+  lastActivity = clock_ms();
+  lastUpdate = lastActivity;
+  memset(&stats, 0, sizeof(stats));
+}
+
+// ¿Cambió algo que merezca despertar la pantalla?
+static bool detectActivity(const ControlSnapshot *snapshot, bool *busy) {
+  bool changed = !haveLast;
+  *busy = false;
+
+  for (int i = 0; i < TANK_COUNT; i++) {
+    const TankSnapshot *tank = &snapshot->tanks[i];
+    TankActivity *prev = &last[i];
+
+    changed |= tank->level != prev->level ||
+               tank->pumpState != prev->pumpState ||
+               tank->systemState != prev->systemState ||
+               tank->sequenceError != prev->sequenceError;
+    // El llenado dura casi todo el ciclo: cuenta solo por sus cambios de
+    // nivel y deja atenuar. Bomba en marcha o error mantienen la pantalla.
+    *busy |= tank->pumpState != PUMP_OFF ||
+             tank->systemState == STATE_ERROR || tank->sequenceError;
+
+    prev->level = tank->level;
+    prev->pumpState = tank->pumpState;
+    prev->systemState = tank->systemState;
+    prev->sequenceError = tank->sequenceError;
+  }
+
+  haveLast = true;
+  return changed;
+}
+
+bool governor_update(const ControlSnapshot *snapshot) {
+  uint64_t now = clock_ms();
+  UiMode current = mode.load(std::memory_order_relaxed);
+  stats.modeMs[current] += now - lastUpdate;
+  lastUpdate = now;
+
+  bool busy;
+  bool event = detectActivity(snapshot, &busy);
+  if (wakeRequested.exchange(false, std::memory_order_acquire)) {
+    event = true;
+  }
+  if (event || busy) {
+    lastActivity = now;
+  }
+
+  UiMode next;
+  uint64_t quietMs = now - lastActivity;
+  if (busy) {
+    next = UI_ACTIVE;
+  } else if (quietMs < BACKLIGHT_DIM_AFTER_MS) {
+    next = UI_IDLE;
+  } else if (quietMs < BACKLIGHT_OFF_AFTER_MS) {
+    next = UI_DIM;
+  } else {
+    next = UI_BLANK;
+  }
+
+  if (next != current) {
+    Serial.printf("[GOVERNOR] %s -> %s\n", modeNames[current],
+                  modeNames[next]);
+    if (current >= UI_DIM && next < UI_DIM) {
+      stats.wakeups++;
+    }
+    if (modeDuty[next] != modeDuty[current]) {
+      setBacklight(modeDuty[next]);
+    }
+    mode.store(next, std::memory_order_relaxed);
+  }
+
+  // Refresco: siempre con actividad, lento en reposo, nunca apagada
+  bool refresh;
+  switch (next) {
+  case UI_ACTIVE:
+    refresh = true;
+    break;
+  case UI_BLANK:
+    refresh = false;
+    break;
+  default:
+    refresh = event || now - lastRefresh >= DISPLAY_IDLE_INTERVAL_MS;
+    break;
+  }
+
+  if (refresh) {
+    lastRefresh = now;
+  }
+  return refresh;
+}
+
+// El backlight lo enciende governor_update() en la tarea de display: un
+// ledcWrite() desde el control competiría con el de esa tarea
+bool governor_wake() {
+  wakeRequested.store(true, std::memory_order_release);
+  return mode.load(std::memory_order_relaxed) >= UI_DIM;
+}
+
+UiMode governor_mode() { return mode.load(std::memory_order_relaxed); }
+
+uint32_t governor_anim_period() {
+  switch (governor_mode()) {
+  case UI_ACTIVE:
+    return 1000 / DISPLAY_ANIM_FPS;
+  case UI_IDLE:
+    return 1000 / DISPLAY_IDLE_ANIM_FPS;
+  default:
+    return 0;
+  }
+}
+
+void governor_get_stats(GovernorStats *out) {
+  memcpy(out, &stats, sizeof(stats));
+}
+
+void governor_reset_stats() { memset(&stats, 0, sizeof(stats)); }
@@ -0,0 +1,54 @@
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include "config.h"
+#include "snapshot.h"
+#include <Arduino.h>
+
+// ============================================
+// GOBERNADOR DE REFRESCO Y BACKLIGHT
+// ============================================
+// Decide cuándo redibujar según el estado de los tanques: en cada tick
+// con bomba o error; cada DISPLAY_IDLE_INTERVAL_MS en reposo o llenando.
+// Sin actividad atenúa y luego apaga el backlight (y deja de dibujar); un
+// tanque que se llena solo cuenta como actividad al cambiar de nivel.
+// Un cambio de nivel, bomba, estado o error, o el botón, lo despierta.
+
+enum UiMode {
+  UI_ACTIVE, // Bombeando o en error: refresco rápido
+  UI_IDLE,   // Reposo o llenado sin cambios recientes: refresco lento
+  UI_DIM,    // Reposo prolongado: backlight atenuado
+  UI_BLANK   // Backlight apagado: no se dibuja
+};
+
+#define UI_MODE_COUNT 4
+
+// Tiempo en cada modo desde el último governor_reset_stats()
+struct GovernorStats {
+  uint64_t modeMs[UI_MODE_COUNT];
+  uint32_t wakeups; // Salidas de UI_DIM / UI_BLANK
+};
+
+// Configurar el PWM del backlight (encendido al máximo)
+void governor_init();
+
+// Evaluar la foto (tarea de display, en cada tick). Devuelve true si hay
+// que llamar a display_update() ahora.
+bool governor_update(const ControlSnapshot *snapshot);
+
+// Actividad del usuario (botón). Se puede llamar desde otra tarea: el
+// backlight se enciende en el próximo governor_update(). Devuelve true si
+// la pantalla estaba atenuada o apagada.
+bool governor_wake();
+
+// Modo actual
+UiMode governor_mode();
+
+// Período de las animaciones en ms (0 = en pausa)
+uint32_t governor_anim_period();
+
+// Estadísticas de tiempo por modo
+void governor_get_stats(GovernorStats *stats);
+void governor_reset_stats();
+
+#endif // GOVERNOR_H
@@ -0,0 +1,62 @@
+#include "history.h"
+
+// Nivel 0..NUM_SENSORS: 4 bits hasta 15 boyas, 5 bits con 16 o más
+#define LEVEL_BITS (NUM_SENSORS >= 16 ? 5 : 4)
+#define SAMPLE_BITS (LEVEL_BITS + 2)
+#define LEVEL_MASK ((1 << LEVEL_BITS) - 1)
+#define PUMP_SHIFT LEVEL_BITS
+#define SAMPLE_MASK ((1 << SAMPLE_BITS) - 1)
+
+static_assert(NUM_SENSORS <= LEVEL_MASK, "el nivel no entra en LEVEL_BITS");
+static_assert(PUMP_EMERGENCY <= (SAMPLE_MASK >> PUMP_SHIFT),
+              "el estado de bomba no entra en 2 bits");
+
+// +1: una muestra puede cruzar al byte siguiente
+static uint8_t packed[(HISTORY_SAMPLES * SAMPLE_BITS + 7) / 8 + 1];
+static uint32_t total = 0;
+
+// Leer/escribir los SAMPLE_BITS de la posición slot (pueden ocupar dos bytes)
+static uint8_t readSlot(uint32_t slot) {
+  uint32_t bit = slot * SAMPLE_BITS;
+  uint16_t window = packed[bit / 8] | (packed[bit / 8 + 1] << 8);
+  return (window >> (bit % 8)) & SAMPLE_MASK;
+}
+
+static void writeSlot(uint32_t slot, uint8_t value) {
+  uint32_t bit = slot * SAMPLE_BITS;
+  uint16_t window = packed[bit / 8] | (packed[bit / 8 + 1] << 8);
+  window &= ~(SAMPLE_MASK << (bit % 8));
+  window |= value << (bit % 8);
+  packed[bit / 8] = window & 0xFF;
+  packed[bit / 8 + 1] = window >> 8;
+}
+
+void history_init() {
+  memset(packed, 0, sizeof(packed));
+  total = 0;
+  Serial.printf("[HISTORY] %d samples every %d ms (%u bytes)\n",
+                HISTORY_SAMPLES, HISTORY_SAMPLE_INTERVAL_MS,
+                (unsigned)sizeof(packed));
+}
+
+void history_add(int level, PumpState pumpState) {
+  uint8_t value = (constrain(level, 0, NUM_SENSORS) & LEVEL_MASK) |
+                  (pumpState << PUMP_SHIFT);
+  writeSlot(total % HISTORY_SAMPLES, value);
+  total++;
+}
+
+uint32_t history_total() { return total; }
+
+uint32_t history_count() { return min(total, (uint32_t)HISTORY_SAMPLES); }
+
+bool history_get(uint32_t index, HistorySample *out) {
+  if (index >= total || total - index > HISTORY_SAMPLES) {
+    return false;
+  }
+
+  uint8_t value = readSlot(index % HISTORY_SAMPLES);
+  out->level = value & LEVEL_MASK;
+  out->pumpState = (PumpState)(value >> PUMP_SHIFT);
+  return true;
+}
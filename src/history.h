@@ -0,0 +1,38 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "config.h"
+#include "pump.h"
+#include <Arduino.h>
+
+// ============================================
+// HISTORIAL DE NIVEL Y BOMBA
+// ============================================
+// Una muestra cada HISTORY_SAMPLE_INTERVAL_MS en un anillo de tamaño fijo
+// (HISTORY_SAMPLES). Cada muestra ocupa 6 bits empaquetados: 4 de nivel y
+// 2 de estado de bomba (7 bits, con 5 de nivel, si NUM_SENSORS >= 16).
+// 24 h a 10 s = 8640 muestras = 6480 bytes (7560 con 16 boyas).
+// Sin locks: escribe y lee la misma tarea (display).
+
+struct HistorySample {
+  uint8_t level;       // 0-NUM_SENSORS
+  PumpState pumpState; // Estado de la bomba al tomar la muestra
+};
+
+// Vaciar el historial
+void history_init();
+
+// Agregar una muestra (pisa la más vieja con el anillo lleno)
+void history_add(int level, PumpState pumpState);
+
+// Muestras agregadas desde el arranque. La última es history_total() - 1.
+uint32_t history_total();
+
+// Muestras disponibles (como mucho HISTORY_SAMPLES)
+uint32_t history_count();
+
+// Leer la muestra de índice absoluto index. Devuelve false si no está
+// (todavía no se tomó o ya se pisó).
+bool history_get(uint32_t index, HistorySample *out);
+
+#endif // HISTORY_H
@@ -6,7 +6,7 @@
  *
  * Hardware:
  * - ESP32-WROOM-32
- * - 7 sensores de boya magnética (NA)
+ * - 7 sensores de boya magnética (NA), configurable con NUM_SENSORS
  * - Display TFT ILI9341 2.4"
  * - Bomba 12V tipo "sapito"
  * - Buzzer activo 5V
@@ -16,296 +16,1006 @@
  */
 
 #include "alarm.h"
+#include "clock.h"
 #include "config.h"
+#include "cyclelog.h"
 #include "display.h"
+#include "edges.h"
+#include "expander.h"
+#include "governor.h"
+#include "history.h"
+#include "eventlog.h"
 #include "mqtt.h"
+#include "profiler.h"
 #include "pump.h"
+#include "pumpstats.h"
+#include "scheduler.h"
 #include "sensors.h"
+#include "snapshot.h"
+#include "tank.h"
+#include "warmstart.h"
 #include <Arduino.h>
-#include <TFT_eSPI.h>
-
-extern TFT_eSPI tft; // Declarado en display.cpp
-
-// Estados de la máquina de estados principal
-enum SystemState {
-  STATE_INIT,    // Inicialización
-  STATE_IDLE,    // Esperando llenado
-  STATE_FILLING, // Llenándose
-  STATE_PUMPING, // Bomba activa (vaciando)
-  STATE_ERROR    // Error de secuencia
-};
+#include <atomic>
+#if SCHED_LIGHT_SLEEP
+#include <esp_pm.h>
+#endif
 
 // Variables globales de estado
-SystemState systemState = STATE_INIT;
-SensorState sensorState;
-PumpStatus pumpStatus;
+Tank tanks[TANK_COUNT];
+Tank &mainTank = tanks[0]; // Tanque en GPIO (modo simple y demo)
 AlarmState alarmState;
 DisplayData displayData;
 
-// Timers
-unsigned long lastSensorRead = 0;
-unsigned long lastDisplayUpdate = 0;
-unsigned long lastMqttPublish = 0;
-unsigned long fillStartTime = 0;
+// Período del ciclo de control. Sondeando GPIO o expansores, cada ciclo
+// es una muestra del filtro de debounce.
+#if SENSOR_USE_INTERRUPTS && !MULTI_TANK_ENABLED
+#define CONTROL_CYCLE_MS CONTROL_PERIOD_MS
+#else
+#define CONTROL_CYCLE_MS DEBOUNCE_SAMPLE_MS
+#endif
+#define CONTROL_PERIOD_US (CONTROL_CYCLE_MS * 1000UL)
+
+// Planificadores: control, display y red. Con RTOS cada uno corre en su
+// tarea; sin RTOS loop() los corre a los tres y duerme hasta el próximo plazo.
+Scheduler controlSched;
+Scheduler uiSched;
+Scheduler netSched;
+
+// Jitter del lazo de control: intervalo entre decisiones consecutivas.
+// Solo la tarea de control escribe los máximos; el informe (tarea de
+// display) los lee y pide el reinicio, que el control aplica en su pasada.
+uint64_t lastControlUs = 0;
+std::atomic<uint32_t> maxControlIntervalUs(0);
+std::atomic<uint32_t> maxControlJitterUs(0);
+std::atomic<bool> jitterResetPending(false);
+#if MULTI_TANK_ENABLED
+std::atomic<uint32_t> maxTankCycleUs(0); // Ciclo de todos los tanques
+#endif
+
+// Costo del display acumulado para el informe por hora
+uint64_t powerReportStart = 0;
+uint64_t hourSpiBytes = 0;
+uint64_t hourCpuUs = 0;
+uint32_t hourFrames = 0;
 
 // Reset button
-unsigned long buttonPressStart = 0;
+uint64_t buttonPressStart = 0;
 bool buttonWasPressed = false;
+bool buttonPressUsed = false; // Pulsación que ya tuvo efecto (no cambia página)
 #define BUTTON_HOLD_TIME_MS 2000 // Mantener 2 segundos para reset
+#define BUTTON_SHORT_MIN_MS 50   // Pulsación corta: cambiar de página
 
-// Demo mode
-bool demoMode = false;
-unsigned long lastDemoUpdate = 0;
+// Demo mode (lo decide la tarea de control; el display lo lee)
+std::atomic<bool> demoMode(false);
 int demoLevel = 0;
 bool demoFilling = true;
-#define DEMO_SPEED_MS 800 // Velocidad de simulación
+#define DEMO_SPEED_MS 800   // Velocidad de simulación
+#define DEMO_DETECT_MS 2000 // BOOT presionado a esta altura: modo demo
+#define DEMO_POLL_MS 50     // Splash esperando la decisión
+#define DEMO_BANNER_MS 1500 // Cartel de modo demo
+
+// Arranque: setup() y primera decisión de control (clock_us())
+uint64_t bootSetupUs = 0;
+uint64_t bootDecisionUs = 0;
 
 // Prototipos
-void updateStateMachine();
+void registerJobs();
+void controlStep();
+void updateTanks();
+void recordEdges();
 void updateDisplay();
 void publishMqtt();
+void measureControlJitter();
+void reportBoot();
+void printReport();
+void printPowerReport();
+void onMqttState(MqttConnState state);
+#if RTOS_TASKS_ENABLED
+void controlTask(void *arg);
+void displayTask(void *arg);
+void mqttTask(void *arg);
+#endif
 void checkResetButton();
 void updateDemoMode();
+void demoStep();
 const char *getPumpStateString(PumpState state);
 const char *getSequenceStateString(SequenceState state);
 
 void setup() {
+  bootSetupUs = clock_us();
   Serial.begin(115200);
   Serial.println("\n\n================================");
   Serial.println("   AC Water Level Monitor v1.0");
   Serial.println("================================\n");
 
-  // Inicializar display primero para mostrar splash
-  display_init();
-  display_splash();
+  // Arranque rápido: aquí solo lo que necesita el control (boyas, relés,
+  // estado). Display, detección del modo demo y red arrancan después en
+  // sus tareas, en paralelo con el control.
 
   // Botón de reset (GPIO 0 tiene pull-up interno)
   pinMode(RESET_BUTTON_PIN, INPUT_PULLUP);
 
-  // Mostrar instrucciones para modo demo durante el splash
-  Serial.println("[INFO] Hold BOOT button now for DEMO MODE...");
-  delay(2000);
-
-  // Detectar modo demo: si BOOT está presionado AL FINAL del splash
-  // (después de que el ESP ya arrancó normalmente)
-  if (digitalRead(RESET_BUTTON_PIN) == LOW) {
-    demoMode = true;
-    Serial.println("[DEMO] Demo mode activated!");
-
-    // Mostrar mensaje en display
-    tft.fillScreen(0x001F); // Fondo azul
-    tft.setTextDatum(MC_DATUM);
-    tft.setTextColor(0xFFFF, 0x001F);
-    tft.setTextFont(4);
-    tft.drawString("MODO DEMO", 120, 140);
-    tft.setTextFont(2);
-    tft.drawString("Simulacion activa", 120, 180);
-    tft.setTextDatum(TL_DATUM);
-    delay(1500);
-  }
-
   // Inicializar módulos
-  sensors_init();
-  pump_init();
   alarm_init();
-
-  // Inicializar estructuras
-  memset(&sensorState, 0, sizeof(sensorState));
-  memset(&pumpStatus, 0, sizeof(pumpStatus));
   memset(&alarmState, 0, sizeof(alarmState));
   memset(&displayData, 0, sizeof(displayData));
 
-  // Si es modo demo, inicializar estado
-  if (demoMode) {
-    sensorState.sequenceError = false;
-    sensorState.currentLevel = 0;
-    sensorState.sequenceState = SEQ_IDLE;
+  for (int i = 0; i < TANK_COUNT; i++) {
+    tank_init(&tanks[i], i, &alarmState);
   }
+#if !MULTI_TANK_ENABLED
+  history_init();
+#endif
 
-// Inicializar MQTT (opcional)
-#if MQTT_ENABLED
-  if (mqtt_init()) {
-    displayData.wifiConnected = true;
+#if MULTI_TANK_ENABLED
+  // Boyas y relés de cada tanque en su expansor
+  expander_init();
+  for (int i = 0; i < TANK_COUNT; i++) {
+    pump_attach_relay(&tanks[i].pump, expander_set_relay, i);
   }
+#else
+  sensors_init();
+  pump_init();
 #endif
 
-  // Forzar redibujado inicial
-  display_force_redraw();
+  // Ciclos y tiempos de bomba del día y, si fue un reinicio en caliente,
+  // el estado de cada tanque (bomba en marcha incluida)
+  pumpstats_init(tanks, TANK_COUNT);
+  warmstart_restore(tanks, TANK_COUNT);
+#if MULTI_TANK_ENABLED
+  expander_flush();
+#endif
+
+  snapshot_publish(tanks, TANK_COUNT);
+
+  registerJobs();
+
+#if SCHED_LIGHT_SLEEP && CONFIG_PM_ENABLE
+  // Dormir entre plazos: el planificador cede el CPU hasta el próximo
+  esp_pm_config_esp32_t pmConfig = {};
+  pmConfig.max_freq_mhz = 240;
+  pmConfig.min_freq_mhz = 80;
+  pmConfig.light_sleep_enable = true;
+  esp_pm_configure(&pmConfig);
+#endif
+
+#if RTOS_TASKS_ENABLED
+  xTaskCreatePinnedToCore(controlTask, "control", 4096, nullptr,
+                          CONTROL_TASK_PRIORITY, nullptr, CONTROL_TASK_CORE);
+  xTaskCreatePinnedToCore(displayTask, "display", 4096, nullptr,
+                          DISPLAY_TASK_PRIORITY, nullptr, UI_TASK_CORE);
+#if MQTT_ENABLED
+  xTaskCreatePinnedToCore(mqttTask, "mqtt", 6144, nullptr, MQTT_TASK_PRIORITY,
+                          nullptr, UI_TASK_CORE);
+#endif
+#endif
 
-  systemState = STATE_IDLE;
   Serial.println("[MAIN] System initialized - entering IDLE state\n");
 }
 
 void loop() {
-  unsigned long currentTime = millis();
+#if RTOS_TASKS_ENABLED
+  // Todo corre en las tareas creadas en setup()
+  vTaskDelete(nullptr);
+#else
+  // Ejecutar lo vencido y dormir hasta el próximo plazo
+  uint32_t wait = scheduler_run(&controlSched);
+  wait = min(wait, scheduler_run(&uiSched));
+  wait = min(wait, scheduler_run(&netSched));
+  if (wait > 0) {
+    delay(wait);
+  }
+#endif
+}
+
+// Adaptadores de trabajos del planificador
+static void controlJob(void *arg) {
+  (void)arg;
+  controlStep();
+}
 
-  // 0. Verificar botón de reset
-  checkResetButton();
+static void validateJob(void *arg) {
+  (void)arg;
+  uint32_t start = profiler_start(PROF_VALIDATE);
+  sensors_validate_sequence(&mainTank.sensors);
+  profiler_stop(PROF_VALIDATE, start);
+}
 
-  // MODO DEMO: Simular en lugar de leer sensores reales
-  if (demoMode) {
-    updateDemoMode();
+static void demoJob(void *arg) {
+  (void)arg;
+  demoStep();
+}
+
+static void statsJob(void *arg) {
+  (void)arg;
+  pumpstats_poll(tanks, TANK_COUNT, time(nullptr));
+}
+
+static void reportJob(void *arg) {
+  (void)arg;
+  printReport();
+}
+
+static bool flushArmed = false;
+
+static void flushJob(void *arg) {
+  (void)arg;
+  if (display_poll()) {
+    scheduler_once(&uiSched, "flush", DISPLAY_FLUSH_POLL_MS, flushJob, nullptr);
   } else {
-    // 1. Leer sensores periódicamente (modo normal)
-    if (currentTime - lastSensorRead >= SENSOR_READ_INTERVAL_MS) {
-      lastSensorRead = currentTime;
-      sensors_read(&sensorState);
-      sensors_validate_sequence(&sensorState);
+    flushArmed = false;
+  }
+}
+
+// Frame enviándose por DMA: revisarlo hasta que termine
+static void armFlush() {
+  if (display_busy() && !flushArmed) {
+    flushArmed = true;
+    scheduler_once(&uiSched, "flush", DISPLAY_FLUSH_POLL_MS, flushJob, nullptr);
+  }
+}
+
+#if !MULTI_TANK_ENABLED
+static int animJobId = -1;
+#endif
+
+static void displayJob(void *arg) {
+  (void)arg;
+  uint32_t start = profiler_start(PROF_DISPLAY);
+  updateDisplay();
+  profiler_stop(PROF_DISPLAY, start);
+  armFlush();
+
+#if !MULTI_TANK_ENABLED
+  // Animaciones a la tasa del modo actual (en pausa: solo revisar)
+  uint32_t animPeriod = governor_anim_period();
+  scheduler_set_period(&uiSched, animJobId,
+                       animPeriod > 0 ? animPeriod : DISPLAY_IDLE_INTERVAL_MS);
+#endif
+}
+
+#if !MULTI_TANK_ENABLED
+static void animJob(void *arg) {
+  (void)arg;
+  if (governor_anim_period() == 0) {
+    return;
+  }
+  display_animate();
+  armFlush();
+}
+
+// Muestra del historial (misma tarea que el display, que lo lee)
+static void historyJob(void *arg) {
+  (void)arg;
+  static ControlSnapshot snapshot;
+  if (snapshot_read(&snapshot)) {
+    history_add(snapshot.tanks[0].level, snapshot.tanks[0].pumpState);
+  }
+}
+#endif
+
+// ============================================
+// HISTORIAL DE CICLOS
+// ============================================
+// La tarea de display es la dueña del historial: escribe lo que anota el
+// control y atiende las consultas de a poco, unas filas por pasada.
+// Serial: una línea con la consulta (ver cyclelog_parse_query()) y la
+// respuesta en CSV; "profile" y "profile reset" van al perfilador. MQTT: el
+// pedido llega por la tarea MQTT y la respuesta vuelve de a una página, que
+// la tarea MQTT publica y libera.
+
+#define HISTORY_ROW_MAX 96       // Una fila CSV
+#define HISTORY_ROWS_PER_POLL 32 // Filas por serial en cada pasada
+
+static CycleQuery serialQuery;
+static bool serialQueryActive = false;
+
+static void serialHistory() {
+  static char line[64];
+  static size_t lineLength = 0;
+
+  while (Serial.available() > 0) {
+    char c = Serial.read();
+    if (c != '\n' && c != '\r') {
+      if (lineLength < sizeof(line) - 1) {
+        line[lineLength++] = c;
+      }
+      continue;
     }
+    if (lineLength == 0) {
+      continue;
+    }
+    line[lineLength] = '\0';
+    lineLength = 0;
+    if (profiler_command(line)) {
+      continue;
+    }
+    if (cyclelog_parse_query(line, &serialQuery)) {
+      serialQueryActive = true;
+    } else {
+      Serial.printf("[CYCLELOG] Unknown command: %s\n", line);
+    }
+  }
 
-    // 2. Actualizar máquina de estados
-    updateStateMachine();
+  char row[HISTORY_ROW_MAX];
+  for (int i = 0; serialQueryActive && i < HISTORY_ROWS_PER_POLL; i++) {
+    if (cyclelog_query_row(&serialQuery, row, sizeof(row))) {
+      Serial.println(row);
+    } else {
+      serialQueryActive = false;
+      Serial.printf("[CYCLELOG] %lu rows, %lu records read\n",
+                    (unsigned long)(serialQuery.rows - 1),
+                    (unsigned long)serialQuery.scanned);
+    }
+  }
+}
 
-    // 3. Actualizar bomba (tiempos)
-    pump_update(&pumpStatus);
+#if MQTT_ENABLED
+static CycleQuery mqttQuery;
+static bool mqttQueryActive = false;
+static char historyPage[CYCLELOG_PAGE_BYTES];
+static size_t historyPageLength = 0;
+static std::atomic<bool> historyPageReady(false); // La página es de MQTT
 
-    // 4. Actualizar alarma (patrones de sonido)
-    alarm_update(&alarmState);
+// Próxima página de la consulta por MQTT, con filas enteras. Una página
+// vacía cierra la respuesta.
+static void mqttHistory() {
+  char request[64];
+  if (!mqttQueryActive && mqtt_take_history_request(request, sizeof(request))) {
+    mqttQueryActive = cyclelog_parse_query(request, &mqttQuery);
+    if (!mqttQueryActive) {
+      Serial.printf("[CYCLELOG] Unknown request: %s\n", request);
+    }
+  }
+  if (!mqttQueryActive || historyPageReady.load(std::memory_order_acquire)) {
+    return;
   }
 
-  // 5. Actualizar display periódicamente
-  if (currentTime - lastDisplayUpdate >= DISPLAY_UPDATE_INTERVAL_MS) {
-    lastDisplayUpdate = currentTime;
-    updateDisplay();
+  size_t length = 0;
+  while (length + HISTORY_ROW_MAX <= sizeof(historyPage)) {
+    if (!cyclelog_query_row(&mqttQuery, historyPage + length,
+                            HISTORY_ROW_MAX)) {
+      mqttQueryActive = length > 0; // Falta la página vacía
+      break;
+    }
+    length += strlen(historyPage + length);
+    historyPage[length++] = '\n';
   }
+  historyPageLength = length;
+  historyPageReady.store(true, std::memory_order_release);
+}
+#endif
+
+static void cyclelogJob(void *arg) {
+  (void)arg;
+  cyclelog_poll();
+  serialHistory();
+#if MQTT_ENABLED
+  mqttHistory();
+#endif
+}
 
-// 6. Publicar MQTT periódicamente
 #if MQTT_ENABLED
+static void mqttLoopJob(void *arg) {
+  (void)arg;
+  uint32_t start = profiler_start(PROF_MQTT);
   mqtt_loop();
-  if (currentTime - lastMqttPublish >= MQTT_PUBLISH_INTERVAL_MS) {
-    lastMqttPublish = currentTime;
-    publishMqtt();
+  profiler_stop(PROF_MQTT, start);
+}
+
+static void publishJob(void *arg) {
+  (void)arg;
+  uint32_t start = profiler_start(PROF_PUBLISH);
+  publishMqtt();
+  profiler_stop(PROF_PUBLISH, start);
+}
+#endif
+
+// ============================================
+// ARRANQUE EN PARALELO
+// ============================================
+// El control corre desde el primer ciclo. El modo demo se decide en el
+// control al cumplirse DEMO_DETECT_MS (BOOT presionado en ese instante);
+// hasta entonces el botón no actúa. La tarea de display muestra el splash,
+// espera la decisión y después arranca sus trabajos; la de red conecta.
+
+static int statsJobId = -1;
+static std::atomic<bool> demoDecided(false);
+
+void startDisplayJobs();
+
+static void demoDetectJob(void *arg) {
+  (void)arg;
+  if (digitalRead(RESET_BUTTON_PIN) == LOW) {
+    Serial.println("[DEMO] Demo mode activated!");
+
+    // La simulación maneja el tanque principal: soltar la bomba real (un
+    // reinicio en caliente pudo retomarla) y no guardar nada
+    tank_clear_error(&mainTank);
+    warmstart_clear();
+    scheduler_cancel(&controlSched, statsJobId);
+    scheduler_every(&controlSched, "demo", DEMO_SPEED_MS, DEMO_SPEED_MS,
+                    demoJob, nullptr);
+    demoMode = true;
+
+    // Esta pulsación ya se usó: soltarla no cambia de página
+    buttonPressStart = clock_ms();
+    buttonWasPressed = true;
+    buttonPressUsed = true;
+  }
+  demoDecided.store(true, std::memory_order_release);
+}
+
+static void bannerJob(void *arg) {
+  (void)arg;
+  startDisplayJobs();
+}
+
+static void splashJob(void *arg) {
+  (void)arg;
+  if (!demoDecided.load(std::memory_order_acquire)) {
+    scheduler_once(&uiSched, "splash", DEMO_POLL_MS, splashJob, nullptr);
+  } else if (demoMode) {
+    display_demo_banner();
+    scheduler_once(&uiSched, "banner", DEMO_BANNER_MS, bannerJob, nullptr);
+  } else {
+    startDisplayJobs();
   }
+}
+
+static void uiBootJob(void *arg) {
+  (void)arg;
+  display_init();
+  governor_init(); // Backlight encendido
+  display_splash();
+  Serial.println("[INFO] Hold BOOT button now for DEMO MODE...");
+
+  // Historial de ciclos: lo escribe esta tarea
+  cyclelog_init();
+  scheduler_every(&uiSched, "cyclelog", CYCLELOG_POLL_MS, CYCLELOG_POLL_MS,
+                  cyclelogJob, nullptr);
+  scheduler_once(&uiSched, "splash", DEMO_POLL_MS, splashJob, nullptr);
+}
+
+#if MQTT_ENABLED
+static void netBootJob(void *arg) {
+  (void)arg;
+  // No bloquea: el estado de la red llega a la foto por el callback
+  mqtt_set_state_callback(onMqttState);
+  eventlog_init();
+  mqtt_init();
+
+  scheduler_every(&netSched, "mqtt", MQTT_LOOP_INTERVAL_MS, 0, mqttLoopJob,
+                  nullptr);
+  scheduler_every(&netSched, "publish", MQTT_EVENT_POLL_MS, MQTT_EVENT_POLL_MS,
+                  publishJob, nullptr);
+  profiler_set_period(PROF_MQTT, MQTT_LOOP_INTERVAL_MS);
+  profiler_set_period(PROF_PUBLISH, MQTT_EVENT_POLL_MS);
+}
+#endif
+
+// Todos los tiempos del sistema, en un solo lugar. Display y red registran
+// el resto de sus trabajos al terminar de arrancar.
+void registerJobs() {
+  scheduler_init(&controlSched, "control");
+  scheduler_init(&uiSched, "ui");
+  scheduler_init(&netSched, "net");
+
+  scheduler_every(&controlSched, "control", CONTROL_CYCLE_MS, 0, controlJob,
+                  nullptr);
+  profiler_set_period(PROF_CONTROL, CONTROL_CYCLE_MS);
+#if SENSOR_USE_INTERRUPTS && !MULTI_TANK_ENABLED
+  // Re-validar periódicamente aunque no haya flancos
+  scheduler_every(&controlSched, "validate", SENSOR_READ_INTERVAL_MS,
+                  SENSOR_READ_INTERVAL_MS, validateJob, nullptr);
+#endif
+  scheduler_once(&controlSched, "demo?", DEMO_DETECT_MS, demoDetectJob,
+                 nullptr);
+  statsJobId = scheduler_every(&controlSched, "stats", PUMP_STATS_POLL_MS,
+                               PUMP_STATS_POLL_MS, statsJob, nullptr);
+
+  // El informe bloquea en Serial: va en la tarea de menor prioridad
+  scheduler_once(&uiSched, "boot", 0, uiBootJob, nullptr);
+  scheduler_every(&uiSched, "report", JITTER_REPORT_INTERVAL_MS,
+                  JITTER_REPORT_INTERVAL_MS, reportJob, nullptr);
+#if MQTT_ENABLED
+  scheduler_once(&netSched, "boot", 0, netBootJob, nullptr);
 #endif
 }
 
-void updateStateMachine() {
-  SystemState previousState = systemState;
+// Vista inicial y trabajos del display, después del splash
+void startDisplayJobs() {
+  display_force_redraw();
+  scheduler_every(&uiSched, "display", DISPLAY_UPDATE_INTERVAL_MS, 0,
+                  displayJob, nullptr);
+  profiler_set_period(PROF_DISPLAY, DISPLAY_UPDATE_INTERVAL_MS);
+#if !MULTI_TANK_ENABLED
+  animJobId = scheduler_every(&uiSched, "anim", 1000 / DISPLAY_ANIM_FPS,
+                              1000 / DISPLAY_ANIM_FPS, animJob, nullptr);
+  scheduler_every(&uiSched, "history", HISTORY_SAMPLE_INTERVAL_MS,
+                  HISTORY_SAMPLE_INTERVAL_MS, historyJob, nullptr);
+#endif
+}
 
-  switch (systemState) {
-  case STATE_INIT:
-    // No debería llegar aquí después del setup
-    systemState = STATE_IDLE;
-    break;
+// Un ciclo de control completo. Termina publicando la foto que leen
+// display y MQTT.
+void controlStep() {
+  uint32_t stepStart = profiler_start(PROF_CONTROL);
+  measureControlJitter();
 
-  case STATE_IDLE:
-    // Esperando que empiece a llenarse
-    if (sensorState.sequenceError) {
-      systemState = STATE_ERROR;
-    } else if (sensorState.currentLevel > 0) {
-      systemState = STATE_FILLING;
-      fillStartTime = millis();
-      Serial.println("[MAIN] Water detected - entering FILLING state");
-    }
-    break;
-
-  case STATE_FILLING:
-    // Llenándose, esperar nivel 7
-    if (sensorState.sequenceError) {
-      systemState = STATE_ERROR;
-    } else if (sensors_is_tank_full(&sensorState)) {
-      // ¡Tanque lleno! Encender bomba
-      systemState = STATE_PUMPING;
-      pump_on(&pumpStatus);
-      alarm_beep(&alarmState); // Beep de inicio
-      Serial.println("[MAIN] Tank FULL - PUMP ON");
+  // 0. Verificar botón de reset (no en la ventana del modo demo)
+  if (demoDecided.load(std::memory_order_relaxed)) {
+    uint32_t start = profiler_start(PROF_BUTTON);
+    checkResetButton();
+    profiler_stop(PROF_BUTTON, start);
+  }
+
+  // MODO DEMO: Simular en lugar de leer sensores reales
+  if (demoMode) {
+    updateDemoMode();
+  } else {
+    // 1-3. Leer sensores, máquina de estados y tiempos de bomba
+    updateTanks();
+
+    // 4. Actualizar alarma (patrones de sonido)
+    alarm_update(&alarmState);
+
+    // 5. Estado para retomar después de un reinicio en caliente
+    warmstart_save(tanks, TANK_COUNT);
+    if (bootDecisionUs == 0) {
+      reportBoot();
     }
-    break;
-
-  case STATE_PUMPING:
-    // Bomba activa, esperar que llegue a vacío
-    if (sensorState.sequenceError) {
-      // Error durante bombeo
-      systemState = STATE_ERROR;
-    } else if (sensors_is_tank_empty(&sensorState)) {
-      // ¡Tanque vacío! Apagar bomba
-      pump_off(&pumpStatus);
-      sensors_reset_error(&sensorState); // Limpiar estados
-
-      // Registrar tiempo de llenado para cálculo de emergencia
-      unsigned long fillDuration = millis() - fillStartTime;
-      pump_register_cycle(&pumpStatus, fillDuration);
-
-      systemState = STATE_IDLE;
-      alarm_beep(&alarmState); // Beep de fin de ciclo
-      Serial.println("[MAIN] Tank EMPTY - PUMP OFF - Cycle complete");
+  }
+
+  recordEdges();
+  snapshot_publish(tanks, TANK_COUNT);
+  profiler_stop(PROF_CONTROL, stepStart);
+}
+
+// Tiempo de arranque: desde el reset (esp_timer) hasta setup() y hasta la
+// primera decisión de la máquina de estados con las boyas leídas
+void reportBoot() {
+  bootDecisionUs = clock_us();
+  WarmStartInfo warm;
+  warmstart_get_info(&warm);
+  Serial.printf("[BOOT] setup() at %lu ms, first control decision at %lu ms "
+                "(%s start, reset reason %lu, %lu warm restarts since cold)\n",
+                (unsigned long)(bootSetupUs / 1000),
+                (unsigned long)(bootDecisionUs / 1000),
+                warm.resumed ? "warm" : "cold",
+                (unsigned long)warm.resetReason,
+                (unsigned long)warm.restarts);
+}
+
+void measureControlJitter() {
+  uint64_t nowUs = clock_us();
+
+  if (jitterResetPending.load(std::memory_order_acquire)) {
+    maxControlIntervalUs.store(0, std::memory_order_relaxed);
+    maxControlJitterUs.store(0, std::memory_order_relaxed);
+#if MULTI_TANK_ENABLED
+    maxTankCycleUs.store(0, std::memory_order_relaxed);
+#endif
+    jitterResetPending.store(false, std::memory_order_release);
+  }
+
+  if (lastControlUs != 0) {
+    uint32_t intervalUs = (uint32_t)(nowUs - lastControlUs);
+    uint32_t jitterUs = intervalUs > CONTROL_PERIOD_US
+                            ? intervalUs - CONTROL_PERIOD_US
+                            : CONTROL_PERIOD_US - intervalUs;
+
+    // Único escritor: cargar y guardar, sin operación atómica
+    if (intervalUs > maxControlIntervalUs.load(std::memory_order_relaxed)) {
+      maxControlIntervalUs.store(intervalUs, std::memory_order_relaxed);
     }
-    break;
-
-  case STATE_ERROR:
-    // Modo de error
-    if (!pumpStatus.isRunning) {
-      // Encender bomba en modo emergencia
-      pump_emergency_on(&pumpStatus);
-      alarm_set(&alarmState, ALARM_ERROR);
-      Serial.println("[MAIN] ERROR STATE - Emergency pump activated!");
+    if (jitterUs > maxControlJitterUs.load(std::memory_order_relaxed)) {
+      maxControlJitterUs.store(jitterUs, std::memory_order_relaxed);
     }
+  }
+  lastControlUs = nowUs;
+}
 
-    // Verificar si terminó el tiempo de emergencia
-    if (pump_emergency_timeout(&pumpStatus)) {
-      pump_off(&pumpStatus);
-      alarm_off(&alarmState);
-      sensors_reset_error(&sensorState);
-      systemState = STATE_IDLE;
-      Serial.println("[MAIN] Emergency timeout - returning to IDLE");
-    }
+// Informe por serial en la tarea de display: sus contadores (display,
+// gobernador, historial) se leen y reinician aquí mismo; los del control y
+// de la red se reinician por pedido que aplica la tarea dueña.
+void printReport() {
+  Serial.printf("[MAIN] Control loop: period %lu us, max interval %lu us, "
+                "max jitter %lu us\n",
+                CONTROL_PERIOD_US,
+                (unsigned long)maxControlIntervalUs.load(
+                    std::memory_order_relaxed),
+                (unsigned long)maxControlJitterUs.load(
+                    std::memory_order_relaxed));
 
-    // También terminar si todos los sensores están apagados
-    if (sensors_is_tank_empty(&sensorState) &&
-        pumpStatus.runTime > 5000) { // Al menos 5 segundos
-      pump_off(&pumpStatus);
-      alarm_off(&alarmState);
-      sensors_reset_error(&sensorState);
-      systemState = STATE_IDLE;
-      Serial.println("[MAIN] Tank empty during emergency - returning to IDLE");
-    }
-    break;
+#if MULTI_TANK_ENABLED
+  uint32_t cycleUs = maxTankCycleUs.load(std::memory_order_relaxed);
+  Serial.printf("[MAIN] Max multi-tank cycle: %lu us for %d tanks "
+                "(~%lu tanks per %d us budget)\n",
+                (unsigned long)cycleUs, TANK_COUNT,
+                (unsigned long)(MULTI_TANK_CYCLE_BUDGET_US * TANK_COUNT /
+                                (cycleUs > 0 ? cycleUs : 1)),
+                MULTI_TANK_CYCLE_BUDGET_US);
+#endif
+  jitterResetPending.store(true, std::memory_order_release);
+
+#if !MULTI_TANK_ENABLED
+  DisplayStats displayStats;
+  display_get_stats(&displayStats);
+  if (displayStats.frames > 0) {
+    Serial.printf("[DISPLAY] SPI per frame: avg %lu B, max %lu B, last %lu B "
+                  "(direct drawing: avg %lu B)\n",
+                  (unsigned long)(displayStats.totalBytes /
+                                  displayStats.frames),
+                  (unsigned long)displayStats.maxBytes,
+                  (unsigned long)displayStats.lastBytes,
+                  (unsigned long)(displayStats.directBytes /
+                                  displayStats.frames));
+    Serial.printf("[DISPLAY] Frames %lu (anim %lu, skipped %lu) | frame avg "
+                  "%lu us, max %lu us | CPU avg %lu us, max %lu us\n",
+                  (unsigned long)displayStats.frames,
+                  (unsigned long)displayStats.animFrames,
+                  (unsigned long)displayStats.skipped,
+                  (unsigned long)(displayStats.totalFrameUs /
+                                  displayStats.frames),
+                  (unsigned long)displayStats.maxFrameUs,
+                  (unsigned long)(displayStats.totalCpuUs /
+                                  displayStats.frames),
+                  (unsigned long)displayStats.maxCpuUs);
   }
+  hourSpiBytes += displayStats.totalBytes;
+  hourCpuUs += displayStats.totalCpuUs;
+  hourFrames += displayStats.frames;
+  display_reset_stats();
+#endif
 
-  // Log de cambio de estado
-  if (previousState != systemState) {
-    Serial.printf("[MAIN] State changed: %d -> %d\n", previousState,
-                  systemState);
+#if MQTT_ENABLED
+  MqttStats mqttStats;
+  mqtt_get_stats(&mqttStats);
+  Serial.printf("[MQTT] Events %lu, heartbeats %lu, rate limited %lu, failed "
+                "%lu | %lu B | max event delay %lu ms\n",
+                (unsigned long)mqttStats.events,
+                (unsigned long)mqttStats.heartbeats,
+                (unsigned long)mqttStats.rateLimited,
+                (unsigned long)mqttStats.failed, (unsigned long)mqttStats.bytes,
+                (unsigned long)mqttStats.maxDelayMs);
+  mqtt_reset_stats();
+
+  EdgeStats edgeStats;
+  edges_get_stats(&edgeStats);
+  Serial.printf("[MQTT] Edges %lu (dropped %lu) | %lu batches, %lu B | max "
+                "edge age %lu ms\n",
+                (unsigned long)edgeStats.recorded,
+                (unsigned long)edgeStats.dropped,
+                (unsigned long)edgeStats.batches,
+                (unsigned long)edgeStats.bytes,
+                (unsigned long)edgeStats.maxAgeMs);
+  edges_reset_stats();
+#endif
+
+  if (clock_ms() - powerReportStart >= DISPLAY_POWER_REPORT_MS) {
+    printPowerReport();
   }
+
+  scheduler_print_stats(&controlSched);
+  scheduler_print_stats(&uiSched);
+  scheduler_print_stats(&netSched);
 }
 
-void updateDisplay() {
-  displayData.level = sensorState.currentLevel;
-  displayData.pumpState = pumpStatus.state;
-  displayData.hasError = sensorState.sequenceError;
-  displayData.sequenceState = sensorState.sequenceState;
-  displayData.cyclesCompleted = pumpStatus.cyclesCompleted;
-  displayData.lastCycleDuration = pumpStatus.lastCycleDuration;
-  displayData.pumpRunTime = pumpStatus.runTime;
+// Costo del display y tiempo en cada modo del gobernador, por hora
+void printPowerReport() {
+  uint64_t now = clock_ms();
+  uint32_t elapsedS = (uint32_t)((now - powerReportStart) / 1000);
+  powerReportStart = now;
+
+#if !MULTI_TANK_ENABLED
+  Serial.printf("[DISPLAY] Last %lu s: %lu frames, SPI %lu KB, CPU %lu ms\n",
+                (unsigned long)elapsedS, (unsigned long)hourFrames,
+                (unsigned long)(hourSpiBytes / 1024),
+                (unsigned long)(hourCpuUs / 1000));
+  hourSpiBytes = 0;
+  hourCpuUs = 0;
+  hourFrames = 0;
+#endif
+
+  GovernorStats governorStats;
+  governor_get_stats(&governorStats);
+  Serial.printf("[GOVERNOR] Last %lu s: active %lu s, idle %lu s, dim %lu s, "
+                "blank %lu s, %lu wakeups\n",
+                (unsigned long)elapsedS,
+                (unsigned long)(governorStats.modeMs[UI_ACTIVE] / 1000),
+                (unsigned long)(governorStats.modeMs[UI_IDLE] / 1000),
+                (unsigned long)(governorStats.modeMs[UI_DIM] / 1000),
+                (unsigned long)(governorStats.modeMs[UI_BLANK] / 1000),
+                (unsigned long)governorStats.wakeups);
+  governor_reset_stats();
+
+  PumpStatsStats pumpStats;
+  pumpstats_get_stats(&pumpStats);
+  Serial.printf("[STATS] NVS writes since boot: %lu (%lu on cycle end), "
+                "%lu day rollovers, %lu failed\n",
+                (unsigned long)pumpStats.commits,
+                (unsigned long)pumpStats.cycleCommits,
+                (unsigned long)pumpStats.rollovers,
+                (unsigned long)pumpStats.failed);
+
+  CycleLogStats cycleStats;
+  cyclelog_get_stats(&cycleStats);
+  Serial.printf("[CYCLELOG] %lu records since boot (%lu B, %lu dropped), "
+                "%lu sectors in use, %lu erased\n",
+                (unsigned long)cycleStats.appended,
+                (unsigned long)cycleStats.bytes,
+                (unsigned long)cycleStats.dropped,
+                (unsigned long)cycleStats.sectors,
+                (unsigned long)cycleStats.erases);
+}
+
+#if RTOS_TASKS_ENABLED
+
+// Tarea de control: prioridad alta, core de las ISR
+void controlTask(void *arg) {
+  (void)arg;
+  for (;;) {
+    scheduler_run_and_sleep(&controlSched);
+  }
+}
+
+// Tarea de display: un redibujado lento no retrasa al control
+void displayTask(void *arg) {
+  (void)arg;
+  for (;;) {
+    scheduler_run_and_sleep(&uiSched);
+  }
+}
 
 #if MQTT_ENABLED
-  displayData.wifiConnected = mqtt_is_connected();
+// Tarea MQTT: reconexiones y publicaciones bloqueantes quedan aisladas aquí
+void mqttTask(void *arg) {
+  (void)arg;
+  for (;;) {
+    scheduler_run_and_sleep(&netSched);
+  }
+}
+#endif
+
+#endif
+
+#if MULTI_TANK_ENABLED
+
+// Un ciclo por muestra de debounce: leer todos los expansores en una
+// ráfaga, procesar cada tanque y escribir solo los relés que cambiaron
+void updateTanks() {
+  static tank::SensorMask inputs[NUM_TANKS];
+
+  uint64_t cycleStart = clock_us();
+  uint32_t start = profiler_start(PROF_SENSORS);
+  expander_read_all(inputs);
+  profiler_stop(PROF_SENSORS, start);
+
+  // Debounce, validación y máquina de estados de todos los tanques
+  start = profiler_start(PROF_STATE);
+  bool anyError = false;
+  for (int i = 0; i < TANK_COUNT; i++) {
+    tank_sample(&tanks[i], inputs[i]);
+    tank_update(&tanks[i]);
+    anyError |= tanks[i].systemState == STATE_ERROR;
+  }
+  profiler_stop(PROF_STATE, start);
+
+  // La alarma es compartida: un tanque que sale de error no debe
+  // silenciar a otro que sigue en error
+  if (anyError && alarmState.pattern != ALARM_ERROR) {
+    alarm_set(&alarmState, ALARM_ERROR);
+  }
+
+  expander_flush();
+
+  // Sin imprimir desde el control: el máximo sale en printReport()
+  uint32_t cycleUs = (uint32_t)(clock_us() - cycleStart);
+  if (cycleUs > maxTankCycleUs.load(std::memory_order_relaxed)) {
+    maxTankCycleUs.store(cycleUs, std::memory_order_relaxed);
+  }
+}
+
 #else
-  displayData.wifiConnected = false;
+
+void updateTanks() {
+  SensorState *sensorState = &mainTank.sensors;
+
+  uint32_t start = profiler_start(PROF_SENSORS);
+  bool changed = sensors_read(sensorState);
+  profiler_stop(PROF_SENSORS, start);
+
+#if SENSOR_USE_INTERRUPTS
+  // Los flancos ya están en cola con su timestamp: vaciar en cada ciclo y
+  // validar al cambiar (el trabajo "validate" re-valida periódicamente)
+  if (changed) {
+#else
+  // Una muestra del filtro por ciclo: validar siempre
+  (void)changed;
+  {
+#endif
+    start = profiler_start(PROF_VALIDATE);
+    sensors_validate_sequence(sensorState);
+    profiler_stop(PROF_VALIDATE, start);
+  }
+
+  start = profiler_start(PROF_STATE);
+  tank_update(&mainTank);
+  profiler_stop(PROF_STATE, start);
+}
+
 #endif
 
+// Flancos de nivel, relé, error y alarma, con el instante del ciclo de
+// control que los detectó. El primer ciclo anota el estado inicial.
+void recordEdges() {
+#if MQTT_ENABLED
+  static int lastLevel[TANK_COUNT];
+  static PumpState lastPump[TANK_COUNT];
+  static bool lastError[TANK_COUNT];
+  static AlarmPattern lastAlarm = ALARM_OFF;
+  static bool started = false;
+
+  uint64_t now = clock_ms();
+  for (int i = 0; i < TANK_COUNT; i++) {
+    const Tank *tank = &tanks[i];
+    if (!started || tank->sensors.currentLevel != lastLevel[i]) {
+      lastLevel[i] = tank->sensors.currentLevel;
+      edges_record(EDGE_LEVEL, i, lastLevel[i], now);
+    }
+    if (!started || tank->pump.state != lastPump[i]) {
+      lastPump[i] = tank->pump.state;
+      edges_record(EDGE_PUMP, i, lastPump[i], now);
+    }
+    if (!started || tank->sensors.sequenceError != lastError[i]) {
+      lastError[i] = tank->sensors.sequenceError;
+      edges_record(EDGE_ERROR, i, lastError[i], now);
+    }
+  }
+  if (!started || alarmState.pattern != lastAlarm) {
+    lastAlarm = alarmState.pattern;
+    edges_record(EDGE_ALARM, 0, lastAlarm, now);
+  }
+  started = true;
+#endif
+}
+
+void fillDisplayData(const TankSnapshot *tank, bool online,
+                     DisplayData *data) {
+  data->level = tank->level;
+  data->pumpState = tank->pumpState;
+  data->hasError = tank->sequenceError;
+  data->sequenceState = tank->sequenceState;
+  data->cyclesCompleted = tank->cyclesCompleted;
+  data->lastCycleDuration = tank->lastCycleDuration;
+  data->pumpRunTime = tank->pumpRunTime;
+  data->wifiConnected = online;
+}
+
+void fillMqttData(const TankSnapshot *tank, MqttData *mqttData) {
+  mqttData->level = tank->level;
+  mqttData->maxLevel = NUM_SENSORS;
+  mqttData->pumpState = getPumpStateString(tank->pumpState);
+  mqttData->pumpRunning = tank->pumpRunning;
+  mqttData->pumpRuntime = tank->pumpRunTime / 1000; // a segundos
+  mqttData->hasError = tank->sequenceError;
+  mqttData->sequenceState = getSequenceStateString(tank->sequenceState);
+  mqttData->cyclesCompleted = tank->cyclesCompleted;
+  mqttData->lastCycleDuration = tank->lastCycleDuration / 1000; // a segundos
+  mqttData->totalRuntime = tank->totalRunTime / 1000;            // a segundos
+}
+
+// Display y MQTT leen solo la foto publicada por el control
+void updateDisplay() {
+  static ControlSnapshot snapshot;
+  if (!snapshot_read(&snapshot)) {
+    return;
+  }
+
+  // Rápido con actividad, lento en reposo, nada con el backlight apagado
+  if (!governor_update(&snapshot)) {
+    return;
+  }
+
+#if MULTI_TANK_ENABLED
+  static DisplayData tiles[TANK_COUNT];
+  for (int i = 0; i < TANK_COUNT; i++) {
+    fillDisplayData(&snapshot.tanks[i], snapshot.networkOnline, &tiles[i]);
+  }
+  display_update_tiles(tiles, TANK_COUNT);
+#else
+  fillDisplayData(&snapshot.tanks[0], snapshot.networkOnline, &displayData);
   display_update(&displayData);
+#endif
+}
+
+#if MQTT_ENABLED
+// Eventos que van al registro en flash: fin de ciclo y flancos de error y
+// de emergencia, comparando con la foto anterior
+static void logEvents(const ControlSnapshot *snapshot) {
+  static TankSnapshot last[TANK_COUNT];
+  static bool haveLast = false;
+
+  for (int i = 0; i < TANK_COUNT; i++) {
+    const TankSnapshot *tank = &snapshot->tanks[i];
+    const TankSnapshot *prev = &last[i];
+    if (haveLast) {
+      if (tank->cyclesCompleted > prev->cyclesCompleted) {
+        eventlog_append(EVENT_CYCLE, i, tank->level,
+                        (uint32_t)tank->lastCycleDuration);
+      }
+      if (tank->sequenceError && !prev->sequenceError) {
+        eventlog_append(EVENT_ERROR, i, tank->level, tank->sequenceState);
+      }
+      if (tank->pumpState == PUMP_EMERGENCY &&
+          prev->pumpState != PUMP_EMERGENCY) {
+        eventlog_append(EVENT_EMERGENCY, i, tank->level, 0);
+      }
+    }
+    last[i] = *tank;
+  }
+  haveLast = true;
+}
+#endif
+
+#if PROFILER_ENABLED && MQTT_ENABLED
+// Percentiles por etapa a MQTT_DIAG_TOPIC cada PROFILER_PUBLISH_MS
+static void publishProfile() {
+  static char json[PROFILER_JSON_MAX];
+  static uint64_t lastMs = 0;
+  static bool sent = false;
+
+  uint64_t now = clock_ms();
+  if (sent && now - lastMs < PROFILER_PUBLISH_MS) {
+    return;
+  }
+  size_t length = profiler_format_json(json, sizeof(json));
+  if (length > 0 && mqtt_publish_diag(json, length)) {
+    lastMs = now;
+    sent = true;
+  }
 }
+#endif
 
 void publishMqtt() {
 #if MQTT_ENABLED
-  MqttData mqttData;
-  mqttData.level = sensorState.currentLevel;
-  mqttData.maxLevel = NUM_SENSORS;
-  mqttData.pumpState = getPumpStateString(pumpStatus.state);
-  mqttData.pumpRunning = pumpStatus.isRunning;
-  mqttData.pumpRuntime = pumpStatus.runTime / 1000; // a segundos
-  mqttData.hasError = sensorState.sequenceError;
-  mqttData.sequenceState = getSequenceStateString(sensorState.sequenceState);
-  mqttData.cyclesCompleted = pumpStatus.cyclesCompleted;
-  mqttData.lastCycleDuration =
-      pumpStatus.lastCycleDuration / 1000;                // a segundos
-  mqttData.totalRuntime = pumpStatus.totalRunTime / 1000; // a segundos
+  static ControlSnapshot snapshot;
+  if (!snapshot_read(&snapshot)) {
+    return;
+  }
 
-  mqtt_publish_status(&mqttData);
+  // El registro se escribe con o sin broker; se vacía al haberlo
+  logEvents(&snapshot);
+  if (mqtt_is_connected()) {
+    eventlog_replay(mqtt_publish_events);
+    edges_flush(mqtt_publish_edges);
+    if (historyPageReady.load(std::memory_order_acquire) &&
+        mqtt_publish_history(historyPage, historyPageLength)) {
+      historyPageReady.store(false, std::memory_order_release);
+    }
+#if PROFILER_ENABLED
+    publishProfile();
+#endif
+  }
+
+  MqttData mqttData;
+#if MULTI_TANK_ENABLED
+  for (int i = 0; i < TANK_COUNT; i++) {
+    fillMqttData(&snapshot.tanks[i], &mqttData);
+    mqtt_report_status(i, &mqttData);
+  }
+#else
+  fillMqttData(&snapshot.tanks[0], &mqttData);
+  mqtt_report_status(0, &mqttData);
+#endif
 #endif
 }
 
+void onMqttState(MqttConnState state) {
+  snapshot_set_network(state == MQTT_STATE_ONLINE);
+}
+
 const char *getPumpStateString(PumpState state) {
   switch (state) {
   case PUMP_OFF:
@@ -334,95 +1044,123 @@ const char *getSequenceStateString(SequenceState state) {
   }
 }
 
+// Tanque con error de secuencia pendiente o en modo emergencia
+static bool tankHasError(const Tank *tank) {
+  return tank->sensors.sequenceError || tank->systemState == STATE_ERROR;
+}
+
 // Verificar botón de reset
+// Pulsación corta: alterna vista principal / tendencia.
 // Mantener presionado 2 segundos: si hay error lo limpia, si no reinicia ESP
 void checkResetButton() {
   bool buttonPressed = (digitalRead(RESET_BUTTON_PIN) == LOW); // Activo en bajo
 
   if (buttonPressed && !buttonWasPressed) {
-    // Botón recién presionado
-    buttonPressStart = millis();
+    // Botón recién presionado. Si la pantalla dormía, solo la despierta.
+    buttonPressStart = clock_ms();
     buttonWasPressed = true;
+    buttonPressUsed = governor_wake();
   } else if (buttonPressed && buttonWasPressed) {
     // Botón mantenido
-    if (millis() - buttonPressStart >= BUTTON_HOLD_TIME_MS) {
+    if (clock_ms() - buttonPressStart >= BUTTON_HOLD_TIME_MS) {
       Serial.println("[RESET] Button held for 2 seconds");
+      buttonPressUsed = true;
+
+      // Si hay error (en cualquier tanque), limpiarlo solo en esos: un
+      // vecino sano sigue con su llenado o su bombeo
+      bool hasError = false;
+      for (int i = 0; i < TANK_COUNT; i++) {
+        hasError |= tankHasError(&tanks[i]);
+      }
 
-      // Si hay error, limpiarlo
-      if (sensorState.sequenceError || systemState == STATE_ERROR) {
+      if (hasError) {
         Serial.println("[RESET] Clearing error state...");
-        pump_off(&pumpStatus);
-        alarm_off(&alarmState);
-        sensors_reset_error(&sensorState);
-        systemState = STATE_IDLE;
+        for (int i = 0; i < TANK_COUNT; i++) {
+          if (tankHasError(&tanks[i])) {
+            tank_clear_error(&tanks[i]);
+          }
+        }
         display_force_redraw();
         alarm_beep(&alarmState); // Beep de confirmación
 
         // Evitar múltiples triggers
-        buttonPressStart = millis();
+        buttonPressStart = clock_ms();
       } else {
         // No hay error, reiniciar ESP
+        // Reinicio pedido: arranque en frío, sin retomar la bomba
         Serial.println("[RESET] Restarting ESP32...");
+        pumpstats_flush(tanks, TANK_COUNT);
+        warmstart_clear();
         delay(100);
         ESP.restart();
       }
     }
-  } else {
-    // Botón liberado
+  } else if (buttonWasPressed) {
+    // Botón liberado: si no fue una pulsación larga ni despertó la
+    // pantalla, cambiar de página
+    // (los rebotes de menos de BUTTON_SHORT_MIN_MS se ignoran)
+#if !MULTI_TANK_ENABLED
+    if (!buttonPressUsed &&
+        clock_ms() - buttonPressStart >= BUTTON_SHORT_MIN_MS) {
+      display_toggle_page();
+    }
+#endif
     buttonWasPressed = false;
+    buttonPressUsed = false;
   }
 }
 
 // Función para modo demo - simula llenado y vaciado
 void updateDemoMode() {
-  unsigned long currentTime = millis();
+  uint64_t currentTime = clock_ms();
 
   // Asegurarse de que no haya errores en modo demo
-  sensorState.sequenceError = false;
-
-  if (currentTime - lastDemoUpdate >= DEMO_SPEED_MS) {
-    lastDemoUpdate = currentTime;
-
-    if (demoFilling) {
-      // Llenando
-      demoLevel++;
-      sensorState.currentLevel = demoLevel;
-      sensorState.sequenceState = SEQ_FILLING;
-
-      if (demoLevel >= 7) {
-        // Tanque lleno, encender bomba
-        demoFilling = false;
-        pumpStatus.state = PUMP_ON;
-        pumpStatus.isRunning = true;
-        pumpStatus.startTime = currentTime;
-        sensorState.sequenceState = SEQ_EMPTYING;
-        Serial.println("[DEMO] Tank full - PUMP ON");
-      }
-    } else {
-      // Vaciando
-      demoLevel--;
-      sensorState.currentLevel = demoLevel;
-      sensorState.sequenceState = SEQ_EMPTYING;
-
-      // Actualizar tiempo de bomba
-      pumpStatus.runTime = currentTime - pumpStatus.startTime;
-
-      if (demoLevel <= 0) {
-        // Tanque vacío, apagar bomba
-        demoFilling = true;
-        demoLevel = 0;
-        pumpStatus.state = PUMP_OFF;
-        pumpStatus.isRunning = false;
-        pumpStatus.cyclesCompleted++;
-        pumpStatus.lastCycleDuration = pumpStatus.runTime;
-        sensorState.sequenceState = SEQ_IDLE;
-        Serial.println("[DEMO] Tank empty - PUMP OFF - Cycle complete");
-      }
-    }
-  }
+  mainTank.sensors.sequenceError = false;
 
   // Mantener actualizado el tiempo de bomba si está corriendo
-  if (pumpStatus.isRunning) {
-    pumpStatus.runTime = currentTime - pumpStatus.startTime;
+  if (mainTank.pump.isRunning) {
+    mainTank.pump.runTime = currentTime - mainTank.pump.startTime;
+  }
+}
+
+// Un paso de la simulación (trabajo "demo", cada DEMO_SPEED_MS)
+void demoStep() {
+  uint64_t currentTime = clock_ms();
+
+  if (demoFilling) {
+    // Llenando
+    demoLevel++;
+    mainTank.sensors.currentLevel = demoLevel;
+    mainTank.sensors.sequenceState = SEQ_FILLING;
+
+    if (demoLevel >= NUM_SENSORS) {
+      // Tanque lleno, encender bomba
+      demoFilling = false;
+      mainTank.pump.state = PUMP_ON;
+      mainTank.pump.isRunning = true;
+      mainTank.pump.startTime = currentTime;
+      mainTank.sensors.sequenceState = SEQ_EMPTYING;
+      Serial.println("[DEMO] Tank full - PUMP ON");
+    }
+  } else {
+    // Vaciando
+    demoLevel--;
+    mainTank.sensors.currentLevel = demoLevel;
+    mainTank.sensors.sequenceState = SEQ_EMPTYING;
+
+    // Actualizar tiempo de bomba
+    mainTank.pump.runTime = currentTime - mainTank.pump.startTime;
+
+    if (demoLevel <= 0) {
+      // Tanque vacío, apagar bomba
+      demoFilling = true;
+      demoLevel = 0;
+      mainTank.pump.state = PUMP_OFF;
+      mainTank.pump.isRunning = false;
+      mainTank.pump.cyclesCompleted++;
+      mainTank.pump.lastCycleDuration = mainTank.pump.runTime;
+      mainTank.sensors.sequenceState = SEQ_IDLE;
+      Serial.println("[DEMO] Tank empty - PUMP OFF - Cycle complete");
+    }
   }
 }
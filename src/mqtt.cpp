@@ -1,55 +1,274 @@
 #include "mqtt.h"
+#include "clock.h"
+#include "eventlog.h"
+#include "tank.h"
 
 #if MQTT_ENABLED
 
+// mqtt_connect() bloquea: hasta MQTT_CONNECT_TIMEOUT_MS el TCP y otro tanto
+// la espera del CONNACK. Solo puede correr en su propia tarea, nunca en el
+// loop() que también lleva las boyas y la bomba.
+#if !RTOS_TASKS_ENABLED
+#error "MQTT_ENABLED necesita RTOS_TASKS_ENABLED (la conexión bloquea)"
+#endif
+
+#include <atomic>
+
+// ============================================
+// PUBACK PARA QoS1
+// ============================================
+// PubSubClient publica solo con QoS0 y descarta los PUBACK que recibe. Este
+// cliente se pone entre PubSubClient y el socket: deja pasar todo y sigue
+// el encuadre de los paquetes entrantes para avisar cada PUBACK al registro
+// de eventos. Los PUBLISH QoS1 se escriben directo por aquí.
+
+#define MQTT_PACKET_PUBLISH 3
+#define MQTT_PACKET_PUBACK 4
+
+class AckTapClient : public Client {
+public:
+  explicit AckTapClient(WiFiClient &socket) : socket(socket) {}
+
+  int connect(IPAddress ip, uint16_t port) override {
+    resetTap();
+    return socket.connect(ip, port);
+  }
+  int connect(const char *host, uint16_t port) override {
+    resetTap();
+    return socket.connect(host, port);
+  }
+  int connect(IPAddress ip, uint16_t port, int32_t timeout) {
+    resetTap();
+    return socket.connect(ip, port, timeout);
+  }
+  int connect(const char *host, uint16_t port, int32_t timeout) {
+    resetTap();
+    return socket.connect(host, port, timeout);
+  }
+  size_t write(uint8_t c) override { return socket.write(c); }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    return socket.write(buffer, size);
+  }
+  int available() override { return socket.available(); }
+  int read() override {
+    int c = socket.read();
+    if (c >= 0) {
+      tap(c);
+    }
+    return c;
+  }
+  int read(uint8_t *buffer, size_t size) override {
+    int n = socket.read(buffer, size);
+    for (int i = 0; i < n; i++) {
+      tap(buffer[i]);
+    }
+    return n;
+  }
+  int peek() override { return socket.peek(); }
+  void flush() override { socket.flush(); }
+  void stop() override {
+    resetTap();
+    socket.stop();
+  }
+  uint8_t connected() override { return socket.connected(); }
+  operator bool() override { return (bool)socket; }
+
+private:
+  enum TapState { TAP_HEADER, TAP_LENGTH, TAP_BODY };
+
+  void resetTap() { state = TAP_HEADER; }
+
+  // Encuadre MQTT: tipo, largo restante (varint) y cuerpo
+  void tap(uint8_t c) {
+    switch (state) {
+    case TAP_HEADER:
+      type = c >> 4;
+      remaining = 0;
+      shift = 0;
+      state = TAP_LENGTH;
+      break;
+    case TAP_LENGTH:
+      remaining |= (uint32_t)(c & 0x7F) << shift;
+      shift += 7;
+      if (!(c & 0x80)) {
+        received = 0;
+        packetId = 0;
+        state = remaining > 0 ? TAP_BODY : TAP_HEADER;
+      }
+      break;
+    case TAP_BODY:
+      if (received < 2) {
+        packetId = (packetId << 8) | c;
+      }
+      received++;
+      if (received == remaining) {
+        state = TAP_HEADER;
+        if (type == MQTT_PACKET_PUBACK && remaining >= 2) {
+          eventlog_acked(packetId);
+        }
+      }
+      break;
+    }
+  }
+
+  WiFiClient &socket;
+  TapState state = TAP_HEADER;
+  uint8_t type = 0;
+  uint32_t remaining = 0;
+  uint32_t received = 0;
+  uint8_t shift = 0;
+  uint16_t packetId = 0;
+};
+
 WiFiClient espClient;
-PubSubClient mqttClient(espClient);
+static AckTapClient tapClient(espClient);
+PubSubClient mqttClient(tapClient);
 
-static unsigned long lastReconnectAttempt = 0;
+// ============================================
+// CONSULTAS AL HISTORIAL
+// ============================================
+// El pedido llega en el callback de PubSubClient (tarea MQTT) y lo toma la
+// tarea dueña del historial: un solo lugar, ocupado hasta que lo tomen.
+// Un pedido que llega con otro esperando se descarta.
 
-bool mqtt_init() {
-  Serial.println("[MQTT] Initializing...");
+#define HISTORY_REQUEST_MAX 64
+
+static char historyRequest[HISTORY_REQUEST_MAX];
+static std::atomic<bool> historyRequestPending(false);
+
+static void onMessage(char *topic, uint8_t *payload, unsigned int length) {
+  if (strcmp(topic, MQTT_HISTORY_REQUEST_TOPIC) != 0) {
+    return;
+  }
+  if (historyRequestPending.load(std::memory_order_acquire)) {
+    Serial.println("[MQTT] History request dropped: another one pending");
+    return;
+  }
+  size_t n = min((size_t)length, sizeof(historyRequest) - 1);
+  memcpy(historyRequest, payload, n);
+  historyRequest[n] = '\0';
+  historyRequestPending.store(true, std::memory_order_release);
+}
 
-  if (!mqtt_connect_wifi()) {
+bool mqtt_take_history_request(char *out, size_t size) {
+  if (!historyRequestPending.load(std::memory_order_acquire)) {
     return false;
   }
+  strncpy(out, historyRequest, size - 1);
+  out[size - 1] = '\0';
+  historyRequestPending.store(false, std::memory_order_release);
+  return true;
+}
+
+// ============================================
+// GESTOR DE CONEXIÓN
+// ============================================
+// Máquina de estados avanzada por mqtt_loop(). El WiFi se sigue con eventos
+// (tarea de eventos del WiFi), nunca con esperas activas. Cada intento de
+// broker está acotado por MQTT_CONNECT_TIMEOUT_MS y los reintentos se
+// espacian con backoff exponencial con jitter.
+
+static volatile bool wifiUp = false;        // Escrito por el evento WiFi
+static volatile bool wifiLost = false;      // Desconexión pendiente de procesar
+static MqttConnState connState = MQTT_STATE_IDLE;
+static MqttStateCallback stateCallback = nullptr;
+
+static uint64_t nextAttemptAt = 0;          // clock_ms() del próximo intento
+static uint64_t wifiAttemptStart = 0;
+static uint32_t backoffMs = MQTT_BACKOFF_MIN_MS;
+static MqttStats stats;                     // Solo la tarea de red
+static std::atomic<bool> statsResetPending(false); // mqtt_reset_stats()
+
+static void resetReporters();
+
+static void setState(MqttConnState state) {
+  if (state == connState) {
+    return;
+  }
+  if (connState == MQTT_STATE_ONLINE) {
+    eventlog_link_down(); // Los lotes sin PUBACK se vuelven a enviar
+  }
+  connState = state;
+  if (state == MQTT_STATE_ONLINE) {
+    resetReporters();
+  }
+  Serial.printf("[MQTT] State: %s\n", mqtt_state_name(state));
+  if (stateCallback) {
+    stateCallback(state);
+  }
+}
+
+// Programar el próximo intento: backoff/2 + jitter en [0, backoff/2], y
+// duplicar el backoff hasta el máximo
+static void scheduleRetry() {
+  uint32_t half = backoffMs / 2;
+  uint32_t delayMs = half + (uint32_t)random(half + 1);
+  nextAttemptAt = clock_ms() + delayMs;
+  backoffMs = min(backoffMs * 2, (uint32_t)MQTT_BACKOFF_MAX_MS);
+
+  Serial.printf("[MQTT] Retry in %lu ms\n", (unsigned long)delayMs);
+  setState(MQTT_STATE_BACKOFF);
+}
+
+static void onWifiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  switch (event) {
+  case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+    wifiUp = true;
+    break;
+  case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+    if (wifiUp) {
+      wifiLost = true;
+    }
+    wifiUp = false;
+    break;
+  default:
+    break;
+  }
+  (void)info;
+}
+
+bool mqtt_init() {
+  Serial.println("[MQTT] Initializing...");
 
+  WiFi.onEvent(onWifiEvent);
   mqttClient.setServer(MQTT_SERVER, MQTT_PORT);
+  mqttClient.setCallback(onMessage);
+  mqttClient.setSocketTimeout(MQTT_CONNECT_TIMEOUT_MS / 1000);
+
+  // Solo arranca la conexión: mqtt_loop() la sigue sin bloquear
+  bool connected = mqtt_connect_wifi();
 
-  return mqtt_connect();
+  // Hora por SNTP: se sincroniza sola cuando hay red
+  configTzTime(TIME_ZONE, NTP_SERVER);
+  return connected;
 }
 
 bool mqtt_connect_wifi() {
   Serial.printf("[MQTT] Connecting to WiFi: %s\n", WIFI_SSID);
 
   WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(false); // Los reintentos los maneja el backoff
   WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
 
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
-  }
-
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println();
-    Serial.printf("[MQTT] WiFi connected! IP: %s\n",
-                  WiFi.localIP().toString().c_str());
-    return true;
-  }
-
-  Serial.println();
-  Serial.println("[MQTT] WiFi connection failed!");
+  wifiAttemptStart = clock_ms();
+  setState(MQTT_STATE_WIFI_CONNECTING);
   return false;
 }
 
 bool mqtt_connect() {
-  if (!WiFi.isConnected()) {
+  if (!wifiUp) {
     return false;
   }
 
   Serial.printf("[MQTT] Connecting to broker %s:%d\n", MQTT_SERVER, MQTT_PORT);
+  setState(MQTT_STATE_BROKER_CONNECTING);
+
+  // Abrir el socket con tiempo acotado; PubSubClient reutiliza la conexión
+  if (!tapClient.connected() &&
+      !tapClient.connect(MQTT_SERVER, MQTT_PORT, MQTT_CONNECT_TIMEOUT_MS)) {
+    Serial.println("[MQTT] TCP connect failed");
+    return false;
+  }
 
   bool connected;
   if (strlen(MQTT_USER) > 0) {
@@ -63,65 +282,352 @@ bool mqtt_connect() {
 
     // Publicar mensaje de conexión
     mqttClient.publish(MQTT_TOPIC, "{\"status\":\"online\"}");
+    mqttClient.subscribe(MQTT_HISTORY_REQUEST_TOPIC);
     return true;
   }
 
   Serial.printf("[MQTT] Connection failed, rc=%d\n", mqttClient.state());
+  tapClient.stop();
   return false;
 }
 
-bool mqtt_is_connected() {
-  return mqttClient.connected() && WiFi.isConnected();
+bool mqtt_is_connected() { return connState == MQTT_STATE_ONLINE; }
+
+MqttConnState mqtt_get_state() { return connState; }
+
+void mqtt_set_state_callback(MqttStateCallback callback) {
+  stateCallback = callback;
+}
+
+// El mensaje se escribe directo en el cliente: beginPublish() con el largo
+// exacto y después los trozos del serializador, sin armarlo en RAM
+static bool publishStatus(const char *topic, TelemetryFormat format,
+                          const MqttData *data,
+                          uint32_t fields = TELEMETRY_ALL_FIELDS) {
+  if (!mqtt_is_connected()) {
+    return false;
+  }
+
+  size_t len = telemetry_size(format, data, fields);
+  if (!mqttClient.beginPublish(topic, len, false)) {
+    Serial.printf("[MQTT] Publish failed on %s\n", topic);
+    return false;
+  }
+  size_t written = telemetry_write(&mqttClient, format, data, fields);
+  if (!mqttClient.endPublish() || written != len) {
+    Serial.printf("[MQTT] Publish failed on %s (%u/%u B)\n", topic,
+                  (unsigned)written, (unsigned)len);
+    return false;
+  }
+
+  stats.bytes += len;
+  Serial.printf("[MQTT] Published %s: %u B %s%s\n", topic, (unsigned)len,
+                telemetry_format_name(format),
+                fields != TELEMETRY_ALL_FIELDS ? " delta" : "");
+  return true;
 }
 
 void mqtt_publish_status(const MqttData *data) {
+  publishStatus(MQTT_TOPIC, MQTT_STATUS_FORMAT, data);
+}
+
+static void tankTopic(char *topic, size_t size, int tank) {
+  snprintf(topic, size, MQTT_TANK_TOPIC_PREFIX "%d/status", tank);
+}
+
+void mqtt_publish_tank_status(int tank, const MqttData *data) {
+  char topic[48];
+  tankTopic(topic, sizeof(topic), tank);
+  publishStatus(topic, MQTT_TANK_STATUS_FORMAT, data);
+}
+
+// Un lote del registro de eventos como PUBLISH QoS1: el PUBACK llega por
+// AckTapClient. Sin retain; el consumidor descarta repetidos por id.
+#define EVENT_JSON_MAX 144
+
+bool mqtt_publish_events(uint16_t packetId, const LoggedEvent *events,
+                         int count) {
   if (!mqtt_is_connected()) {
+    return false;
+  }
+
+  static char payload[EVENT_BATCH_SIZE * EVENT_JSON_MAX + 16];
+  size_t len = snprintf(payload, sizeof(payload), "{\"events\":[");
+  for (int i = 0; i < count && len < sizeof(payload); i++) {
+    const LoggedEvent *e = &events[i];
+    len += snprintf(payload + len, sizeof(payload) - len,
+                    "%s{\"id\":%lu,\"type\":\"%s\",\"tank\":%u,"
+                    "\"boot\":%u,\"uptime_ms\":%llu,\"time\":%lu,"
+                    "\"level\":%u,\"value\":%lu}",
+                    i > 0 ? "," : "", (unsigned long)e->id,
+                    eventlog_type_name(e->type), e->tank, e->boot,
+                    (unsigned long long)e->uptimeMs, (unsigned long)e->epoch,
+                    e->level, (unsigned long)e->value);
+  }
+  if (len < sizeof(payload)) {
+    len += snprintf(payload + len, sizeof(payload) - len, "]}");
+  }
+  if (len >= sizeof(payload)) {
+    Serial.println("[MQTT] Event batch too large");
+    return false;
+  }
+
+  // Cabecera fija (QoS1), largo restante, topic, packet id y payload
+  size_t topicLen = strlen(MQTT_EVENT_TOPIC);
+  uint32_t remaining = 2 + topicLen + 2 + len;
+  uint8_t header[8];
+  size_t n = 0;
+  header[n++] = (MQTT_PACKET_PUBLISH << 4) | (1 << 1);
+  do {
+    uint8_t digit = remaining & 0x7F;
+    remaining >>= 7;
+    header[n++] = remaining > 0 ? digit | 0x80 : digit;
+  } while (remaining > 0);
+  header[n++] = topicLen >> 8;
+  header[n++] = topicLen & 0xFF;
+
+  uint8_t id[2] = {(uint8_t)(packetId >> 8), (uint8_t)(packetId & 0xFF)};
+  bool ok = tapClient.write(header, n) == n &&
+            tapClient.write((const uint8_t *)MQTT_EVENT_TOPIC, topicLen) ==
+                topicLen &&
+            tapClient.write(id, 2) == 2 &&
+            tapClient.write((const uint8_t *)payload, len) == len;
+  if (!ok) {
+    Serial.println("[MQTT] Event batch write failed");
+    return false;
+  }
+
+  stats.bytes += len;
+  Serial.printf("[MQTT] Published %s: %d events, packet %u, %u B\n",
+                MQTT_EVENT_TOPIC, count, packetId, (unsigned)len);
+  return true;
+}
+
+// Lote binario del flujo de flancos: QoS0, se escribe directo como el
+// estado porque puede superar el buffer de PubSubClient
+bool mqtt_publish_edges(const uint8_t *batch, size_t length) {
+  if (!mqtt_is_connected()) {
+    return false;
+  }
+
+  if (!mqttClient.beginPublish(MQTT_EDGE_TOPIC, length, false) ||
+      mqttClient.write(batch, length) != length || !mqttClient.endPublish()) {
+    Serial.printf("[MQTT] Publish failed on %s\n", MQTT_EDGE_TOPIC);
+    return false;
+  }
+
+  stats.bytes += length;
+  return true;
+}
+
+// Página CSV de una consulta al historial: directo como los flancos
+bool mqtt_publish_history(const char *page, size_t length) {
+  if (!mqtt_is_connected()) {
+    return false;
+  }
+
+  if (!mqttClient.beginPublish(MQTT_HISTORY_TOPIC, length, false) ||
+      mqttClient.write((const uint8_t *)page, length) != length ||
+      !mqttClient.endPublish()) {
+    Serial.printf("[MQTT] Publish failed on %s\n", MQTT_HISTORY_TOPIC);
+    return false;
+  }
+
+  stats.bytes += length;
+  return true;
+}
+
+// Percentiles del perfilador: directo como los flancos
+bool mqtt_publish_diag(const char *json, size_t length) {
+  if (!mqtt_is_connected()) {
+    return false;
+  }
+
+  if (!mqttClient.beginPublish(MQTT_DIAG_TOPIC, length, false) ||
+      mqttClient.write((const uint8_t *)json, length) != length ||
+      !mqttClient.endPublish()) {
+    Serial.printf("[MQTT] Publish failed on %s\n", MQTT_DIAG_TOPIC);
+    return false;
+  }
+
+  stats.bytes += length;
+  return true;
+}
+
+// ============================================
+// PUBLICACIÓN POR EXCEPCIÓN
+// ============================================
+// Cada tanque recuerda lo último publicado. Un cambio de nivel, bomba,
+// error, secuencia o ciclos se publica en el acto, salvo que el tanque haya
+// publicado hace menos de MQTT_MIN_PUBLISH_GAP_MS: entonces queda pendiente
+// y sale al vencer el intervalo con el estado de ese momento. Sin eventos,
+// un latido con el estado completo cada MQTT_HEARTBEAT_MS. Al (re)conectar
+// se publica todo de nuevo, así el broker nunca queda con un delta suelto.
+
+struct Reporter {
+  MqttData last;         // Último estado publicado
+  bool published;        // last es válido en esta conexión
+  bool pending;          // Evento esperando el rate limit
+  uint64_t pendingSince; // clock_ms() del primer evento pendiente
+  uint64_t lastPublish;
+};
+
+static Reporter reporters[TANK_COUNT];
+
+// Al conectar: todos los tanques vuelven a publicar el estado completo
+static void resetReporters() {
+  for (int i = 0; i < TANK_COUNT; i++) {
+    reporters[i].published = false;
+    reporters[i].pending = false;
+  }
+}
+
+void mqtt_report_status(int tank, const MqttData *data) {
+  if (tank < 0 || tank >= TANK_COUNT || !mqtt_is_connected()) {
     return;
   }
 
-  // Construir JSON completo
-  char payload[512];
-  snprintf(payload, sizeof(payload),
-           "{"
-           "\"level\":%d,"
-           "\"max_level\":%d,"
-           "\"pump\":{"
-           "\"state\":\"%s\","
-           "\"running\":%s,"
-           "\"runtime_s\":%lu"
-           "},"
-           "\"error\":%s,"
-           "\"sequence\":\"%s\","
-           "\"stats\":{"
-           "\"cycles_today\":%d,"
-           "\"last_cycle_s\":%lu,"
-           "\"total_runtime_s\":%lu"
-           "}"
-           "}",
-           data->level, data->maxLevel, data->pumpState,
-           data->pumpRunning ? "true" : "false", data->pumpRuntime,
-           data->hasError ? "true" : "false", data->sequenceState,
-           data->cyclesCompleted, data->lastCycleDuration, data->totalRuntime);
-
-  mqttClient.publish(MQTT_TOPIC, payload);
-  Serial.printf("[MQTT] Published: %s\n", payload);
+  Reporter *r = &reporters[tank];
+  uint64_t now = clock_ms();
+
+  bool full = !r->published;
+  uint32_t changed = full ? 0 : telemetry_delta_fields(data, &r->last);
+  if (changed != 0 && !r->pending) {
+    r->pending = true;
+    r->pendingSince = now;
+  } else if (changed == 0 && r->pending) {
+    r->pending = false; // Volvió a lo publicado mientras esperaba
+  }
+
+  bool heartbeat = !full && !r->pending &&
+                   now - r->lastPublish >= MQTT_HEARTBEAT_MS;
+  if (!full && !r->pending && !heartbeat) {
+    return;
+  }
+
+  if (r->pending && now - r->lastPublish < MQTT_MIN_PUBLISH_GAP_MS) {
+    stats.rateLimited++;
+    return;
+  }
+
+  char topic[48];
+#if MULTI_TANK_ENABLED
+  tankTopic(topic, sizeof(topic), tank);
+  TelemetryFormat format = MQTT_TANK_STATUS_FORMAT;
+#else
+  snprintf(topic, sizeof(topic), "%s", MQTT_TOPIC);
+  TelemetryFormat format = MQTT_STATUS_FORMAT;
+#endif
+
+  uint32_t fields =
+      (MQTT_PUBLISH_DELTAS && r->pending) ? changed : TELEMETRY_ALL_FIELDS;
+  if (!publishStatus(topic, format, data, fields)) {
+    stats.failed++; // Se reintenta en la próxima revisión
+    return;
+  }
+
+  if (r->pending) {
+    stats.events++;
+    uint32_t delayMs = (uint32_t)(now - r->pendingSince);
+    if (delayMs > stats.maxDelayMs) {
+      stats.maxDelayMs = delayMs;
+    }
+  } else {
+    stats.heartbeats++;
+  }
+
+  r->last = *data;
+  r->published = true;
+  r->pending = false;
+  r->lastPublish = now;
+}
+
+void mqtt_get_stats(MqttStats *out) { memcpy(out, &stats, sizeof(stats)); }
+
+// Se pide desde otra tarea: la de red lo aplica en el próximo mqtt_loop()
+void mqtt_reset_stats() {
+  statsResetPending.store(true, std::memory_order_release);
 }
 
 void mqtt_loop() {
-  if (!WiFi.isConnected()) {
-    return;
+  uint64_t now = clock_ms();
+
+  if (statsResetPending.load(std::memory_order_acquire)) {
+    memset(&stats, 0, sizeof(stats));
+    statsResetPending.store(false, std::memory_order_release);
+  }
+
+  // WiFi caído (evento): cerrar la sesión y reintentar con backoff
+  if (wifiLost) {
+    wifiLost = false;
+    mqttClient.disconnect();
+    tapClient.stop();
+    Serial.println("[MQTT] WiFi lost");
+    scheduleRetry();
   }
 
-  if (!mqttClient.connected()) {
-    unsigned long now = millis();
-    if (now - lastReconnectAttempt > 5000) {
-      lastReconnectAttempt = now;
+  switch (connState) {
+  case MQTT_STATE_IDLE:
+    break;
+
+  case MQTT_STATE_WIFI_CONNECTING:
+    if (wifiUp) {
+      Serial.printf("[MQTT] WiFi connected! IP: %s\n",
+                    WiFi.localIP().toString().c_str());
       if (mqtt_connect()) {
-        lastReconnectAttempt = 0;
+        backoffMs = MQTT_BACKOFF_MIN_MS;
+        setState(MQTT_STATE_ONLINE);
+      } else {
+        scheduleRetry();
       }
+    } else if (now - wifiAttemptStart >= MQTT_WIFI_TIMEOUT_MS) {
+      Serial.println("[MQTT] WiFi connection failed!");
+      WiFi.disconnect();
+      scheduleRetry();
     }
-  } else {
-    mqttClient.loop();
+    break;
+
+  case MQTT_STATE_BROKER_CONNECTING:
+    // Solo transitorio dentro de mqtt_connect()
+    break;
+
+  case MQTT_STATE_ONLINE:
+    if (!mqttClient.loop()) {
+      Serial.printf("[MQTT] Broker lost, rc=%d\n", mqttClient.state());
+      scheduleRetry();
+    }
+    break;
+
+  case MQTT_STATE_BACKOFF:
+    if (now < nextAttemptAt) {
+      break;
+    }
+    if (!wifiUp) {
+      mqtt_connect_wifi();
+    } else if (mqtt_connect()) {
+      backoffMs = MQTT_BACKOFF_MIN_MS;
+      setState(MQTT_STATE_ONLINE);
+    } else {
+      scheduleRetry();
+    }
+    break;
+  }
+}
+
+const char *mqtt_state_name(MqttConnState state) {
+  switch (state) {
+  case MQTT_STATE_IDLE:
+    return "idle";
+  case MQTT_STATE_WIFI_CONNECTING:
+    return "wifi_connecting";
+  case MQTT_STATE_BROKER_CONNECTING:
+    return "broker_connecting";
+  case MQTT_STATE_ONLINE:
+    return "online";
+  case MQTT_STATE_BACKOFF:
+    return "backoff";
+  default:
+    return "unknown";
   }
 }
 
@@ -136,7 +642,50 @@ bool mqtt_init() {
 bool mqtt_connect_wifi() { return false; }
 bool mqtt_connect() { return false; }
 bool mqtt_is_connected() { return false; }
+MqttConnState mqtt_get_state() { return MQTT_STATE_IDLE; }
+void mqtt_set_state_callback(MqttStateCallback callback) { (void)callback; }
+const char *mqtt_state_name(MqttConnState state) {
+  (void)state;
+  return "disabled";
+}
 void mqtt_publish_status(const MqttData *data) { (void)data; }
+void mqtt_publish_tank_status(int tank, const MqttData *data) {
+  (void)tank;
+  (void)data;
+}
+void mqtt_report_status(int tank, const MqttData *data) {
+  (void)tank;
+  (void)data;
+}
+bool mqtt_publish_events(uint16_t packetId, const LoggedEvent *events,
+                         int count) {
+  (void)packetId;
+  (void)events;
+  (void)count;
+  return false;
+}
+bool mqtt_publish_edges(const uint8_t *batch, size_t length) {
+  (void)batch;
+  (void)length;
+  return false;
+}
+bool mqtt_take_history_request(char *out, size_t size) {
+  (void)out;
+  (void)size;
+  return false;
+}
+bool mqtt_publish_history(const char *page, size_t length) {
+  (void)page;
+  (void)length;
+  return false;
+}
+bool mqtt_publish_diag(const char *json, size_t length) {
+  (void)json;
+  (void)length;
+  return false;
+}
+void mqtt_get_stats(MqttStats *out) { memset(out, 0, sizeof(*out)); }
+void mqtt_reset_stats() {}
 void mqtt_loop() {}
 
 #endif
@@ -2,6 +2,9 @@
 #define MQTT_H
 
 #include "config.h"
+#include "edges.h"
+#include "eventlog.h"
+#include "telemetry.h"
 #include <Arduino.h>
 
 #if MQTT_ENABLED
@@ -9,36 +12,89 @@
 #include <WiFi.h>
 #endif
 
-// Estructura de datos para publicar
-struct MqttData {
-  int level;
-  int maxLevel;
-  const char *pumpState;
-  bool pumpRunning;
-  unsigned long pumpRuntime; // segundos
-  bool hasError;
-  const char *sequenceState;
-  int cyclesCompleted;
-  unsigned long lastCycleDuration; // segundos
-  unsigned long totalRuntime;      // segundos de bomba hoy
+// Estado del gestor de conexión
+enum MqttConnState {
+  MQTT_STATE_IDLE,              // Sin iniciar
+  MQTT_STATE_WIFI_CONNECTING,   // Esperando IP (evento WiFi)
+  MQTT_STATE_BROKER_CONNECTING, // Intento de conexión al broker en curso
+  MQTT_STATE_ONLINE,            // WiFi + broker conectados
+  MQTT_STATE_BACKOFF            // Esperando para reintentar
 };
 
-// Inicializar WiFi y MQTT
+// Aviso de cambio de estado (se llama desde mqtt_loop())
+typedef void (*MqttStateCallback)(MqttConnState state);
+
+// Contadores de publicación por excepción (desde mqtt_reset_stats())
+struct MqttStats {
+  uint32_t events;      // Publicaciones por cambio de estado
+  uint32_t heartbeats;  // Estados completos (latido o reconexión)
+  uint32_t rateLimited; // Revisiones con un evento frenado por el rate limit
+  uint32_t failed;      // publish() rechazado por el cliente
+  uint32_t bytes;       // Payload publicado
+  uint32_t maxDelayMs;  // Mayor espera de un evento hasta salir
+};
+
+// Inicializar WiFi y MQTT. No espera: arranca la conexión y devuelve
+// enseguida; el progreso se informa por el callback de estado.
 bool mqtt_init();
 
-// Conectar a WiFi
+// Iniciar conexión a WiFi (no bloquea)
 bool mqtt_connect_wifi();
 
-// Conectar al broker MQTT
+// Conectar al broker MQTT. Bloquea hasta 2 * MQTT_CONNECT_TIMEOUT_MS (TCP y
+// CONNACK): llamar solo desde la tarea de red
 bool mqtt_connect();
 
 // Verificar conexión
 bool mqtt_is_connected();
 
+// Estado del gestor de conexión
+MqttConnState mqtt_get_state();
+const char *mqtt_state_name(MqttConnState state);
+
+// Registrar callback de cambio de estado
+void mqtt_set_state_callback(MqttStateCallback callback);
+
 // Publicar estado
 void mqtt_publish_status(const MqttData *data);
 
-// Loop de mantenimiento (llamar frecuentemente)
+// Publicar estado de un tanque en su subárbol (modo multi-tanque)
+void mqtt_publish_tank_status(int tank, const MqttData *data);
+
+// Publicación por excepción: llamar seguido (MQTT_EVENT_POLL_MS) con el
+// estado actual del tanque. Publica solo si cambió algo, respetando
+// MQTT_MIN_PUBLISH_GAP_MS, o si toca el latido de MQTT_HEARTBEAT_MS. En
+// modo simple el tanque 0 va a MQTT_TOPIC.
+void mqtt_report_status(int tank, const MqttData *data);
+
+// Publicar un lote del registro de eventos en MQTT_EVENT_TOPIC con QoS1
+// (EventSender de eventlog_replay). El PUBACK llega a eventlog_acked().
+bool mqtt_publish_events(uint16_t packetId, const LoggedEvent *events,
+                         int count);
+
+// Publicar un lote del flujo de flancos en MQTT_EDGE_TOPIC (EdgeSender de
+// edges_flush())
+bool mqtt_publish_edges(const uint8_t *batch, size_t length);
+
+// Tomar el último pedido de consulta al historial recibido en
+// MQTT_HISTORY_REQUEST_TOPIC (texto de cyclelog_parse_query()). false si
+// no hay ninguno. Se puede llamar desde otra tarea.
+bool mqtt_take_history_request(char *out, size_t size);
+
+// Publicar una página CSV de la respuesta en MQTT_HISTORY_TOPIC (vacía al
+// terminar)
+bool mqtt_publish_history(const char *page, size_t length);
+
+// Publicar el JSON del perfilador en MQTT_DIAG_TOPIC
+bool mqtt_publish_diag(const char *json, size_t length);
+
+// Estadísticas de publicación. El reinicio se puede pedir desde otra
+// tarea: se aplica en el próximo mqtt_loop().
+void mqtt_get_stats(MqttStats *out);
+void mqtt_reset_stats();
+
+// Loop de mantenimiento: avanza el gestor de conexión (llamar
+// frecuentemente)
 void mqtt_loop();
 
 #endif // MQTT_H
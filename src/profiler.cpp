@@ -0,0 +1,272 @@
+#include "profiler.h"
+
+#if PROFILER_ENABLED
+
+#include <atomic>
+#include <stdarg.h>
+
+// Histograma en unidades de 32 ns (~8 ciclos a 240 MHz): 0-3 exactos y
+// después 4 intervalos por potencia de 2 hasta 2^26 unidades (~4,3 s)
+#define UNIT_SHIFT 5
+#define SUB_BITS 2
+#define SUBS (1 << SUB_BITS)
+#define MAX_EXP (31 - UNIT_SHIFT)
+#define BUCKETS ((MAX_EXP - SUB_BITS + 2) * SUBS)
+
+struct Histogram {
+  std::atomic<uint32_t> counts[BUCKETS];
+  std::atomic<uint32_t> maxNs;
+};
+
+struct Stage {
+  Histogram duration;
+  Histogram jitter;
+  std::atomic<uint32_t> periodUs; // 0 = sin jitter
+  uint64_t lastStartUs;           // clock_us() de la pasada anterior
+  std::atomic<bool> resetPending;
+};
+
+static Stage stages[PROF_STAGE_COUNT];
+
+static const char *const stageNames[PROF_STAGE_COUNT] = {
+    "control", "button", "sensors", "validate",
+    "state",   "display", "mqtt",   "publish"};
+
+static int bucketOf(uint32_t ns) {
+  uint32_t units = ns >> UNIT_SHIFT;
+  if (units < SUBS) {
+    return (int)units;
+  }
+  int exp = 31 - __builtin_clz(units);
+  return (exp - SUB_BITS + 1) * SUBS +
+         (int)((units >> (exp - SUB_BITS)) & (SUBS - 1));
+}
+
+// Límite superior de un intervalo (ns)
+static uint32_t bucketLimit(int bucket) {
+  if (bucket < SUBS) {
+    return ((uint32_t)(bucket + 1) << UNIT_SHIFT) - 1;
+  }
+  int exp = bucket / SUBS + SUB_BITS - 1;
+  uint64_t units = (uint64_t)(SUBS + bucket % SUBS + 1) << (exp - SUB_BITS);
+  return (uint32_t)min((units << UNIT_SHIFT) - 1, (uint64_t)UINT32_MAX);
+}
+
+// Solo el escritor de la etapa: cargar y guardar, sin operación atómica
+static void add(Histogram *histogram, uint32_t ns) {
+  std::atomic<uint32_t> &count = histogram->counts[bucketOf(ns)];
+  count.store(count.load(std::memory_order_relaxed) + 1,
+              std::memory_order_relaxed);
+  if (ns > histogram->maxNs.load(std::memory_order_relaxed)) {
+    histogram->maxNs.store(ns, std::memory_order_relaxed);
+  }
+}
+
+static void clear(Histogram *histogram) {
+  for (int i = 0; i < BUCKETS; i++) {
+    histogram->counts[i].store(0, std::memory_order_relaxed);
+  }
+  histogram->maxNs.store(0, std::memory_order_relaxed);
+}
+
+static void summarize(const Histogram *histogram, ProfileSummary *out) {
+  uint32_t counts[BUCKETS];
+  uint32_t total = 0;
+  for (int i = 0; i < BUCKETS; i++) {
+    counts[i] = histogram->counts[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  out->count = total;
+  out->maxNs = histogram->maxNs.load(std::memory_order_relaxed);
+  out->p50Ns = 0;
+  out->p99Ns = 0;
+  if (total == 0) {
+    return;
+  }
+
+  // Rango del percentil redondeado hacia arriba: con pocas muestras el
+  // p99 es el máximo
+  uint32_t rank50 = (uint32_t)(((uint64_t)total * 50 + 99) / 100);
+  uint32_t rank99 = (uint32_t)(((uint64_t)total * 99 + 99) / 100);
+  uint32_t seen = 0;
+  for (int i = 0; i < BUCKETS; i++) {
+    seen += counts[i];
+    if (out->p50Ns == 0 && seen >= rank50) {
+      out->p50Ns = min(bucketLimit(i), out->maxNs);
+    }
+    if (seen >= rank99) {
+      out->p99Ns = min(bucketLimit(i), out->maxNs);
+      break;
+    }
+  }
+}
+
+static uint32_t cpuMhz() {
+#ifdef ESP_PLATFORM
+  return getCpuFrequencyMhz();
+#else
+  return 1;
+#endif
+}
+
+void profiler_set_period(ProfileStage stage, uint32_t periodMs) {
+  stages[stage].periodUs.store(periodMs * 1000, std::memory_order_relaxed);
+  stages[stage].lastStartUs = 0;
+}
+
+uint32_t profiler_start(ProfileStage stage) {
+  Stage *s = &stages[stage];
+  uint32_t periodUs = s->periodUs.load(std::memory_order_relaxed);
+  if (periodUs > 0) {
+    uint64_t nowUs = clock_us();
+    if (s->lastStartUs != 0) {
+      uint64_t intervalUs = nowUs - s->lastStartUs;
+      uint64_t jitterUs = intervalUs > periodUs ? intervalUs - periodUs
+                                                : periodUs - intervalUs;
+      add(&s->jitter, (uint32_t)min(jitterUs * 1000, (uint64_t)UINT32_MAX));
+    }
+    s->lastStartUs = nowUs;
+  }
+  return profiler_cycles();
+}
+
+void profiler_stop(ProfileStage stage, uint32_t start) {
+  uint32_t cycles = profiler_cycles() - start;
+  Stage *s = &stages[stage];
+
+  if (s->resetPending.load(std::memory_order_acquire)) {
+    clear(&s->duration);
+    clear(&s->jitter);
+    s->resetPending.store(false, std::memory_order_release);
+  }
+
+  // Con DFS (SCHED_LIGHT_SLEEP) la frecuencia es la del momento
+  uint64_t ns = (uint64_t)cycles * 1000 / cpuMhz();
+  add(&s->duration, (uint32_t)min(ns, (uint64_t)UINT32_MAX));
+}
+
+void profiler_get(ProfileStage stage, ProfileSummary *duration,
+                  ProfileSummary *jitter) {
+  summarize(&stages[stage].duration, duration);
+  summarize(&stages[stage].jitter, jitter);
+}
+
+const char *profiler_stage_name(ProfileStage stage) {
+  return stageNames[stage];
+}
+
+void profiler_reset() {
+  for (int i = 0; i < PROF_STAGE_COUNT; i++) {
+    stages[i].resetPending.store(true, std::memory_order_release);
+  }
+}
+
+// Percentiles en µs con un decimal
+struct SummaryText {
+  char p50[12];
+  char p99[12];
+  char peak[12];
+};
+
+static void formatUs(char *out, size_t size, uint32_t ns) {
+  snprintf(out, size, "%lu.%lu", (unsigned long)(ns / 1000),
+           (unsigned long)(ns % 1000 / 100));
+}
+
+static void toText(const ProfileSummary *summary, SummaryText *out) {
+  formatUs(out->p50, sizeof(out->p50), summary->p50Ns);
+  formatUs(out->p99, sizeof(out->p99), summary->p99Ns);
+  formatUs(out->peak, sizeof(out->peak), summary->maxNs);
+}
+
+void profiler_print() {
+  Serial.printf("[PROFILE] CPU %lu MHz | us p50/p99/max | jitter vs period\n",
+                (unsigned long)cpuMhz());
+  for (int i = 0; i < PROF_STAGE_COUNT; i++) {
+    ProfileSummary duration, jitter;
+    profiler_get((ProfileStage)i, &duration, &jitter);
+
+    SummaryText text;
+    toText(&duration, &text);
+    Serial.printf("[PROFILE] %-8s %9lu runs | %s/%s/%s", stageNames[i],
+                  (unsigned long)duration.count, text.p50, text.p99,
+                  text.peak);
+
+    uint32_t periodUs = stages[i].periodUs.load(std::memory_order_relaxed);
+    if (periodUs > 0) {
+      toText(&jitter, &text);
+      Serial.printf(" | jitter %s/%s/%s (period %lu us)", text.p50, text.p99,
+                    text.peak, (unsigned long)periodUs);
+    }
+    Serial.println();
+  }
+}
+
+// snprintf a continuación de lo ya escrito; false si no entra
+static bool append(char *out, size_t size, size_t *length,
+                   const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(out + *length, size - *length, format, args);
+  va_end(args);
+  if (n < 0 || (size_t)n >= size - *length) {
+    return false;
+  }
+  *length += n;
+  return true;
+}
+
+size_t profiler_format_json(char *out, size_t size) {
+  size_t length = 0;
+  if (!append(out, size, &length,
+              "{\"uptime_s\":%lu,\"cpu_mhz\":%lu,\"stages\":{",
+              (unsigned long)(clock_ms() / 1000), (unsigned long)cpuMhz())) {
+    return 0;
+  }
+
+  for (int i = 0; i < PROF_STAGE_COUNT; i++) {
+    ProfileSummary duration, jitter;
+    profiler_get((ProfileStage)i, &duration, &jitter);
+
+    SummaryText text;
+    toText(&duration, &text);
+    if (!append(out, size, &length,
+                "%s\"%s\":{\"n\":%lu,\"p50_us\":%s,\"p99_us\":%s,"
+                "\"max_us\":%s",
+                i > 0 ? "," : "", stageNames[i],
+                (unsigned long)duration.count, text.p50, text.p99,
+                text.peak)) {
+      return 0;
+    }
+
+    if (stages[i].periodUs.load(std::memory_order_relaxed) > 0) {
+      toText(&jitter, &text);
+      if (!append(out, size, &length,
+                  ",\"jitter_p50_us\":%s,\"jitter_p99_us\":%s,"
+                  "\"jitter_max_us\":%s",
+                  text.p50, text.p99, text.peak)) {
+        return 0;
+      }
+    }
+    if (!append(out, size, &length, "}")) {
+      return 0;
+    }
+  }
+
+  return append(out, size, &length, "}}") ? length : 0;
+}
+
+bool profiler_command(const char *line) {
+  if (!strcmp(line, "profile")) {
+    profiler_print();
+    return true;
+  }
+  if (!strcmp(line, "profile reset")) {
+    profiler_reset();
+    Serial.println("[PROFILE] Histograms reset");
+    return true;
+  }
+  return false;
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "clock.h"
+#include "config.h"
+#include <Arduino.h>
+
+// ============================================
+// PERFILADOR POR ETAPA
+// ============================================
+// Cada etapa del control, del display y de MQTT se mide con el contador de
+// ciclos del CPU (CCOUNT es por core: inicio y fin en la misma tarea) y se
+// acumula en un histograma log-lineal de memoria fija: 4 intervalos por
+// potencia de 2, así que un percentil cae a lo sumo un 25% por encima del
+// real; el máximo es exacto. Las etapas con período registran además el
+// jitter: la diferencia entre el intervalo desde la pasada anterior
+// (clock_us(), que sigue contando en light sleep) y su período.
+//
+// Cada etapa tiene un solo escritor (la tarea que la corre) y no hay
+// locks. Un reinicio pedido desde otra tarea lo hace el escritor en su
+// próxima pasada. Con PROFILER_ENABLED en false las llamadas son
+// funciones vacías en línea y no queda nada en el binario.
+
+enum ProfileStage {
+  PROF_CONTROL,  // controlStep() completo
+  PROF_BUTTON,   // checkResetButton()
+  PROF_SENSORS,  // sensors_read() / expander_read_all()
+  PROF_VALIDATE, // sensors_validate_sequence()
+  PROF_STATE,    // tank_update(): máquina de estados
+  PROF_DISPLAY,  // updateDisplay()
+  PROF_MQTT,     // mqtt_loop()
+  PROF_PUBLISH,  // publishMqtt()
+  PROF_STAGE_COUNT
+};
+
+// Percentiles de un histograma (ns)
+struct ProfileSummary {
+  uint32_t count;
+  uint32_t p50Ns;
+  uint32_t p99Ns;
+  uint32_t maxNs;
+};
+
+#define PROFILER_JSON_MAX 1536 // Salida de profiler_format_json()
+
+#if PROFILER_ENABLED
+
+// Contador de ciclos del CPU (fuera del ESP32: µs de clock_us())
+static inline uint32_t profiler_cycles() {
+#ifdef ESP_PLATFORM
+  return ESP.getCycleCount();
+#else
+  return (uint32_t)clock_us();
+#endif
+}
+
+// Período nominal de una etapa para medir su jitter (0 = sin jitter).
+// Llamar desde la tarea que corre la etapa o antes de crear las tareas.
+void profiler_set_period(ProfileStage stage, uint32_t periodMs);
+
+// Empezar una pasada: devuelve el valor para profiler_stop()
+uint32_t profiler_start(ProfileStage stage);
+
+// Terminar la pasada empezada en start
+void profiler_stop(ProfileStage stage, uint32_t start);
+
+// Duración y jitter de una etapa desde el arranque o el último reinicio
+void profiler_get(ProfileStage stage, ProfileSummary *duration,
+                  ProfileSummary *jitter);
+
+const char *profiler_stage_name(ProfileStage stage);
+
+// Vaciar los histogramas (cada escritor en su próxima pasada)
+void profiler_reset();
+
+// Tabla por serial
+void profiler_print();
+
+// JSON para MQTT_DIAG_TOPIC; devuelve la longitud (0 si no entra)
+size_t profiler_format_json(char *out, size_t size);
+
+// Comandos por serial: "profile" (tabla) y "profile reset". Devuelve
+// false si la línea no es un comando del perfilador.
+bool profiler_command(const char *line);
+
+#else
+
+static inline void profiler_set_period(ProfileStage stage, uint32_t periodMs) {
+  (void)stage;
+  (void)periodMs;
+}
+static inline uint32_t profiler_start(ProfileStage stage) {
+  (void)stage;
+  return 0;
+}
+static inline void profiler_stop(ProfileStage stage, uint32_t start) {
+  (void)stage;
+  (void)start;
+}
+static inline bool profiler_command(const char *line) {
+  (void)line;
+  return false;
+}
+
+#endif
+
+#endif // PROFILER_H
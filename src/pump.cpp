@@ -8,12 +8,27 @@ void pump_init() {
                  String(PUMP_RELAY_PIN));
 }
 
+static void setRelay(const PumpStatus *status, bool on) {
+  if (status->relayWriter) {
+    status->relayWriter(status->relayChannel, on);
+  } else {
+    digitalWrite(PUMP_RELAY_PIN, on ? HIGH : LOW);
+  }
+}
+
+void pump_attach_relay(PumpStatus *status, PumpRelayWriter writer,
+                       int channel) {
+  status->relayWriter = writer;
+  status->relayChannel = channel;
+  setRelay(status, false);
+}
+
 void pump_on(PumpStatus *status) {
   if (status->state != PUMP_ON) {
-    digitalWrite(PUMP_RELAY_PIN, HIGH);
+    setRelay(status, true);
     status->state = PUMP_ON;
     status->isRunning = true;
-    status->startTime = millis();
+    status->startTime = clock_ms();
 
     Serial.println("[PUMP] ON - Normal mode");
   }
@@ -21,24 +36,24 @@ void pump_on(PumpStatus *status) {
 
 void pump_emergency_on(PumpStatus *status) {
   if (status->state != PUMP_EMERGENCY) {
-    digitalWrite(PUMP_RELAY_PIN, HIGH);
+    setRelay(status, true);
     status->state = PUMP_EMERGENCY;
     status->isRunning = true;
-    status->startTime = millis();
+    status->startTime = clock_ms();
 
     // Calcular tiempo de emergencia
     status->emergencyDuration = pump_get_emergency_time(status);
 
-    Serial.printf("[PUMP] EMERGENCY ON - Duration: %lu seconds\n",
-                  status->emergencyDuration / 1000);
+    Serial.printf("[PUMP] EMERGENCY ON - Duration: %llu seconds\n",
+                  (unsigned long long)(status->emergencyDuration / 1000));
   }
 }
 
 void pump_off(PumpStatus *status) {
   if (status->isRunning) {
-    digitalWrite(PUMP_RELAY_PIN, LOW);
+    setRelay(status, false);
 
-    unsigned long runDuration = millis() - status->startTime;
+    uint64_t runDuration = clock_ms() - status->startTime;
     status->runTime = runDuration;
     status->totalRunTime += runDuration;
 
@@ -47,19 +62,19 @@ void pump_off(PumpStatus *status) {
       status->cyclesCompleted++;
       status->lastCycleDuration = runDuration;
 
-      // Actualizar promedio
+      // Actualizar promedio: suma exacta en 64 bits, sin multiplicar el
+      // promedio anterior (desbordaba) ni acumular error de redondeo
       if (status->cyclesCompleted == 1) {
-        status->avgCycleDuration = runDuration;
-      } else {
-        status->avgCycleDuration =
-            (status->avgCycleDuration * (status->cyclesCompleted - 1) +
-             runDuration) /
-            status->cyclesCompleted;
+        status->cycleTimeSum = 0;
       }
+      status->cycleTimeSum += runDuration;
+      status->avgCycleDuration = status->cycleTimeSum / status->cyclesCompleted;
 
-      Serial.printf("[PUMP] OFF - Cycle completed in %lu ms\n", runDuration);
+      Serial.printf("[PUMP] OFF - Cycle completed in %llu ms\n",
+                    (unsigned long long)runDuration);
     } else {
-      Serial.printf("[PUMP] OFF - Emergency ended after %lu ms\n", runDuration);
+      Serial.printf("[PUMP] OFF - Emergency ended after %llu ms\n",
+                    (unsigned long long)runDuration);
     }
 
     status->state = PUMP_OFF;
@@ -67,20 +82,37 @@ void pump_off(PumpStatus *status) {
   }
 }
 
+void pump_resume(PumpStatus *status, PumpState state, uint64_t startTime,
+                 uint64_t emergencyDuration) {
+  if (state == PUMP_OFF) {
+    return;
+  }
+  setRelay(status, true);
+  status->state = state;
+  status->isRunning = true;
+  status->startTime = startTime;
+  status->emergencyDuration = emergencyDuration;
+  status->runTime = clock_ms() - startTime;
+
+  Serial.printf("[PUMP] Resumed %s after %llu ms\n",
+                state == PUMP_ON ? "normal mode" : "EMERGENCY",
+                (unsigned long long)status->runTime);
+}
+
 void pump_update(PumpStatus *status) {
   if (status->isRunning) {
-    status->runTime = millis() - status->startTime;
+    status->runTime = clock_ms() - status->startTime;
   }
 }
 
-unsigned long pump_get_emergency_time(const PumpStatus *status) {
+uint64_t pump_get_emergency_time(const PumpStatus *status) {
   // Si tenemos datos de ciclos previos, usar promedio * factor de seguridad
   if (status->avgCycleDuration > 0) {
-    return (unsigned long)(status->avgCycleDuration * SAFETY_TIME_FACTOR);
+    return (uint64_t)(status->avgCycleDuration * SAFETY_TIME_FACTOR);
   }
 
   // Si no hay datos, usar tiempo mínimo de emergencia
-  return MIN_EMERGENCY_PUMP_TIME_S * 1000;
+  return MIN_EMERGENCY_PUMP_TIME_S * 1000ULL;
 }
 
 bool pump_emergency_timeout(const PumpStatus *status) {
@@ -91,15 +123,17 @@ bool pump_emergency_timeout(const PumpStatus *status) {
   return status->runTime >= status->emergencyDuration;
 }
 
-void pump_register_cycle(PumpStatus *status, unsigned long fillTime) {
+void pump_register_cycle(PumpStatus *status, uint64_t fillTime) {
   // Este método se puede usar para registrar el tiempo de llenado
   // y mejorar el cálculo del tiempo de emergencia
-  Serial.printf("[PUMP] Fill cycle registered: %lu ms\n", fillTime);
+  Serial.printf("[PUMP] Fill cycle registered: %llu ms\n",
+                (unsigned long long)fillTime);
 }
 
 void pump_reset_daily_stats(PumpStatus *status) {
   status->cyclesCompleted = 0;
   status->totalRunTime = 0;
+  status->cycleTimeSum = 0;
   Serial.println("[PUMP] Daily stats reset");
 }
 
@@ -118,9 +152,10 @@ void pump_debug_print(const PumpStatus *status) {
   }
 
   if (status->isRunning) {
-    Serial.printf(" | Running: %lu s", status->runTime / 1000);
+    Serial.printf(" | Running: %llu s",
+                  (unsigned long long)(status->runTime / 1000));
   }
 
-  Serial.printf(" | Cycles: %d | Avg: %lu s\n", status->cyclesCompleted,
-                status->avgCycleDuration / 1000);
+  Serial.printf(" | Cycles: %d | Avg: %llu s\n", status->cyclesCompleted,
+                (unsigned long long)(status->avgCycleDuration / 1000));
 }
@@ -1,6 +1,7 @@
 #ifndef PUMP_H
 #define PUMP_H
 
+#include "clock.h"
 #include "config.h"
 #include <Arduino.h>
 
@@ -11,22 +12,32 @@ enum PumpState {
   PUMP_EMERGENCY // Bomba en modo emergencia (por error)
 };
 
+// Escritura del relé en un canal externo (p.ej. expansor I2C)
+typedef void (*PumpRelayWriter)(int channel, bool on);
+
 // Estructura de estado de la bomba
 struct PumpStatus {
   PumpState state;                 // Estado actual
   bool isRunning;                  // ¿Está funcionando?
-  unsigned long startTime;         // Tiempo de inicio
-  unsigned long runTime;           // Tiempo corriendo (ms)
-  unsigned long totalRunTime;      // Tiempo total de funcionamiento hoy
+  uint64_t startTime;              // Tiempo de inicio (clock_ms())
+  uint64_t runTime;                // Tiempo corriendo (ms)
+  uint64_t totalRunTime;           // Tiempo total de funcionamiento hoy
   int cyclesCompleted;             // Ciclos completados hoy
-  unsigned long lastCycleDuration; // Duración del último ciclo
-  unsigned long avgCycleDuration;  // Duración promedio de ciclos
-  unsigned long emergencyDuration; // Duración de emergencia calculada
+  uint64_t cycleTimeSum;           // Suma de ciclos normales hoy (ms)
+  uint64_t lastCycleDuration;      // Duración del último ciclo
+  uint64_t avgCycleDuration;       // Duración promedio de ciclos
+  uint64_t emergencyDuration;      // Duración de emergencia calculada
+  PumpRelayWriter relayWriter;     // nullptr = PUMP_RELAY_PIN
+  int relayChannel;                // Canal para relayWriter
 };
 
 // Inicializar control de bomba
 void pump_init();
 
+// Redirigir el relé de esta bomba a un canal externo
+void pump_attach_relay(PumpStatus *status, PumpRelayWriter writer,
+                       int channel);
+
 // Encender bomba (modo normal)
 void pump_on(PumpStatus *status);
 
@@ -36,17 +47,22 @@ void pump_emergency_on(PumpStatus *status);
 // Apagar bomba
 void pump_off(PumpStatus *status);
 
+// Retomar una bomba que estaba en marcha antes de un reinicio en caliente:
+// vuelve a encender el relé sin reiniciar el tiempo ni contar un arranque
+void pump_resume(PumpStatus *status, PumpState state, uint64_t startTime,
+                 uint64_t emergencyDuration);
+
 // Actualizar estado (llamar en loop)
 void pump_update(PumpStatus *status);
 
 // Obtener tiempo de emergencia calculado
-unsigned long pump_get_emergency_time(const PumpStatus *status);
+uint64_t pump_get_emergency_time(const PumpStatus *status);
 
 // Verificar si debe apagar por timeout de emergencia
 bool pump_emergency_timeout(const PumpStatus *status);
 
 // Registrar ciclo completado (para calcular tiempo promedio)
-void pump_register_cycle(PumpStatus *status, unsigned long fillTime);
+void pump_register_cycle(PumpStatus *status, uint64_t fillTime);
 
 // Resetear estadísticas diarias
 void pump_reset_daily_stats(PumpStatus *status);
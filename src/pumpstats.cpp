@@ -0,0 +1,185 @@
+#include "pumpstats.h"
+#include "clock.h"
+
+#ifdef ESP_PLATFORM
+#include <Preferences.h>
+#endif
+
+#define STATS_VERSION 1
+#define MIN_EPOCH 1600000000UL // Antes de esto la hora no está puesta
+
+// Lo que se guarda de cada bomba. El promedio no se reinicia con el día:
+// es la base del tiempo de emergencia.
+struct SavedPump {
+  uint32_t cyclesCompleted;
+  uint64_t totalRunTime;
+  uint64_t cycleTimeSum;
+  uint64_t lastCycleDuration;
+  uint64_t avgCycleDuration;
+};
+
+struct SavedStats {
+  uint16_t version;
+  uint16_t tankCount;
+  uint32_t day; // Día local AAAAMMDD de las estadísticas (0 = sin hora)
+  SavedPump pumps[TANK_COUNT];
+};
+
+static const PumpStatsStore *store = nullptr;
+static SavedStats saved;        // Lo último escrito
+static uint32_t currentDay = 0; // Día de las estadísticas en RAM
+static uint64_t lastCommit = 0; // clock_ms()
+static PumpStatsStats stats;
+
+static void capture(const Tank *tanks, int count, SavedStats *out) {
+  memset(out, 0, sizeof(SavedStats));
+  out->version = STATS_VERSION;
+  out->tankCount = TANK_COUNT;
+  out->day = currentDay;
+  for (int i = 0; i < count && i < TANK_COUNT; i++) {
+    const PumpStatus *pump = &tanks[i].pump;
+    SavedPump *p = &out->pumps[i];
+    p->cyclesCompleted = pump->cyclesCompleted;
+    p->totalRunTime = pump->totalRunTime;
+    p->cycleTimeSum = pump->cycleTimeSum;
+    p->lastCycleDuration = pump->lastCycleDuration;
+    p->avgCycleDuration = pump->avgCycleDuration;
+  }
+}
+
+static void commit(const SavedStats *next) {
+  lastCommit = clock_ms();
+  if (!store->save(next, sizeof(SavedStats))) {
+    stats.failed++; // Queda pendiente: se reintenta al vencer el intervalo
+    Serial.println("[STATS] Save failed");
+    return;
+  }
+  saved = *next;
+  stats.commits++;
+}
+
+// Día local AAAAMMDD (la zona horaria la fija configTzTime())
+static uint32_t localDay(time_t now) {
+  struct tm local;
+  localtime_r(&now, &local);
+  return (local.tm_year + 1900) * 10000 + (local.tm_mon + 1) * 100 +
+         local.tm_mday;
+}
+
+void pumpstats_attach(const PumpStatsStore *newStore, Tank *tanks,
+                      int count) {
+  store = newStore;
+  lastCommit = clock_ms();
+
+  SavedStats loaded;
+  if (!store->load(&loaded, sizeof(loaded)) ||
+      loaded.version != STATS_VERSION || loaded.tankCount != TANK_COUNT) {
+    Serial.println("[STATS] No saved pump stats");
+    capture(tanks, count, &saved);
+    return;
+  }
+
+  for (int i = 0; i < count && i < TANK_COUNT; i++) {
+    PumpStatus *pump = &tanks[i].pump;
+    const SavedPump *p = &loaded.pumps[i];
+    pump->cyclesCompleted = p->cyclesCompleted;
+    pump->totalRunTime = p->totalRunTime;
+    pump->cycleTimeSum = p->cycleTimeSum;
+    pump->lastCycleDuration = p->lastCycleDuration;
+    pump->avgCycleDuration = p->avgCycleDuration;
+  }
+  saved = loaded;
+  currentDay = loaded.day;
+  Serial.printf("[STATS] Restored day %lu: %lu cycles on tank 0\n",
+                (unsigned long)currentDay,
+                (unsigned long)loaded.pumps[0].cyclesCompleted);
+}
+
+void pumpstats_poll(Tank *tanks, int count, time_t now) {
+  if (!store) {
+    return;
+  }
+
+  // Cambio de día: reiniciar por el camino de siempre y guardar ya
+  bool rollover = false;
+  if (now >= (time_t)MIN_EPOCH) {
+    uint32_t today = localDay(now);
+    if (currentDay != 0 && today != currentDay) {
+      for (int i = 0; i < count; i++) {
+        pump_reset_daily_stats(&tanks[i].pump);
+      }
+      stats.rollovers++;
+      rollover = true;
+      Serial.printf("[STATS] New day %lu\n", (unsigned long)today);
+    }
+    currentDay = today; // Sin día guardado: se adopta el actual
+  }
+
+  SavedStats next;
+  capture(tanks, count, &next);
+  if (memcmp(&next, &saved, sizeof(SavedStats)) == 0) {
+    return;
+  }
+
+  bool cycle = false;
+  for (int i = 0; i < TANK_COUNT; i++) {
+    cycle |= next.pumps[i].cyclesCompleted > saved.pumps[i].cyclesCompleted;
+  }
+
+  // Ciclos y cambios de día enseguida; el resto se junta
+  if (cycle || rollover || clock_ms() - lastCommit >= PUMP_STATS_COMMIT_MS) {
+    commit(&next);
+    if (cycle) {
+      stats.cycleCommits++;
+    }
+  }
+}
+
+void pumpstats_flush(const Tank *tanks, int count) {
+  if (!store) {
+    return;
+  }
+  SavedStats next;
+  capture(tanks, count, &next);
+  if (memcmp(&next, &saved, sizeof(SavedStats)) != 0) {
+    commit(&next);
+  }
+}
+
+void pumpstats_get_stats(PumpStatsStats *out) {
+  memcpy(out, &stats, sizeof(stats));
+}
+
+#ifdef ESP_PLATFORM
+
+// Un blob en NVS: cada escritura agrega entradas nuevas en la página
+// activa y NVS reparte el desgaste entre las páginas de su partición
+static Preferences prefs;
+
+static bool nvsLoad(void *data, size_t length) {
+  return prefs.getBytesLength("pumps") == length &&
+         prefs.getBytes("pumps", data, length) == length;
+}
+
+static bool nvsSave(const void *data, size_t length) {
+  return prefs.putBytes("pumps", data, length) == length;
+}
+
+void pumpstats_init(Tank *tanks, int count) {
+  static const PumpStatsStore nvs = {nvsLoad, nvsSave};
+  if (!prefs.begin("pumpstats", false)) {
+    Serial.println("[STATS] NVS not available");
+    return;
+  }
+  pumpstats_attach(&nvs, tanks, count);
+}
+
+#else
+
+void pumpstats_init(Tank *tanks, int count) {
+  (void)tanks;
+  (void)count;
+  Serial.println("[STATS] No NVS on this platform");
+}
+
+#endif
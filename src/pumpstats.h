@@ -0,0 +1,51 @@
+#ifndef PUMPSTATS_H
+#define PUMPSTATS_H
+
+#include "config.h"
+#include "tank.h"
+#include <Arduino.h>
+#include <time.h>
+
+// ============================================
+// ESTADÍSTICAS DE BOMBA PERSISTENTES
+// ============================================
+// Ciclos, tiempo total y promedio de cada bomba se guardan en NVS para
+// sobrevivir a reinicios. Se escriben juntos (un solo blob) y solo cuando
+// hace falta: enseguida al completar un ciclo o al cambiar de día, y otros
+// cambios (fin de una emergencia) a lo sumo cada PUMP_STATS_COMMIT_MS.
+// Entre escrituras los cambios esperan en RAM.
+//
+// Cambio de día: con la hora de SNTP, al pasar la medianoche local se
+// llama a pump_reset_daily_stats() en cada tanque. Si el equipo estuvo
+// apagado durante la medianoche, el reinicio se hace al tener hora. Sin
+// hora (sin WiFi) las estadísticas siguen acumulando.
+
+// Almacenamiento del blob: NVS en el ESP32, RAM en una simulación
+struct PumpStatsStore {
+  bool (*load)(void *data, size_t length);
+  bool (*save)(const void *data, size_t length);
+};
+
+struct PumpStatsStats {
+  uint32_t commits;      // Escrituras al almacenamiento
+  uint32_t cycleCommits; // ... por ciclo completado
+  uint32_t rollovers;    // Cambios de día
+  uint32_t failed;       // Escrituras fallidas
+};
+
+// Restaurar las estadísticas guardadas en NVS (después de tank_init())
+void pumpstats_init(Tank *tanks, int count);
+
+// Restaurar desde otro almacenamiento
+void pumpstats_attach(const PumpStatsStore *store, Tank *tanks, int count);
+
+// Revisar cambio de día y guardar si corresponde (tarea de control, cada
+// PUMP_STATS_POLL_MS). now: hora UNIX actual (time(nullptr)).
+void pumpstats_poll(Tank *tanks, int count, time_t now);
+
+// Guardar ya lo pendiente (antes de un reinicio pedido)
+void pumpstats_flush(const Tank *tanks, int count);
+
+void pumpstats_get_stats(PumpStatsStats *out);
+
+#endif // PUMPSTATS_H
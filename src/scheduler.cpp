@@ -0,0 +1,146 @@
+#include "scheduler.h"
+
+void scheduler_init(Scheduler *sched, const char *name) {
+  memset(sched, 0, sizeof(Scheduler));
+  sched->name = name;
+}
+
+static int addJob(Scheduler *sched, const char *name, uint32_t periodMs,
+                  uint32_t delayMs, SchedJobFn fn, void *arg) {
+  for (int i = 0; i < SCHED_MAX_JOBS; i++) {
+    SchedJob *job = &sched->jobs[i];
+    if (job->active) {
+      continue;
+    }
+
+    memset(job, 0, sizeof(SchedJob));
+    job->name = name;
+    job->fn = fn;
+    job->arg = arg;
+    job->periodMs = periodMs;
+    job->deadline = clock_ms() + delayMs;
+    job->active = true;
+    return i;
+  }
+
+  Serial.printf("[SCHED] %s: no room for job %s\n", sched->name, name);
+  return -1;
+}
+
+int scheduler_every(Scheduler *sched, const char *name, uint32_t periodMs,
+                    uint32_t firstDelayMs, SchedJobFn fn, void *arg) {
+  return addJob(sched, name, periodMs > 0 ? periodMs : 1, firstDelayMs, fn,
+                arg);
+}
+
+int scheduler_once(Scheduler *sched, const char *name, uint32_t delayMs,
+                   SchedJobFn fn, void *arg) {
+  return addJob(sched, name, 0, delayMs, fn, arg);
+}
+
+void scheduler_cancel(Scheduler *sched, int id) {
+  if (id >= 0 && id < SCHED_MAX_JOBS) {
+    sched->jobs[id].active = false;
+  }
+}
+
+void scheduler_set_period(Scheduler *sched, int id, uint32_t periodMs) {
+  if (id < 0 || id >= SCHED_MAX_JOBS || periodMs == 0) {
+    return;
+  }
+
+  SchedJob *job = &sched->jobs[id];
+  if (!job->active || job->periodMs == 0 || job->periodMs == periodMs) {
+    return;
+  }
+
+  job->periodMs = periodMs;
+  uint64_t deadline = clock_ms() + periodMs;
+  if (deadline < job->deadline) {
+    job->deadline = deadline;
+  }
+}
+
+uint32_t scheduler_run(Scheduler *sched) {
+  sched->wakeups++;
+
+  for (int i = 0; i < SCHED_MAX_JOBS; i++) {
+    SchedJob *job = &sched->jobs[i];
+    uint64_t now = clock_ms();
+    if (!job->active || now < job->deadline) {
+      continue;
+    }
+
+    uint32_t lateMs = (uint32_t)(now - job->deadline);
+    if (lateMs > job->maxLateMs) {
+      job->maxLateMs = lateMs;
+    }
+
+    uint64_t start = clock_us();
+    job->fn(job->arg);
+    uint32_t runUs = (uint32_t)(clock_us() - start);
+    job->runs++;
+    if (runUs > job->maxRunUs) {
+      job->maxRunUs = runUs;
+    }
+
+    if (job->periodMs == 0) {
+      job->active = false;
+      continue;
+    }
+
+    if (runUs > job->periodMs * 1000UL) {
+      job->overruns++;
+    }
+
+    // Próximo plazo sobre la grilla original; saltar los perdidos
+    job->deadline += job->periodMs;
+    now = clock_ms();
+    if (now >= job->deadline) {
+      uint32_t missed = (uint32_t)((now - job->deadline) / job->periodMs + 1);
+      job->deadline += missed * job->periodMs;
+      job->overruns += missed;
+    }
+  }
+
+  // Tiempo hasta el plazo más cercano
+  uint64_t now = clock_ms();
+  uint32_t wait = SCHED_MAX_SLEEP_MS;
+  for (int i = 0; i < SCHED_MAX_JOBS; i++) {
+    const SchedJob *job = &sched->jobs[i];
+    if (!job->active) {
+      continue;
+    }
+    if (now >= job->deadline) {
+      return 0;
+    }
+    if (job->deadline - now < wait) {
+      wait = (uint32_t)(job->deadline - now);
+    }
+  }
+  return wait;
+}
+
+void scheduler_run_and_sleep(Scheduler *sched) {
+  uint32_t wait = scheduler_run(sched);
+  if (wait > 0) {
+    vTaskDelay(pdMS_TO_TICKS(wait));
+  }
+}
+
+void scheduler_print_stats(const Scheduler *sched) {
+  Serial.printf("[SCHED] %s: %lu wakeups\n", sched->name,
+                (unsigned long)sched->wakeups);
+  for (int i = 0; i < SCHED_MAX_JOBS; i++) {
+    const SchedJob *job = &sched->jobs[i];
+    if (!job->active) {
+      continue;
+    }
+    Serial.printf("[SCHED]   %-10s every %5lu ms | runs %lu | overruns %lu | "
+                  "max late %lu ms | max run %lu us\n",
+                  job->name, (unsigned long)job->periodMs,
+                  (unsigned long)job->runs, (unsigned long)job->overruns,
+                  (unsigned long)job->maxLateMs,
+                  (unsigned long)job->maxRunUs);
+  }
+}
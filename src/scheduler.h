@@ -0,0 +1,73 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "clock.h"
+#include "config.h"
+#include <Arduino.h>
+
+// ============================================
+// PLANIFICADOR COOPERATIVO POR PLAZOS
+// ============================================
+// Cada tarea (o loop() sin RTOS) tiene su propio Scheduler con trabajos
+// periódicos o de una sola vez. scheduler_run() ejecuta los vencidos y
+// devuelve cuánto falta para el próximo plazo, de modo que el llamador
+// duerme hasta entonces en vez de girar comparando millis().
+//
+// Los plazos son instantes de clock_ms() en 64 bits: no hay desborde. Un
+// trabajo periódico que se atrasa más de un período no se ejecuta en
+// ráfaga: salta los plazos perdidos y los cuenta como overruns.
+
+#define SCHED_MAX_JOBS 8
+#define SCHED_MAX_SLEEP_MS 1000 // Tope de espera sin trabajos
+
+typedef void (*SchedJobFn)(void *arg);
+
+struct SchedJob {
+  const char *name;
+  SchedJobFn fn;
+  void *arg;
+  uint32_t periodMs;   // 0 = una sola vez
+  uint64_t deadline;   // clock_ms() del próximo vencimiento
+  bool active;
+  uint32_t runs;       // Ejecuciones
+  uint32_t overruns;   // Plazos perdidos o ejecuciones más largas que el período
+  uint32_t maxLateMs;  // Mayor retraso de inicio respecto al plazo
+  uint32_t maxRunUs;   // Mayor duración de una ejecución
+};
+
+struct Scheduler {
+  const char *name;
+  SchedJob jobs[SCHED_MAX_JOBS];
+  uint32_t wakeups; // Llamadas a scheduler_run() (despertares)
+};
+
+// Inicializar un planificador vacío
+void scheduler_init(Scheduler *sched, const char *name);
+
+// Registrar un trabajo periódico; la primera ejecución es en firstDelayMs.
+// Devuelve el id del trabajo o -1 si no hay lugar.
+int scheduler_every(Scheduler *sched, const char *name, uint32_t periodMs,
+                    uint32_t firstDelayMs, SchedJobFn fn, void *arg);
+
+// Registrar un trabajo que se ejecuta una vez dentro de delayMs
+int scheduler_once(Scheduler *sched, const char *name, uint32_t delayMs,
+                   SchedJobFn fn, void *arg);
+
+// Cancelar un trabajo
+void scheduler_cancel(Scheduler *sched, int id);
+
+// Cambiar el período de un trabajo periódico. Si el nuevo plazo queda
+// antes que el actual, se adelanta; si no, rige desde el próximo.
+void scheduler_set_period(Scheduler *sched, int id, uint32_t periodMs);
+
+// Ejecutar los trabajos vencidos. Devuelve ms hasta el próximo plazo.
+uint32_t scheduler_run(Scheduler *sched);
+
+// Ejecutar y dormir hasta el próximo plazo (cede el CPU a otras tareas y,
+// con light sleep automático habilitado, deja dormir al chip)
+void scheduler_run_and_sleep(Scheduler *sched);
+
+// Imprimir contadores de cada trabajo por serial
+void scheduler_print_stats(const Scheduler *sched);
+
+#endif // SCHEDULER_H
@@ -1,57 +1,230 @@
 #include "sensors.h"
+#include "debounce.h"
+#include <soc/gpio_reg.h>
+#include <soc/soc.h>
 
-// Array de pines de sensores (ordenados por nivel)
-static const int sensorPins[NUM_SENSORS] = {
-    SENSOR_1_PIN, SENSOR_2_PIN, SENSOR_3_PIN, SENSOR_4_PIN,
-    SENSOR_5_PIN, SENSOR_6_PIN, SENSOR_7_PIN};
+using tank::SensorMask;
 
-// Estado anterior para detectar cambios
-static bool previousLevels[NUM_SENSORS] = {false};
-static unsigned long lastDebounceTime[NUM_SENSORS] = {0};
-static bool debouncedLevels[NUM_SENSORS] = {false};
+// Pines de sensores (ordenados por nivel), ver tank_geometry.h
+static constexpr const int *sensorPins = tank::kPins;
+
+// Leer todas las boyas de una vez desde los registros de entrada GPIO
+// (GPIO 0-31 y 32-39 leídos consecutivamente) y empaquetarlas en una máscara.
+// El bucle sobre sensorPins es constante y el compilador lo desenrolla.
+static inline SensorMask IRAM_ATTR readSensorSnapshot() {
+  uint32_t in0 = REG_READ(GPIO_IN_REG);
+  uint32_t in1 = REG_READ(GPIO_IN1_REG);
+
+  SensorMask mask = 0;
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    uint32_t bit = sensorPins[i] < 32 ? (in0 >> sensorPins[i])
+                                      : (in1 >> (sensorPins[i] - 32));
+    mask |= (SensorMask)((bit & 1) << i);
+  }
+  return mask;
+}
+
+// Estado de debounce: lectura cruda y filtro vertical de todas las boyas
+static SensorMask rawMask = 0;
+static DebounceState debounce;
+
+static SensorLatencyStats latencyStats;
+
+#if SENSOR_USE_INTERRUPTS
+
+#define EDGE_BUFFER_MASK (SENSOR_EDGE_BUFFER_SIZE - 1)
+
+#if (SENSOR_EDGE_BUFFER_SIZE & EDGE_BUFFER_MASK) != 0
+#error "SENSOR_EDGE_BUFFER_SIZE debe ser potencia de 2"
+#endif
+
+// Flanco capturado por la ISR: foto completa de las boyas
+struct SensorEdge {
+  uint32_t timeUs;
+  SensorMask mask;
+};
+
+// Cola SPSC sin locks: la ISR solo escribe edgeHead y sensors_read() solo
+// escribe edgeTail. Ambos corren en el mismo core (la ISR se registra desde
+// setup()), así que basta con publicar edgeHead después de escribir el
+// flanco.
+static SensorEdge edgeBuffer[SENSOR_EDGE_BUFFER_SIZE];
+static volatile uint32_t edgeHead = 0;
+static volatile uint32_t edgeTail = 0;
+static volatile uint32_t edgeCount = 0;
+static volatile uint32_t edgeDrops = 0;
+
+#define DEBOUNCE_SAMPLE_US (DEBOUNCE_SAMPLE_MS * 1000UL)
+
+// Tras este número de muestras iguales el filtro ya no cambia: ponerse al
+// día tras un loop lento cuesta como mucho esto
+#define DEBOUNCE_CATCHUP_SAMPLES (DEBOUNCE_MAX_THRESHOLD + 1)
+
+// Instante de la próxima muestra del filtro (µs, clock_us() en 32 bits)
+static uint32_t nextSampleUs = 0;
+
+static void IRAM_ATTR sensorEdgeISR(void *arg) {
+  (void)arg;
+  sensors_push_edge(readSensorSnapshot(), (uint32_t)clock_us());
+}
+
+void IRAM_ATTR sensors_push_edge(SensorMask mask, uint32_t timeUs) {
+  uint32_t head = edgeHead;
+  if (head - edgeTail >= SENSOR_EDGE_BUFFER_SIZE) {
+    edgeDrops++;
+    return;
+  }
+
+  SensorEdge &edge = edgeBuffer[head & EDGE_BUFFER_MASK];
+  edge.timeUs = timeUs;
+  edge.mask = mask;
+  edgeHead = head + 1;
+  edgeCount++;
+}
+
+#else
+
+void sensors_push_edge(SensorMask mask, uint32_t timeUs) {
+  (void)mask;
+  (void)timeUs;
+}
+
+#endif
 
 void sensors_init() {
   // Configurar pines como entrada
   // GPIO 34 y 35 son solo entrada, no necesitan pulldown externo
   for (int i = 0; i < NUM_SENSORS; i++) {
     pinMode(sensorPins[i], INPUT);
-    previousLevels[i] = false;
-    debouncedLevels[i] = false;
-    lastDebounceTime[i] = 0;
   }
 
-  Serial.println("[SENSORS] Initialized 7 level sensors");
+  // Estado inicial leído directamente: la ISR solo reporta cambios
+  rawMask = readSensorSnapshot();
+  debounce_init(&debounce, DEBOUNCE_ASSERT_SAMPLES, DEBOUNCE_RELEASE_SAMPLES,
+                rawMask);
+  memset(&latencyStats, 0, sizeof(latencyStats));
+
+#if SENSOR_USE_INTERRUPTS
+  nextSampleUs = (uint32_t)clock_us() + DEBOUNCE_SAMPLE_US;
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    attachInterruptArg(digitalPinToInterrupt(sensorPins[i]), sensorEdgeISR,
+                       nullptr, CHANGE);
+  }
+
+  Serial.printf("[SENSORS] Initialized %d level sensors (interrupt capture)\n",
+                NUM_SENSORS);
+#else
+  Serial.printf("[SENSORS] Initialized %d level sensors\n", NUM_SENSORS);
+#endif
 }
 
-void sensors_read(SensorState *state) {
-  unsigned long currentTime = millis();
-  int newLevel = 0;
+void sensors_restore(SensorMask levels) {
+  rawMask = readSensorSnapshot();
+  debounce_init(&debounce, DEBOUNCE_ASSERT_SAMPLES, DEBOUNCE_RELEASE_SAMPLES,
+                levels);
+}
 
-  // Leer y aplicar debounce a cada sensor
-  for (int i = 0; i < NUM_SENSORS; i++) {
-    bool reading = digitalRead(sensorPins[i]) == HIGH;
+#if SENSOR_USE_INTERRUPTS
 
-    // Si cambió el estado, resetear timer de debounce
-    if (reading != previousLevels[i]) {
-      lastDebounceTime[i] = currentTime;
+// Avanzar el filtro hasta untilUs con la lectura cruda actual. Las muestras
+// caen en instantes fijos reconstruidos a partir de los timestamps de la
+// ISR, así que el resultado no depende de cuándo corra el loop.
+static SensorMask sampleUntil(uint32_t untilUs, uint32_t nowUs) {
+  SensorMask changed = 0;
+  int samples = 0;
+
+  while ((int32_t)(untilUs - nextSampleUs) >= 0) {
+    if (++samples > DEBOUNCE_CATCHUP_SAMPLES) {
+      // Filtro ya estable con esta lectura: saltar el resto
+      uint32_t skipped = (untilUs - nextSampleUs) / DEBOUNCE_SAMPLE_US + 1;
+      nextSampleUs += skipped * DEBOUNCE_SAMPLE_US;
+      break;
     }
 
-    // Si pasó el tiempo de debounce, aceptar el nuevo valor
-    if ((currentTime - lastDebounceTime[i]) > DEBOUNCE_TIME_MS) {
-      if (reading != debouncedLevels[i]) {
-        debouncedLevels[i] = reading;
-        state->lastChangeTime = currentTime;
+    SensorMask accepted = (SensorMask)debounce_sample(&debounce, rawMask);
+    if (accepted) {
+      changed |= accepted;
+
+      // Retraso entre el instante de aceptación y su detección
+      uint32_t acceptUs = nowUs - nextSampleUs;
+      latencyStats.lastAcceptUs = acceptUs;
+      if (acceptUs > latencyStats.maxAcceptUs) {
+        latencyStats.maxAcceptUs = acceptUs;
       }
     }
+    nextSampleUs += DEBOUNCE_SAMPLE_US;
+  }
+
+  return changed;
+}
 
-    previousLevels[i] = reading;
-    state->levels[i] = debouncedLevels[i];
+// Vaciar la cola de flancos y pasar cada foto al filtro en su instante
+// real. No depende del período del loop: el timestamp viene de la ISR.
+static bool debounceFromEdges(SensorState *state, uint64_t currentTime) {
+  uint32_t nowUs = (uint32_t)clock_us();
+  SensorMask changed = 0;
 
-    // Contar niveles activos
-    if (state->levels[i]) {
-      newLevel = i + 1; // El nivel es el sensor más alto activo
+  uint32_t head = edgeHead;
+  while (edgeTail != head) {
+    const SensorEdge &edge = edgeBuffer[edgeTail & EDGE_BUFFER_MASK];
+    changed |= sampleUntil(edge.timeUs, nowUs);
+    rawMask = edge.mask;
+
+    uint32_t drainUs = nowUs - edge.timeUs;
+    latencyStats.lastDrainUs = drainUs;
+    if (drainUs > latencyStats.maxDrainUs) {
+      latencyStats.maxDrainUs = drainUs;
     }
+    edgeTail = edgeTail + 1;
+  }
+
+  // Cola desbordada: resincronizar con una foto de los pines
+  if (edgeDrops != latencyStats.edgesDropped) {
+    latencyStats.edgesDropped = edgeDrops;
+    rawMask = readSensorSnapshot();
+  }
+  latencyStats.edgesCaptured = edgeCount;
+
+  changed |= sampleUntil(nowUs, nowUs);
+
+  if (changed) {
+    state->lastChangeTime = currentTime;
   }
+  return changed != 0;
+}
+
+#else
+
+// Una muestra del filtro por llamada: llamar cada DEBOUNCE_SAMPLE_MS
+static bool debounceFromPolling(SensorState *state, uint64_t currentTime) {
+  rawMask = readSensorSnapshot();
+
+  if (debounce_sample(&debounce, rawMask)) {
+    state->lastChangeTime = currentTime;
+    return true;
+  }
+
+  return false;
+}
+
+#endif
+
+bool sensors_read(SensorState *state) {
+  uint64_t currentTime = clock_ms();
+
+#if SENSOR_USE_INTERRUPTS
+  bool changed = debounceFromEdges(state, currentTime);
+#else
+  bool changed = debounceFromPolling(state, currentTime);
+#endif
+
+  sensors_apply(state, (SensorMask)debounce_get_state(&debounce));
+  return changed;
+}
+
+void sensors_apply(SensorState *state, SensorMask levels) {
+  state->levels = levels;
+  int newLevel = tank::maskLevel(levels);
 
   // Guardar nivel anterior antes de actualizar
   state->previousLevel = state->currentLevel;
@@ -80,7 +253,7 @@ void sensors_read(SensorState *state) {
     }
   }
 
-  // Si llegamos a 0 o 7, volver a IDLE
+  // Si llegamos a 0 o al tope, volver a IDLE
   if (state->currentLevel == 0 || state->currentLevel == NUM_SENSORS) {
     if (!state->sequenceError) {
       state->sequenceState = SEQ_IDLE;
@@ -91,27 +264,41 @@ void sensors_read(SensorState *state) {
 bool sensors_validate_sequence(SensorState *state) {
   // Verificar que los sensores activos sean contiguos desde el nivel 1
   // Por ejemplo: nivel 3 debe tener S1, S2, S3 activos
+  if (tank::maskContiguous(state->levels) &&
+      tank::maskLevel(state->levels) == state->currentLevel) {
+    return true;
+  }
 
-  bool valid = true;
-  int expectedActive = state->currentLevel;
-
-  for (int i = 0; i < NUM_SENSORS; i++) {
-    bool shouldBeActive = (i < expectedActive);
-    if (state->levels[i] != shouldBeActive) {
-      // Sensor no contiguo detectado
-      valid = false;
-      state->sequenceError = true;
-      state->sequenceState = SEQ_ERROR;
+  // Sensor no contiguo detectado
+  state->sequenceError = true;
+  state->sequenceState = SEQ_ERROR;
 
-      Serial.printf(
-          "[SENSORS] ERROR: Sensor %d deberia estar %s pero esta %s\n", i + 1,
-          shouldBeActive ? "ACTIVO" : "INACTIVO",
-          state->levels[i] ? "ACTIVO" : "INACTIVO");
-      break;
-    }
+  // Informar una vez por patrón y por tanque, no en cada validación
+  if (state->levels != state->reportedMask) {
+    state->reportedMask = state->levels;
+    Serial.printf("[SENSORS] ERROR: Boyas no contiguas (mascara 0x%lX, "
+                  "nivel %d)\n",
+                  (unsigned long)state->levels, state->currentLevel);
   }
 
-  return valid;
+  return false;
+}
+
+void sensors_get_latency(SensorLatencyStats *stats) {
+  memcpy(stats, &latencyStats, sizeof(SensorLatencyStats));
+}
+
+uint16_t sensors_get_bounces(int sensor) {
+  return debounce_get_bounces(&debounce, sensor);
+}
+
+void sensors_reset_latency() {
+  uint32_t captured = latencyStats.edgesCaptured;
+  uint32_t dropped = latencyStats.edgesDropped;
+  memset(&latencyStats, 0, sizeof(latencyStats));
+  latencyStats.edgesCaptured = captured;
+  latencyStats.edgesDropped = dropped;
+  debounce_reset_bounces(&debounce);
 }
 
 int sensors_get_level(const SensorState *state) { return state->currentLevel; }
@@ -133,7 +320,7 @@ void sensors_reset_error(SensorState *state) {
 void sensors_debug_print(const SensorState *state) {
   Serial.print("[SENSORS] Niveles: ");
   for (int i = 0; i < NUM_SENSORS; i++) {
-    Serial.print(state->levels[i] ? "1" : "0");
+    Serial.print((state->levels >> i) & 1 ? "1" : "0");
   }
   Serial.printf(" | Nivel: %d | Estado: ", state->currentLevel);
 
@@ -156,4 +343,19 @@ void sensors_debug_print(const SensorState *state) {
     Serial.print(" [ERROR SECUENCIA]");
   }
   Serial.println();
+
+  Serial.print("[SENSORS] Rebotes:");
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    Serial.printf(" %u", debounce_get_bounces(&debounce, i));
+  }
+  Serial.println();
+
+#if SENSOR_USE_INTERRUPTS
+  Serial.printf("[SENSORS] Flancos: %lu (perdidos %lu) | Latencia max: "
+                "cola %lu us, aceptacion +%lu us\n",
+                (unsigned long)latencyStats.edgesCaptured,
+                (unsigned long)latencyStats.edgesDropped,
+                (unsigned long)latencyStats.maxDrainUs,
+                (unsigned long)latencyStats.maxAcceptUs);
+#endif
 }
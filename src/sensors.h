@@ -1,40 +1,78 @@
 #ifndef SENSORS_H
 #define SENSORS_H
 
+#include "clock.h"
 #include "config.h"
+#include "tank_geometry.h"
 #include <Arduino.h>
 
 // Estados de secuencia
 enum SequenceState {
   SEQ_IDLE,     // Sin cambios
-  SEQ_FILLING,  // Llenándose (1→7)
-  SEQ_EMPTYING, // Vaciándose (7→1)
+  SEQ_FILLING,  // Llenándose (1→N)
+  SEQ_EMPTYING, // Vaciándose (N→1)
   SEQ_ERROR     // Secuencia incorrecta
 };
 
 // Estructura de estado de sensores
 struct SensorState {
-  bool levels[NUM_SENSORS];     // Estado actual de cada sensor
-  int currentLevel;             // Nivel actual (0-7)
+  tank::SensorMask levels;      // Máscara de sensores (bit 0 = nivel 1)
+  int currentLevel;             // Nivel actual (0-NUM_SENSORS)
   int previousLevel;            // Nivel anterior
   SequenceState sequenceState;  // Estado de la secuencia
   bool sequenceError;           // Flag de error de secuencia
-  unsigned long lastChangeTime; // Tiempo del último cambio
+  uint64_t lastChangeTime;     // clock_ms() del último cambio
+  tank::SensorMask reportedMask; // Último patrón no contiguo informado
+};
+
+// Latencias de la captura por interrupción (µs)
+struct SensorLatencyStats {
+  uint32_t edgesCaptured; // Flancos encolados por la ISR
+  uint32_t edgesDropped;  // Flancos perdidos por cola llena
+  uint32_t lastDrainUs;   // Flanco → sensors_read() (último)
+  uint32_t maxDrainUs;    // Flanco → sensors_read() (máximo)
+  uint32_t lastAcceptUs;  // Aceptación del filtro → detección (último)
+  uint32_t maxAcceptUs;   // Aceptación del filtro → detección (máximo)
 };
 
 // Inicializar pines de sensores
 void sensors_init();
 
+// Reiniciar el filtro de las boyas GPIO con una salida ya aceptada (reinicio
+// en caliente): la lectura cruda se toma de nuevo de los pines y el filtro
+// converge desde levels, como si nunca se hubiera reiniciado
+void sensors_restore(tank::SensorMask levels);
+
 // Leer estado actual de todos los sensores
-void sensors_read(SensorState *state);
+// Con SENSOR_USE_INTERRUPTS vacía la cola de flancos; llamar en cada loop.
+// Sin interrupciones toma una muestra; llamar cada DEBOUNCE_SAMPLE_MS.
+// Devuelve true si cambió algún nivel filtrado.
+bool sensors_read(SensorState *state);
+
+// Aplicar una máscara ya filtrada: actualiza nivel y dirección de la
+// secuencia. sensors_read() la usa con los GPIO; los tanques en expansores
+// I2C la llaman con su propia máscara.
+void sensors_apply(SensorState *state, tank::SensorMask levels);
+
+// Encolar una foto de las boyas (usado por la ISR; también sirve para
+// inyectar flancos sintéticos). timeUs en la base de clock_us()
+// truncada a 32 bits (solo se usan diferencias).
+void sensors_push_edge(tank::SensorMask mask, uint32_t timeUs);
+
+// Obtener / reiniciar estadísticas de latencia y rebotes
+void sensors_get_latency(SensorLatencyStats *stats);
+void sensors_reset_latency();
+
+// Rebotes descartados por el debounce en un sensor (0-based)
+uint16_t sensors_get_bounces(int sensor);
 
 // Validar secuencia de sensores
 bool sensors_validate_sequence(SensorState *state);
 
-// Obtener nivel actual (0-7)
+// Obtener nivel actual (0-NUM_SENSORS)
 int sensors_get_level(const SensorState *state);
 
-// Verificar si el tanque está lleno (nivel 7)
+// Verificar si el tanque está lleno (nivel NUM_SENSORS)
 bool sensors_is_tank_full(const SensorState *state);
 
 // Verificar si el tanque está vacío (nivel 0)
@@ -0,0 +1,57 @@
+#include "snapshot.h"
+#include <atomic>
+
+// Contador del seqlock: impar = escritura en curso
+static std::atomic<uint32_t> seqlock(0);
+static ControlSnapshot current;
+static std::atomic<bool> networkOnline(false);
+static uint32_t publishCount = 0;
+
+void snapshot_publish(const Tank *tanks, int count) {
+  uint32_t seq = seqlock.load(std::memory_order_relaxed);
+  seqlock.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  current.sequence = ++publishCount;
+  current.time = clock_ms();
+  current.networkOnline = networkOnline.load(std::memory_order_relaxed);
+
+  for (int i = 0; i < count && i < TANK_COUNT; i++) {
+    const Tank *tank = &tanks[i];
+    TankSnapshot *snap = &current.tanks[i];
+
+    snap->systemState = tank->systemState;
+    snap->level = tank->sensors.currentLevel;
+    snap->sequenceState = tank->sensors.sequenceState;
+    snap->sequenceError = tank->sensors.sequenceError;
+    snap->pumpState = tank->pump.state;
+    snap->pumpRunning = tank->pump.isRunning;
+    snap->pumpRunTime = tank->pump.runTime;
+    snap->totalRunTime = tank->pump.totalRunTime;
+    snap->cyclesCompleted = tank->pump.cyclesCompleted;
+    snap->lastCycleDuration = tank->pump.lastCycleDuration;
+  }
+
+  seqlock.store(seq + 2, std::memory_order_release);
+}
+
+bool snapshot_read(ControlSnapshot *out) {
+  uint32_t before;
+  uint32_t after = 0;
+
+  do {
+    before = seqlock.load(std::memory_order_acquire);
+    if (before & 1) {
+      continue; // Escritura en curso
+    }
+    memcpy(out, &current, sizeof(ControlSnapshot));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = seqlock.load(std::memory_order_relaxed);
+  } while ((before & 1) || before != after);
+
+  return out->sequence != 0;
+}
+
+void snapshot_set_network(bool online) {
+  networkOnline.store(online, std::memory_order_relaxed);
+}
@@ -0,0 +1,47 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "config.h"
+#include "tank.h"
+#include <Arduino.h>
+
+// ============================================
+// FOTO INMUTABLE DEL ESTADO DE CONTROL
+// ============================================
+// La tarea de control publica una copia de lo que necesitan display y MQTT
+// después de cada ciclo. Los lectores (otra tarea, otro core) la copian sin
+// locks con un seqlock: si el escritor publicó mientras copiaban, reintentan.
+// El escritor nunca espera a los lectores.
+
+// Resumen de un tanque
+struct TankSnapshot {
+  SystemState systemState;
+  int level;
+  SequenceState sequenceState;
+  bool sequenceError;
+  PumpState pumpState;
+  bool pumpRunning;
+  uint64_t pumpRunTime;       // ms
+  uint64_t totalRunTime;      // ms
+  int cyclesCompleted;
+  uint64_t lastCycleDuration; // ms
+};
+
+// Estado completo publicado por la tarea de control
+struct ControlSnapshot {
+  uint32_t sequence;   // Nº de publicación (crece de a 1)
+  uint64_t time;       // clock_ms() de la publicación
+  bool networkOnline;  // WiFi + broker (lo actualiza la tarea MQTT)
+  TankSnapshot tanks[TANK_COUNT];
+};
+
+// Publicar el estado actual de los tanques (solo la tarea de control)
+void snapshot_publish(const Tank *tanks, int count);
+
+// Copiar la última foto publicada. Devuelve false si no hay ninguna aún.
+bool snapshot_read(ControlSnapshot *out);
+
+// Estado de la red, escrito por quien maneja MQTT y leído en cada foto
+void snapshot_set_network(bool online);
+
+#endif // SNAPSHOT_H
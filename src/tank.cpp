@@ -0,0 +1,172 @@
+#include "tank.h"
+#include "cyclelog.h"
+
+// Anotar en el historial el fin de un ciclo normal
+static void recordCycle(const Tank *tank, uint64_t fillDuration) {
+  CycleRecord record;
+  memset(&record, 0, sizeof(record));
+  record.tank = tank->id;
+  record.kind = CYCLE_NORMAL;
+  record.fillMs = (uint32_t)fillDuration;
+  record.drainMs = (uint32_t)tank->pump.runTime;
+  cyclelog_record(&record);
+}
+
+// Anotar en el historial el fin de una emergencia (la bomba ya apagada)
+static void recordEmergency(const Tank *tank) {
+  CycleRecord record;
+  memset(&record, 0, sizeof(record));
+  record.tank = tank->id;
+  record.kind = CYCLE_EMERGENCY;
+  record.cause = tank->errorGap ? CAUSE_GAP : CAUSE_DIRECTION;
+  record.phase = tank->errorPhase;
+  record.level = tank->errorLevel;
+  record.drainMs = (uint32_t)tank->pump.runTime;
+  cyclelog_record(&record);
+}
+
+void tank_init(Tank *tank, int id, AlarmState *alarm) {
+  memset(tank, 0, sizeof(Tank));
+  tank->id = id;
+  tank->alarm = alarm;
+  tank->systemState = STATE_IDLE;
+  debounce_init(&tank->debounce, DEBOUNCE_ASSERT_SAMPLES,
+                DEBOUNCE_RELEASE_SAMPLES, 0);
+}
+
+bool tank_sample(Tank *tank, tank::SensorMask raw) {
+  bool changed = debounce_sample(&tank->debounce, raw) != 0;
+
+  sensors_apply(&tank->sensors,
+                (tank::SensorMask)debounce_get_state(&tank->debounce));
+  if (changed) {
+    tank->sensors.lastChangeTime = clock_ms();
+  }
+  // En cada muestra, no solo al cambiar: una boya trabada en un patrón no
+  // contiguo vuelve a marcar error después de limpiarlo (es una consulta a
+  // tabla)
+  sensors_validate_sequence(&tank->sensors);
+  return changed;
+}
+
+void tank_update(Tank *tank) {
+  SensorState *sensors = &tank->sensors;
+  PumpStatus *pump = &tank->pump;
+  SystemState previousState = tank->systemState;
+
+  switch (tank->systemState) {
+  case STATE_INIT:
+    // No debería llegar aquí después del setup
+    tank->systemState = STATE_IDLE;
+    break;
+
+  case STATE_IDLE:
+    // Esperando que empiece a llenarse
+    if (sensors->sequenceError) {
+      tank->systemState = STATE_ERROR;
+    } else if (sensors->currentLevel > 0) {
+      tank->systemState = STATE_FILLING;
+      tank->fillStartTime = clock_ms();
+      Serial.printf("[TANK %d] Water detected - entering FILLING state\n",
+                    tank->id);
+    }
+    break;
+
+  case STATE_FILLING:
+    // Llenándose, esperar nivel máximo
+    if (sensors->sequenceError) {
+      tank->systemState = STATE_ERROR;
+    } else if (sensors_is_tank_full(sensors)) {
+      // ¡Tanque lleno! Encender bomba
+      tank->systemState = STATE_PUMPING;
+      pump_on(pump);
+      alarm_beep(tank->alarm); // Beep de inicio
+      Serial.printf("[TANK %d] Tank FULL - PUMP ON\n", tank->id);
+    }
+    break;
+
+  case STATE_PUMPING:
+    // Bomba activa, esperar que llegue a vacío
+    if (sensors->sequenceError) {
+      // Error durante bombeo
+      tank->systemState = STATE_ERROR;
+    } else if (sensors_is_tank_empty(sensors)) {
+      // ¡Tanque vacío! Apagar bomba
+      pump_off(pump);
+      sensors_reset_error(sensors); // Limpiar estados
+
+      // Registrar tiempo de llenado (hasta encender la bomba) para
+      // cálculo de emergencia y para el historial
+      uint64_t fillDuration = pump->startTime - tank->fillStartTime;
+      pump_register_cycle(pump, fillDuration);
+      recordCycle(tank, fillDuration);
+
+      tank->systemState = STATE_IDLE;
+      alarm_beep(tank->alarm); // Beep de fin de ciclo
+      Serial.printf("[TANK %d] Tank EMPTY - PUMP OFF - Cycle complete\n",
+                    tank->id);
+    }
+    break;
+
+  case STATE_ERROR:
+    // Modo de error
+    if (!pump->isRunning) {
+      // Encender bomba en modo emergencia
+      pump_emergency_on(pump);
+      alarm_set(tank->alarm, ALARM_ERROR);
+      Serial.printf("[TANK %d] ERROR STATE - Emergency pump activated!\n",
+                    tank->id);
+    }
+
+    // Verificar si terminó el tiempo de emergencia
+    if (pump_emergency_timeout(pump)) {
+      pump_off(pump);
+      alarm_off(tank->alarm);
+      sensors_reset_error(sensors);
+      tank->systemState = STATE_IDLE;
+      Serial.printf("[TANK %d] Emergency timeout - returning to IDLE\n",
+                    tank->id);
+    }
+
+    // También terminar si todos los sensores están apagados
+    if (sensors_is_tank_empty(sensors) &&
+        pump->runTime > 5000) { // Al menos 5 segundos
+      pump_off(pump);
+      alarm_off(tank->alarm);
+      sensors_reset_error(sensors);
+      tank->systemState = STATE_IDLE;
+      Serial.printf("[TANK %d] Tank empty during emergency - returning to "
+                    "IDLE\n",
+                    tank->id);
+    }
+    break;
+  }
+
+  pump_update(pump);
+
+  // Entrada y salida del error: causa para el historial
+  if (previousState != STATE_ERROR && tank->systemState == STATE_ERROR) {
+    tank->errorPhase = previousState;
+    tank->errorLevel = sensors->currentLevel;
+    tank->errorGap = !tank::maskContiguous(sensors->levels);
+  } else if (previousState == STATE_ERROR &&
+             tank->systemState != STATE_ERROR) {
+    recordEmergency(tank);
+  }
+
+  // Log de cambio de estado
+  if (previousState != tank->systemState) {
+    Serial.printf("[TANK %d] State changed: %d -> %d\n", tank->id,
+                  previousState, tank->systemState);
+  }
+}
+
+void tank_clear_error(Tank *tank) {
+  pump_off(&tank->pump);
+  if (tank->systemState == STATE_ERROR) {
+    recordEmergency(tank);
+  }
+  alarm_off(tank->alarm);
+  sensors_reset_error(&tank->sensors);
+  tank->systemState = STATE_IDLE;
+}
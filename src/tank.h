@@ -0,0 +1,56 @@
+#ifndef TANK_H
+#define TANK_H
+
+#include "alarm.h"
+#include "config.h"
+#include "debounce.h"
+#include "pump.h"
+#include "sensors.h"
+#include <Arduino.h>
+
+// Tanques controlados: uno en GPIO, o NUM_TANKS en expansores I2C
+#if MULTI_TANK_ENABLED
+#define TANK_COUNT NUM_TANKS
+#else
+#define TANK_COUNT 1
+#endif
+
+// Estados de la máquina de estados de un tanque
+enum SystemState {
+  STATE_INIT,    // Inicialización
+  STATE_IDLE,    // Esperando llenado
+  STATE_FILLING, // Llenándose
+  STATE_PUMPING, // Bomba activa (vaciando)
+  STATE_ERROR    // Error de secuencia
+};
+
+// Un tanque controlado: boyas, bomba y máquina de estados. La alarma
+// (buzzer + LED) es física y única, así que se comparte entre tanques.
+struct Tank {
+  int id;                      // Índice del tanque (0-based)
+  SystemState systemState;     // Estado de la máquina
+  SensorState sensors;         // Boyas
+  PumpStatus pump;             // Bomba
+  AlarmState *alarm;           // Alarma compartida
+  DebounceState debounce;      // Filtro propio (solo tanques en expansor)
+  uint64_t fillStartTime;      // Inicio del llenado actual (clock_ms())
+  SystemState errorPhase;      // Estado al detectar el último error
+  int errorLevel;              // Nivel al detectar el último error
+  bool errorGap;               // Boyas no contiguas al detectar el error
+};
+
+// Inicializar estado del tanque (no toca hardware)
+void tank_init(Tank *tank, int id, AlarmState *alarm);
+
+// Procesar una muestra cruda de boyas de un expansor (llamar cada
+// DEBOUNCE_SAMPLE_MS). Valida la secuencia en cada muestra. Devuelve true
+// si cambió algún nivel filtrado.
+bool tank_sample(Tank *tank, tank::SensorMask raw);
+
+// Avanzar la máquina de estados y los tiempos de la bomba
+void tank_update(Tank *tank);
+
+// Limpiar error: apaga bomba y alarma, vuelve a IDLE
+void tank_clear_error(Tank *tank);
+
+#endif // TANK_H
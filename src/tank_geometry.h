@@ -0,0 +1,207 @@
+#ifndef TANK_GEOMETRY_H
+#define TANK_GEOMETRY_H
+
+#include "config.h"
+#include <stdint.h>
+#include <type_traits>
+
+// ============================================
+// GEOMETRÍA DEL TANQUE EN TIEMPO DE COMPILACIÓN
+// ============================================
+// Todo lo que depende del número de boyas (tipo de máscara, tablas de nivel,
+// gradiente de color, alto de cada franja) se deriva aquí de NUM_SENSORS y
+// SENSOR_PINS. Cada entorno de platformio.ini define su propia combinación y
+// los static_assert la validan al compilar.
+
+namespace tank {
+
+constexpr int kPins[] = {SENSOR_PINS};
+constexpr int kNumSensors = NUM_SENSORS;
+
+static_assert(kNumSensors >= 2 && kNumSensors <= 32,
+              "NUM_SENSORS fuera de rango (2-32)");
+static_assert(sizeof(kPins) / sizeof(kPins[0]) == kNumSensors,
+              "SENSOR_PINS no tiene NUM_SENSORS pines");
+
+// GPIO utilizable como entrada digital en el ESP32 (sin flash SPI 6-11 ni
+// los números que no existen)
+constexpr bool isInputPin(int pin) {
+  return pin >= 0 && pin <= 39 && !(pin >= 6 && pin <= 11) && pin != 20 &&
+         pin != 24 && !(pin >= 28 && pin <= 31);
+}
+
+// Pines que ya usa otra función de la placa
+constexpr int kReservedPins[] = {
+    PUMP_RELAY_PIN, BUZZER_PIN,  LED_ERROR_PIN, RESET_BUTTON_PIN,
+    I2C_SDA_PIN,    I2C_SCL_PIN, BACKLIGHT_PIN, TFT_RESERVED_PINS};
+
+constexpr bool isReservedPin(int pin) {
+  for (int reserved : kReservedPins) {
+    if (pin == reserved) {
+      return true;
+    }
+  }
+  return false;
+}
+
+#if defined(TFT_CS) && defined(TFT_RST) && defined(TFT_DC) &&                  \
+    defined(TFT_MOSI) && defined(TFT_SCLK)
+constexpr bool tftPinsReserved() {
+  return isReservedPin(TFT_CS) && isReservedPin(TFT_RST) &&
+         isReservedPin(TFT_DC) && isReservedPin(TFT_MOSI) &&
+         isReservedPin(TFT_SCLK);
+}
+static_assert(tftPinsReserved(),
+              "TFT_RESERVED_PINS no coincide con los pines de platformio.ini");
+#endif
+
+constexpr bool pinsValid() {
+  for (int i = 0; i < kNumSensors; i++) {
+    if (!isInputPin(kPins[i]) || isReservedPin(kPins[i])) {
+      return false;
+    }
+    for (int j = i + 1; j < kNumSensors; j++) {
+      if (kPins[i] == kPins[j]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static_assert(pinsValid(),
+              "SENSOR_PINS: pin inválido, repetido o usado por otra función");
+
+// Tipo de máscara más chico que entra en N boyas (bit 0 = nivel 1)
+template <int N>
+using MaskFor = typename std::conditional<
+    (N <= 8), uint8_t,
+    typename std::conditional<(N <= 16), uint16_t, uint32_t>::type>::type;
+
+using SensorMask = MaskFor<kNumSensors>;
+
+constexpr SensorMask kFullMask =
+    (SensorMask)((kNumSensors == 32) ? 0xFFFFFFFFUL
+                                     : ((1UL << kNumSensors) - 1));
+
+// ----------------------------------------------------------------
+// Nivel y contigüidad
+// ----------------------------------------------------------------
+// Hasta 8 boyas: tabla de 2^N entradas (bits 0-5 = nivel, bit 7 = válido).
+// Con más boyas la tabla crecería a 2^N bytes, así que se usa el bit más
+// alto (una instrucción NSAU en Xtensa) y la prueba m & (m + 1) == 0.
+constexpr uint8_t kEntryLevel = 0x3F;
+constexpr uint8_t kEntryValid = 0x80;
+
+template <int N> struct LevelTable {
+  uint8_t entry[1 << N];
+};
+
+template <int N> constexpr LevelTable<N> buildLevelTable() {
+  LevelTable<N> table = {};
+  for (int mask = 0; mask < (1 << N); mask++) {
+    int level = 0;
+    for (int i = 0; i < N; i++) {
+      if (mask & (1 << i)) {
+        level = i + 1;
+      }
+    }
+    bool valid = mask == (1 << level) - 1;
+    table.entry[mask] = (uint8_t)(level | (valid ? kEntryValid : 0));
+  }
+  return table;
+}
+
+template <int N, bool UseTable = (N <= 8)> struct LevelLookup;
+
+template <int N> struct LevelLookup<N, true> {
+  static constexpr LevelTable<N> table = buildLevelTable<N>();
+
+  static constexpr int level(MaskFor<N> mask) {
+    return table.entry[mask] & kEntryLevel;
+  }
+  static constexpr bool contiguous(MaskFor<N> mask) {
+    return (table.entry[mask] & kEntryValid) != 0;
+  }
+};
+
+template <int N> struct LevelLookup<N, false> {
+  static constexpr int level(MaskFor<N> mask) {
+    return mask ? 32 - __builtin_clz((uint32_t)mask) : 0;
+  }
+  static constexpr bool contiguous(MaskFor<N> mask) {
+    return (((uint64_t)mask + 1) & mask) == 0;
+  }
+};
+
+// Nivel = boya activa más alta (0 = vacío)
+constexpr int maskLevel(SensorMask mask) {
+  return LevelLookup<kNumSensors>::level(mask);
+}
+
+// Activos contiguos desde el nivel 1
+constexpr bool maskContiguous(SensorMask mask) {
+  return LevelLookup<kNumSensors>::contiguous(mask);
+}
+
+static_assert(maskLevel(0) == 0 && maskContiguous(0), "vacío válido");
+static_assert(maskLevel(0x07) == 3 && maskContiguous(0x07), "nivel 3");
+static_assert(maskLevel(0x05) == 3 && !maskContiguous(0x05), "hueco en S2");
+static_assert(maskLevel(kFullMask) == kNumSensors, "tanque lleno");
+
+// ----------------------------------------------------------------
+// Gradiente de agua (RGB565)
+// ----------------------------------------------------------------
+// Interpolación por componente entre COLOR_WATER_LOW (nivel 1) y
+// COLOR_WATER_HIGH (nivel N)
+constexpr uint16_t lerp565(uint16_t from, uint16_t to, int step, int steps) {
+  int r = ((from >> 11) & 0x1F) +
+          (((to >> 11) & 0x1F) - ((from >> 11) & 0x1F)) * step / steps;
+  int g = ((from >> 5) & 0x3F) +
+          (((to >> 5) & 0x3F) - ((from >> 5) & 0x3F)) * step / steps;
+  int b = (from & 0x1F) + ((to & 0x1F) - (from & 0x1F)) * step / steps;
+  return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+template <int N> struct Gradient {
+  uint16_t color[N];
+};
+
+template <int N> constexpr Gradient<N> buildWaterGradient() {
+  Gradient<N> gradient = {};
+  for (int i = 0; i < N; i++) {
+    gradient.color[i] = lerp565(COLOR_WATER_LOW, COLOR_WATER_HIGH, i, N - 1);
+  }
+  return gradient;
+}
+
+constexpr Gradient<kNumSensors> kWaterColors =
+    buildWaterGradient<kNumSensors>();
+
+static_assert(kWaterColors.color[0] == COLOR_WATER_LOW, "gradiente");
+static_assert(kWaterColors.color[kNumSensors - 1] == COLOR_WATER_HIGH,
+              "gradiente");
+
+// ----------------------------------------------------------------
+// Layout en píxeles
+// ----------------------------------------------------------------
+// Alto de franja entero y alto de tanque ajustado a N franjas exactas
+template <int MaxHeight, int N> struct Layout {
+  static constexpr int levelHeight = MaxHeight / N;
+  static constexpr int height = levelHeight * N;
+
+  static_assert(levelHeight >= 8, "Franja demasiado baja para la etiqueta");
+
+  // Y superior de la franja del nivel (1..N) dentro de un tanque en y0
+  static constexpr int bandY(int y0, int level) {
+    return y0 + height - level * levelHeight;
+  }
+  // Y de la marca centrada en la franja
+  static constexpr int tickY(int y0, int level) {
+    return bandY(y0, level) + levelHeight / 2;
+  }
+};
+
+} // namespace tank
+
+#endif // TANK_GEOMETRY_H
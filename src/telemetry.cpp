@@ -0,0 +1,403 @@
+#include "telemetry.h"
+#include <stddef.h>
+
+// ============================================
+// ESQUEMA DE MqttData
+// ============================================
+// Orden del mensaje. Los campos de un grupo van seguidos y el grupo se
+// abre como objeto (JSON) o mapa (CBOR) anidado con su nombre. event:
+// el cambio del campo es un evento que merece publicarse.
+
+enum FieldGroup : uint8_t { GROUP_ROOT, GROUP_PUMP, GROUP_STATS, GROUP_COUNT };
+enum FieldType : uint8_t { FIELD_INT, FIELD_ULONG, FIELD_BOOL, FIELD_STRING };
+
+struct Field {
+  const char *key;
+  uint8_t keyLen;
+  FieldGroup group;
+  FieldType type;
+  bool event;
+  uint16_t offset;
+};
+
+#define FIELD(key, group, type, event, member)                                 \
+  {key, sizeof(key) - 1, group, type, event, offsetof(MqttData, member)}
+
+static constexpr Field schema[] = {
+    FIELD("level", GROUP_ROOT, FIELD_INT, true, level),
+    FIELD("max_level", GROUP_ROOT, FIELD_INT, false, maxLevel),
+    FIELD("state", GROUP_PUMP, FIELD_STRING, true, pumpState),
+    FIELD("running", GROUP_PUMP, FIELD_BOOL, true, pumpRunning),
+    FIELD("runtime_s", GROUP_PUMP, FIELD_ULONG, false, pumpRuntime),
+    FIELD("error", GROUP_ROOT, FIELD_BOOL, true, hasError),
+    FIELD("sequence", GROUP_ROOT, FIELD_STRING, true, sequenceState),
+    FIELD("cycles_today", GROUP_STATS, FIELD_INT, true, cyclesCompleted),
+    FIELD("last_cycle_s", GROUP_STATS, FIELD_ULONG, false, lastCycleDuration),
+    FIELD("total_runtime_s", GROUP_STATS, FIELD_ULONG, false, totalRuntime),
+};
+
+#define FIELD_COUNT (int)(sizeof(schema) / sizeof(schema[0]))
+
+static const char *const groupKeys[GROUP_COUNT] = {nullptr, "pump", "stats"};
+
+// Bits de los campos de cada grupo, calculados al compilar
+static constexpr uint32_t groupMask(FieldGroup group) {
+  uint32_t mask = 0;
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (schema[i].group == group) {
+      mask |= 1UL << i;
+    }
+  }
+  return mask;
+}
+
+// Un grupo no puede aparecer en dos tramos: se abriría dos veces
+static constexpr bool groupsContiguous() {
+  for (int i = 1; i < FIELD_COUNT; i++) {
+    FieldGroup group = schema[i].group;
+    if (group == GROUP_ROOT || group == schema[i - 1].group) {
+      continue;
+    }
+    for (int j = 0; j < i; j++) {
+      if (schema[j].group == group) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static constexpr bool keysShort() {
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (schema[i].keyLen >= 24) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(FIELD_COUNT <= 32, "el esquema no entra en la máscara");
+static_assert(TELEMETRY_ALL_FIELDS == (1UL << FIELD_COUNT) - 1,
+              "TELEMETRY_ALL_FIELDS no coincide con el esquema");
+static_assert(groupsContiguous(), "los campos de un grupo deben ir seguidos");
+static_assert(keysShort(), "las claves CBOR se codifican en un byte de largo");
+
+static constexpr uint32_t groupMasks[GROUP_COUNT] = {
+    groupMask(GROUP_ROOT), groupMask(GROUP_PUMP), groupMask(GROUP_STATS)};
+
+static const void *fieldPtr(const MqttData *data, int i) {
+  return (const uint8_t *)data + schema[i].offset;
+}
+
+static bool fieldChanged(const MqttData *data, const MqttData *prev, int i) {
+  const void *a = fieldPtr(data, i);
+  const void *b = fieldPtr(prev, i);
+  switch (schema[i].type) {
+  case FIELD_INT:
+    return *(const int *)a != *(const int *)b;
+  case FIELD_ULONG:
+    return *(const unsigned long *)a != *(const unsigned long *)b;
+  case FIELD_BOOL:
+    return *(const bool *)a != *(const bool *)b;
+  case FIELD_STRING:
+    return strcmp(*(const char *const *)a, *(const char *const *)b) != 0;
+  }
+  return false;
+}
+
+uint32_t telemetry_delta_fields(const MqttData *data, const MqttData *prev) {
+  uint32_t fields = 0;
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (schema[i].event && fieldChanged(data, prev, i)) {
+      FieldGroup group = schema[i].group;
+      fields |= group == GROUP_ROOT ? 1UL << i : groupMasks[group];
+    }
+  }
+  return fields;
+}
+
+// ============================================
+// DESTINOS
+// ============================================
+// El mismo codificador corre sobre dos destinos: uno que solo cuenta
+// (telemetry_size) y otro que junta trozos y los pasa al Print.
+
+struct CountSink {
+  size_t length = 0;
+
+  void put(uint8_t c) {
+    (void)c;
+    length++;
+  }
+  void raw(const char *text, size_t len) {
+    (void)text;
+    length += len;
+  }
+  // Decimal: solo las cifras, sin formatear
+  void decimal(unsigned long value) {
+    do {
+      length++;
+      value /= 10;
+    } while (value > 0);
+  }
+};
+
+struct PrintSink {
+  Print *out;
+  size_t length = 0;
+  size_t fill = 0;
+  uint8_t chunk[TELEMETRY_CHUNK];
+
+  explicit PrintSink(Print *print) : out(print) {}
+
+  void flush() {
+    if (fill > 0) {
+      length += out->write(chunk, fill);
+      fill = 0;
+    }
+  }
+  void put(uint8_t c) {
+    if (fill == sizeof(chunk)) {
+      flush();
+    }
+    chunk[fill++] = c;
+  }
+  void raw(const char *text, size_t len) {
+    while (len > 0) {
+      if (fill == sizeof(chunk)) {
+        flush();
+      }
+      size_t n = min(len, sizeof(chunk) - fill);
+      memcpy(chunk + fill, text, n);
+      fill += n;
+      text += n;
+      len -= n;
+    }
+  }
+  void decimal(unsigned long value) {
+    char digits[20];
+    int n = 0;
+    do {
+      digits[n++] = '0' + value % 10;
+      value /= 10;
+    } while (value > 0);
+    while (n > 0) {
+      put(digits[--n]);
+    }
+  }
+};
+
+// ============================================
+// JSON
+// ============================================
+// Mismo texto que el snprintf anterior: sin espacios y con las claves en
+// el orden del esquema. Los valores de texto son nombres fijos (estado de
+// bomba y secuencia) y no necesitan escape.
+
+template <class Sink>
+static void jsonKey(Sink &sink, const char *key, size_t len) {
+  sink.put('"');
+  sink.raw(key, len);
+  sink.raw("\":", 2);
+}
+
+template <class Sink>
+static void jsonValue(Sink &sink, const MqttData *data, int i) {
+  const void *value = fieldPtr(data, i);
+  switch (schema[i].type) {
+  case FIELD_INT: {
+    int n = *(const int *)value;
+    if (n < 0) {
+      sink.put('-');
+    }
+    sink.decimal(n < 0 ? 0UL - (unsigned long)n : (unsigned long)n);
+    break;
+  }
+  case FIELD_ULONG:
+    sink.decimal(*(const unsigned long *)value);
+    break;
+  case FIELD_BOOL:
+    if (*(const bool *)value) {
+      sink.raw("true", 4);
+    } else {
+      sink.raw("false", 5);
+    }
+    break;
+  case FIELD_STRING: {
+    const char *text = *(const char *const *)value;
+    sink.put('"');
+    sink.raw(text, strlen(text));
+    sink.put('"');
+    break;
+  }
+  }
+}
+
+template <class Sink>
+static void encodeJson(Sink &sink, const MqttData *data, uint32_t fields) {
+  bool first = true;      // Primer miembro del objeto raíz
+  bool groupFirst = true; // Primer miembro del grupo abierto
+  FieldGroup open = GROUP_ROOT;
+
+  sink.put('{');
+  if (fields != TELEMETRY_ALL_FIELDS) {
+    sink.raw("\"delta\":true", 12);
+    first = false;
+  }
+
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (!(fields & (1UL << i))) {
+      continue;
+    }
+    FieldGroup group = schema[i].group;
+    if (group != open) {
+      if (open != GROUP_ROOT) {
+        sink.put('}');
+      }
+      if (group != GROUP_ROOT) {
+        if (!first) {
+          sink.put(',');
+        }
+        jsonKey(sink, groupKeys[group], strlen(groupKeys[group]));
+        sink.put('{');
+        groupFirst = true;
+      }
+      first = false;
+      open = group;
+    }
+
+    bool *isFirst = group == GROUP_ROOT ? &first : &groupFirst;
+    if (!*isFirst) {
+      sink.put(',');
+    }
+    *isFirst = false;
+    jsonKey(sink, schema[i].key, schema[i].keyLen);
+    jsonValue(sink, data, i);
+  }
+
+  if (open != GROUP_ROOT) {
+    sink.put('}');
+  }
+  sink.put('}');
+}
+
+// ============================================
+// CBOR (RFC 8949)
+// ============================================
+// Mapas de largo definido con las mismas claves que el JSON: el consumidor
+// ve la misma estructura. Enteros en el menor ancho que entren.
+
+template <class Sink>
+static void cborHead(Sink &sink, uint8_t major, unsigned long value) {
+  major <<= 5;
+  if (value < 24) {
+    sink.put(major | value);
+  } else if (value <= 0xFF) {
+    sink.put(major | 24);
+    sink.put(value);
+  } else if (value <= 0xFFFF) {
+    sink.put(major | 25);
+    sink.put(value >> 8);
+    sink.put(value & 0xFF);
+  } else {
+    sink.put(major | 26);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      sink.put((value >> shift) & 0xFF);
+    }
+  }
+}
+
+template <class Sink>
+static void cborText(Sink &sink, const char *text, size_t len) {
+  cborHead(sink, 3, len);
+  sink.raw(text, len);
+}
+
+template <class Sink>
+static void cborValue(Sink &sink, const MqttData *data, int i) {
+  const void *value = fieldPtr(data, i);
+  switch (schema[i].type) {
+  case FIELD_INT: {
+    int n = *(const int *)value;
+    if (n < 0) {
+      cborHead(sink, 1, (unsigned long)(-1 - n));
+    } else {
+      cborHead(sink, 0, (unsigned long)n);
+    }
+    break;
+  }
+  case FIELD_ULONG:
+    cborHead(sink, 0, *(const unsigned long *)value & 0xFFFFFFFFUL);
+    break;
+  case FIELD_BOOL:
+    sink.put(*(const bool *)value ? 0xF5 : 0xF4);
+    break;
+  case FIELD_STRING: {
+    const char *text = *(const char *const *)value;
+    cborText(sink, text, strlen(text));
+    break;
+  }
+  }
+}
+
+static int countBits(uint32_t value) { return __builtin_popcount(value); }
+
+template <class Sink>
+static void encodeCbor(Sink &sink, const MqttData *data, uint32_t fields) {
+  bool delta = fields != TELEMETRY_ALL_FIELDS;
+
+  // Entradas del mapa raíz: campos sueltos, grupos presentes y "delta"
+  int entries = countBits(fields & groupMasks[GROUP_ROOT]) + (delta ? 1 : 0);
+  for (int g = GROUP_ROOT + 1; g < GROUP_COUNT; g++) {
+    entries += (fields & groupMasks[g]) ? 1 : 0;
+  }
+  cborHead(sink, 5, entries);
+  if (delta) {
+    cborText(sink, "delta", 5);
+    sink.put(0xF5);
+  }
+
+  FieldGroup open = GROUP_ROOT;
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (!(fields & (1UL << i))) {
+      continue;
+    }
+    FieldGroup group = schema[i].group;
+    if (group != open && group != GROUP_ROOT) {
+      cborText(sink, groupKeys[group], strlen(groupKeys[group]));
+      cborHead(sink, 5, countBits(fields & groupMasks[group]));
+    }
+    open = group;
+    cborText(sink, schema[i].key, schema[i].keyLen);
+    cborValue(sink, data, i);
+  }
+}
+
+template <class Sink>
+static void encode(Sink &sink, TelemetryFormat format, const MqttData *data,
+                   uint32_t fields) {
+  if (format == TELEMETRY_CBOR) {
+    encodeCbor(sink, data, fields);
+  } else {
+    encodeJson(sink, data, fields);
+  }
+}
+
+size_t telemetry_size(TelemetryFormat format, const MqttData *data,
+                      uint32_t fields) {
+  CountSink sink;
+  encode(sink, format, data, fields);
+  return sink.length;
+}
+
+size_t telemetry_write(Print *out, TelemetryFormat format, const MqttData *data,
+                       uint32_t fields) {
+  PrintSink sink(out);
+  encode(sink, format, data, fields);
+  sink.flush();
+  return sink.length;
+}
+
+const char *telemetry_format_name(TelemetryFormat format) {
+  return format == TELEMETRY_CBOR ? "cbor" : "json";
+}
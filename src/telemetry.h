@@ -0,0 +1,51 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "config.h"
+#include <Arduino.h>
+
+// ============================================
+// SERIALIZADOR DE TELEMETRÍA
+// ============================================
+// El estado se codifica recorriendo un esquema fijo de MqttData (clave,
+// grupo, tipo) en JSON o CBOR, directo sobre un Print (el cliente MQTT)
+// en trozos de TELEMETRY_CHUNK bytes: sin buffer del mensaje completo ni
+// memoria dinámica. telemetry_size() da la longitud exacta antes de
+// escribir, como pide beginPublish().
+
+enum TelemetryFormat { TELEMETRY_JSON, TELEMETRY_CBOR };
+
+// Estructura de datos para publicar
+struct MqttData {
+  int level;
+  int maxLevel;
+  const char *pumpState;
+  bool pumpRunning;
+  unsigned long pumpRuntime; // segundos
+  bool hasError;
+  const char *sequenceState;
+  int cyclesCompleted;
+  unsigned long lastCycleDuration; // segundos
+  unsigned long totalRuntime;      // segundos de bomba hoy
+};
+
+// Conjunto de campos a codificar: un bit por campo del esquema. Con menos
+// que TELEMETRY_ALL_FIELDS el mensaje es un delta ("delta": true).
+#define TELEMETRY_ALL_FIELDS 0x3FFUL
+
+// Campos de un delta respecto de prev: los de evento que cambiaron, y los
+// grupos (pump, stats) enteros si cambió alguno de sus campos de evento.
+// Devuelve 0 si no hay evento (el cronómetro de la bomba solo no cuenta).
+uint32_t telemetry_delta_fields(const MqttData *data, const MqttData *prev);
+
+// Bytes exactos del mensaje, sin escribir nada
+size_t telemetry_size(TelemetryFormat format, const MqttData *data,
+                      uint32_t fields);
+
+// Escribir el mensaje en out. Devuelve los bytes aceptados por out.
+size_t telemetry_write(Print *out, TelemetryFormat format, const MqttData *data,
+                       uint32_t fields);
+
+const char *telemetry_format_name(TelemetryFormat format);
+
+#endif // TELEMETRY_H
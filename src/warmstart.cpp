@@ -0,0 +1,210 @@
+#include "warmstart.h"
+#include "clock.h"
+#include <stddef.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_system.h>
+#endif
+
+#define WARM_MAGIC 0x314D5257UL // "WRM1"
+
+// Lo que hace falta para seguir con un tanque
+struct WarmTank {
+  uint8_t systemState;
+  uint8_t pumpState;
+  uint8_t sequenceState;
+  uint8_t errorPhase;
+  uint32_t levels;
+  int16_t currentLevel;
+  int16_t previousLevel;
+  int16_t errorLevel;
+  bool sequenceError;
+  bool errorGap;
+  uint32_t fillElapsedMs; // Desde fillStartTime
+  uint32_t pumpElapsedMs; // Desde el encendido de la bomba
+  uint32_t emergencyMs;   // Duración de la emergencia en curso
+};
+
+struct WarmSlot {
+  uint32_t magic;
+  uint32_t seq;      // La copia con el mayor es la última
+  uint32_t restarts; // Reinicios en caliente desde el último en frío
+  uint16_t tankCount;
+  uint16_t quickRestarts; // Seguidos, sin llegar a WARM_STABLE_MS de marcha
+  WarmTank tanks[TANK_COUNT];
+  uint32_t check; // FNV-1a de todo lo anterior
+};
+
+// Fuera del ESP32 (simulación) es memoria común: sobrevive a un
+// "reinicio" dentro del mismo proceso
+#ifdef ESP_PLATFORM
+static RTC_NOINIT_ATTR WarmSlot slots[2];
+#else
+static WarmSlot slots[2];
+#endif
+
+static uint32_t seq = 0;
+static uint32_t restarts = 0;
+static uint16_t quickRestarts = 0;
+static WarmStartInfo info;
+
+static uint32_t checksum(const WarmSlot *slot) {
+  const uint8_t *bytes = (const uint8_t *)slot;
+  uint32_t hash = 2166136261UL;
+  for (size_t i = 0; i < offsetof(WarmSlot, check); i++) {
+    hash = (hash ^ bytes[i]) * 16777619UL;
+  }
+  return hash;
+}
+
+static bool valid(const WarmSlot *slot) {
+  return slot->magic == WARM_MAGIC && slot->tankCount == TANK_COUNT &&
+         slot->check == checksum(slot);
+}
+
+void warmstart_save(const Tank *tanks, int count) {
+  WarmSlot slot;
+  memset(&slot, 0, sizeof(slot));
+  slot.magic = WARM_MAGIC;
+  slot.seq = ++seq;
+  slot.restarts = restarts;
+  slot.tankCount = TANK_COUNT;
+
+  uint64_t now = clock_ms();
+  if (now >= WARM_STABLE_MS) {
+    quickRestarts = 0; // Marcha estable: se corta la racha
+  }
+  slot.quickRestarts = quickRestarts;
+  for (int i = 0; i < count && i < TANK_COUNT; i++) {
+    const Tank *tank = &tanks[i];
+    WarmTank *w = &slot.tanks[i];
+    w->systemState = tank->systemState;
+    w->pumpState = tank->pump.isRunning ? tank->pump.state : PUMP_OFF;
+    w->sequenceState = tank->sensors.sequenceState;
+    w->errorPhase = tank->errorPhase;
+    w->levels = tank->sensors.levels;
+    w->currentLevel = tank->sensors.currentLevel;
+    w->previousLevel = tank->sensors.previousLevel;
+    w->errorLevel = tank->errorLevel;
+    w->sequenceError = tank->sensors.sequenceError;
+    w->errorGap = tank->errorGap;
+    w->fillElapsedMs = (uint32_t)(now - tank->fillStartTime);
+    w->pumpElapsedMs = (uint32_t)(now - tank->pump.startTime);
+    w->emergencyMs = (uint32_t)tank->pump.emergencyDuration;
+  }
+  slot.check = checksum(&slot);
+
+  // Alternar: la otra copia sigue válida mientras se escribe esta
+  slots[seq & 1] = slot;
+}
+
+#ifdef ESP_PLATFORM
+// Reinicios en los que la bomba puede seguir. Encendido: memoria RTC sin
+// inicializar. Brownout: puede causarlo la propia bomba y retomarla
+// volvería a tirar la tensión. Pin EN o desconocido: sin garantías.
+static bool resumableReason(uint32_t reason) {
+  switch (reason) {
+  case ESP_RST_SW:
+  case ESP_RST_PANIC:
+  case ESP_RST_INT_WDT:
+  case ESP_RST_TASK_WDT:
+  case ESP_RST_WDT:
+    return true;
+  default:
+    return false;
+  }
+}
+#endif
+
+bool warmstart_restore(Tank *tanks, int count) {
+  memset(&info, 0, sizeof(info));
+#ifdef ESP_PLATFORM
+  info.resetReason = esp_reset_reason();
+  if (!resumableReason(info.resetReason)) {
+    Serial.printf("[WARM] Reset reason %lu - cold start\n",
+                  (unsigned long)info.resetReason);
+    warmstart_clear();
+    return false;
+  }
+#endif
+
+  const WarmSlot *slot = nullptr;
+  for (int i = 0; i < 2; i++) {
+    if (valid(&slots[i]) && (!slot || slots[i].seq > slot->seq)) {
+      slot = &slots[i];
+    }
+  }
+  if (!slot) {
+    Serial.println("[WARM] No saved state - cold start");
+    return false;
+  }
+
+  seq = slot->seq;
+  restarts = slot->restarts + 1;
+  quickRestarts = slot->quickRestarts + 1;
+  info.restarts = restarts;
+  if (quickRestarts > WARM_MAX_QUICK_RESTARTS) {
+    // La racha sigue contando hasta que el equipo aguante WARM_STABLE_MS
+    Serial.printf("[WARM] %lu restarts in a row - cold start without "
+                  "resuming the pump\n",
+                  (unsigned long)quickRestarts);
+    return false;
+  }
+
+  uint64_t now = clock_ms();
+  for (int i = 0; i < count && i < TANK_COUNT; i++) {
+    Tank *tank = &tanks[i];
+    const WarmTank *w = &slot->tanks[i];
+    if (w->systemState > STATE_ERROR || w->pumpState > PUMP_EMERGENCY) {
+      continue;
+    }
+
+    // Los tiempos son instantes de clock_ms(), que volvió a cero: restar
+    // puede dar la vuelta en 64 bits, pero solo se usan diferencias
+    tank->systemState = (SystemState)w->systemState;
+    tank->fillStartTime = now - w->fillElapsedMs;
+    tank->errorPhase = (SystemState)w->errorPhase;
+    tank->errorLevel = w->errorLevel;
+    tank->errorGap = w->errorGap;
+
+    // Boyas como estaban: la primera lectura sigue la secuencia desde aquí
+    // y no desde vacío (que en STATE_PUMPING apagaría la bomba)
+    SensorState *sensors = &tank->sensors;
+    sensors->levels = w->levels;
+    sensors->currentLevel = w->currentLevel;
+    sensors->previousLevel = w->previousLevel;
+    sensors->sequenceState = (SequenceState)w->sequenceState;
+    sensors->sequenceError = w->sequenceError;
+    sensors->lastChangeTime = now;
+#if MULTI_TANK_ENABLED
+    debounce_init(&tank->debounce, DEBOUNCE_ASSERT_SAMPLES,
+                  DEBOUNCE_RELEASE_SAMPLES, w->levels);
+#else
+    // Un solo tanque: el filtro es el de sensors.cpp, no tank->debounce
+    sensors_restore(w->levels);
+#endif
+
+    pump_resume(&tank->pump, (PumpState)w->pumpState,
+                now - w->pumpElapsedMs, w->emergencyMs);
+    if (tank->systemState == STATE_ERROR) {
+      alarm_set(tank->alarm, ALARM_ERROR);
+    }
+
+    Serial.printf("[WARM] Tank %d resumed in state %d, level %d, pump %d\n",
+                  i, tank->systemState, sensors->currentLevel,
+                  tank->pump.state);
+  }
+
+  info.resumed = true;
+  return true;
+}
+
+void warmstart_clear() {
+  memset(slots, 0, sizeof(slots));
+  restarts = 0;
+  quickRestarts = 0;
+}
+
+void warmstart_get_info(WarmStartInfo *out) {
+  memcpy(out, &info, sizeof(info));
+}
@@ -0,0 +1,43 @@
+#ifndef WARMSTART_H
+#define WARMSTART_H
+
+#include "config.h"
+#include "tank.h"
+#include <Arduino.h>
+
+// ============================================
+// REINICIO EN CALIENTE
+// ============================================
+// La tarea de control copia en cada ciclo el estado de la máquina de cada
+// tanque (estado, inicio del llenado, bomba y secuencia de boyas) a memoria
+// RTC, que sobrevive a un reinicio por software, watchdog o pánico pero no
+// a un corte de energía. Al arrancar tras uno de esos reinicios, si hay una
+// copia válida, el tanque sigue donde estaba: un reinicio a mitad de
+// STATE_PUMPING vuelve a encender la bomba con su tiempo de marcha en lugar
+// de empezar de cero. Brownout y encendido arrancan en frío, igual que una
+// racha de más de WARM_MAX_QUICK_RESTARTS reinicios seguidos.
+//
+// Dos copias alternadas con checksum: un reinicio a mitad de una escritura
+// deja la anterior. Los tiempos se guardan como transcurridos; el tiempo
+// del reinicio en sí (unos cientos de ms) no se cuenta.
+
+struct WarmStartInfo {
+  bool resumed;         // Se retomó el estado anterior
+  uint32_t resetReason; // esp_reset_reason() (0 fuera del ESP32)
+  uint32_t restarts;    // Reinicios en caliente desde el último en frío
+};
+
+// Guardar el estado de control (solo la tarea de control, cada ciclo)
+void warmstart_save(const Tank *tanks, int count);
+
+// Retomar el estado guardado (en setup(), después de tank_init(), de
+// iniciar boyas y relés y de pumpstats_init()). Devuelve true si se retomó.
+bool warmstart_restore(Tank *tanks, int count);
+
+// Descartar lo guardado (al entrar en modo demo o antes de un reinicio
+// pedido por el usuario, que debe arrancar en frío)
+void warmstart_clear();
+
+void warmstart_get_info(WarmStartInfo *out);
+
+#endif // WARMSTART_H
@@ -0,0 +1,243 @@
+/*
+ * Prueba de la base de tiempo de 64 bits
+ * ======================================
+ * Corre scheduler.cpp, pump.cpp y alarm.cpp sin cambios sobre el reloj
+ * falso a través de los desbordes que tenían los contadores de 32 bits:
+ * micros() a los 2^32 µs (~71 min) y millis() a los 2^32 ms (~49,7 días).
+ *
+ * Verifica:
+ *   - meses de planificador sin desvío: cada trabajo corre exactamente
+ *     sobre su grilla, sin atrasos ni overruns, y el de una sola vez a los
+ *     45 días en su plazo
+ *   - tiempos de bomba exactos cruzando 2^32 ms, una bomba que corre más
+ *     de 2^32 ms y un promedio de ciclos cuya suma pasa de 2^32
+ *   - el patrón de la alarma y un beep no se cortan ni se traban en el
+ *     desborde
+ *
+ * Uso: clock_check [--days N] [--verbose]
+ */
+
+#include "alarm.h"
+#include "clock.h"
+#include "pump.h"
+#include "scheduler.h"
+#include "sim_check.h"
+
+#define SECOND_MS 1000ULL
+#define HOUR_MS (3600 * SECOND_MS)
+#define DAY_MS (24 * HOUR_MS)
+#define WRAP32 ((uint64_t)1 << 32)
+
+static uint32_t days = 120;
+
+static void advanceMs(uint64_t ms) { clock_fake_advance(ms * 1000); }
+
+// La tarea duerme: el reloj falso avanza lo pedido
+void vTaskDelay(uint32_t ticks) { advanceMs(ticks); }
+
+// ----------------------------------------------------------------
+// Planificador
+// ----------------------------------------------------------------
+
+struct Tracker {
+  uint32_t periodMs;
+  uint64_t firstMs; // Primer plazo
+  uint64_t lastMs;
+  uint32_t runs;
+  uint32_t offGrid; // Ejecuciones fuera de firstMs + k * periodMs
+};
+
+static void track(void *arg) {
+  Tracker *t = (Tracker *)arg;
+  uint64_t now = clock_ms();
+  uint64_t expected = t->firstMs + (uint64_t)t->runs * t->periodMs;
+  if (now != expected) {
+    t->offGrid++;
+  }
+  t->lastMs = now;
+  t->runs++;
+}
+
+static void schedulerCase(const char *label, uint64_t startUs) {
+  clock_fake_start(startUs);
+  Scheduler sched;
+  scheduler_init(&sched, "sim");
+
+  static const uint32_t periodsMs[] = {1000, 60000, 3600000};
+  static const uint32_t firstDelaysMs[] = {250, 1000, 60000};
+  const int count = sizeof(periodsMs) / sizeof(periodsMs[0]);
+  Tracker trackers[count + 1];
+  int ids[count + 1];
+  for (int i = 0; i < count; i++) {
+    trackers[i] = {periodsMs[i], clock_ms() + firstDelaysMs[i], 0, 0, 0};
+    ids[i] = scheduler_every(&sched, "job", periodsMs[i], firstDelaysMs[i],
+                             track, &trackers[i]);
+  }
+  uint32_t onceDelayMs = 45 * DAY_MS;
+  trackers[count] = {0, clock_ms() + onceDelayMs, 0, 0, 0};
+  ids[count] = scheduler_once(&sched, "once", onceDelayMs, track,
+                              &trackers[count]);
+
+  uint64_t startMs = clock_ms();
+  uint64_t endMs = startMs + days * DAY_MS;
+  uint32_t spins = 0; // Pasadas seguidas sin dormir
+  while (clock_ms() < endMs && spins < 1000) {
+    uint64_t before = clock_ms();
+    scheduler_run_and_sleep(&sched);
+    spins = clock_ms() == before ? spins + 1 : 0;
+  }
+  check(spins < 1000, "scheduler spun without sleeping");
+
+  uint64_t elapsed = clock_ms() - startMs;
+  for (int i = 0; i < count; i++) {
+    const Tracker *t = &trackers[i];
+    const SchedJob *job = &sched.jobs[ids[i]];
+    // Plazos anteriores al último instante (el que cae justo ahí no corrió)
+    uint64_t expected = (elapsed - firstDelaysMs[i] - 1) / periodsMs[i] + 1;
+    check(t->runs == expected, "periodic job run count drifted");
+    check(t->offGrid == 0, "periodic job ran off its grid");
+    check(job->overruns == 0 && job->maxLateMs == 0,
+          "periodic job late or overrun");
+  }
+  check(trackers[count].runs == 1 && trackers[count].offGrid == 0,
+        "45-day one-shot job did not run once on time");
+
+  printf("%-22s %8llu %8lu %8lu %8lu %6s\n", label,
+         (unsigned long long)(elapsed / DAY_MS),
+         (unsigned long)trackers[0].runs, (unsigned long)trackers[1].runs,
+         (unsigned long)trackers[2].runs,
+         trackers[count].runs == 1 ? "yes" : "no");
+}
+
+// ----------------------------------------------------------------
+// Bomba
+// ----------------------------------------------------------------
+
+static void pumpCase() {
+  PumpStatus pump;
+  memset(&pump, 0, sizeof(pump));
+
+  // Ciclo de 90 s que empieza 30 s antes de 2^32 ms
+  clock_fake_start((WRAP32 - 30 * SECOND_MS) * 1000);
+  pump_on(&pump);
+  for (int s = 0; s < 90; s++) {
+    advanceMs(SECOND_MS);
+    pump_update(&pump);
+    check(pump.runTime == (uint64_t)(s + 1) * SECOND_MS,
+          "runTime jumped across 2^32 ms");
+  }
+  pump_off(&pump);
+  check(pump.runTime == 90 * SECOND_MS && pump.lastCycleDuration == 90000,
+        "cycle across 2^32 ms not 90 s");
+  check(pump.avgCycleDuration == 90000, "average wrong after wrap cycle");
+
+  // Emergencia que corre 60 días (> 2^32 ms) sin apagarse
+  pump_emergency_on(&pump);
+  uint64_t runMs = 60 * DAY_MS;
+  for (uint64_t t = 0; t < runMs; t += HOUR_MS) {
+    advanceMs(HOUR_MS);
+    pump_update(&pump);
+  }
+  check(pump.runTime == runMs, "60-day runTime wrapped");
+  check(pump_emergency_timeout(&pump), "emergency timeout missed");
+  pump_off(&pump);
+  check(pump.totalRunTime == 90 * SECOND_MS + runMs,
+        "totalRunTime wrapped past 2^32 ms");
+
+  // Dos ciclos de 30 días: la suma pasa de 2^32 y el promedio es exacto
+  pump_reset_daily_stats(&pump);
+  for (int i = 0; i < 2; i++) {
+    pump_on(&pump);
+    advanceMs(30 * DAY_MS);
+    pump_off(&pump);
+  }
+  check(pump.cycleTimeSum == 60 * DAY_MS && pump.cyclesCompleted == 2,
+        "cycle sum wrapped past 2^32 ms");
+  check(pump.avgCycleDuration == 30 * DAY_MS, "30-day average wrong");
+  check(pump_get_emergency_time(&pump) ==
+            (uint64_t)(30 * DAY_MS * SAFETY_TIME_FACTOR),
+        "emergency time from a long average wrong");
+
+  printf("pump: 90 s cycle across 2^32 ms, 60-day run = %llu ms, "
+         "30-day average = %llu ms\n",
+         (unsigned long long)runMs,
+         (unsigned long long)pump.avgCycleDuration);
+}
+
+// ----------------------------------------------------------------
+// Alarma
+// ----------------------------------------------------------------
+
+// Patrón de error durante 20 s centrados en el desborde, paso de 1 ms
+static void alarmCase() {
+  AlarmState alarm;
+  memset(&alarm, 0, sizeof(alarm));
+  clock_fake_start((WRAP32 - 10 * SECOND_MS) * 1000);
+  alarm_set(&alarm, ALARM_ERROR);
+
+  uint64_t lastToggle = clock_ms();
+  uint64_t interval = 0;
+  uint32_t toggles = 0, irregular = 0;
+  bool led = alarm.ledOn;
+  for (int i = 0; i < 20000; i++) {
+    advanceMs(1);
+    alarm_update(&alarm);
+    if (alarm.ledOn != led) {
+      led = alarm.ledOn;
+      uint64_t gap = clock_ms() - lastToggle;
+      if (interval == 0) {
+        interval = gap;
+      } else if (gap != interval) {
+        irregular++;
+      }
+      lastToggle = clock_ms();
+      toggles++;
+    }
+  }
+  check(interval > 0 && irregular == 0, "error pattern stuttered at 2^32 ms");
+  check(toggles == 20000 / interval, "error pattern lost toggles");
+
+  // Beep único que empieza 50 ms antes del desborde
+  clock_fake_start((WRAP32 - 50) * 1000);
+  alarm_beep(&alarm);
+  uint64_t start = clock_ms();
+  while (alarm.pattern != ALARM_OFF && clock_ms() - start < 10 * SECOND_MS) {
+    advanceMs(1);
+    alarm_update(&alarm);
+  }
+  uint64_t beepMs = clock_ms() - start;
+  check(alarm.pattern == ALARM_OFF && beepMs < 1000,
+        "beep across 2^32 ms did not end");
+  printf("alarm: %lu toggles every %llu ms across 2^32 ms, beep %llu ms\n",
+         (unsigned long)toggles, (unsigned long long)interval,
+         (unsigned long long)beepMs);
+}
+
+int main(int argc, char **argv) {
+  bool verbose = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--days") && i + 1 < argc) {
+      days = max(46L, atol(argv[++i]));
+    } else if (!strcmp(argv[i], "--verbose")) {
+      verbose = true;
+    } else {
+      printf("usage: %s [--days N] [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+  Serial.enabled = verbose;
+
+  printf("scheduler, %lu days per start\n", (unsigned long)days);
+  printf("%-22s %8s %8s %8s %8s %6s\n", "start", "days", "1 s", "1 min",
+         "1 h", "once");
+  schedulerCase("boot", 0);
+  schedulerCase("2^32 us - 10 s", WRAP32 - 10 * SECOND_MS * 1000);
+  schedulerCase("2^32 ms - 1 h", (WRAP32 - HOUR_MS) * 1000);
+  schedulerCase("2^32 ms - 40 days", (WRAP32 - 40 * DAY_MS) * 1000);
+
+  pumpCase();
+  alarmCase();
+
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,418 @@
+/*
+ * Banco de pruebas del historial de ciclos
+ * ========================================
+ * Corre cyclelog.cpp contra una flash NOR en RAM del tamaño de la partición
+ * (programar solo baja bits, borrar por sector, cortes en cualquier byte)
+ * con registros realistas: el aire llena el tanque cada 5-30 min de día,
+ * la bomba vacía en ~45 s y algunas veces hay una emergencia.
+ *
+ * Informa:
+ *   - bytes por registro contra el struct crudo y una línea JSON
+ *   - tiempo y bytes de flash leídos por consultas de 1 día, 1 semana y
+ *     todo el historial, y por resúmenes por hora y por día
+ *
+ * Verifica:
+ *   - lo que queda en la flash es la cola exacta de lo escrito
+ *   - consultas por rango y resúmenes iguales a la fuerza bruta
+ *   - montar de nuevo continúa donde estaba
+ *   - un corte a mitad de un registro no rompe nada de lo anterior
+ *
+ * Uso: cyclelog_bench [--records N] [--sectors N] [--seed N] [--verbose]
+ */
+
+#include "clock.h"
+#include "cyclelog.h"
+#include "sim_check.h"
+#include "tank.h"
+#include <chrono>
+#include <vector>
+
+#define SIM_SECTOR_SIZE 4096
+#define START_EPOCH 1792227600UL // 2026-10-17 06:00 (UTC-3)
+#define EMERGENCY_CHANCE 0.03
+#define CUT_TRIALS 300
+
+static bool verbose = false;
+
+// ============================================
+// FLASH NOR EN RAM
+// ============================================
+
+static std::vector<uint8_t> memory;
+static uint64_t bytesRead = 0;
+static long cutBudget = -1; // Bytes hasta el corte (-1: nunca)
+static bool powerDown = false;
+
+static bool simRead(uint32_t address, void *data, size_t length) {
+  if (powerDown || address + length > memory.size()) {
+    return false;
+  }
+  memcpy(data, memory.data() + address, length);
+  bytesRead += length;
+  return true;
+}
+
+static bool simWrite(uint32_t address, const void *data, size_t length) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  for (size_t i = 0; i < length; i++) {
+    if (powerDown) {
+      return false;
+    }
+    if (cutBudget == 0) {
+      // Algunos bits del byte llegaron a programarse
+      memory[address + i] &= bytes[i] | (uint8_t)nextRandom();
+      powerDown = true;
+      return false;
+    }
+    if (cutBudget > 0) {
+      cutBudget--;
+    }
+    memory[address + i] &= bytes[i];
+  }
+  return true;
+}
+
+static bool simErase(uint32_t sector) {
+  if (powerDown) {
+    return false;
+  }
+  memset(memory.data() + sector * SIM_SECTOR_SIZE, 0xFF, SIM_SECTOR_SIZE);
+  return true;
+}
+
+static FlashDevice device = {SIM_SECTOR_SIZE, 0, simRead, simWrite,
+                             simErase};
+
+// ============================================
+// REGISTROS SIMULADOS
+// ============================================
+
+static uint32_t simTime = START_EPOCH;
+
+static int localHour(uint32_t t) {
+  time_t now = t;
+  struct tm local;
+  localtime_r(&now, &local);
+  return local.tm_hour;
+}
+
+// Próximo ciclo: cada 5-30 min entre las 10 y las 23. El llenado es lo
+// que pasó desde el ciclo anterior; las duraciones en décimas, como se
+// guardan.
+static CycleRecord nextCycle() {
+  uint32_t gap;
+  do {
+    gap = 5 * 60 + nextRandom() % (25 * 60);
+    simTime += gap;
+  } while (localHour(simTime) < 10 || localHour(simTime) >= 23);
+
+  CycleRecord record;
+  memset(&record, 0, sizeof(record));
+  record.time = simTime;
+  record.tank = nextRandom() % TANK_COUNT;
+  if (chance(EMERGENCY_CHANCE)) {
+    record.kind = CYCLE_EMERGENCY;
+    record.cause = chance(0.5) ? CAUSE_GAP : CAUSE_DIRECTION;
+    record.phase = 1 + nextRandom() % 3;
+    record.level = nextRandom() % (NUM_SENSORS + 1);
+    record.drainMs = (600 + nextRandom() % 300) * 100;
+  } else {
+    record.kind = CYCLE_NORMAL;
+    record.fillMs = (gap - 45) * 1000 + nextRandom() % 10 * 100;
+    record.drainMs = (430 + nextRandom() % 40) * 100;
+  }
+  return record;
+}
+
+static bool sameRecord(const CycleRecord *a, const CycleRecord *b) {
+  return a->time == b->time && a->tank == b->tank && a->kind == b->kind &&
+         a->estimated == b->estimated && a->fillMs == b->fillMs &&
+         a->drainMs == b->drainMs &&
+         (a->kind == CYCLE_NORMAL ||
+          (a->cause == b->cause && a->phase == b->phase &&
+           a->level == b->level));
+}
+
+static size_t jsonLength(const CycleRecord *r) {
+  char line[256];
+  return snprintf(line, sizeof(line),
+                  "{\"time\":%lu,\"tank\":%u,\"kind\":\"%s\",\"fill_ms\":%lu,"
+                  "\"drain_ms\":%lu,\"cause\":%u,\"phase\":%u,\"level\":%u}",
+                  (unsigned long)r->time, r->tank,
+                  r->kind == CYCLE_NORMAL ? "cycle" : "emergency",
+                  (unsigned long)r->fillMs, (unsigned long)r->drainMs,
+                  r->cause, r->phase, r->level);
+}
+
+// ============================================
+// CONSULTAS
+// ============================================
+
+static std::vector<CycleRecord> written; // Todo lo escrito, en orden
+
+static std::vector<CycleRecord> queryAll(uint32_t from, uint32_t to,
+                                         int tank) {
+  std::vector<CycleRecord> out;
+  CycleQuery query;
+  CycleRecord record;
+  cyclelog_query_begin(&query, from, to, tank, 0);
+  while (cyclelog_query_next(&query, &record)) {
+    out.push_back(record);
+  }
+  return out;
+}
+
+// Lo que debería quedar en la flash: la cola de lo escrito desde oldest
+static size_t firstKept() {
+  CycleLogStats stats;
+  cyclelog_get_stats(&stats);
+  size_t i = 0;
+  while (i < written.size() && written[i].time < stats.oldest) {
+    i++;
+  }
+  return i;
+}
+
+static bool compareRange(uint32_t from, uint32_t to, int tank) {
+  std::vector<CycleRecord> got = queryAll(from, to, tank);
+  std::vector<CycleRecord> want;
+  uint32_t last = to == 0 ? UINT32_MAX : to; // 0 = hasta ahora
+  for (size_t i = firstKept(); i < written.size(); i++) {
+    const CycleRecord *r = &written[i];
+    if (r->time >= from && r->time <= last && (tank < 0 || r->tank == tank)) {
+      want.push_back(*r);
+    }
+  }
+  if (got.size() != want.size()) {
+    if (verbose) {
+      printf("   range %lu-%lu: %zu records, expected %zu\n",
+             (unsigned long)from, (unsigned long)to, got.size(), want.size());
+    }
+    return false;
+  }
+  for (size_t i = 0; i < got.size(); i++) {
+    if (!sameRecord(&got[i], &want[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Resumen por fuerza bruta con el mismo formato que cyclelog_query_row()
+static std::vector<std::string> bruteRollup(uint32_t from, uint32_t to,
+                                            uint32_t bucket) {
+  std::vector<std::string> rows;
+  size_t i = firstKept();
+  while (i < written.size() && written[i].time < from) {
+    i++;
+  }
+  while (i < written.size() && written[i].time <= to) {
+    uint32_t start = written[i].time - written[i].time % bucket;
+    uint32_t cycles = 0, emergencies = 0, fillMax = 0, drainMax = 0;
+    uint64_t fillSum = 0, drainSum = 0;
+    for (; i < written.size() && written[i].time <= to &&
+           written[i].time - start < bucket;
+         i++) {
+      const CycleRecord *r = &written[i];
+      if (r->kind == CYCLE_NORMAL) {
+        cycles++;
+        fillSum += r->fillMs;
+        drainSum += r->drainMs;
+        fillMax = std::max(fillMax, r->fillMs);
+        drainMax = std::max(drainMax, r->drainMs);
+      } else {
+        emergencies++;
+      }
+    }
+    char row[128];
+    snprintf(row, sizeof(row), "%lu,%lu,%lu,%lu,%lu,%lu,%lu",
+             (unsigned long)start, (unsigned long)cycles,
+             (unsigned long)emergencies,
+             (unsigned long)(cycles > 0 ? fillSum / cycles : 0),
+             (unsigned long)fillMax,
+             (unsigned long)(cycles > 0 ? drainSum / cycles : 0),
+             (unsigned long)drainMax);
+    rows.push_back(row);
+  }
+  return rows;
+}
+
+// Correr una consulta de texto hasta el final: filas, tiempo y lectura
+static std::vector<std::string> timedQuery(const char *label,
+                                           const char *text) {
+  std::vector<std::string> rows;
+  CycleQuery query;
+  char row[128];
+  bytesRead = 0;
+  auto start = std::chrono::steady_clock::now();
+  if (!cyclelog_parse_query(text, &query)) {
+    check(false, "query text not accepted");
+    return rows;
+  }
+  while (cyclelog_query_row(&query, row, sizeof(row))) {
+    rows.push_back(row);
+  }
+  double us = std::chrono::duration<double, std::micro>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  printf("%-16s %7zu rows %7lu records %9.0f us %9lu B read\n", label,
+         rows.size() - 1, (unsigned long)query.scanned, us,
+         (unsigned long)bytesRead);
+  return rows;
+}
+
+static void checkRollup(const char *label, uint32_t from, uint32_t to,
+                        uint32_t bucket) {
+  char text[64];
+  snprintf(text, sizeof(text), "rollup %lu %lu %lu", (unsigned long)from,
+           (unsigned long)to, (unsigned long)bucket);
+  std::vector<std::string> got = timedQuery(label, text);
+  std::vector<std::string> want = bruteRollup(from, to, bucket);
+  check(!got.empty() && got.size() - 1 == want.size() &&
+            std::equal(want.begin(), want.end(), got.begin() + 1),
+        "rollup differs from brute force");
+}
+
+// ============================================
+// ESCENARIOS
+// ============================================
+
+static void append(const CycleRecord *record) {
+  if (cyclelog_append(record)) {
+    written.push_back(*record);
+  } else {
+    check(false, "append failed");
+  }
+}
+
+static void remount() {
+  cyclelog_mount(&device);
+}
+
+// Cortes de energía a mitad de un registro: lo completo sobrevive y lo
+// que sigue se escribe y se lee bien. Devuelve los registros rotos.
+static uint32_t powerCuts() {
+  uint32_t torn = 0;
+  for (int trial = 0; trial < CUT_TRIALS; trial++) {
+    CycleRecord record = nextCycle();
+    cutBudget = nextRandom() % 20;
+    powerDown = false;
+    bool ok = cyclelog_append(&record);
+    bool cut = powerDown;
+    cutBudget = -1;
+    powerDown = false;
+    check(ok || cut, "append failed without a power cut");
+
+    remount();
+    CycleLogStats stats;
+    cyclelog_get_stats(&stats);
+    torn += stats.torn;
+
+    // Un corte en el último bit del CRC puede dejar el registro entero
+    std::vector<CycleRecord> tail = queryAll(record.time, 0, -1);
+    if (ok || (!tail.empty() && sameRecord(&tail.back(), &record))) {
+      written.push_back(record);
+    }
+
+    record = nextCycle();
+    append(&record);
+    check(compareRange(0, 0, -1), "power cut broke the history");
+  }
+  return torn;
+}
+
+int main(int argc, char **argv) {
+  long records = 100000;
+  uint32_t sectors = 0x40000 / SIM_SECTOR_SIZE; // Partición de partitions.csv
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--records") && i + 1 < argc) {
+      records = atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--sectors") && i + 1 < argc) {
+      sectors = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--verbose")) {
+      verbose = true;
+    } else {
+      printf("usage: %s [--records N] [--sectors N] [--seed N] [--verbose]\n",
+             argv[0]);
+      return 2;
+    }
+  }
+  Serial.enabled = verbose;
+  setenv("TZ", TIME_ZONE, 1);
+  tzset();
+  clock_fake_start(0);
+
+  memory.assign((size_t)sectors * SIM_SECTOR_SIZE, 0xFF);
+  device.sectorCount = sectors;
+  cyclelog_mount(&device);
+
+  // Carga: registros realistas hasta dar varias vueltas al anillo
+  size_t jsonBytes = 0;
+  for (long i = 0; i < records; i++) {
+    CycleRecord record = nextCycle();
+    jsonBytes += jsonLength(&record);
+    append(&record);
+  }
+
+  CycleLogStats stats;
+  cyclelog_get_stats(&stats);
+  size_t kept = written.size() - firstKept();
+  uint32_t newest = written.back().time;
+  double days = (newest - stats.oldest) / 86400.0;
+  printf("%ld records, %.2f B/record (raw struct %zu B, JSON %.1f B), "
+         "%lu erases\n",
+         records, (double)stats.bytes / stats.appended, sizeof(CycleRecord),
+         (double)jsonBytes / records, (unsigned long)stats.erases);
+  printf("%lu sectors hold %zu records = %.0f days (%.1f records/day)\n",
+         (unsigned long)stats.sectors, kept, days, kept / days);
+
+  check(compareRange(0, 0, -1), "stored history is not the written tail");
+
+  // Rangos al azar contra fuerza bruta
+  uint32_t span = newest - stats.oldest;
+  for (int i = 0; i < 200; i++) {
+    uint32_t from = stats.oldest - 3600 + nextRandom() % (span + 7200);
+    uint32_t to = from + nextRandom() % (7 * 86400);
+    int tank = chance(0.5) ? -1 : (int)(nextRandom() % TANK_COUNT);
+    check(compareRange(from, to, tank), "range query differs");
+  }
+
+  // Tiempos y lectura de flash
+  char text[64];
+  snprintf(text, sizeof(text), "cycles %lu %lu",
+           (unsigned long)(newest - 86400), (unsigned long)newest);
+  timedQuery("last day", text);
+  snprintf(text, sizeof(text), "cycles %lu %lu",
+           (unsigned long)(newest - 7 * 86400), (unsigned long)newest);
+  timedQuery("last week", text);
+  timedQuery("all", "cycles 0 0");
+  checkRollup("week hourly", newest - 7 * 86400, newest, 3600);
+  checkRollup("all daily", 0, UINT32_MAX, 86400);
+
+  // Montar de nuevo: mismo contenido, se sigue escribiendo a continuación
+  remount();
+  check(compareRange(0, 0, -1), "remount lost records");
+  for (int i = 0; i < 1000; i++) {
+    CycleRecord record = nextCycle();
+    append(&record);
+  }
+  remount();
+  check(compareRange(0, 0, -1), "records after remount differ");
+
+  // El tiempo no retrocede: un registro viejo toma la hora del último
+  CycleRecord late = nextCycle();
+  uint32_t last = written.back().time;
+  late.time = last - 3600;
+  append(&late);
+  written.back().time = last;
+  check(compareRange(0, 0, -1), "late record not moved to the last time");
+
+  uint32_t torn = powerCuts();
+  printf("power cuts: %d trials, %lu torn records sealed\n", CUT_TRIALS,
+         (unsigned long)torn);
+
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,257 @@
+/*
+ * Prueba del debounce por contadores verticales
+ * =============================================
+ * Corre debounce.cpp con 32 canales a la vez contra un filtro escalar por
+ * canal escrito directo de la descripción de debounce.h: +1 si la muestra
+ * difiere de la salida, -1 si coincide (sin bajar de 0), cambio y cuenta
+ * a 0 al llegar al umbral, rebote si la lectura vuelve al valor aceptado
+ * con una cuenta en curso.
+ *
+ * Verifica, para todos los pares de umbrales 1..15:
+ *   - salida, máscara de cambios y rebotes iguales muestra a muestra con
+ *     ruido al azar, flancos con rebotes y oleaje sobre una boya
+ *   - flanco limpio aceptado en exactamente `umbral` muestras
+ *   - nunca se acepta después de la primera muestra en que
+ *     (difieren - coinciden) desde el flanco llega al umbral
+ *   - con una fracción p de muestras nuevas, el promedio de aceptación no
+ *     pasa de umbral / (2p - 1)
+ *   - umbrales fuera de rango se recortan a 1..15
+ *
+ * Uso: debounce_check [--samples N] [--seed N]
+ */
+
+#include "config.h"
+#include "debounce.h"
+#include "sim_check.h"
+
+#define CHANNELS DEBOUNCE_MAX_CHANNELS
+
+static long samples = 2000;
+
+// Un canal, sin trucos de bits
+struct ScalarFilter {
+  int assertSamples;
+  int releaseSamples;
+  bool state;
+  bool lastRaw;
+  int count;
+  unsigned bounces;
+
+  void init(int assertN, int releaseN, bool initial) {
+    assertSamples = assertN;
+    releaseSamples = releaseN;
+    state = initial;
+    lastRaw = initial;
+    count = 0;
+    bounces = 0;
+  }
+
+  bool sample(bool raw) {
+    bool pending = count > 0;
+    bool changed = false;
+    if (raw != state) {
+      count++;
+      if (count == (state ? releaseSamples : assertSamples)) {
+        state = raw;
+        count = 0;
+        changed = true;
+      }
+    } else {
+      if (count > 0) {
+        count--;
+      }
+      if (raw != lastRaw && pending) {
+        bounces++;
+      }
+    }
+    lastRaw = raw;
+    return changed;
+  }
+};
+
+struct Pair {
+  DebounceState db;
+  ScalarFilter ref[CHANNELS];
+
+  void init(int assertN, int releaseN, uint32_t initial) {
+    debounce_init(&db, assertN, releaseN, initial);
+    for (int c = 0; c < CHANNELS; c++) {
+      ref[c].init(assertN, releaseN, (initial >> c) & 1);
+    }
+  }
+
+  // Una muestra en los dos filtros; false si difieren
+  bool sample(uint32_t raw) {
+    uint32_t changed = debounce_sample(&db, raw);
+    uint32_t refChanged = 0, refState = 0;
+    bool bouncesMatch = true;
+    for (int c = 0; c < CHANNELS; c++) {
+      if (ref[c].sample((raw >> c) & 1)) {
+        refChanged |= 1UL << c;
+      }
+      if (ref[c].state) {
+        refState |= 1UL << c;
+      }
+      bouncesMatch &= debounce_get_bounces(&db, c) == ref[c].bounces;
+    }
+    return changed == refChanged && debounce_get_state(&db) == refState &&
+           bouncesMatch;
+  }
+};
+
+static Pair pair;
+
+// Cada canal con su probabilidad de leer 1, distinta por canal
+static void randomCase(int assertN, int releaseN) {
+  pair.init(assertN, releaseN, random32());
+  uint32_t odds[CHANNELS];
+  for (int c = 0; c < CHANNELS; c++) {
+    odds[c] = nextRandom() % 1024;
+  }
+  for (long i = 0; i < samples; i++) {
+    // Cada tanto todos los canales cambian de preferencia
+    if (i % 200 == 0) {
+      for (int c = 0; c < CHANNELS; c++) {
+        odds[c] = 1023 - odds[c];
+      }
+    }
+    uint32_t raw = 0;
+    for (int c = 0; c < CHANNELS; c++) {
+      if (nextRandom() % 1024 < odds[c]) {
+        raw |= 1UL << c;
+      }
+    }
+    if (!pair.sample(raw)) {
+      check(false, "random noise: packed filter differs from scalar");
+      return;
+    }
+  }
+}
+
+// Formas de rebote de una boya, una muestra por carácter
+static const char *const patterns[] = {
+    "1111111111111111",                 // Flanco limpio
+    "1011111111111111",                 // Un rebote al cerrar
+    "1010110111011111111111",           // Contacto que rebota y se asienta
+    "1100110011101111011111111111",     // Oleaje sobre el nivel
+    "1000000000000000",                 // Pulso de una muestra
+    "1110000000000000",                 // Pulso corto
+    "1101101101101101101101101101",     // Ruido 2/3
+    "0101010101010101010101010101",     // Ruido 1/2 y después estable
+};
+
+static void patternCase(int assertN, int releaseN) {
+  for (const char *pattern : patterns) {
+    for (int rising = 0; rising < 2; rising++) {
+      uint32_t initial = rising ? 0 : 0xFFFFFFFFUL;
+      int threshold = rising ? assertN : releaseN;
+      pair.init(assertN, releaseN, initial);
+
+      int len = strlen(pattern);
+      int margin = 0, acceptedAt = -1, boundAt = -1;
+      for (int i = 0; i < len + 2 * DEBOUNCE_MAX_THRESHOLD; i++) {
+        bool nextValue = i >= len || pattern[i] == '1';
+        uint32_t raw = nextValue ? ~initial : initial;
+        // Los canales impares ven el patrón una muestra atrasados
+        uint32_t late = (i == 0 || i > len || pattern[i - 1] == '1')
+                            ? ~initial
+                            : initial;
+        raw = (raw & 0x55555555UL) | (late & 0xAAAAAAAAUL);
+
+        check(pair.sample(raw), "pattern: packed filter differs from scalar");
+        margin += nextValue ? 1 : -1;
+        if (boundAt < 0 && margin >= threshold) {
+          boundAt = i;
+        }
+        if (acceptedAt < 0 && (debounce_get_state(&pair.db) & 1) !=
+                                  (initial & 1)) {
+          acceptedAt = i;
+        }
+      }
+      check(acceptedAt >= 0, "pattern: edge never accepted");
+      check(acceptedAt <= boundAt,
+            "pattern: accepted after (differ - match) reached the threshold");
+      if (pattern == patterns[0]) {
+        check(acceptedAt == threshold - 1,
+              "clean edge not accepted in exactly `threshold` samples");
+      }
+    }
+  }
+}
+
+// Fracción p de muestras con el valor nuevo: demora promedio contra la cota
+static double noisyDelay(int threshold, double p, int trials) {
+  long total = 0;
+  for (int t = 0; t < trials; t++) {
+    pair.init(threshold, threshold, 0);
+    for (int i = 1;; i++) {
+      uint32_t raw = 0;
+      for (int c = 0; c < CHANNELS; c++) {
+        if (nextRandom() % 1000 < p * 1000) {
+          raw |= 1UL << c;
+        }
+      }
+      check(pair.sample(raw), "noisy edge: packed filter differs from scalar");
+      if (debounce_get_state(&pair.db) & 1) {
+        total += i;
+        break;
+      }
+    }
+  }
+  return (double)total / trials;
+}
+
+static void clampCase() {
+  DebounceState db;
+  debounce_init(&db, 0, 40, 0);
+  check(debounce_sample(&db, 1) == 1, "assert threshold 0 not clamped to 1");
+  int release = 0;
+  while (debounce_get_state(&db) & 1) {
+    debounce_sample(&db, 0);
+    release++;
+  }
+  check(release == DEBOUNCE_MAX_THRESHOLD,
+        "release threshold 40 not clamped to 15");
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--samples") && i + 1 < argc) {
+      samples = atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 0);
+    } else {
+      printf("usage: %s [--samples N] [--seed N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  int pairs = 0;
+  for (int a = 1; a <= DEBOUNCE_MAX_THRESHOLD; a++) {
+    for (int r = 1; r <= DEBOUNCE_MAX_THRESHOLD; r++) {
+      randomCase(a, r);
+      patternCase(a, r);
+      pairs++;
+    }
+  }
+  printf("%d threshold pairs x %d channels: %ld random samples and %d "
+         "patterns each\n",
+         pairs, CHANNELS, samples, (int)(sizeof(patterns) / sizeof(*patterns)));
+  clampCase();
+
+  printf("mean acceptance (samples) with a fraction p of new readings\n");
+  printf("%9s %6s %10s %10s\n", "threshold", "p", "mean", "bound");
+  static const int thresholds[] = {DEBOUNCE_ASSERT_SAMPLES, 15};
+  static const double fractions[] = {1.0, 0.9, 0.75, 0.6};
+  for (int threshold : thresholds) {
+    for (double p : fractions) {
+      double mean = noisyDelay(threshold, p, 500);
+      double bound = threshold / (2 * p - 1);
+      check(mean <= bound, "mean acceptance above threshold / (2p - 1)");
+      printf("%9d %6.2f %10.2f %10.2f\n", threshold, p, mean, bound);
+    }
+  }
+
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,342 @@
+/*
+ * Lector del flujo de flancos
+ * ===========================
+ * Decodifica los lotes binarios de MQTT_EDGE_TOPIC (formato en
+ * src/edges.h) y los imprime como CSV, un flanco por línea:
+ *
+ *   batch,uptime_ms,time_ms,tank,type,value
+ *
+ * time_ms es la hora UNIX del flanco (vacía si el equipo no tenía hora).
+ * Un lote con flancos perdidos o un salto en el nº de lote se avisa por
+ * stderr; un nº de lote 0 después de otro indica un reinicio del equipo.
+ *
+ * Entrada:
+ *   sin argumentos  un lote por línea en hexadecimal por stdin, p.ej.
+ *                   mosquitto_sub -t ac-monitor/edges -F %x | edge_reader
+ *   --raw FILE...   un lote binario por archivo
+ *   --selftest      codifica flancos sintéticos con src/edges.cpp y
+ *                   verifica que se lean igual
+ */
+
+#include "clock.h"
+#include "edges.h"
+#include "sim_check.h"
+#include <vector>
+
+struct DecodedEdge {
+  uint64_t uptimeMs;
+  uint8_t type;
+  uint8_t tank;
+  uint8_t value;
+};
+
+struct DecodedBatch {
+  uint8_t version;
+  uint8_t flags;
+  uint64_t seq;
+  uint64_t lost;
+  uint64_t sentUptimeMs;
+  uint64_t sentEpochMs;
+  std::vector<DecodedEdge> edges;
+};
+
+// Lectura acotada: cualquier byte de más o de menos invalida el lote
+class Reader {
+public:
+  Reader(const uint8_t *data, size_t length) : data(data), length(length) {}
+
+  bool byte(uint8_t *out) {
+    if (pos >= length) {
+      return false;
+    }
+    *out = data[pos++];
+    return true;
+  }
+
+  bool varint(uint64_t *out) {
+    *out = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t b;
+      if (!byte(&b)) {
+        return false;
+      }
+      *out |= (uint64_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool done() const { return pos == length; }
+
+private:
+  const uint8_t *data;
+  size_t length;
+  size_t pos = 0;
+};
+
+static bool decodeBatch(const uint8_t *data, size_t length,
+                        DecodedBatch *batch, const char **error) {
+  Reader in(data, length);
+  uint64_t firstMs;
+  uint64_t count;
+  if (!in.byte(&batch->version)) {
+    *error = "empty";
+    return false;
+  }
+  if (batch->version != EDGE_FORMAT_VERSION) {
+    *error = "unknown version";
+    return false;
+  }
+  if (!in.byte(&batch->flags) || !in.varint(&batch->seq) ||
+      !in.varint(&batch->lost) || !in.varint(&batch->sentUptimeMs) ||
+      !in.varint(&batch->sentEpochMs) || !in.varint(&firstMs) ||
+      !in.varint(&count)) {
+    *error = "truncated header";
+    return false;
+  }
+  if (count > length) {
+    *error = "bad count";
+    return false;
+  }
+
+  batch->edges.clear();
+  uint64_t time = firstMs;
+  for (uint64_t i = 0; i < count; i++) {
+    uint64_t delta;
+    uint8_t typeTank;
+    DecodedEdge edge;
+    if (!in.varint(&delta) || !in.byte(&typeTank) || !in.byte(&edge.value)) {
+      *error = "truncated edge";
+      return false;
+    }
+    time += delta;
+    edge.uptimeMs = time;
+    edge.type = typeTank >> 4;
+    edge.tank = typeTank & 0x0F;
+    batch->edges.push_back(edge);
+  }
+  if (!in.done()) {
+    *error = "trailing bytes";
+    return false;
+  }
+  return true;
+}
+
+// ============================================
+// SALIDA CSV
+// ============================================
+
+static bool haveLastSeq = false;
+static uint64_t lastSeq = 0;
+
+static void printBatch(const DecodedBatch *batch) {
+  if (haveLastSeq && batch->seq != lastSeq + 1) {
+    if (batch->seq == 0) {
+      fprintf(stderr, "batch 0: device restarted\n");
+    } else {
+      fprintf(stderr, "batch %llu: %llu batches missing\n",
+              (unsigned long long)batch->seq,
+              (unsigned long long)(batch->seq - lastSeq - 1));
+    }
+  }
+  if (batch->lost > 0) {
+    fprintf(stderr, "batch %llu: %llu edges lost on the device\n",
+            (unsigned long long)batch->seq, (unsigned long long)batch->lost);
+  }
+  haveLastSeq = true;
+  lastSeq = batch->seq;
+
+  bool timed = batch->flags & EDGE_FLAG_EPOCH;
+  for (const DecodedEdge &edge : batch->edges) {
+    printf("%llu,%llu,", (unsigned long long)batch->seq,
+           (unsigned long long)edge.uptimeMs);
+    if (timed) {
+      printf("%llu", (unsigned long long)(batch->sentEpochMs -
+                                          (batch->sentUptimeMs -
+                                           edge.uptimeMs)));
+    }
+    printf(",%u,%s,%u\n", edge.tank, edges_type_name((EdgeType)edge.type),
+           edge.value);
+  }
+}
+
+static bool readBatch(const std::vector<uint8_t> &bytes, const char *source) {
+  DecodedBatch batch;
+  const char *error = "";
+  if (!decodeBatch(bytes.data(), bytes.size(), &batch, &error)) {
+    fprintf(stderr, "%s: %s\n", source, error);
+    return false;
+  }
+  printBatch(&batch);
+  return true;
+}
+
+static int readHexLines() {
+  char line[4 * EDGE_BATCH_MAX_BYTES];
+  int errors = 0;
+  int lineNo = 0;
+  while (fgets(line, sizeof(line), stdin)) {
+    lineNo++;
+    std::vector<uint8_t> bytes;
+    int nibbles = 0;
+    uint8_t value = 0;
+    for (char *c = line; *c; c++) {
+      int digit;
+      if (*c >= '0' && *c <= '9') {
+        digit = *c - '0';
+      } else if (*c >= 'a' && *c <= 'f') {
+        digit = *c - 'a' + 10;
+      } else if (*c >= 'A' && *c <= 'F') {
+        digit = *c - 'A' + 10;
+      } else {
+        continue; // Espacios y fin de línea
+      }
+      value = (value << 4) | digit;
+      if (++nibbles % 2 == 0) {
+        bytes.push_back(value);
+      }
+    }
+    if (bytes.empty()) {
+      continue;
+    }
+    char source[32];
+    snprintf(source, sizeof(source), "line %d", lineNo);
+    errors += !readBatch(bytes, source);
+  }
+  return errors > 0 ? 1 : 0;
+}
+
+static int readRawFiles(int count, char **paths) {
+  int errors = 0;
+  for (int i = 0; i < count; i++) {
+    FILE *file = fopen(paths[i], "rb");
+    if (!file) {
+      perror(paths[i]);
+      errors++;
+      continue;
+    }
+    std::vector<uint8_t> bytes;
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+      bytes.push_back((uint8_t)c);
+    }
+    fclose(file);
+    errors += !readBatch(bytes, paths[i]);
+  }
+  return errors > 0 ? 1 : 0;
+}
+
+// ============================================
+// AUTOPRUEBA
+// ============================================
+
+static std::vector<std::vector<uint8_t>> sent;
+
+static bool captureBatch(const uint8_t *batch, size_t length) {
+  sent.push_back(std::vector<uint8_t>(batch, batch + length));
+  return true;
+}
+
+static int selftest() {
+  clock_fake_start(1000000000ULL); // ~17 min de uptime
+  std::vector<DecodedEdge> expected;
+
+  // Flancos a ráfagas y con pausas, en pasos de 1 ms: lotes por cantidad
+  // y por antigüedad
+  for (int i = 0; i < 5000; i++) {
+    clock_fake_advance(1000);
+    uint32_t r = nextRandom();
+    if (r % 100 < (i / 1000 % 2 ? 40 : 1)) {
+      DecodedEdge edge;
+      edge.uptimeMs = clock_ms();
+      edge.type = EDGE_LEVEL + (r >> 12) % 4;
+      edge.tank = (r >> 4) % 4;
+      edge.value = (r >> 16) % 8;
+      edges_record((EdgeType)edge.type, edge.tank, edge.value,
+                   edge.uptimeMs);
+      expected.push_back(edge);
+    }
+    edges_flush(captureBatch);
+  }
+  clock_fake_advance(EDGE_BATCH_MAX_AGE_MS * 1000ULL);
+  edges_flush(captureBatch);
+  check(edges_pending() == 0, "edges left in the queue");
+
+  // Decodificar y comparar uno por uno
+  std::vector<DecodedEdge> decoded;
+  size_t maxBytes = 0;
+  size_t totalBytes = 0;
+  for (size_t i = 0; i < sent.size(); i++) {
+    DecodedBatch batch;
+    const char *error = "";
+    bool ok = decodeBatch(sent[i].data(), sent[i].size(), &batch, &error);
+    check(ok, error);
+    check(!ok || batch.seq == i, "batch numbers not consecutive");
+    check(!ok || batch.lost == 0, "edges lost without overflow");
+    check(!ok || batch.edges.size() <= EDGE_BATCH_EVENTS, "batch too big");
+    if (ok) {
+      decoded.insert(decoded.end(), batch.edges.begin(), batch.edges.end());
+    }
+    maxBytes = max(maxBytes, sent[i].size());
+    totalBytes += sent[i].size();
+  }
+  bool same = decoded.size() == expected.size();
+  for (size_t i = 0; same && i < expected.size(); i++) {
+    same = decoded[i].uptimeMs == expected[i].uptimeMs &&
+           decoded[i].type == expected[i].type &&
+           decoded[i].tank == expected[i].tank &&
+           decoded[i].value == expected[i].value;
+  }
+  check(same, "decoded edges differ from recorded ones");
+  check(maxBytes <= EDGE_BATCH_MAX_BYTES, "batch larger than the buffer");
+  printf("%zu edges in %zu batches, %zu B max, %.1f B per edge\n",
+         expected.size(), sent.size(), maxBytes,
+         expected.empty() ? 0.0 : (double)totalBytes / expected.size());
+
+  // Cola llena: el lote siguiente avisa cuántos se perdieron
+  sent.clear();
+  for (int i = 0; i < EDGE_QUEUE_SIZE + 10; i++) {
+    edges_record(EDGE_LEVEL, 0, i % 8, clock_ms());
+  }
+  while (edges_pending() > 0) {
+    clock_fake_advance(EDGE_BATCH_MAX_AGE_MS * 1000ULL);
+    edges_flush(captureBatch);
+  }
+  DecodedBatch first;
+  const char *error = "";
+  check(!sent.empty() &&
+            decodeBatch(sent[0].data(), sent[0].size(), &first, &error) &&
+            first.lost == 10,
+        "overflow not reported");
+
+  // Lotes dañados se rechazan
+  std::vector<uint8_t> bad = sent.empty() ? std::vector<uint8_t>() : sent[0];
+  if (!bad.empty()) {
+    bad.pop_back();
+    check(!decodeBatch(bad.data(), bad.size(), &first, &error),
+          "truncated batch accepted");
+    bad[0] = EDGE_FORMAT_VERSION + 1;
+    check(!decodeBatch(bad.data(), bad.size(), &first, &error),
+          "unknown version accepted");
+  }
+
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc >= 2 && !strcmp(argv[1], "--selftest")) {
+    return selftest();
+  }
+  if (argc >= 2 && !strcmp(argv[1], "--raw")) {
+    return readRawFiles(argc - 2, argv + 2);
+  }
+  if (argc > 1) {
+    fprintf(stderr, "usage: %s [--raw FILE... | --selftest] (hex by stdin)\n",
+            argv[0]);
+    return 2;
+  }
+  return readHexLines();
+}
@@ -0,0 +1,511 @@
+/*
+ * Simulador del registro de eventos
+ * =================================
+ * Corre eventlog.cpp contra una flash NOR simulada (programar solo baja
+ * bits, borrar por sector, cortes de energía en cualquier byte) y un broker
+ * de reemplazo en el mismo proceso que recibe los lotes, responde PUBACK
+ * con demora y puede perder PUBLISH, PUBACK o la conexión entera.
+ *
+ * Escenarios:
+ *   online     eventos con el broker conectado: todos llegan una vez
+ *   offline    1000 eventos sin broker, después reconexión: lotes y ventana
+ *   overflow   más eventos que el anillo: se pierden los más viejos
+ *   lossy      20% de pérdidas y desconexiones: todos llegan al menos una vez
+ *   power-cut  cortes de energía al azar durante escrituras, borrados y
+ *              confirmaciones: nada roto llega al broker y los ids crecen
+ *   wear       muchas vueltas al anillo: borrados parejos entre sectores
+ *   uptime     eventos después de 2^32 ms (~50 días): uptime entero
+ *
+ * Uso: eventlog_sim [--seed N] [--verbose]
+ */
+
+#include "clock.h"
+#include "eventlog.h"
+#include "sim_check.h"
+#include <map>
+#include <set>
+#include <vector>
+
+#define SIM_SECTOR_SIZE 4096
+#define SIM_SECTORS 8
+#define ACK_LATENCY_MS 40
+#define STEP_MS 50
+
+static bool verbose = false;
+
+// check() con el escenario delante del mensaje
+static void check(bool ok, const char *scenario, const char *what) {
+  if (!ok) {
+    char message[160];
+    snprintf(message, sizeof(message), "%s: %s", scenario, what);
+    check(false, message);
+  }
+}
+
+// ============================================
+// FLASH NOR SIMULADA
+// ============================================
+
+static uint8_t memory[SIM_SECTORS * SIM_SECTOR_SIZE];
+static uint32_t eraseCount[SIM_SECTORS];
+static long cutBudget = -1; // Bytes o borrados hasta el corte (-1: nunca)
+static bool powerDown = false;
+
+// ¿Hay energía para una operación más? La que agota el presupuesto queda
+// a medias.
+static bool powerFor(bool *partial) {
+  *partial = false;
+  if (powerDown) {
+    return false;
+  }
+  if (cutBudget == 0) {
+    powerDown = true;
+    *partial = true;
+    return false;
+  }
+  if (cutBudget > 0) {
+    cutBudget--;
+  }
+  return true;
+}
+
+static bool simRead(uint32_t address, void *data, size_t length) {
+  if (powerDown || address + length > sizeof(memory)) {
+    return false;
+  }
+  memcpy(data, memory + address, length);
+  return true;
+}
+
+static bool simWrite(uint32_t address, const void *data, size_t length) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  for (size_t i = 0; i < length; i++) {
+    bool partial;
+    if (!powerFor(&partial)) {
+      if (partial) {
+        // Algunos bits del byte llegaron a programarse
+        memory[address + i] &= bytes[i] | (uint8_t)nextRandom();
+      }
+      return false;
+    }
+    memory[address + i] &= bytes[i];
+  }
+  return true;
+}
+
+static bool simErase(uint32_t sector) {
+  bool partial;
+  uint8_t *start = memory + sector * SIM_SECTOR_SIZE;
+  if (!powerFor(&partial)) {
+    if (partial) {
+      for (int i = 0; i < SIM_SECTOR_SIZE; i++) {
+        if (chance(0.5)) {
+          start[i] = 0xFF;
+        }
+      }
+    }
+    return false;
+  }
+  memset(start, 0xFF, SIM_SECTOR_SIZE);
+  eraseCount[sector]++;
+  return true;
+}
+
+static const FlashDevice device = {SIM_SECTOR_SIZE, SIM_SECTORS, simRead,
+                                  simWrite, simErase};
+
+// ============================================
+// BROKER DE REEMPLAZO
+// ============================================
+
+struct PendingAck {
+  uint16_t packetId;
+  uint64_t at;
+};
+
+struct Appended {
+  EventType type;
+  uint8_t tank;
+  uint8_t level;
+  uint64_t uptimeMs;
+};
+
+static bool online = false;
+static double dropPublish = 0;
+static double dropAck = 0;
+static std::vector<PendingAck> acks;
+static std::set<uint16_t> outstanding; // Enviados sin PUBACK entregado
+static uint32_t resentSeen = 0;
+
+// Lo que se intentó escribir, por etiqueta (value), y lo recibido
+static std::map<uint32_t, Appended> attempted;
+static std::set<uint32_t> committed; // eventlog_append() devolvió true
+static std::map<uint32_t, int> received;
+static std::map<uint32_t, uint32_t> idOfTag;
+static uint32_t nextTag = 1;
+static uint32_t batches = 0;
+static uint32_t maxBatch = 0;
+static size_t maxOutstanding = 0;
+static bool corrupt = false;
+static bool badBatch = false;
+
+static void resetBroker() {
+  attempted.clear();
+  committed.clear();
+  received.clear();
+  idOfTag.clear();
+  acks.clear();
+  outstanding.clear();
+  batches = 0;
+  maxBatch = 0;
+  maxOutstanding = 0;
+  corrupt = false;
+  badBatch = false;
+  resentSeen = 0;
+  nextTag = 1;
+}
+
+static bool brokerSend(uint16_t packetId, const LoggedEvent *events,
+                       int count) {
+  if (!online) {
+    return false;
+  }
+
+  // Un reenvío por falta de PUBACK da por perdidos los anteriores
+  EventLogStats stats;
+  eventlog_get_stats(&stats);
+  if (stats.resent != resentSeen) {
+    resentSeen = stats.resent;
+    outstanding.clear();
+  }
+
+  batches++;
+  maxBatch = std::max(maxBatch, (uint32_t)count);
+  badBatch |= count < 1 || count > EVENT_BATCH_SIZE;
+  outstanding.insert(packetId);
+  maxOutstanding = std::max(maxOutstanding, outstanding.size());
+
+  if (chance(dropPublish)) {
+    return true; // Se perdió en la red
+  }
+  for (int i = 0; i < count; i++) {
+    const LoggedEvent *e = &events[i];
+    auto it = attempted.find(e->value);
+    if (it == attempted.end() || it->second.type != e->type ||
+        it->second.tank != e->tank || it->second.level != e->level ||
+        it->second.uptimeMs != e->uptimeMs) {
+      corrupt = true;
+      continue;
+    }
+    auto id = idOfTag.find(e->value);
+    if (id != idOfTag.end() && id->second != e->id) {
+      corrupt = true; // El mismo evento con otro id
+    }
+    idOfTag[e->value] = e->id;
+    received[e->value]++;
+  }
+  if (!chance(dropAck)) {
+    acks.push_back({packetId, clock_ms() + ACK_LATENCY_MS});
+  }
+  return true;
+}
+
+static void setOnline(bool up) {
+  if (online && !up) {
+    acks.clear();
+    outstanding.clear();
+    eventlog_link_down();
+  }
+  online = up;
+}
+
+static void step() {
+  clock_fake_advance(STEP_MS * 1000ULL);
+  uint64_t now = clock_ms();
+  for (size_t i = 0; i < acks.size();) {
+    if (acks[i].at <= now) {
+      outstanding.erase(acks[i].packetId);
+      eventlog_acked(acks[i].packetId);
+      acks.erase(acks.begin() + i);
+    } else {
+      i++;
+    }
+  }
+  if (online) {
+    eventlog_replay(brokerSend);
+  }
+}
+
+static bool append() {
+  uint32_t tag = nextTag++;
+  Appended a;
+  a.type = (EventType)(EVENT_CYCLE + nextRandom() % 3);
+  a.tank = nextRandom() % 4;
+  a.level = nextRandom() % 8;
+  a.uptimeMs = clock_ms();
+  attempted[tag] = a;
+  bool ok = eventlog_append(a.type, a.tank, a.level, tag);
+  if (ok) {
+    committed.insert(tag);
+  }
+  return ok;
+}
+
+static void drain(int maxSteps) {
+  for (int i = 0; i < maxSteps && (eventlog_pending() > 0 || !acks.empty());
+       i++) {
+    step();
+  }
+}
+
+static void format() {
+  memset(memory, 0x00, sizeof(memory)); // Basura: nada válido
+  memset(eraseCount, 0, sizeof(eraseCount));
+  cutBudget = -1;
+  powerDown = false;
+  setOnline(false);
+  resetBroker();
+  eventlog_mount(&device);
+}
+
+// Ids crecientes en el orden en que se escribieron
+static bool idsIncreasing() {
+  uint32_t last = 0;
+  for (auto &entry : idOfTag) {
+    if (entry.second <= last) {
+      return false;
+    }
+    last = entry.second;
+  }
+  return true;
+}
+
+static uint32_t duplicates() {
+  uint32_t extra = 0;
+  for (auto &entry : received) {
+    extra += entry.second - 1;
+  }
+  return extra;
+}
+
+static void report(const char *name) {
+  EventLogStats stats;
+  eventlog_get_stats(&stats);
+  uint32_t minErase = eraseCount[0], maxErase = eraseCount[0];
+  for (int i = 1; i < SIM_SECTORS; i++) {
+    minErase = std::min(minErase, eraseCount[i]);
+    maxErase = std::max(maxErase, eraseCount[i]);
+  }
+  printf("%-10s %7zu %7zu %5lu %7lu %5lu %6lu %3zu %5lu %3lu-%lu\n", name,
+         committed.size(), received.size(), (unsigned long)duplicates(),
+         (unsigned long)stats.dropped, (unsigned long)batches,
+         (unsigned long)maxBatch, maxOutstanding,
+         (unsigned long)eventlog_pending(), (unsigned long)minErase,
+         (unsigned long)maxErase);
+  check(!corrupt, name, "corrupt or re-numbered event delivered");
+  check(!badBatch, name, "batch size out of range");
+  check(maxOutstanding <= EVENT_MAX_IN_FLIGHT, name,
+        "in-flight window exceeded");
+  check(idsIncreasing(), name, "ids not increasing in append order");
+}
+
+// Todo lo confirmado llegó al menos una vez
+static bool allDelivered() {
+  for (uint32_t tag : committed) {
+    if (!received.count(tag)) {
+      if (verbose) {
+        printf("   tag %lu never delivered\n", (unsigned long)tag);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+// ============================================
+// ESCENARIOS
+// ============================================
+
+static void scenarioOnline() {
+  format();
+  setOnline(true);
+  for (int i = 0; i < 300; i++) {
+    append();
+    step();
+  }
+  drain(1000);
+  report("online");
+  check(allDelivered(), "online", "event not delivered");
+  check(duplicates() == 0, "online", "duplicates on a clean link");
+  check(eventlog_pending() == 0, "online", "events left pending");
+}
+
+static void scenarioOffline() {
+  format();
+  for (int i = 0; i < 1000; i++) {
+    append();
+    step();
+  }
+  check(eventlog_pending() == 1000, "offline", "pending != appended");
+
+  // Reinicio sin red: lo pendiente sigue ahí
+  eventlog_mount(&device);
+  check(eventlog_pending() == 1000, "offline", "pending lost on remount");
+
+  setOnline(true);
+  step();
+  check(maxOutstanding == EVENT_MAX_IN_FLIGHT, "offline",
+        "first burst did not fill the window");
+  drain(2000);
+  report("offline");
+  check(allDelivered(), "offline", "event not delivered");
+  check(duplicates() == 0, "offline", "duplicates on a clean link");
+}
+
+static void scenarioOverflow() {
+  format();
+  uint32_t capacity = (SIM_SECTORS - 1) * (SIM_SECTOR_SIZE / EVENT_RECORD_SIZE - 1);
+  uint32_t total = capacity * 2;
+  for (uint32_t i = 0; i < total; i++) {
+    append();
+  }
+  EventLogStats stats;
+  eventlog_get_stats(&stats);
+  check(stats.dropped > 0, "overflow", "nothing dropped");
+  check(eventlog_pending() + stats.dropped == total, "overflow",
+        "pending + dropped != appended");
+  check(eventlog_pending() >= capacity, "overflow",
+        "less than a ring of events kept");
+
+  setOnline(true);
+  drain(5000);
+  report("overflow");
+  // Lo que queda son los más nuevos, sin huecos
+  uint32_t firstKept = total - (uint32_t)received.size() + 1;
+  bool newest = received.size() > 0;
+  for (uint32_t tag = firstKept; tag <= total && newest; tag++) {
+    newest = received.count(tag) > 0;
+  }
+  check(newest, "overflow", "kept events are not the newest ones");
+}
+
+static void scenarioLossy() {
+  format();
+  dropPublish = 0.2;
+  dropAck = 0.2;
+  for (int i = 0; i < 3000; i++) {
+    if (chance(0.05)) {
+      append();
+    }
+    if (chance(0.002)) {
+      setOnline(!online);
+    }
+    step();
+  }
+  setOnline(true);
+  dropPublish = 0;
+  dropAck = 0;
+  drain(20000);
+  report("lossy");
+  check(allDelivered(), "lossy", "event not delivered");
+  check(eventlog_pending() == 0, "lossy", "events left pending");
+}
+
+static void scenarioPowerCut() {
+  format();
+  uint32_t torn = 0;
+  for (int round = 0; round < 400; round++) {
+    cutBudget = 1 + nextRandom() % 3000;
+    while (!powerDown) {
+      if (chance(0.3)) {
+        append();
+      }
+      if (chance(0.01)) {
+        setOnline(!online);
+      }
+      step();
+    }
+
+    // Reinicio: la red vuelve a arrancar desconectada
+    setOnline(false);
+    powerDown = false;
+    cutBudget = -1;
+    eventlog_mount(&device);
+    EventLogStats stats;
+    eventlog_get_stats(&stats);
+    torn += stats.torn;
+  }
+  setOnline(true);
+  drain(50000);
+  report("power-cut");
+  if (verbose) {
+    printf("   %lu torn records found over %d power cuts\n",
+           (unsigned long)torn, 400);
+  }
+  check(allDelivered(), "power-cut", "committed event lost");
+  check(eventlog_pending() == 0, "power-cut", "events left pending");
+}
+
+static void scenarioWear() {
+  format();
+  setOnline(true);
+  uint32_t capacity = SIM_SECTORS * (SIM_SECTOR_SIZE / EVENT_RECORD_SIZE - 1);
+  for (uint32_t i = 0; i < capacity * 20; i++) {
+    append();
+    if (i % 4 == 0) {
+      step();
+    }
+  }
+  drain(5000);
+  report("wear");
+  uint32_t minErase = eraseCount[0], maxErase = eraseCount[0];
+  for (int i = 1; i < SIM_SECTORS; i++) {
+    minErase = std::min(minErase, eraseCount[i]);
+    maxErase = std::max(maxErase, eraseCount[i]);
+  }
+  check(maxErase - minErase <= 1, "wear", "uneven sector erases");
+  check(allDelivered(), "wear", "event not delivered");
+}
+
+// Pasado el desborde de 32 bits de los ms: el uptime llega completo
+static void scenarioUptime() {
+  format();
+  clock_fake_advance(((uint64_t)1 << 32) * 1000);
+  setOnline(true);
+  for (int i = 0; i < 100; i++) {
+    append();
+    step();
+  }
+  drain(1000);
+  report("uptime");
+  check(allDelivered(), "uptime", "event not delivered");
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--verbose")) {
+      verbose = true;
+    } else {
+      printf("usage: %s [--seed N] [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+  Serial.enabled = verbose;
+
+  clock_fake_start(1000000);
+  printf("%-10s %7s %7s %5s %7s %5s %6s %3s %5s %7s\n", "scenario",
+         "written", "recv", "dup", "dropped", "pubs", "batch", "win",
+         "left", "erases");
+  scenarioOnline();
+  scenarioOffline();
+  scenarioOverflow();
+  scenarioLossy();
+  scenarioPowerCut();
+  scenarioWear();
+  scenarioUptime();
+
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+#include "Wire.h"
+#include "clock.h"
+
+TwoWire Wire;
+SimExpander sim_chips[NUM_TANKS];
+SimBusStats sim_bus;
+uint32_t sim_overhead_us = 0;
+
+static uint32_t frequency = 100000;
+static uint64_t pendingNs = 0; // Fracción de µs todavía sin avanzar
+
+static SimExpander *txChip = nullptr;
+static bool txAddressed = false;
+static uint8_t txBytes = 0;
+
+static uint8_t rxData[4];
+static uint8_t rxLength = 0;
+static uint8_t rxIndex = 0;
+
+#if EXPANDER_TYPE == EXPANDER_MCP23017
+#define MCP_GPIOA 0x12
+#define MCP_OLATA 0x14
+#endif
+
+static SimExpander *chipAt(uint8_t address) {
+  int n = address - EXPANDER_BASE_ADDR;
+  if (n < 0 || n >= NUM_TANKS || !sim_chips[n].present) {
+    return nullptr;
+  }
+  return &sim_chips[n];
+}
+
+// bytes en el cable (dirección incluida), START y STOP o START repetido
+static void busTime(int bytes) {
+  sim_bus.transactions++;
+  sim_bus.bytes += bytes;
+  pendingNs += (uint64_t)(9 * bytes + 2) * 1000000000ULL / frequency +
+               (uint64_t)sim_overhead_us * 1000;
+  clock_fake_advance(pendingNs / 1000);
+  pendingNs %= 1000;
+}
+
+#if EXPANDER_TYPE == EXPANDER_MCP23017
+static uint8_t mcpRead(SimExpander *chip, uint8_t reg) {
+  if (reg == MCP_GPIOA || reg == MCP_GPIOA + 1) {
+    // Entradas desde las patas, salidas desde OLAT
+    int port = reg - MCP_GPIOA;
+    uint8_t iodir = chip->reg[port];
+    uint8_t pins = (uint8_t)(chip->pins >> (8 * port));
+    return (pins & iodir) | (chip->reg[MCP_OLATA + port] & ~iodir);
+  }
+  return chip->reg[reg];
+}
+
+static void mcpWrite(SimExpander *chip, uint8_t reg, uint8_t value) {
+  if (reg == MCP_GPIOA || reg == MCP_GPIOA + 1) {
+    reg += MCP_OLATA - MCP_GPIOA;
+  }
+  chip->reg[reg] = value;
+}
+#endif
+
+bool TwoWire::begin(int sda, int scl, uint32_t hz) {
+  frequency = hz;
+  return true;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  txChip = chipAt(address);
+  txAddressed = false;
+  txBytes = 1;
+}
+
+size_t TwoWire::write(uint8_t value) {
+  txBytes++;
+  if (!txChip) {
+    return 1;
+  }
+#if EXPANDER_TYPE == EXPANDER_MCP23017
+  if (!txAddressed) {
+    txChip->pointer = value;
+    txAddressed = true;
+  } else {
+    mcpWrite(txChip, txChip->pointer, value);
+    txChip->pointer = (txChip->pointer + 1) % sizeof(txChip->reg);
+  }
+#else
+  txChip->latch = value;
+#endif
+  return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  if (!txChip) {
+    busTime(1); // Solo la dirección, sin ACK
+    sim_bus.nacks++;
+    return 2;
+  }
+  busTime(txBytes);
+  return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity) {
+  SimExpander *chip = chipAt(address);
+  rxLength = 0;
+  rxIndex = 0;
+  if (!chip) {
+    busTime(1);
+    sim_bus.nacks++;
+    return 0;
+  }
+  for (int i = 0; i < quantity && i < (int)sizeof(rxData); i++) {
+#if EXPANDER_TYPE == EXPANDER_MCP23017
+    rxData[rxLength++] = mcpRead(chip, chip->pointer);
+    chip->pointer = (chip->pointer + 1) % sizeof(chip->reg);
+#else
+    // Cuasi-bidireccional: un 0 escrito fuerza la pata a 0
+    rxData[rxLength++] = (uint8_t)chip->pins & chip->latch;
+#endif
+  }
+  busTime(1 + rxLength);
+  return rxLength;
+}
+
+int TwoWire::read() { return rxIndex < rxLength ? rxData[rxIndex++] : -1; }
+
+void sim_set_floats(int tank, uint32_t mask) {
+  sim_chips[tank].pins = (uint16_t)~mask;
+}
+
+bool sim_relay(int tank) {
+#if EXPANDER_TYPE == EXPANDER_MCP23017
+  return (sim_chips[tank].reg[MCP_OLATA + 1] >> 7) & 1;
+#else
+  return (sim_chips[tank].latch >> 7) & 1;
+#endif
+}
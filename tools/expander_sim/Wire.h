@@ -0,0 +1,47 @@
+#ifndef EXPANDER_SIM_WIRE_H
+#define EXPANDER_SIM_WIRE_H
+
+// Wire de Arduino-ESP32 sobre un bus I2C simulado con NUM_TANKS expansores
+// en EXPANDER_BASE_ADDR + n. Cada transacción avanza el reloj falso lo que
+// tarda en el cable a I2C_FREQUENCY (9 bits por byte, más START y STOP)
+// más un costo fijo por transacción del driver.
+
+#include "config.h"
+#include <Arduino.h>
+
+class TwoWire {
+public:
+  bool begin(int sda, int scl, uint32_t frequency);
+  void beginTransmission(uint8_t address);
+  size_t write(uint8_t value);
+  uint8_t endTransmission(bool sendStop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity);
+  int read();
+};
+
+extern TwoWire Wire;
+
+// Un expansor del bus. pins = nivel de las patas de entrada (1 = abierto).
+struct SimExpander {
+  bool present;
+  uint16_t pins;
+  uint8_t reg[0x16]; // MCP23017: registros con IOCON.BANK = 0
+  uint8_t pointer;   // MCP23017: registro de la próxima lectura/escritura
+  uint8_t latch;     // PCF8574: último byte escrito
+};
+
+struct SimBusStats {
+  uint32_t transactions;
+  uint32_t bytes;  // Incluye el byte de dirección
+  uint32_t nacks;
+};
+
+extern SimExpander sim_chips[NUM_TANKS];
+extern SimBusStats sim_bus;
+extern uint32_t sim_overhead_us; // Costo fijo por transacción
+
+// Boyas activas del tanque (contacto a GND) y estado de su relé
+void sim_set_floats(int tank, uint32_t mask);
+bool sim_relay(int tank);
+
+#endif // EXPANDER_SIM_WIRE_H
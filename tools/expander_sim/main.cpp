@@ -0,0 +1,340 @@
+/*
+ * Simulador del bus de expansores (multi-tanque)
+ * ==============================================
+ * Corre expander.cpp y tank.cpp sin cambios contra un Wire simulado
+ * (Wire.h de esta carpeta) con un MCP23017 o PCF8574 por tanque. El bus
+ * avanza el reloj falso lo que tardan los bytes a I2C_FREQUENCY, así que
+ * las ExpanderStats salen como en la placa salvo el costo del driver.
+ *
+ * Verifica:
+ *   - configuración de cada chip y lectura de las boyas de todos los
+ *     tanques en una ráfaga de una transacción de lectura por chip
+ *   - flush escribe solo los relés que cambiaron y nada si no cambió nada
+ *   - un chip que no responde conserva la lectura anterior y su relé se
+ *     reintenta en el próximo flush
+ *   - un ciclo completo llenado → bomba → vacío en un tanque mueve solo su
+ *     relé, con dos escrituras en todo el ciclo
+ *   - una boya trabada con hueco vuelve a dar error después de limpiarlo
+ *   - lo medido por ExpanderStats coincide con el tiempo del bus
+ *
+ * Informa cuántos tanques entran en MULTI_TANK_CYCLE_BUDGET_US con la
+ * ráfaga contra leer y escribir cada tanque por separado todos los ciclos,
+ * para varios costos por transacción del driver.
+ *
+ * Uso: expander_sim [--seed N] [--verbose]
+ */
+
+#include "Wire.h"
+#include "alarm.h"
+#include "clock.h"
+#include "expander.h"
+#include "sim_check.h"
+#include "tank.h"
+
+#if !MULTI_TANK_ENABLED
+#error "expander_sim se compila con -DMULTI_TANK_ENABLED=true"
+#endif
+
+#if EXPANDER_TYPE == EXPANDER_MCP23017
+#define CHIP_NAME "MCP23017"
+#define READ_TRANSACTIONS 2 // Puntero a GPIOA + lectura de 2 bytes
+#else
+#define CHIP_NAME "PCF8574"
+#define READ_TRANSACTIONS 1
+#endif
+
+#define SAMPLE_US (DEBOUNCE_SAMPLE_MS * 1000ULL)
+
+static Tank tanks[NUM_TANKS];
+static AlarmState alarmState;
+static tank::SensorMask inputs[NUM_TANKS];
+
+static void plugAll() {
+  memset(sim_chips, 0, sizeof(sim_chips));
+  for (int i = 0; i < NUM_TANKS; i++) {
+    sim_chips[i].present = true;
+    sim_set_floats(i, 0);
+  }
+  memset(inputs, 0, sizeof(inputs));
+}
+
+// Como updateTanks() en main.cpp, sin perfilador ni alarma compartida
+static void controlCycle() {
+  expander_read_all(inputs);
+  for (int i = 0; i < NUM_TANKS; i++) {
+    tank_sample(&tanks[i], inputs[i]);
+    tank_update(&tanks[i]);
+  }
+  expander_flush();
+}
+
+static void initCase() {
+  plugAll();
+  check(expander_init(), "expander_init failed with every chip present");
+  for (int i = 0; i < NUM_TANKS; i++) {
+    check(!sim_relay(i), "relay on after init");
+#if EXPANDER_TYPE == EXPANDER_MCP23017
+    uint16_t iodir = sim_chips[i].reg[0] | (sim_chips[i].reg[1] << 8);
+    uint16_t pullup = sim_chips[i].reg[0x0C] | (sim_chips[i].reg[0x0D] << 8);
+    check(iodir == 0x7FFF, "IODIR is not floats in, relay out");
+    check(pullup == tank::kFullMask, "pull-ups not on the float pins");
+#else
+    check(sim_chips[i].latch == tank::kFullMask,
+          "PCF8574 float pins not released high");
+#endif
+  }
+}
+
+static void readCase() {
+  for (int round = 0; round < 100; round++) {
+    tank::SensorMask expected[NUM_TANKS];
+    for (int i = 0; i < NUM_TANKS; i++) {
+      expected[i] = (tank::SensorMask)(nextRandom() & tank::kFullMask);
+      sim_set_floats(i, expected[i]);
+    }
+    SimBusStats before = sim_bus;
+    expander_read_all(inputs);
+    check(sim_bus.transactions - before.transactions ==
+              NUM_TANKS * READ_TRANSACTIONS,
+          "read_all is not one read per chip");
+    check(!memcmp(inputs, expected, sizeof(inputs)),
+          "read_all returned the wrong floats");
+  }
+}
+
+static void relayCase() {
+  SimBusStats before = sim_bus;
+  expander_flush();
+  check(sim_bus.transactions == before.transactions,
+        "flush with nothing pending touched the bus");
+
+  expander_set_relay(1, true);
+  expander_set_relay(NUM_TANKS - 1, true);
+  expander_set_relay(1, true); // Repetido: sin cambio
+  expander_set_relay(NUM_TANKS, true); // Fuera de rango: ignorado
+  before = sim_bus;
+  expander_flush();
+  check(sim_bus.transactions - before.transactions == 2,
+        "flush did not write exactly the two changed relays");
+  for (int i = 0; i < NUM_TANKS; i++) {
+    check(sim_relay(i) == (i == 1 || i == NUM_TANKS - 1),
+          "relay state on the chips is wrong");
+  }
+
+  // Las boyas siguen leyéndose bien con el relé encendido
+  sim_set_floats(1, 0x03);
+  expander_read_all(inputs);
+  check(inputs[1] == 0x03, "relay bit leaked into the float mask");
+
+  expander_set_relay(1, false);
+  expander_set_relay(NUM_TANKS - 1, false);
+  expander_flush();
+  check(!sim_relay(1) && !sim_relay(NUM_TANKS - 1), "relays not turned off");
+}
+
+static void errorCase() {
+  int lost = NUM_TANKS / 2;
+  sim_set_floats(lost, 0x01);
+  expander_read_all(inputs);
+  expander_reset_stats();
+
+  sim_chips[lost].present = false;
+  sim_set_floats(lost, 0x07);
+  expander_read_all(inputs);
+  ExpanderStats stats;
+  expander_get_stats(&stats);
+  check(stats.busErrors == 1, "missing chip not counted as a bus error");
+  check(inputs[lost] == 0x01, "missing chip did not keep its last reading");
+
+  expander_set_relay(lost, true);
+  expander_flush();
+  expander_get_stats(&stats);
+  check(stats.busErrors == 2, "failed relay write not counted");
+  check(!sim_relay(lost), "relay written to a missing chip");
+
+  // Vuelve el chip: el relé pendiente se escribe en el flush siguiente
+  sim_chips[lost].present = true;
+  SimBusStats before = sim_bus;
+  expander_flush();
+  check(sim_relay(lost), "failed relay write not retried");
+  check(sim_bus.transactions - before.transactions == 1,
+        "retry wrote more than the pending relay");
+  expander_set_relay(lost, false);
+  expander_flush();
+}
+
+// Un tanque sube boya por boya, bombea y se vacía; los demás quietos
+static void pipelineCase() {
+  plugAll();
+  expander_init();
+  alarm_init();
+  for (int i = 0; i < NUM_TANKS; i++) {
+    tank_init(&tanks[i], i, &alarmState);
+    pump_attach_relay(&tanks[i].pump, expander_set_relay, i);
+  }
+  expander_flush();
+  expander_reset_stats();
+
+  int active = NUM_TANKS - 1;
+  SimBusStats before = sim_bus;
+  long cycles = 0;
+  bool pumped = false;
+  int level = 0;
+  for (int step = 0; step < 2 * NUM_SENSORS + 2; step++) {
+    level = step <= NUM_SENSORS ? step : 2 * NUM_SENSORS - step;
+    if (level < 0) {
+      level = 0;
+    }
+    sim_set_floats(active, (1UL << level) - 1);
+    for (int i = 0; i < 20; i++) { // 200 ms por boya
+      clock_fake_advance(SAMPLE_US - clock_us() % SAMPLE_US);
+      controlCycle();
+      cycles++;
+      for (int t = 0; t < NUM_TANKS; t++) {
+        check(t == active || !sim_relay(t), "an idle tank's relay moved");
+      }
+      pumped |= sim_relay(active);
+    }
+  }
+  check(pumped, "full tank never turned its relay on");
+  check(!sim_relay(active) && tanks[active].systemState == STATE_IDLE,
+        "emptied tank did not finish its cycle");
+  check(tanks[active].pump.cyclesCompleted == 1, "cycle not counted");
+  uint32_t writes = sim_bus.transactions - before.transactions -
+                    cycles * NUM_TANKS * READ_TRANSACTIONS;
+  check(writes == 2, "a fill/pump cycle wrote more than on + off");
+  printf("pipeline: tank %d filled, pumped and emptied in %ld cycles with "
+         "%lu relay writes\n",
+         active, cycles, (unsigned long)writes);
+}
+
+// Boya trabada en un patrón no contiguo: después de limpiar el error
+// vuelve a marcarse aunque la máscara filtrada no cambie
+static void stuckFloatCase() {
+  int stuck = 0;
+  sim_set_floats(stuck, 0x05); // S1 y S3 sin S2
+  for (int i = 0; i < 20; i++) {
+    clock_fake_advance(SAMPLE_US);
+    controlCycle();
+  }
+  check(tanks[stuck].sensors.sequenceError, "gap in the floats not flagged");
+
+  tank_clear_error(&tanks[stuck]);
+  clock_fake_advance(SAMPLE_US);
+  controlCycle();
+  check(tanks[stuck].sensors.sequenceError,
+        "stuck gap not flagged again after clearing the error");
+
+  sim_set_floats(stuck, 0);
+  for (int i = 0; i < 20; i++) {
+    clock_fake_advance(SAMPLE_US);
+    controlCycle();
+  }
+  tank_clear_error(&tanks[stuck]);
+}
+
+// Alternativa sin ráfaga: cada tanque lee sus puertos por separado y
+// reescribe su relé en todos los ciclos
+static void naiveTank(int tank, bool relay) {
+  uint8_t addr = EXPANDER_BASE_ADDR + tank;
+#if EXPANDER_TYPE == EXPANDER_MCP23017
+  for (uint8_t reg = 0x12; reg <= 0x13; reg++) {
+    Wire.beginTransmission(addr);
+    Wire.write(reg);
+    Wire.endTransmission(false);
+    Wire.requestFrom(addr, (uint8_t)1);
+    Wire.read();
+  }
+  Wire.beginTransmission(addr);
+  Wire.write(0x15);
+  Wire.write(relay ? 0x80 : 0);
+  Wire.endTransmission();
+#else
+  Wire.requestFrom(addr, (uint8_t)1);
+  Wire.read();
+  Wire.beginTransmission(addr);
+  Wire.write((uint8_t)(tank::kFullMask | (relay ? 0x80 : 0)));
+  Wire.endTransmission();
+#endif
+}
+
+static void budgetCase() {
+  printf("bus time per cycle, %s at %lu Hz, budget %d us\n", CHIP_NAME,
+         (unsigned long)I2C_FREQUENCY, MULTI_TANK_CYCLE_BUDGET_US);
+  printf("%9s %9s %9s %9s %7s %7s %7s\n", "overhead", "read", "+relays",
+         "naive", "tanks", "worst", "naive");
+
+  static const uint32_t overheadsUs[] = {0, 25, 50, 100};
+  for (uint32_t overhead : overheadsUs) {
+    sim_overhead_us = overhead;
+    plugAll();
+    expander_init();
+    expander_reset_stats();
+
+    // Ciclo típico: solo lectura
+    uint64_t start = clock_us();
+    expander_read_all(inputs);
+    uint32_t readUs = (uint32_t)(clock_us() - start);
+    ExpanderStats stats;
+    expander_get_stats(&stats);
+    check(stats.lastReadUs == readUs, "lastReadUs differs from bus time");
+
+    // Peor caso: todos los relés cambian en el mismo ciclo
+    for (int i = 0; i < NUM_TANKS; i++) {
+      expander_set_relay(i, true);
+    }
+    start = clock_us();
+    expander_flush();
+    uint32_t writeUs = (uint32_t)(clock_us() - start);
+    expander_get_stats(&stats);
+    check(stats.lastWriteUs == writeUs, "lastWriteUs differs from bus time");
+
+    start = clock_us();
+    for (int i = 0; i < NUM_TANKS; i++) {
+      naiveTank(i, true);
+    }
+    uint32_t naiveUs = (uint32_t)(clock_us() - start);
+
+    uint32_t worstUs = readUs + writeUs;
+    if (overhead == 0) {
+      check(worstUs < MULTI_TANK_CYCLE_BUDGET_US,
+            "NUM_TANKS do not fit the cycle budget on the bare bus");
+    }
+    printf("%6lu us %6lu us %6lu us %6lu us %7lu %7lu %7lu\n",
+           (unsigned long)overhead, (unsigned long)readUs,
+           (unsigned long)worstUs, (unsigned long)naiveUs,
+           (unsigned long)(MULTI_TANK_CYCLE_BUDGET_US * NUM_TANKS / readUs),
+           (unsigned long)(MULTI_TANK_CYCLE_BUDGET_US * NUM_TANKS / worstUs),
+           (unsigned long)(MULTI_TANK_CYCLE_BUDGET_US * NUM_TANKS / naiveUs));
+  }
+  sim_overhead_us = 0;
+  printf("(tanks that fit the budget: burst read only, burst read with every "
+         "relay changing, per-tank read + relay; 8 addresses at most)\n");
+}
+
+int main(int argc, char **argv) {
+  bool verbose = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 0);
+    } else if (!strcmp(argv[i], "--verbose")) {
+      verbose = true;
+    } else {
+      printf("usage: %s [--seed N] [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+  Serial.enabled = verbose;
+  clock_fake_start(0);
+
+  initCase();
+  readCase();
+  relayCase();
+  errorCase();
+  pipelineCase();
+  stuckFloatCase();
+  budgetCase();
+
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * Banco de pruebas de LevelLookup
+ * ===============================
+ * Compara el nivel y la contigüidad de tank_geometry.h (tabla hasta 8
+ * boyas, bit más alto con más) contra el bucle sobre bool levels[] que
+ * usaban sensors_read() y sensors_validate_sequence().
+ *
+ * Verifica:
+ *   - MaskFor<N> es el tipo más chico y LevelLookup elige tabla o NSAU
+ *   - N = 7, 8, 12 y 16: las 2^N máscaras dan lo mismo que el bucle
+ *   - N = 32: todas las máscaras contiguas, todos los bits sueltos y
+ *     máscaras al azar
+ *
+ * Informa ns por lectura (nivel + validación) de cada forma.
+ *
+ * Uso: levels_bench [--iterations N] [--seed N]
+ */
+
+#include "sim_check.h"
+#include "tank_geometry.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using tank::LevelLookup;
+using tank::MaskFor;
+
+static_assert(sizeof(MaskFor<7>) == 1 && sizeof(MaskFor<8>) == 1, "MaskFor");
+static_assert(sizeof(MaskFor<9>) == 2 && sizeof(MaskFor<12>) == 2, "MaskFor");
+static_assert(sizeof(MaskFor<16>) == 2 && sizeof(MaskFor<17>) == 4, "MaskFor");
+static_assert(sizeof(MaskFor<32>) == 4, "MaskFor");
+static_assert(sizeof(LevelLookup<7>::table) == 128, "7 boyas usa tabla");
+static_assert(sizeof(LevelLookup<8>::table) == 256, "8 boyas usa tabla");
+static_assert(LevelLookup<12>::level(0x800) == 12, "12 boyas sin tabla");
+static_assert(LevelLookup<12>::contiguous(0xFFF), "12 boyas llenas");
+static_assert(!LevelLookup<12>::contiguous(0xEFF), "hueco en S9");
+static_assert(LevelLookup<32>::level(0xFFFFFFFF) == 32, "32 boyas llenas");
+static_assert(LevelLookup<32>::contiguous(0xFFFFFFFF), "32 boyas llenas");
+
+#define MASK_POOL 4096
+
+static long iterations = 20000000;
+
+// check() con la configuración y la máscara delante del mensaje
+static void check(bool ok, const char *what, int n, uint32_t mask) {
+  if (!ok) {
+    char message[160];
+    snprintf(message, sizeof(message), "N=%d mask 0x%08lx: %s", n,
+             (unsigned long)mask, what);
+    check(false, message);
+  }
+}
+
+// El bucle anterior: nivel = boya activa más alta, después recorrer las
+// boyas contra i < nivel
+template <int N> struct LoopLevels {
+  bool levels[N];
+
+  void load(uint32_t mask) {
+    for (int i = 0; i < N; i++) {
+      levels[i] = (mask >> i) & 1;
+    }
+  }
+  int level() const {
+    int level = 0;
+    for (int i = 0; i < N; i++) {
+      if (levels[i]) {
+        level = i + 1;
+      }
+    }
+    return level;
+  }
+  bool contiguous(int level) const {
+    for (int i = 0; i < N; i++) {
+      if (levels[i] != (i < level)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+template <int N> static void checkMask(uint32_t mask) {
+  LoopLevels<N> loop;
+  loop.load(mask);
+  int level = loop.level();
+  MaskFor<N> m = (MaskFor<N>)mask;
+  check(LevelLookup<N>::level(m) == level, "level differs", N, mask);
+  check(LevelLookup<N>::contiguous(m) == loop.contiguous(level),
+        "contiguous differs", N, mask);
+}
+
+template <int N> static void checkAll() {
+  for (uint32_t mask = 0; mask < (1UL << N); mask++) {
+    checkMask<N>(mask);
+  }
+  printf("N=%-2d %-5s all %lu masks\n", N, N <= 8 ? "table" : "nsau",
+         (unsigned long)(1UL << N));
+}
+
+static void check32() {
+  long count = 0;
+  for (int level = 0; level <= 32; level++) {
+    uint32_t mask = level == 32 ? 0xFFFFFFFFUL : (1UL << level) - 1;
+    checkMask<32>(mask);
+    // El mismo nivel con un hueco en cada posición por debajo
+    for (int hole = 0; hole + 1 < level; hole++) {
+      checkMask<32>(mask & ~(1UL << hole));
+      count++;
+    }
+    count++;
+  }
+  for (int bit = 0; bit < 32; bit++) {
+    checkMask<32>(1UL << bit);
+    count++;
+  }
+  for (int i = 0; i < 1000000; i++) {
+    checkMask<32>(random32());
+    count++;
+  }
+  printf("N=32 nsau  %ld masks (contiguous, one hole, single bit, random)\n",
+         count);
+}
+
+// Máscaras como las del tanque: casi todas contiguas, alguna con falla
+template <int N> static void fillPool(uint32_t *pool) {
+  for (int i = 0; i < MASK_POOL; i++) {
+    int level = nextRandom() % (N + 1);
+    uint32_t mask = level == 32 ? 0xFFFFFFFFUL : (1UL << level) - 1;
+    if (nextRandom() % 16 == 0) {
+      mask ^= 1UL << (nextRandom() % N);
+    }
+    pool[i] = mask;
+  }
+}
+
+template <class F> static double nsPerCall(F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < iterations; i++) {
+    f(i & (MASK_POOL - 1));
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         iterations;
+}
+
+template <int N> static void bench() {
+  static uint32_t pool[MASK_POOL];
+  static LoopLevels<N> loops[MASK_POOL];
+  fillPool<N>(pool);
+  for (int i = 0; i < MASK_POOL; i++) {
+    loops[i].load(pool[i]);
+  }
+
+  volatile int sink = 0;
+  double loopNs = nsPerCall([&](long i) {
+    int level = loops[i].level();
+    sink = level + loops[i].contiguous(level);
+  });
+  double lookupNs = nsPerCall([&](long i) {
+    MaskFor<N> mask = (MaskFor<N>)pool[i];
+    sink = LevelLookup<N>::level(mask) + LevelLookup<N>::contiguous(mask);
+  });
+  printf("%6d %10.2f %10.2f %9.1fx\n", N, loopNs, lookupNs, loopNs / lookupNs);
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+      iterations = atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 0);
+    } else {
+      printf("usage: %s [--iterations N] [--seed N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (iterations < 1) {
+    iterations = 1;
+  }
+
+  checkAll<7>();
+  checkAll<8>();
+  checkAll<12>();
+  checkAll<16>();
+  check32();
+
+  printf("level + validation (ns/read), %d masks\n", MASK_POOL);
+  printf("%6s %10s %10s %10s\n", "boyas", "loop", "lookup", "speedup");
+  bench<7>();
+  bench<12>();
+  bench<tank::kNumSensors>();
+
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
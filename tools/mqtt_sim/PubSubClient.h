@@ -0,0 +1,60 @@
+#ifndef MQTT_SIM_PUBSUBCLIENT_H
+#define MQTT_SIM_PUBSUBCLIENT_H
+
+// Lo de PubSubClient que usa mqtt.cpp. CONNECT/CONNACK no viajan por el
+// socket: el resultado lo decide sim_broker (sin CONNACK, la espera dura el
+// socket timeout, como en la biblioteca).
+
+#include "WiFi.h"
+
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+#define MQTT_CONNECTED 0
+#define MQTT_CONNECT_UNAUTHORIZED 5
+
+typedef void (*MqttCallback)(char *topic, uint8_t *payload,
+                             unsigned int length);
+
+class PubSubClient : public Print {
+public:
+  explicit PubSubClient(Client &client) : client(&client) {}
+
+  void setServer(const char *host, uint16_t port) {
+    this->host = host;
+    this->port = port;
+  }
+  void setCallback(MqttCallback callback) {}
+  void setSocketTimeout(uint16_t seconds) { socketTimeoutS = seconds; }
+
+  bool connect(const char *id);
+  bool connect(const char *id, const char *user, const char *password) {
+    return connect(id);
+  }
+  void disconnect();
+  bool connected();
+  bool loop();
+  int state() const { return rc; }
+
+  bool publish(const char *topic, const char *payload) { return connected(); }
+  bool subscribe(const char *topic) { return connected(); }
+  bool beginPublish(const char *topic, unsigned int length, bool retained) {
+    return connected();
+  }
+  int endPublish() { return connected(); }
+  size_t write(uint8_t c) override { return client->write(c); }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    return client->write(buffer, size);
+  }
+
+private:
+  Client *client;
+  const char *host = "";
+  uint16_t port = 0;
+  uint16_t socketTimeoutS = 15; // Valor por defecto de PubSubClient
+  bool session = false;
+  int rc = MQTT_DISCONNECTED;
+};
+
+#endif // MQTT_SIM_PUBSUBCLIENT_H
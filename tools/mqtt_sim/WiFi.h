@@ -0,0 +1,120 @@
+#ifndef MQTT_SIM_WIFI_H
+#define MQTT_SIM_WIFI_H
+
+// WiFi y WiFiClient de Arduino-ESP32 contra un punto de acceso y un broker
+// simulados (sim_ap, sim_broker). Un connect() avanza el reloj falso lo que
+// tarda el broker en contestar, acotado por el timeout pedido, como el
+// connect() real bloquea la tarea que lo llama.
+
+#include <Arduino.h>
+
+class IPAddress {
+public:
+  String toString() const { return String("192.168.1.50"); }
+};
+
+class Client : public Print {
+public:
+  virtual int connect(IPAddress ip, uint16_t port) = 0;
+  virtual int connect(const char *host, uint16_t port) = 0;
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int read(uint8_t *buffer, size_t size) = 0;
+  virtual int peek() = 0;
+  virtual void flush() = 0;
+  virtual void stop() = 0;
+  virtual uint8_t connected() = 0;
+  virtual operator bool() = 0;
+  using Print::write;
+};
+
+class WiFiClient : public Client {
+public:
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char *host, uint16_t port) override;
+  int connect(IPAddress ip, uint16_t port, int32_t timeout);
+  int connect(const char *host, uint16_t port, int32_t timeout);
+  size_t write(uint8_t c) override { return connected() ? 1 : 0; }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    return connected() ? size : 0;
+  }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int read(uint8_t *buffer, size_t size) override { return -1; }
+  int peek() override { return -1; }
+  void flush() override {}
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return connected(); }
+};
+
+typedef enum {
+  ARDUINO_EVENT_WIFI_STA_GOT_IP,
+  ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+} arduino_event_id_t;
+
+typedef struct {
+} arduino_event_info_t;
+
+typedef void (*WiFiEventFuncCb)(arduino_event_id_t event,
+                                arduino_event_info_t info);
+
+#define WIFI_STA 1
+
+class WiFiClass {
+public:
+  void onEvent(WiFiEventFuncCb callback) { eventCallback = callback; }
+  void mode(int mode) {}
+  void setAutoReconnect(bool enable) {}
+  void begin(const char *ssid, const char *password);
+  void disconnect();
+  IPAddress localIP() { return IPAddress(); }
+
+  WiFiEventFuncCb eventCallback = nullptr;
+};
+
+extern WiFiClass WiFi;
+
+// SNTP: sin red simulada no hace nada
+static inline void configTzTime(const char *tz, const char *server) {}
+
+// ----------------------------------------------------------------
+// Red simulada
+// ----------------------------------------------------------------
+
+// Punto de acceso: da IP ipDelayMs después de WiFi.begin() si está arriba
+struct SimAp {
+  bool up;
+  uint32_t ipDelayMs;
+  uint32_t joins;       // WiFi.begin()
+  uint32_t disconnects; // WiFi.disconnect()
+};
+
+// Cómo contesta el broker el próximo intento
+enum SimBrokerMode {
+  SIM_BROKER_ACCEPT, // TCP y CONNACK después de delayMs
+  SIM_BROKER_REFUSE, // TCP rechazado enseguida (puerto cerrado)
+  SIM_BROKER_SILENT, // Sin respuesta: el connect() agota su timeout
+  SIM_BROKER_NACK,   // TCP abre, CONNACK con código de error
+  SIM_BROKER_MUTE    // TCP abre, el CONNACK no llega: vence el socket timeout
+};
+
+struct SimBroker {
+  SimBrokerMode mode;
+  uint32_t delayMs;  // Demora del TCP (ACCEPT, NACK y MUTE)
+  bool open;         // Sesión TCP abierta
+  uint32_t attempts; // Llamadas a connect()
+  uint64_t lastAttemptMs;
+};
+
+extern SimAp sim_ap;
+extern SimBroker sim_broker;
+
+// Entregar los eventos WiFi vencidos (la tarea de eventos del WiFi)
+void sim_wifi_poll();
+
+// Caídas desde afuera
+void sim_ap_drop();
+void sim_broker_drop();
+
+#endif // MQTT_SIM_WIFI_H
@@ -0,0 +1,335 @@
+/*
+ * Simulador del gestor de conexión WiFi/MQTT
+ * ==========================================
+ * Corre mqtt.cpp sin cambios contra un punto de acceso y un broker
+ * simulados (WiFi.h y PubSubClient.h de esta carpeta) que rechazan,
+ * demoran, no contestan o cortan conexiones. mqtt_loop() se llama cada
+ * MQTT_LOOP_INTERVAL_MS sobre el reloj falso, como la tarea de red.
+ *
+ * Verifica:
+ *   - mqtt_init() no espera nada y el callback informa cada estado
+ *   - cada reintento espera entre backoff/2 y backoff, el backoff se
+ *     duplica hasta MQTT_BACKOFF_MAX_MS y vuelve al mínimo al conectar
+ *   - el jitter reparte los reintentos de muchos cortes sobre todo el
+ *     intervalo [backoff/2, backoff]
+ *   - ninguna pasada de mqtt_loop() bloquea más que
+ *     MQTT_CONNECT_TIMEOUT_MS en el TCP y otro tanto esperando el CONNACK
+ *     (broker mudo, lento o que no contesta el CONNECT)
+ *   - WiFi caído o que no da IP: reintento con backoff y nueva asociación
+ *   - eventlog_link_down() una vez por cada salida de ONLINE
+ *
+ * Uso: mqtt_sim [--episodes N] [--seed N] [--verbose]
+ */
+
+#include "clock.h"
+#include "mqtt.h"
+#include "sim_check.h"
+#include <vector>
+
+#if !MQTT_ENABLED
+#error "mqtt_sim necesita MQTT_ENABLED"
+#endif
+
+#define STEP_MS MQTT_LOOP_INTERVAL_MS
+#define JITTER_STEPS 4
+
+static long episodes = 400;
+
+// ----------------------------------------------------------------
+// Registro de eventos: solo lo que usa mqtt.cpp
+// ----------------------------------------------------------------
+
+static uint32_t linkDowns = 0;
+
+void eventlog_acked(uint16_t packetId) {}
+void eventlog_link_down() { linkDowns++; }
+const char *eventlog_type_name(EventType type) { return "sim"; }
+
+// ----------------------------------------------------------------
+// Tarea de red simulada
+// ----------------------------------------------------------------
+
+struct Transition {
+  MqttConnState state;
+  uint64_t atMs;
+};
+
+static std::vector<Transition> transitions;
+static uint32_t onlineExits = 0;
+static uint64_t maxBlockMs = 0;
+
+static void onState(MqttConnState state) {
+  if (!transitions.empty() && transitions.back().state == MQTT_STATE_ONLINE) {
+    onlineExits++;
+  }
+  transitions.push_back({state, clock_ms()});
+}
+
+static void tick() {
+  sim_wifi_poll();
+  uint64_t start = clock_ms();
+  mqtt_loop();
+  uint64_t blocked = clock_ms() - start;
+  if (blocked > maxBlockMs) {
+    maxBlockMs = blocked;
+  }
+  clock_fake_advance(STEP_MS * 1000ULL);
+}
+
+// Correr hasta que se cumpla la condición o pasen limitMs
+template <class F> static bool runUntil(F done, uint64_t limitMs) {
+  uint64_t start = clock_ms();
+  while (!done()) {
+    if (clock_ms() - start > limitMs) {
+      return false;
+    }
+    tick();
+  }
+  return true;
+}
+
+static bool online() { return mqtt_get_state() == MQTT_STATE_ONLINE; }
+
+static bool waitOnline() { return runUntil(online, 10 * MQTT_BACKOFF_MAX_MS); }
+
+// Reintentos desde que el gestor entra en BACKOFF hasta el próximo intento
+// (nueva asociación WiFi o connect() al broker)
+static std::vector<uint64_t> retryDelays(int count) {
+  std::vector<uint64_t> delays;
+  while ((int)delays.size() < count) {
+    if (!runUntil([] { return mqtt_get_state() == MQTT_STATE_BACKOFF; },
+                  2 * MQTT_BACKOFF_MAX_MS)) {
+      break;
+    }
+    uint64_t since = clock_ms();
+    uint32_t attempts = sim_broker.attempts, joins = sim_ap.joins;
+    if (!runUntil([&] {
+          return sim_broker.attempts != attempts || sim_ap.joins != joins;
+        },
+                  2 * MQTT_BACKOFF_MAX_MS)) {
+      break;
+    }
+    uint64_t attemptAt =
+        sim_broker.attempts != attempts ? sim_broker.lastAttemptMs : clock_ms();
+    delays.push_back(attemptAt - since);
+  }
+  return delays;
+}
+
+static uint32_t backoffFor(int step) {
+  uint64_t b = MQTT_BACKOFF_MIN_MS;
+  for (int i = 0; i < step && b < MQTT_BACKOFF_MAX_MS; i++) {
+    b *= 2;
+  }
+  return (uint32_t)min(b, (uint64_t)MQTT_BACKOFF_MAX_MS);
+}
+
+// El reintento k espera en [b/2, b], más lo que tarda en llegar la pasada
+static bool inWindow(uint64_t delayMs, int step) {
+  uint32_t b = backoffFor(step);
+  return delayMs >= b / 2 && delayMs <= b + STEP_MS;
+}
+
+// ----------------------------------------------------------------
+// Casos
+// ----------------------------------------------------------------
+
+static void bootCase() {
+  sim_ap.up = true;
+  sim_ap.ipDelayMs = 800;
+  sim_broker.mode = SIM_BROKER_ACCEPT;
+  sim_broker.delayMs = 30;
+  mqtt_set_state_callback(onState);
+
+  uint64_t start = clock_ms();
+  mqtt_init();
+  check(clock_ms() == start, "mqtt_init() waited");
+  check(mqtt_get_state() == MQTT_STATE_WIFI_CONNECTING,
+        "mqtt_init() did not start the WiFi association");
+  check(waitOnline(), "never came online at boot");
+  uint64_t tookMs = clock_ms() - start;
+  check(tookMs <= sim_ap.ipDelayMs + sim_broker.delayMs + 2 * STEP_MS,
+        "boot connection slower than IP + TCP + one loop");
+
+  static const MqttConnState expected[] = {MQTT_STATE_WIFI_CONNECTING,
+                                           MQTT_STATE_BROKER_CONNECTING,
+                                           MQTT_STATE_ONLINE};
+  bool sequence = transitions.size() == 3;
+  for (size_t i = 0; sequence && i < 3; i++) {
+    sequence = transitions[i].state == expected[i];
+  }
+  check(sequence, "boot callback sequence is not wifi -> broker -> online");
+  printf("boot: online after %lu ms, mqtt_init() took 0 ms\n",
+         (unsigned long)tookMs);
+}
+
+static void backoffCase() {
+  sim_broker.mode = SIM_BROKER_REFUSE;
+  sim_broker_drop();
+  std::vector<uint64_t> delays = retryDelays(12);
+  check(delays.size() == 12, "refused broker stopped retrying");
+  bool capped = false;
+  printf("backoff with the broker refusing (ms):");
+  for (size_t k = 0; k < delays.size(); k++) {
+    check(inWindow(delays[k], k), "retry outside [backoff/2, backoff]");
+    capped |= backoffFor(k) == MQTT_BACKOFF_MAX_MS;
+    printf(" %lu", (unsigned long)delays[k]);
+  }
+  printf("\n");
+  check(capped, "backoff never reached MQTT_BACKOFF_MAX_MS");
+
+  // Al conectar, el backoff vuelve al mínimo
+  sim_broker.mode = SIM_BROKER_ACCEPT;
+  check(waitOnline(), "did not reconnect when the broker came back");
+  sim_broker.mode = SIM_BROKER_REFUSE;
+  sim_broker_drop();
+  delays = retryDelays(1);
+  check(delays.size() == 1 && inWindow(delays[0], 0),
+        "backoff not reset to the minimum after connecting");
+  sim_broker.mode = SIM_BROKER_ACCEPT;
+  waitOnline();
+}
+
+// Muchos cortes: los reintentos deben cubrir todo [b/2, b]
+static void jitterCase() {
+  uint64_t lo[JITTER_STEPS], hi[JITTER_STEPS];
+  double sum[JITTER_STEPS] = {};
+  for (int k = 0; k < JITTER_STEPS; k++) {
+    lo[k] = UINT64_MAX;
+    hi[k] = 0;
+  }
+  for (long e = 0; e < episodes; e++) {
+    sim_broker.mode = SIM_BROKER_REFUSE;
+    sim_broker_drop();
+    std::vector<uint64_t> delays = retryDelays(JITTER_STEPS);
+    for (size_t k = 0; k < delays.size(); k++) {
+      lo[k] = min(lo[k], delays[k]);
+      hi[k] = max(hi[k], delays[k]);
+      sum[k] += delays[k];
+    }
+    check(delays.size() == JITTER_STEPS, "jitter episode stopped retrying");
+    sim_broker.mode = SIM_BROKER_ACCEPT;
+    check(waitOnline(), "jitter episode did not reconnect");
+  }
+
+  printf("retry spread over %ld outages (ms)\n", episodes);
+  printf("%5s %8s %8s %8s %8s\n", "retry", "backoff", "min", "mean", "max");
+  for (int k = 0; k < JITTER_STEPS; k++) {
+    uint32_t b = backoffFor(k);
+    double mean = sum[k] / episodes;
+    // Uniforme en [b/2, b]: media 3b/4, extremos cerca de los bordes
+    check(lo[k] <= b / 2 + b / 20 && hi[k] + b / 20 >= b,
+          "jitter does not cover [backoff/2, backoff]");
+    check(mean > 0.7 * b && mean < 0.8 * b + STEP_MS,
+          "jitter mean far from 3/4 of the backoff");
+    printf("%5d %8lu %8lu %8.0f %8lu\n", k + 1, (unsigned long)b,
+           (unsigned long)lo[k], mean, (unsigned long)hi[k]);
+  }
+}
+
+// Broker mudo, lento, que rechaza o no contesta el CONNECT
+static void slowBrokerCase() {
+  maxBlockMs = 0;
+  sim_broker.mode = SIM_BROKER_SILENT;
+  sim_broker_drop();
+  retryDelays(3);
+  check(maxBlockMs == MQTT_CONNECT_TIMEOUT_MS,
+        "silent broker did not block exactly MQTT_CONNECT_TIMEOUT_MS");
+
+  sim_broker.mode = SIM_BROKER_ACCEPT;
+  sim_broker.delayMs = MQTT_CONNECT_TIMEOUT_MS + 500;
+  retryDelays(2);
+  check(!online(), "connected through a TCP slower than the timeout");
+
+  sim_broker.delayMs = MQTT_CONNECT_TIMEOUT_MS * 3 / 4;
+  check(waitOnline(), "slow but in-time broker never connected");
+
+  sim_broker.mode = SIM_BROKER_NACK;
+  sim_broker.delayMs = 20;
+  sim_broker_drop();
+  retryDelays(2);
+  check(!online() && !sim_broker.open,
+        "refused CONNACK left the socket open or went online");
+
+  sim_broker.mode = SIM_BROKER_ACCEPT;
+  check(waitOnline(), "did not recover after CONNACK refusals");
+  check(maxBlockMs <= MQTT_CONNECT_TIMEOUT_MS,
+        "an mqtt_loop() pass blocked longer than MQTT_CONNECT_TIMEOUT_MS");
+
+  // Peor caso: TCP lento y CONNACK que no llega, un timeout detrás del otro
+  uint64_t tcpBlockMs = maxBlockMs;
+  maxBlockMs = 0;
+  sim_broker.mode = SIM_BROKER_MUTE;
+  sim_broker.delayMs = MQTT_CONNECT_TIMEOUT_MS * 3 / 4;
+  sim_broker_drop();
+  retryDelays(2);
+  check(!online() && !sim_broker.open,
+        "missing CONNACK left the socket open or went online");
+  check(maxBlockMs > MQTT_CONNECT_TIMEOUT_MS &&
+            maxBlockMs <= 2 * MQTT_CONNECT_TIMEOUT_MS,
+        "missing CONNACK not bounded by 2 * MQTT_CONNECT_TIMEOUT_MS");
+
+  sim_broker.mode = SIM_BROKER_ACCEPT;
+  sim_broker.delayMs = 20;
+  check(waitOnline(), "did not recover after a missing CONNACK");
+  printf("slow broker: longest mqtt_loop() pass %lu ms on TCP, %lu ms "
+         "without CONNACK (timeout %d ms)\n",
+         (unsigned long)tcpBlockMs, (unsigned long)maxBlockMs,
+         MQTT_CONNECT_TIMEOUT_MS);
+}
+
+static void wifiCase() {
+  // Punto de acceso caído estando en línea
+  uint32_t joins = sim_ap.joins;
+  sim_ap_drop();
+  runUntil([] { return !online(); }, 10 * STEP_MS);
+  check(mqtt_get_state() == MQTT_STATE_BACKOFF, "WiFi loss did not back off");
+
+  // Sin punto de acceso: cada asociación vence por MQTT_WIFI_TIMEOUT_MS
+  uint32_t disconnects = sim_ap.disconnects;
+  maxBlockMs = 0;
+  runUntil([&] { return sim_ap.disconnects >= disconnects + 2; },
+           4 * (MQTT_WIFI_TIMEOUT_MS + MQTT_BACKOFF_MAX_MS));
+  check(sim_ap.disconnects >= disconnects + 2,
+        "WiFi association without IP did not time out");
+  check(maxBlockMs == 0, "waiting for WiFi blocked mqtt_loop()");
+
+  sim_ap.up = true;
+  check(waitOnline(), "did not reconnect when WiFi came back");
+  check(sim_ap.joins > joins, "reconnected without a new association");
+}
+
+int main(int argc, char **argv) {
+  bool verbose = false;
+  uint32_t seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--episodes") && i + 1 < argc) {
+      episodes = max(1L, atol(argv[++i]));
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], NULL, 0);
+    } else if (!strcmp(argv[i], "--verbose")) {
+      verbose = true;
+    } else {
+      printf("usage: %s [--episodes N] [--seed N] [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+  Serial.enabled = verbose;
+  randomSeed(seed);
+  clock_fake_start(0);
+
+  bootCase();
+  backoffCase();
+  jitterCase();
+  slowBrokerCase();
+  wifiCase();
+
+  check(linkDowns == onlineExits,
+        "eventlog_link_down() not called once per ONLINE exit");
+  printf("%lu transitions, %lu online exits, %lu link-down notices\n",
+         (unsigned long)transitions.size(), (unsigned long)onlineExits,
+         (unsigned long)linkDowns);
+
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
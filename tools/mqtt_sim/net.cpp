@@ -0,0 +1,150 @@
+#include "PubSubClient.h"
+#include "clock.h"
+
+#define SIM_DEFAULT_CONNECT_TIMEOUT_MS 3000 // WiFiClient sin timeout
+
+WiFiClass WiFi;
+SimAp sim_ap = {true, 500, 0, 0};
+SimBroker sim_broker = {SIM_BROKER_ACCEPT, 20, false, 0, 0};
+
+static bool hasIp = false;
+static bool ipPending = false;
+static uint64_t ipAt = 0;
+static bool disconnectPending = false;
+
+static void advanceMs(uint32_t ms) { clock_fake_advance((uint64_t)ms * 1000); }
+
+// ----------------------------------------------------------------
+// WiFi
+// ----------------------------------------------------------------
+
+void WiFiClass::begin(const char *ssid, const char *password) {
+  sim_ap.joins++;
+  ipPending = true;
+  ipAt = clock_ms() + sim_ap.ipDelayMs;
+}
+
+void WiFiClass::disconnect() {
+  sim_ap.disconnects++;
+  ipPending = false;
+  hasIp = false;
+  disconnectPending = true;
+}
+
+void sim_wifi_poll() {
+  arduino_event_info_t info;
+  if (disconnectPending) {
+    disconnectPending = false;
+    if (WiFi.eventCallback) {
+      WiFi.eventCallback(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, info);
+    }
+  }
+  if (ipPending && sim_ap.up && clock_ms() >= ipAt) {
+    ipPending = false;
+    hasIp = true;
+    if (WiFi.eventCallback) {
+      WiFi.eventCallback(ARDUINO_EVENT_WIFI_STA_GOT_IP, info);
+    }
+  }
+}
+
+void sim_ap_drop() {
+  sim_ap.up = false;
+  ipPending = false;
+  sim_broker.open = false;
+  if (hasIp) {
+    hasIp = false;
+    disconnectPending = true;
+  }
+}
+
+void sim_broker_drop() { sim_broker.open = false; }
+
+// ----------------------------------------------------------------
+// Socket
+// ----------------------------------------------------------------
+
+int WiFiClient::connect(IPAddress ip, uint16_t port) {
+  return connect("", port, SIM_DEFAULT_CONNECT_TIMEOUT_MS);
+}
+
+int WiFiClient::connect(const char *host, uint16_t port) {
+  return connect(host, port, SIM_DEFAULT_CONNECT_TIMEOUT_MS);
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+  return connect("", port, timeout);
+}
+
+int WiFiClient::connect(const char *host, uint16_t port, int32_t timeout) {
+  sim_broker.attempts++;
+  sim_broker.lastAttemptMs = clock_ms();
+  sim_broker.open = false;
+  if (!hasIp) {
+    return 0;
+  }
+
+  switch (sim_broker.mode) {
+  case SIM_BROKER_REFUSE:
+    advanceMs(1); // RST inmediato
+    return 0;
+  case SIM_BROKER_SILENT:
+    advanceMs(timeout);
+    return 0;
+  case SIM_BROKER_ACCEPT:
+  case SIM_BROKER_NACK:
+  case SIM_BROKER_MUTE:
+    if (sim_broker.delayMs >= (uint32_t)timeout) {
+      advanceMs(timeout);
+      return 0;
+    }
+    advanceMs(sim_broker.delayMs);
+    sim_broker.open = true;
+    return 1;
+  }
+  return 0;
+}
+
+void WiFiClient::stop() { sim_broker.open = false; }
+
+uint8_t WiFiClient::connected() { return sim_broker.open; }
+
+// ----------------------------------------------------------------
+// Sesión MQTT (CONNACK inmediato, salvo MUTE)
+// ----------------------------------------------------------------
+
+bool PubSubClient::connect(const char *id) {
+  if (!client->connected() && !client->connect(host, port)) {
+    rc = MQTT_CONNECT_FAILED;
+    return false;
+  }
+  if (sim_broker.mode == SIM_BROKER_NACK) {
+    rc = MQTT_CONNECT_UNAUTHORIZED;
+    return false;
+  }
+  if (sim_broker.mode == SIM_BROKER_MUTE) {
+    advanceMs(socketTimeoutS * 1000U);
+    client->stop();
+    rc = MQTT_CONNECTION_TIMEOUT;
+    return false;
+  }
+  session = true;
+  rc = MQTT_CONNECTED;
+  return true;
+}
+
+void PubSubClient::disconnect() {
+  session = false;
+  rc = MQTT_DISCONNECTED;
+  client->stop();
+}
+
+bool PubSubClient::connected() {
+  if (session && !client->connected()) {
+    session = false;
+    rc = MQTT_CONNECTION_LOST;
+  }
+  return session;
+}
+
+bool PubSubClient::loop() { return connected(); }
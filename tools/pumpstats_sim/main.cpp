@@ -0,0 +1,278 @@
+/*
+ * Simulador de las estadísticas persistentes de bomba
+ * ===================================================
+ * Corre pumpstats.cpp y pump.cpp con un reloj falso durante varios días:
+ * el aire acondicionado llena el tanque de día, la bomba hace sus ciclos
+ * (a veces en emergencia), el equipo se reinicia por cortes de energía y
+ * por el botón, y la hora tarda en llegar por SNTP después de cada
+ * arranque. El almacenamiento es un blob en RAM que cuenta escrituras.
+ *
+ * Verifica:
+ *   - los ciclos del día coinciden con los contados por la simulación
+ *     (también después de reinicios y de medianoches con el equipo sin hora)
+ *   - un corte de energía no pierde ciclos ni el promedio
+ *   - un reinicio por botón no pierde nada
+ *
+ * Informa escrituras por día y una estimación del desgaste de la
+ * partición NVS (0x5000 de partitions.csv).
+ *
+ * Uso: pumpstats_sim [--days N] [--seed N] [--verbose]
+ */
+
+#include "clock.h"
+#include "pump.h"
+#include "pumpstats.h"
+#include "sim_check.h"
+#include <vector>
+
+#define START_EPOCH 1792227600UL // 2026-10-17 06:00 (UTC-3)
+#define STEP_S 1                 // Un PUMP_STATS_POLL_MS
+#define SNTP_DELAY_S 30          // Sin hora después de cada arranque
+#define PUMP_RUN_S 45            // Ciclo normal
+#define EMERGENCY_CHANCE 0.03    // Llenados que terminan en emergencia
+
+// NVS: entradas de 32 B, 126 por página de 4 KB; un blob ocupa su índice,
+// la cabecera de datos y los datos. Una página de la partición queda libre
+// para la recolección.
+#define NVS_ENTRY_SIZE 32
+#define NVS_ENTRIES_PER_PAGE 126
+#define NVS_PAGES (0x5000 / 4096 - 1)
+#define NVS_ERASE_CYCLES 100000.0
+
+static bool verbose = false;
+
+// ============================================
+// ALMACENAMIENTO EN RAM
+// ============================================
+
+static std::vector<uint8_t> blob;
+static uint32_t writes = 0;
+static uint64_t writtenBytes = 0;
+
+static bool ramLoad(void *data, size_t length) {
+  if (blob.size() != length) {
+    return false;
+  }
+  memcpy(data, blob.data(), length);
+  return true;
+}
+
+static bool ramSave(const void *data, size_t length) {
+  blob.assign((const uint8_t *)data, (const uint8_t *)data + length);
+  writes++;
+  writtenBytes += length;
+  return true;
+}
+
+static const PumpStatsStore ramStore = {ramLoad, ramSave};
+
+// ============================================
+// EQUIPO SIMULADO
+// ============================================
+
+static Tank tanks[TANK_COUNT];
+static uint32_t bootAt = 0;      // Segundo de simulación del último arranque
+static uint32_t nextFill[TANK_COUNT]; // Segundo en que se llena cada tanque
+static uint32_t stopAt[TANK_COUNT];   // Fin de la corrida de la bomba
+static int expectedCycles[TANK_COUNT];
+static bool cycleEnded = false; // Algún ciclo terminó en este paso
+static uint32_t expectedDay = 0;
+
+static uint32_t localDay(time_t now) {
+  struct tm local;
+  localtime_r(&now, &local);
+  return (local.tm_year + 1900) * 10000 + (local.tm_mon + 1) * 100 +
+         local.tm_mday;
+}
+
+static int localHour(time_t now) {
+  struct tm local;
+  localtime_r(&now, &local);
+  return local.tm_hour;
+}
+
+// El aire llena el tanque cada 5-30 min entre las 10 y las 23
+static uint32_t fillDelay(uint32_t t) {
+  int hour = localHour(START_EPOCH + t);
+  if (hour < 10 || hour >= 23) {
+    return 3600;
+  }
+  return 5 * 60 + nextRandom() % (25 * 60);
+}
+
+static void boot(uint32_t t, bool restore) {
+  for (int i = 0; i < TANK_COUNT; i++) {
+    memset(&tanks[i], 0, sizeof(Tank));
+    tanks[i].id = i;
+    pump_attach_relay(&tanks[i].pump, [](int, bool) {}, i);
+    stopAt[i] = 0;
+  }
+  if (restore) {
+    pumpstats_attach(&ramStore, tanks, TANK_COUNT);
+  }
+  bootAt = t;
+}
+
+static void stepTank(int i, uint32_t t) {
+  PumpStatus *pump = &tanks[i].pump;
+  pump_update(pump);
+  if (pump->isRunning) {
+    if (t >= stopAt[i]) {
+      if (pump->state == PUMP_ON) {
+        expectedCycles[i]++;
+        cycleEnded = true;
+      }
+      pump_off(pump);
+      nextFill[i] = t + fillDelay(t);
+    }
+    return;
+  }
+  if (t < nextFill[i]) {
+    return;
+  }
+  if (localHour(START_EPOCH + t) < 10 || localHour(START_EPOCH + t) >= 23) {
+    nextFill[i] = t + fillDelay(t);
+    return;
+  }
+  if (chance(EMERGENCY_CHANCE)) {
+    pump_emergency_on(pump);
+    stopAt[i] = t + (uint32_t)(pump->emergencyDuration / 1000);
+  } else {
+    pump_on(pump);
+    stopAt[i] = t + PUMP_RUN_S;
+  }
+}
+
+// ============================================
+// INFORME POR DÍA
+// ============================================
+
+struct DayRow {
+  uint32_t day;
+  int cycles;
+  uint32_t writes;
+  uint32_t powerCuts;
+  uint32_t buttonRestarts;
+};
+
+int main(int argc, char **argv) {
+  int days = 7;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--days") && i + 1 < argc) {
+      days = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      seed = strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--verbose")) {
+      verbose = true;
+    } else {
+      printf("usage: %s [--days N] [--seed N] [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+  Serial.enabled = verbose;
+  setenv("TZ", TIME_ZONE, 1);
+  tzset();
+
+  clock_fake_start(0);
+  boot(0, true);
+  for (int i = 0; i < TANK_COUNT; i++) {
+    nextFill[i] = fillDelay(0);
+  }
+  expectedDay = localDay(START_EPOCH);
+
+  std::vector<DayRow> rows;
+  rows.push_back({expectedDay, 0, 0, 0, 0});
+  uint32_t dayWritesStart = 0;
+  uint32_t end = (uint32_t)days * 86400;
+
+  for (uint32_t t = 1; t <= end; t += STEP_S) {
+    clock_fake_advance(STEP_S * 1000000ULL);
+    time_t epoch = START_EPOCH + t;
+
+    uint32_t today = localDay(epoch);
+    if (today != expectedDay) {
+      rows.back().writes = writes - dayWritesStart;
+      dayWritesStart = writes;
+      rows.push_back({today, 0, 0, 0, 0});
+      expectedDay = today;
+      for (int i = 0; i < TANK_COUNT; i++) {
+        expectedCycles[i] = 0;
+      }
+    }
+
+    cycleEnded = false;
+    for (int i = 0; i < TANK_COUNT; i++) {
+      stepTank(i, t);
+    }
+
+    bool timeKnown = t - bootAt >= SNTP_DELAY_S;
+    pumpstats_poll(tanks, TANK_COUNT, timeKnown ? epoch : 0);
+    if (timeKnown) {
+      for (int i = 0; i < TANK_COUNT; i++) {
+        check(tanks[i].pump.cyclesCompleted == expectedCycles[i],
+              "daily cycles differ from the simulated ones");
+      }
+    }
+
+    // Corte de energía: sin aviso, la bomba en marcha se pierde. Además de
+    // dos por día al azar, uno de cada diez ciclos termina con un corte
+    // (lo peor para un ciclo recién contado).
+    if (chance(cycleEnded ? 0.1 : 2.0 / 86400)) {
+      int cycles = tanks[0].pump.cyclesCompleted;
+      uint64_t average = tanks[0].pump.avgCycleDuration;
+      boot(t, true);
+      check(tanks[0].pump.cyclesCompleted == cycles, "power cut lost cycles");
+      check(tanks[0].pump.avgCycleDuration == average,
+            "power cut lost the average");
+      rows.back().powerCuts++;
+    }
+
+    // Botón: reinicio pedido, se guarda antes
+    if (chance(0.5 / 86400) && !tanks[0].pump.isRunning) {
+      PumpStatus before = tanks[0].pump;
+      pumpstats_flush(tanks, TANK_COUNT);
+      boot(t, true);
+      check(tanks[0].pump.cyclesCompleted == before.cyclesCompleted &&
+                tanks[0].pump.totalRunTime == before.totalRunTime &&
+                tanks[0].pump.cycleTimeSum == before.cycleTimeSum &&
+                tanks[0].pump.avgCycleDuration == before.avgCycleDuration,
+            "button restart lost stats");
+      rows.back().buttonRestarts++;
+    }
+
+    int cycles = 0;
+    for (int i = 0; i < TANK_COUNT; i++) {
+      cycles += expectedCycles[i];
+    }
+    rows.back().cycles = cycles;
+  }
+  rows.back().writes = writes - dayWritesStart;
+
+  PumpStatsStats stats;
+  pumpstats_get_stats(&stats);
+  uint32_t entriesPerWrite =
+      2 + (uint32_t)((blob.size() + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE);
+
+  printf("day        cycles  writes  cuts  button\n");
+  for (const DayRow &row : rows) {
+    printf("%-8lu %8d %7lu %5lu %7lu\n", (unsigned long)row.day, row.cycles,
+           (unsigned long)row.writes, (unsigned long)row.powerCuts,
+           (unsigned long)row.buttonRestarts);
+  }
+  double writesPerDay = (double)writes / days;
+  double erasesPerPageDay =
+      writesPerDay * entriesPerWrite / NVS_ENTRIES_PER_PAGE / NVS_PAGES;
+  printf("%.1f writes/day (%lu on cycle end, %lu rollovers), %zu B blob, "
+         "%lu entries per write\n",
+         writesPerDay, (unsigned long)stats.cycleCommits,
+         (unsigned long)stats.rollovers, blob.size(),
+         (unsigned long)entriesPerWrite);
+  printf("NVS: %.2f erases per page per day, ~%.0f years to %.0f cycles\n",
+         erasesPerPageDay,
+         erasesPerPageDay > 0 ? NVS_ERASE_CYCLES / erasesPerPageDay / 365
+                              : 0.0,
+         NVS_ERASE_CYCLES);
+  check(stats.rollovers >= (uint32_t)days - 1, "missing day rollovers");
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,272 @@
+/*
+ * Prueba de la captura de boyas por interrupción
+ * ==============================================
+ * Inyecta flancos sintéticos con sensors_push_edge(), lo mismo que encola
+ * la ISR, y llama a sensors_read() como la tarea de control, con distintos
+ * períodos de loop sobre el reloj falso.
+ *
+ * Verifica:
+ *   - el instante de aceptación depende del flanco y del filtro, no de
+ *     cuándo corre el loop: entre (umbral - 1) y umbral muestras después
+ *     del flanco, con loops de 1 ms a 250 ms
+ *   - lastDrainUs y lastAcceptUs miden la demora del loop
+ *   - un pulso más corto que el umbral no cambia el nivel y cuenta como
+ *     rebote; un flanco con rebotes se acepta igual
+ *   - cola llena: cuenta los perdidos y se resincroniza con los pines
+ *   - timestamps que cruzan el desborde de 32 bits de los µs (~71 min)
+ *   - sensors_restore(): tras un reinicio en caliente el filtro sale de las
+ *     boyas guardadas y llega a los pines por el debounce
+ *
+ * Uso: sensors_check [--verbose]
+ */
+
+#include "clock.h"
+#include "sensors.h"
+#include "sim_check.h"
+
+#if !SENSOR_USE_INTERRUPTS
+#error "sensors_check prueba la captura por interrupción"
+#endif
+
+#define MS_US ((uint64_t)1000)
+#define SAMPLE_US (DEBOUNCE_SAMPLE_MS * MS_US)
+#define GIVE_UP_US (2000 * MS_US)
+
+static SensorState state;
+
+// Pines de las boyas sin pasar por la ISR: los flancos se inyectan aparte
+static void setPins(tank::SensorMask mask) {
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    int pin = tank::kPins[i];
+    uint32_t bit = 1UL << (pin % 32);
+    if ((mask >> i) & 1) {
+      shim_gpio_in[pin / 32] |= bit;
+    } else {
+      shim_gpio_in[pin / 32] &= ~bit;
+    }
+  }
+}
+
+static void advanceTo(uint64_t us) { clock_fake_advance(us - clock_us()); }
+
+static void restart(uint64_t startUs) {
+  clock_fake_start(startUs);
+  setPins(0);
+  memset(&state, 0, sizeof(state));
+  sensors_init();
+  sensors_read(&state); // Vaciar lo que haya quedado de la prueba anterior
+  sensors_reset_latency();
+}
+
+static void edge(tank::SensorMask mask) {
+  setPins(mask);
+  sensors_push_edge(mask, (uint32_t)clock_us());
+}
+
+// Un flanco en edgeUs y sensors_read() cada periodUs hasta detectarlo
+struct EdgeResult {
+  bool detected;
+  uint64_t drainUs;  // Flanco → primera lectura que lo vació
+  uint64_t acceptUs; // Flanco → instante de aceptación del filtro
+  uint64_t detectUs; // Flanco → lectura que informó el cambio
+  SensorLatencyStats stats;
+};
+
+static EdgeResult runEdge(tank::SensorMask mask, uint64_t edgeUs,
+                          uint64_t periodUs) {
+  EdgeResult result = {};
+  uint64_t tick = clock_us();
+  bool pushed = false;
+  uint64_t firstRead = 0;
+
+  while (tick - edgeUs < GIVE_UP_US || !pushed) {
+    tick += periodUs;
+    if (!pushed && tick > edgeUs) {
+      advanceTo(edgeUs);
+      edge(mask);
+      pushed = true;
+    }
+    advanceTo(tick);
+    bool changed = sensors_read(&state);
+    if (pushed && firstRead == 0) {
+      firstRead = tick;
+      SensorLatencyStats stats;
+      sensors_get_latency(&stats);
+      result.drainUs = stats.lastDrainUs;
+      check(stats.lastDrainUs == firstRead - edgeUs,
+            "lastDrainUs is not edge -> first read");
+    }
+    if (changed) {
+      sensors_get_latency(&result.stats);
+      result.detected = true;
+      result.detectUs = tick - edgeUs;
+      result.acceptUs = tick - result.stats.lastAcceptUs - edgeUs;
+      return result;
+    }
+  }
+  return result;
+}
+
+// Flanco limpio de subida y de bajada con un loop de periodUs
+static void latencyCase(uint64_t startUs, uint64_t periodUs) {
+  restart(startUs);
+  uint64_t edgeUs = clock_us() + 123457; // Entre muestras y entre loops
+
+  EdgeResult rise = runEdge(0x01, edgeUs, periodUs);
+  check(rise.detected && state.currentLevel == 1, "rising edge not detected");
+  check(rise.acceptUs > (DEBOUNCE_ASSERT_SAMPLES - 1) * SAMPLE_US &&
+            rise.acceptUs <= DEBOUNCE_ASSERT_SAMPLES * SAMPLE_US,
+        "rising edge accepted outside the assert window");
+  check(rise.detectUs - rise.acceptUs < periodUs,
+        "rising edge detected more than one loop after acceptance");
+
+  uint64_t fallUs = clock_us() + 234567;
+  EdgeResult fall = runEdge(0x00, fallUs, periodUs);
+  check(fall.detected && state.currentLevel == 0, "falling edge not detected");
+  check(fall.acceptUs > (DEBOUNCE_RELEASE_SAMPLES - 1) * SAMPLE_US &&
+            fall.acceptUs <= DEBOUNCE_RELEASE_SAMPLES * SAMPLE_US,
+        "falling edge accepted outside the release window");
+
+  printf("%10.1f %10.1f %10.1f %10.1f %10.1f\n", periodUs / 1000.0,
+         rise.drainUs / 1000.0, rise.acceptUs / 1000.0,
+         rise.detectUs / 1000.0, fall.acceptUs / 1000.0);
+}
+
+// Pulso de 15 ms (menos que el umbral) y flanco con rebotes
+static void bounceCase() {
+  restart(1000 * MS_US);
+  uint64_t t = clock_us() + 5000;
+  advanceTo(t);
+  edge(0x01);
+  advanceTo(t + 15 * MS_US);
+  edge(0x00);
+  for (int i = 0; i < 20; i++) {
+    clock_fake_advance(CONTROL_PERIOD_MS * MS_US);
+    check(!sensors_read(&state), "short pulse changed the level");
+  }
+  check(state.currentLevel == 0, "short pulse left a level");
+  check(sensors_get_bounces(0) > 0, "short pulse not counted as a bounce");
+
+  // Contacto que rebota 4 veces en 12 ms antes de quedar cerrado
+  static const uint32_t offsetsMs[] = {0, 2, 4, 9, 12};
+  t = clock_us() + 3000;
+  tank::SensorMask mask = 0;
+  for (uint32_t offset : offsetsMs) {
+    advanceTo(t + offset * MS_US);
+    mask ^= 0x01;
+    edge(mask);
+  }
+  uint64_t settledUs = t + 12 * MS_US;
+  bool detected = false;
+  while (!detected && clock_us() - settledUs < GIVE_UP_US) {
+    clock_fake_advance(CONTROL_PERIOD_MS * MS_US);
+    detected = sensors_read(&state);
+  }
+  SensorLatencyStats stats;
+  sensors_get_latency(&stats);
+  uint64_t acceptUs = clock_us() - stats.lastAcceptUs;
+  check(detected && state.currentLevel == 1, "bouncy edge not accepted");
+  check(acceptUs - t <= 2 * DEBOUNCE_ASSERT_SAMPLES * SAMPLE_US,
+        "bouncy edge took more than twice the assert window");
+  printf("bounces: 15 ms pulse rejected, bouncy edge accepted %.1f ms after "
+         "the first edge (%u bounces counted)\n",
+         (acceptUs - t) / 1000.0, sensors_get_bounces(0));
+}
+
+// Más flancos que la cola sin leer: los que no entran se pierden y la
+// lectura siguiente toma los pines
+static void overflowCase() {
+  restart(2000 * MS_US);
+  SensorLatencyStats before;
+  sensors_get_latency(&before);
+
+  const int extra = 10;
+  for (int i = 0; i < SENSOR_EDGE_BUFFER_SIZE + extra; i++) {
+    clock_fake_advance(100);
+    sensors_push_edge(i & 1 ? 0x00 : 0x01, (uint32_t)clock_us());
+  }
+  setPins(0x03);
+  for (int i = 0; i < 20; i++) {
+    clock_fake_advance(CONTROL_PERIOD_MS * MS_US);
+    sensors_read(&state);
+  }
+
+  SensorLatencyStats after;
+  sensors_get_latency(&after);
+  check(after.edgesDropped - before.edgesDropped == (uint32_t)extra,
+        "dropped edges not counted");
+  check(after.edgesCaptured - before.edgesCaptured ==
+            (uint32_t)SENSOR_EDGE_BUFFER_SIZE,
+        "captured edges not counted");
+  check(state.currentLevel == 2, "no resync from the pins after overflow");
+  printf("overflow: %lu captured, %lu dropped, level %d after resync\n",
+         (unsigned long)(after.edgesCaptured - before.edgesCaptured),
+         (unsigned long)(after.edgesDropped - before.edgesDropped),
+         state.currentLevel);
+}
+
+// Reinicio en caliente con nivel 2 guardado y los pines ya en 3: la primera
+// lectura sigue en 2 y el 3 llega tras la ventana de assert, en secuencia
+static void restoreCase() {
+  clock_fake_start(3000 * MS_US);
+  setPins(0x07);
+  sensors_init();
+  memset(&state, 0, sizeof(state));
+  state.levels = 0x03;
+  state.currentLevel = 2;
+  state.previousLevel = 1;
+  state.sequenceState = SEQ_FILLING;
+  sensors_restore(0x03);
+
+  sensors_read(&state);
+  check(state.currentLevel == 2, "restore did not seed the filter");
+  uint64_t startUs = clock_us();
+  while (state.currentLevel == 2 && clock_us() - startUs < GIVE_UP_US) {
+    clock_fake_advance(CONTROL_PERIOD_MS * MS_US);
+    sensors_read(&state);
+  }
+  uint64_t elapsedUs = clock_us() - startUs;
+  check(state.currentLevel == 3 && !state.sequenceError,
+        "restored filter did not reach the pins in sequence");
+  check(elapsedUs >= (DEBOUNCE_ASSERT_SAMPLES - 1) * SAMPLE_US,
+        "restored filter skipped the debounce");
+  printf("restore: level 2 -> %d after %.1f ms\n", state.currentLevel,
+         elapsedUs / 1000.0);
+}
+
+int main(int argc, char **argv) {
+  bool verbose = false;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--verbose")) {
+      verbose = true;
+    } else {
+      printf("usage: %s [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+  Serial.enabled = verbose;
+
+  printf("edge latency (ms), filter %d/%d samples of %d ms\n",
+         DEBOUNCE_ASSERT_SAMPLES, DEBOUNCE_RELEASE_SAMPLES,
+         DEBOUNCE_SAMPLE_MS);
+  printf("%10s %10s %10s %10s %10s\n", "loop", "drain", "accept", "detect",
+         "release");
+  static const uint64_t periodsUs[] = {1000, CONTROL_PERIOD_MS * MS_US, 7000,
+                                       50000, 100000, 250000};
+  for (uint64_t period : periodsUs) {
+    latencyCase(1000 * MS_US, period);
+  }
+
+  // Los timestamps de la cola son µs en 32 bits: cruzar el desborde
+  uint64_t wrapUs = (uint64_t)1 << 32;
+  printf("across the 32-bit us wrap:\n");
+  latencyCase(wrapUs - 150 * MS_US, CONTROL_PERIOD_MS * MS_US);
+  latencyCase(4 * wrapUs - 100, 50000);
+
+  bounceCase();
+  overflowCase();
+  restoreCase();
+
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
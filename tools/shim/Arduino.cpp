@@ -0,0 +1,105 @@
+// Serial, Print, GPIO virtual y esp_timer_get_time() del host, compartidos
+// por las herramientas de tools/ que compilan módulos de src/
+
+#include <Arduino.h>
+#include <chrono>
+#include <esp_timer.h>
+#include <stdarg.h>
+
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (enabled) {
+    putchar(c);
+  }
+  return 1;
+}
+
+size_t Print::print(const char *text) {
+  size_t n = 0;
+  while (*text) {
+    n += write((uint8_t)*text++);
+  }
+  return n;
+}
+
+size_t Print::print(char c) { return write((uint8_t)c); }
+
+size_t Print::print(int value) { return printf("%d", value); }
+
+size_t Print::print(unsigned int value) { return printf("%u", value); }
+
+size_t Print::print(long value) { return printf("%ld", value); }
+
+size_t Print::print(unsigned long value) { return printf("%lu", value); }
+
+size_t Print::println(const char *text) { return print(text) + print('\n'); }
+
+int Print::printf(const char *format, ...) {
+  char text[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  return (int)print(text);
+}
+
+static uint32_t randomState = 1;
+
+long random(long max) {
+  if (max <= 0) {
+    return 0;
+  }
+  randomState = randomState * 1664525UL + 1013904223UL;
+  return (long)((randomState >> 8) % (uint32_t)max);
+}
+
+void randomSeed(unsigned long seed) { randomState = (uint32_t)seed; }
+
+#define SHIM_GPIO_COUNT 40
+
+volatile uint32_t shim_gpio_in[2];
+static uint8_t gpioOut[SHIM_GPIO_COUNT];
+static void (*gpioIsr[SHIM_GPIO_COUNT])(void *);
+static void *gpioIsrArg[SHIM_GPIO_COUNT];
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < SHIM_GPIO_COUNT) {
+    gpioOut[pin] = value ? HIGH : LOW;
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  if (pin >= SHIM_GPIO_COUNT) {
+    return LOW;
+  }
+  return (shim_gpio_in[pin / 32] >> (pin % 32)) & 1;
+}
+
+void attachInterruptArg(int pin, void (*isr)(void *), void *arg, int mode) {
+  (void)mode; // Solo CHANGE
+  if (pin >= 0 && pin < SHIM_GPIO_COUNT) {
+    gpioIsr[pin] = isr;
+    gpioIsrArg[pin] = arg;
+  }
+}
+
+void shim_gpio_set(uint8_t pin, uint8_t value) {
+  if (pin >= SHIM_GPIO_COUNT || digitalRead(pin) == (value ? HIGH : LOW)) {
+    return;
+  }
+  shim_gpio_in[pin / 32] ^= 1UL << (pin % 32);
+  if (gpioIsr[pin]) {
+    gpioIsr[pin](gpioIsrArg[pin]);
+  }
+}
+
+uint8_t shim_gpio_output(uint8_t pin) {
+  return pin < SHIM_GPIO_COUNT ? gpioOut[pin] : LOW;
+}
+
+int64_t esp_timer_get_time() {
+  using namespace std::chrono;
+  static const steady_clock::time_point start = steady_clock::now();
+  return duration_cast<microseconds>(steady_clock::now() - start).count();
+}
@@ -0,0 +1,100 @@
+#ifndef SHIM_ARDUINO_H
+#define SHIM_ARDUINO_H
+
+// Lo mínimo de Arduino-ESP32 que usan los módulos de src/ compilados en el
+// host por las herramientas de tools/
+
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+using std::max;
+using std::min;
+
+#define constrain(amt, low, high)                                              \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define IRAM_ATTR
+
+// FreeRTOS: un tick = 1 ms. vTaskDelay() lo define la herramienta que
+// compila scheduler.cpp (avanzando su reloj falso)
+#define pdMS_TO_TICKS(ms) (ms)
+void vTaskDelay(uint32_t ticks);
+
+// random() de Arduino: [0, max), repetible salvo que se llame randomSeed()
+long random(long max);
+void randomSeed(unsigned long seed);
+
+// Pines: GPIO virtual. Las salidas solo se guardan; las entradas las fija
+// una simulación con shim_gpio_set(), que dispara la interrupción del pin
+// como lo haría el flanco real.
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define CHANGE 3
+static inline void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+static inline int digitalPinToInterrupt(int pin) { return pin; }
+void attachInterruptArg(int pin, void (*isr)(void *), void *arg, int mode);
+
+// Registros de entrada (GPIO 0-31 y 32-39), ver soc/gpio_reg.h
+extern volatile uint32_t shim_gpio_in[2];
+void shim_gpio_set(uint8_t pin, uint8_t value);
+uint8_t shim_gpio_output(uint8_t pin);
+
+// String: solo la concatenación que usan los mensajes de log
+class String {
+public:
+  String(const char *text = "") : text(text) {}
+  String(int value) : text(std::to_string(value)) {}
+  const char *c_str() const { return text.c_str(); }
+  friend String operator+(const char *left, const String &right) {
+    return String((left + right.text).c_str());
+  }
+
+private:
+  std::string text;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size-- > 0) {
+      n += write(*buffer++);
+    }
+    return n;
+  }
+  size_t print(const char *text);
+  size_t print(char c);
+  size_t print(int value);
+  size_t print(unsigned int value);
+  size_t print(long value);
+  size_t print(unsigned long value);
+  size_t println(const char *text = "");
+  size_t println(const String &text) { return println(text.c_str()); }
+  int printf(const char *format, ...)
+      __attribute__((format(printf, 2, 3)));
+};
+
+// Serial va a stdout (se puede silenciar con --quiet)
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  size_t write(uint8_t c) override;
+  bool enabled = true;
+};
+
+extern HardwareSerial Serial;
+
+#endif // SHIM_ARDUINO_H
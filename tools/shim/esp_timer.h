@@ -0,0 +1,9 @@
+#ifndef SHIM_ESP_TIMER_H
+#define SHIM_ESP_TIMER_H
+
+#include <stdint.h>
+
+// Reloj monotónico del host (el emulador usa el reloj falso de clock.h)
+int64_t esp_timer_get_time();
+
+#endif // SHIM_ESP_TIMER_H
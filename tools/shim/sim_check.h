@@ -0,0 +1,40 @@
+#ifndef SHIM_SIM_CHECK_H
+#define SHIM_SIM_CHECK_H
+
+// Lo que comparten las pruebas de tools/: el contador de fallas con check()
+// y un generador congruencial con semilla fija (--seed N repite la corrida).
+// Solo para el main.cpp de cada herramienta: las variables son static.
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Fallas que se imprimen; el resto solo se cuenta
+#define SIM_CHECK_SHOWN 10
+
+static int failures = 0;
+static uint32_t seed = 1;
+
+// Contar una falla si !ok
+static inline void check(bool ok, const char *what) {
+  if (!ok) {
+    if (failures < SIM_CHECK_SHOWN) {
+      printf("   %s\n", what);
+    }
+    failures++;
+  }
+}
+
+// 24 bits pseudoaleatorios (descarta los bits bajos, de período corto)
+static inline uint32_t nextRandom() {
+  seed = seed * 1664525UL + 1013904223UL;
+  return seed >> 8;
+}
+
+static inline uint32_t random32() { return (nextRandom() << 16) ^ nextRandom(); }
+
+// true con probabilidad p
+static inline bool chance(double p) {
+  return (nextRandom() % 1000000) < p * 1e6;
+}
+
+#endif // SHIM_SIM_CHECK_H
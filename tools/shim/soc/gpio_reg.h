@@ -0,0 +1,8 @@
+#ifndef SHIM_SOC_GPIO_REG_H
+#define SHIM_SOC_GPIO_REG_H
+
+// Registros de entrada del GPIO virtual (índices de shim_gpio_in)
+#define GPIO_IN_REG 0
+#define GPIO_IN1_REG 1
+
+#endif // SHIM_SOC_GPIO_REG_H
@@ -0,0 +1,8 @@
+#ifndef SHIM_SOC_SOC_H
+#define SHIM_SOC_SOC_H
+
+#include <Arduino.h>
+
+#define REG_READ(reg) (shim_gpio_in[(reg)])
+
+#endif // SHIM_SOC_SOC_H
@@ -0,0 +1,719 @@
+/*
+ * Simulador del tanque
+ * ====================
+ * Física del tanque por eventos discretos contra el firmware sin cambios:
+ * sensors.cpp (ISR, cola de flancos y debounce), tank.cpp (máquina de
+ * estados), pump.cpp y alarm.cpp corren sobre el GPIO virtual del shim y
+ * el reloj falso de clock.cpp. El condensado del aire sube el agua, la
+ * bomba la baja mientras el relé está encendido, y cada boya mueve su pin
+ * con histéresis y rebotes. Se pueden trabar boyas (contacto pegado o
+ * abierto) y agregar pulsos espurios.
+ *
+ * El control corre como en la tarea de control: updateTanks() y
+ * alarm_update() cada CONTROL_PERIOD_MS y la validación de la secuencia
+ * cada SENSOR_READ_INTERVAL_MS, pero solo en los ticks donde algo puede
+ * cambiar: después de cada flanco o cambio de estado y en los
+ * vencimientos de la bomba en emergencia. El resto se salta (un mes corre
+ * en segundos); --exact corre todos los ticks para comprobar que el
+ * resultado es el mismo.
+ *
+ * Informa ciclos, emergencias, tiempo de bomba (y en seco), desbordes y
+ * latencias de detección: cruce físico → nivel filtrado, boya de arriba →
+ * bomba encendida y boya de abajo → bomba apagada. Verifica que el
+ * historial de ciclos (flash en RAM) tenga un registro por ciclo y por
+ * emergencia.
+ *
+ * Uso: tank_sim [--days N] [--seed N] [--exact] [--verbose]
+ *               [--inflow L/H] [--ac H-H] [--compressor MIN/MIN]
+ *               [--pump L/H] [--level L] [--margin L] [--hysteresis L]
+ *               [--bounce MS] [--bounces N] [--spikes N/H]
+ *               [--stuck BOYA=0|1[@H]] [--failed BOYA[@H]]
+ */
+
+#include "clock.h"
+#include "cyclelog.h"
+#include "debounce.h"
+#include "sim_check.h"
+#include "tank.h"
+#include <chrono>
+#include <math.h>
+#include <queue>
+#include <vector>
+
+#define MS_US ((uint64_t)1000)
+#define HOUR_US (3600 * 1000 * MS_US)
+#define DAY_US (24 * HOUR_US)
+#define TICK_US (CONTROL_PERIOD_MS * MS_US)
+#define VALIDATE_US (SENSOR_READ_INTERVAL_MS * MS_US)
+#define HEARTBEAT_US (1000 * MS_US) // Tick mínimo con el tanque quieto
+#define NEVER UINT64_MAX
+
+// Ticks seguidos después de un cambio: el filtro más lento más dos
+// muestras, y una validación periódica
+#define BUSY_US                                                                \
+  ((DEBOUNCE_MAX_THRESHOLD + 2) * DEBOUNCE_SAMPLE_MS * MS_US + VALIDATE_US)
+
+#define EPSILON_L 1e-9
+
+// ============================================
+// ESCENARIO
+// ============================================
+
+struct Scenario {
+  int days = 30;
+  double inflowLph = 1.5; // Condensado con el compresor en marcha
+  int acStartH = 10;      // Aire encendido de acStartH a acEndH
+  int acEndH = 23;
+  int compressorOnMin = 25;
+  int compressorOffMin = 10;
+  double pumpLph = 120;
+  double levelL = 0.3;      // Agua entre dos boyas
+  double marginL = 0.3;     // De la última boya al borde
+  double hysteresisL = 0.01; // Sube en +h/2, baja en -h/2
+  int bounceMs = 15;        // Ventana de rebotes después de un cambio
+  int bounces = 3;          // Rebotes máximos por cambio
+  double spikesPerHour = 0; // Pulsos espurios sueltos
+  bool exact = false;
+  bool verbose = false;
+};
+
+// Boya trabada desde un instante: el pin queda fijo
+struct FloatFault {
+  bool configured;
+  bool active;
+  uint8_t level;
+  uint64_t atUs;
+};
+
+static Scenario sc;
+static FloatFault faults[NUM_SENSORS];
+
+static double uniform() { return (nextRandom() & 0xFFFFFF) / 16777216.0; }
+
+// ============================================
+// FIRMWARE
+// ============================================
+
+static Tank simTank;
+static AlarmState alarmState;
+
+static uint64_t now = 0; // Reloj falso (µs)
+
+static void setNow(uint64_t t) {
+  clock_fake_advance(t - now);
+  now = t;
+}
+
+// Historial sobre una flash en RAM (64 sectores de 4 KB)
+#define SIM_SECTOR_SIZE 4096
+#define SIM_SECTORS 64
+
+static std::vector<uint8_t> flashMemory(SIM_SECTOR_SIZE *SIM_SECTORS, 0xFF);
+
+static bool ramRead(uint32_t address, void *data, size_t length) {
+  memcpy(data, flashMemory.data() + address, length);
+  return true;
+}
+
+static bool ramWrite(uint32_t address, const void *data, size_t length) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  for (size_t i = 0; i < length; i++) {
+    flashMemory[address + i] &= bytes[i];
+  }
+  return true;
+}
+
+static bool ramErase(uint32_t sector) {
+  memset(flashMemory.data() + sector * SIM_SECTOR_SIZE, 0xFF,
+         SIM_SECTOR_SIZE);
+  return true;
+}
+
+static FlashDevice flash = {SIM_SECTOR_SIZE, SIM_SECTORS, ramRead, ramWrite,
+                            ramErase};
+
+// ============================================
+// MEDICIONES
+// ============================================
+
+struct DayStats {
+  int fills;       // Llegadas físicas a la boya de arriba
+  int cycles;      // Ciclos normales completados
+  int emergencies; // Arranques de bomba en emergencia
+  int overflows;   // Veces que el agua llegó al borde
+  uint64_t pumpUs;
+  uint64_t dryUs; // Bomba encendida con el tanque vacío
+  double inflowL;
+};
+
+struct Latency {
+  const char *name;
+  std::vector<uint32_t> samples; // µs
+
+  void add(uint64_t us) { samples.push_back((uint32_t)us); }
+
+  double percentile(double q) {
+    if (samples.empty()) {
+      return 0;
+    }
+    size_t index = (size_t)(q * (samples.size() - 1) + 0.5);
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index] / 1000.0;
+  }
+};
+
+static std::vector<DayStats> days;
+static Latency levelLatency = {"level", {}};
+static Latency fullLatency = {"full->pump on", {}};
+static Latency emptyLatency = {"empty->pump off", {}};
+
+static uint64_t emergencyUs = 0;
+static int errorsEntered = 0;
+static int emergenciesEnded = 0;
+static double pumpedL = 0;
+static double spilledL = 0;
+static double maxVolume = 0;
+static uint64_t ticks = 0;
+
+static DayStats *today() {
+  return &days[min((size_t)(now / DAY_US), days.size() - 1)];
+}
+
+// ============================================
+// FÍSICA
+// ============================================
+
+static double volume = 0;      // Litros en el tanque
+static double inflowLph = 0;   // Condensado en este momento
+static bool compressor = false;
+static uint64_t inflowNext = 0; // Próximo cambio del condensado
+static bool relayOn = false;
+static bool spilling = false;
+
+static bool floatUp[NUM_SENSORS];         // Posición física de cada boya
+static uint32_t floatGen[NUM_SENSORS];    // Invalida rebotes pendientes
+static int physLevel = 0;                 // Boyas arriba
+static uint64_t physLevelAt[NUM_SENSORS + 1]; // Llegada a cada nivel
+static uint64_t topUpAt = 0;
+static uint64_t bottomDownAt = 0;
+
+// Cambio de pin pendiente: rebote, pulso espurio o cambio limpio
+struct PinEvent {
+  uint64_t atUs;
+  int sensor;
+  uint8_t level;
+  uint32_t gen;
+  uint64_t order; // Desempate: en un mismo instante, en orden de llegada
+  bool operator>(const PinEvent &other) const {
+    return atUs != other.atUs ? atUs > other.atUs : order > other.order;
+  }
+};
+
+static std::priority_queue<PinEvent, std::vector<PinEvent>,
+                           std::greater<PinEvent>>
+    pinEvents;
+static uint64_t pinOrder = 0;
+static uint64_t spikeNext = NEVER;
+static uint64_t busyUntil = 0;
+
+static double capacity() { return NUM_SENSORS * sc.levelL + sc.marginL; }
+
+static double floatHeight(int i) { return (i + 1) * sc.levelL; }
+
+static double netLph() {
+  return inflowLph - (relayOn ? sc.pumpLph : 0);
+}
+
+// Condensado: el compresor alterna marcha y pausa mientras el aire está
+// encendido; cada marcha rinde ±30% del nominal
+static void inflowStep() {
+  uint64_t dayStart = now / DAY_US * DAY_US;
+  uint64_t acStart = dayStart + sc.acStartH * HOUR_US;
+  uint64_t acEnd = dayStart + sc.acEndH * HOUR_US;
+
+  if (now < acStart) {
+    compressor = false;
+    inflowNext = acStart;
+  } else if (now >= acEnd) {
+    compressor = false;
+    inflowNext = acStart + DAY_US;
+  } else if (!compressor) {
+    compressor = true;
+    inflowNext = min(now + sc.compressorOnMin * 60 * 1000 * MS_US, acEnd);
+  } else {
+    compressor = false;
+    inflowNext = min(now + sc.compressorOffMin * 60 * 1000 * MS_US, acEnd);
+  }
+  inflowLph = compressor ? sc.inflowLph * (0.7 + 0.6 * uniform()) : 0;
+}
+
+// Próximo instante en que el agua cruza una boya, el fondo o el borde
+static uint64_t nextCrossing() {
+  double perUs = netLph() / HOUR_US;
+  double target = -1;
+
+  if (perUs > 0) {
+    for (int i = 0; i < NUM_SENSORS; i++) {
+      double up = floatHeight(i) + sc.hysteresisL / 2;
+      if (!floatUp[i] && up > volume) {
+        target = target < 0 ? up : min(target, up);
+      }
+    }
+    if (volume < capacity() - EPSILON_L) {
+      target = target < 0 ? capacity() : min(target, capacity());
+    }
+  } else if (perUs < 0) {
+    for (int i = 0; i < NUM_SENSORS; i++) {
+      double down = floatHeight(i) - sc.hysteresisL / 2;
+      if (floatUp[i] && down < volume) {
+        target = max(target, down);
+      }
+    }
+    if (volume > EPSILON_L) {
+      target = max(target, 0.0);
+    }
+  }
+
+  if (target < 0) {
+    return NEVER;
+  }
+  return now + (uint64_t)ceil((target - volume) / perUs);
+}
+
+// Avanzar el agua hasta t (sin cruces en el medio)
+static void advance(uint64_t t) {
+  uint64_t dt = t - now;
+  if (dt > 0) {
+    DayStats *day = today();
+    double in = inflowLph * dt / HOUR_US;
+    double out = relayOn ? sc.pumpLph * dt / HOUR_US : 0;
+    day->inflowL += in;
+
+    if (relayOn) {
+      day->pumpUs += dt;
+      if (simTank.pump.state == PUMP_EMERGENCY) {
+        emergencyUs += dt;
+      }
+      if (volume <= EPSILON_L) {
+        day->dryUs += dt;
+      }
+    }
+
+    double next = volume + in - out;
+    if (next < 0) {
+      out += next; // Solo sale lo que entra
+      next = 0;
+    }
+    pumpedL += out;
+    if (next > capacity()) {
+      spilledL += next - capacity();
+      next = capacity();
+    }
+    volume = next;
+    maxVolume = max(maxVolume, volume);
+  }
+  setNow(t);
+
+  bool full = volume >= capacity() - EPSILON_L && netLph() > 0;
+  if (full && !spilling) {
+    today()->overflows++;
+  }
+  spilling = full;
+}
+
+static void schedulePin(uint64_t atUs, int sensor, uint8_t level) {
+  pinEvents.push({atUs, sensor, level, floatGen[sensor], pinOrder++});
+}
+
+// Cambio físico de una boya: el contacto rebota unas veces dentro de la
+// ventana y termina en la posición nueva
+static void moveFloat(int i, bool up) {
+  floatUp[i] = up;
+  floatGen[i]++;
+  schedulePin(now, i, up);
+
+  int toggles = 2 * (int)(nextRandom() % (sc.bounces + 1));
+  std::vector<uint64_t> offsets;
+  for (int k = 0; k < toggles; k++) {
+    offsets.push_back(1 + nextRandom() % (sc.bounceMs * MS_US));
+  }
+  std::sort(offsets.begin(), offsets.end());
+  for (int k = 0; k < toggles; k++) {
+    schedulePin(now + offsets[k], i, k % 2 == 0 ? !up : up);
+  }
+
+  physLevel += up ? 1 : -1;
+  physLevelAt[physLevel] = now;
+  if (up && i == NUM_SENSORS - 1) {
+    topUpAt = now;
+    today()->fills++;
+  } else if (!up && i == 0) {
+    bottomDownAt = now;
+  }
+}
+
+static void updateFloats() {
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    if (!floatUp[i] &&
+        volume >= floatHeight(i) + sc.hysteresisL / 2 - EPSILON_L) {
+      moveFloat(i, true);
+    } else if (floatUp[i] &&
+               volume <= floatHeight(i) - sc.hysteresisL / 2 + EPSILON_L) {
+      moveFloat(i, false);
+    }
+  }
+}
+
+static void applyPin(const PinEvent &event) {
+  if (event.gen != floatGen[event.sensor] || faults[event.sensor].active) {
+    return;
+  }
+  shim_gpio_set(tank::kPins[event.sensor], event.level);
+  busyUntil = max(busyUntil, now + BUSY_US);
+}
+
+// Pulso espurio: una boya cambia un instante y vuelve
+static void spike() {
+  int i = nextRandom() % NUM_SENSORS;
+  uint64_t width = 1 + nextRandom() % (sc.bounceMs * MS_US);
+  schedulePin(now, i, !floatUp[i]);
+  schedulePin(now + width, i, floatUp[i]);
+  spikeNext = now + (uint64_t)(-log(1 - uniform()) / sc.spikesPerHour *
+                               HOUR_US);
+}
+
+static uint64_t nextFault() {
+  uint64_t next = NEVER;
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    if (faults[i].configured && !faults[i].active) {
+      next = min(next, faults[i].atUs);
+    }
+  }
+  return next;
+}
+
+static void applyFaults() {
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    FloatFault *fault = &faults[i];
+    if (fault->configured && !fault->active && fault->atUs <= now) {
+      fault->active = true;
+      shim_gpio_set(tank::kPins[i], fault->level);
+      busyUntil = max(busyUntil, now + BUSY_US);
+    }
+  }
+}
+
+// ============================================
+// CONTROL
+// ============================================
+
+// Lo que la tarea de control hace en un ciclo (ver controlStep() y
+// updateTanks() en main.cpp), más el trabajo "validate" en su período
+static void controlTick() {
+  SystemState lastState = simTank.systemState;
+  PumpState lastPump = simTank.pump.state;
+  int lastLevel = simTank.sensors.currentLevel;
+  bool lastError = simTank.sensors.sequenceError;
+
+  if (now % VALIDATE_US == 0) {
+    sensors_validate_sequence(&simTank.sensors);
+  }
+  if (sensors_read(&simTank.sensors)) {
+    sensors_validate_sequence(&simTank.sensors);
+  }
+  tank_update(&simTank);
+  alarm_update(&alarmState);
+  cyclelog_poll();
+  ticks++;
+
+  relayOn = shim_gpio_output(PUMP_RELAY_PIN) == HIGH;
+
+  int level = simTank.sensors.currentLevel;
+  if (level != lastLevel && level == physLevel) {
+    levelLatency.add(now - physLevelAt[level]);
+  }
+
+  PumpState pump = simTank.pump.state;
+  if (pump != lastPump) {
+    if (pump == PUMP_ON && floatUp[NUM_SENSORS - 1]) {
+      fullLatency.add(now - topUpAt);
+    } else if (pump == PUMP_EMERGENCY) {
+      today()->emergencies++;
+    } else if (pump == PUMP_OFF && lastPump == PUMP_ON) {
+      today()->cycles++;
+      if (!floatUp[0]) {
+        emptyLatency.add(now - bottomDownAt);
+      }
+    }
+  }
+
+  if (simTank.systemState != lastState) {
+    if (simTank.systemState == STATE_ERROR) {
+      errorsEntered++;
+    } else if (lastState == STATE_ERROR) {
+      emergenciesEnded++;
+    }
+  }
+
+  if (simTank.systemState != lastState || pump != lastPump ||
+      level != lastLevel || simTank.sensors.sequenceError != lastError) {
+    busyUntil = max(busyUntil, now + BUSY_US);
+  }
+}
+
+static uint64_t roundUp(uint64_t t, uint64_t step) {
+  return (t + step - 1) / step * step;
+}
+
+// Próximo tick: el siguiente mientras haya cambios recientes; con el
+// tanque quieto, el latido o el vencimiento de la emergencia. tank_update()
+// decide con el runTime del tick anterior, así que un vencimiento necesita
+// un tick en él y otro después.
+static uint64_t nextTick() {
+  uint64_t next = now + TICK_US;
+  if (sc.exact || next <= busyUntil) {
+    return next;
+  }
+
+  uint64_t until = roundUp(now + 1, HEARTBEAT_US);
+  const PumpStatus *pump = &simTank.pump;
+  if (simTank.systemState == STATE_ERROR && pump->isRunning) {
+    uint64_t deadlines[2] = {NEVER, NEVER};
+    if (pump->state == PUMP_EMERGENCY) {
+      deadlines[0] = (pump->startTime + pump->emergencyDuration) * MS_US;
+    }
+    if (sensors_is_tank_empty(&simTank.sensors)) {
+      deadlines[1] = (pump->startTime + 5001) * MS_US; // runTime > 5000
+    }
+    for (uint64_t deadline : deadlines) {
+      if (deadline != NEVER) {
+        until = min(until, max(roundUp(deadline, TICK_US), next));
+      }
+    }
+  }
+  return until;
+}
+
+// ============================================
+// PRINCIPAL
+// ============================================
+
+static bool parseArgs(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    int sensor = 0;
+    int level = 0;
+    double hours = 0;
+
+    if (!strcmp(arg, "--exact")) {
+      sc.exact = true;
+      continue;
+    }
+    if (!strcmp(arg, "--verbose")) {
+      sc.verbose = true;
+      continue;
+    }
+    if (!value) {
+      return false;
+    }
+    i++;
+
+    if (!strcmp(arg, "--days")) {
+      sc.days = atoi(value);
+    } else if (!strcmp(arg, "--seed")) {
+      seed = strtoul(value, nullptr, 10);
+    } else if (!strcmp(arg, "--inflow")) {
+      sc.inflowLph = atof(value);
+    } else if (!strcmp(arg, "--ac")) {
+      if (sscanf(value, "%d-%d", &sc.acStartH, &sc.acEndH) != 2) {
+        return false;
+      }
+    } else if (!strcmp(arg, "--compressor")) {
+      if (sscanf(value, "%d/%d", &sc.compressorOnMin,
+                 &sc.compressorOffMin) != 2) {
+        return false;
+      }
+    } else if (!strcmp(arg, "--pump")) {
+      sc.pumpLph = atof(value);
+    } else if (!strcmp(arg, "--level")) {
+      sc.levelL = atof(value);
+    } else if (!strcmp(arg, "--margin")) {
+      sc.marginL = atof(value);
+    } else if (!strcmp(arg, "--hysteresis")) {
+      sc.hysteresisL = atof(value);
+    } else if (!strcmp(arg, "--bounce")) {
+      sc.bounceMs = atoi(value);
+    } else if (!strcmp(arg, "--bounces")) {
+      sc.bounces = atoi(value);
+    } else if (!strcmp(arg, "--spikes")) {
+      sc.spikesPerHour = atof(value);
+    } else if (!strcmp(arg, "--stuck") || !strcmp(arg, "--failed")) {
+      // Boyas numeradas desde 1, como en el display; --failed = abierta
+      int n = !strcmp(arg, "--stuck")
+                  ? sscanf(value, "%d=%d@%lf", &sensor, &level, &hours)
+                  : sscanf(value, "%d@%lf", &sensor, &hours) + 1;
+      if (n < 2 || sensor < 1 || sensor > NUM_SENSORS) {
+        return false;
+      }
+      FloatFault *fault = &faults[sensor - 1];
+      fault->configured = true;
+      fault->level = level ? HIGH : LOW;
+      fault->atUs = (uint64_t)(hours * HOUR_US);
+    } else {
+      return false;
+    }
+  }
+
+  return sc.days > 0 && sc.acStartH >= 0 && sc.acStartH <= sc.acEndH &&
+         sc.acEndH <= 24 && sc.compressorOnMin > 0 &&
+         sc.compressorOffMin >= 0 && sc.pumpLph > sc.inflowLph * 1.3 &&
+         sc.levelL > sc.hysteresisL && sc.bounceMs > 0 && sc.bounces >= 0;
+}
+
+static void printLatency(Latency *latency) {
+  printf("%-16s %7zu %8.1f %8.1f %8.1f\n", latency->name,
+         latency->samples.size(), latency->percentile(0.5),
+         latency->percentile(0.99), latency->percentile(1.0));
+}
+
+int main(int argc, char **argv) {
+  if (!parseArgs(argc, argv)) {
+    printf("usage: %s [--days N] [--seed N] [--exact] [--verbose]\n"
+           "       [--inflow L/H] [--ac H-H] [--compressor MIN/MIN]\n"
+           "       [--pump L/H] [--level L] [--margin L] [--hysteresis L]\n"
+           "       [--bounce MS] [--bounces N] [--spikes N/H]\n"
+           "       [--stuck FLOAT=0|1[@H]] [--failed FLOAT[@H]]\n"
+           "(the pump must exceed the peak inflow)\n",
+           argv[0]);
+    return 2;
+  }
+  Serial.enabled = sc.verbose;
+
+  // Arranque como setup(): boyas secas, bomba y alarma apagadas
+  clock_fake_start(0);
+  alarm_init();
+  tank_init(&simTank, 0, &alarmState);
+  sensors_init();
+  pump_init();
+  cyclelog_mount(&flash);
+
+  uint64_t endUs = sc.days * DAY_US;
+  days.assign(sc.days, DayStats());
+  inflowStep();
+  if (sc.spikesPerHour > 0) {
+    spikeNext = (uint64_t)(-log(1 - uniform()) / sc.spikesPerHour * HOUR_US);
+  }
+
+  auto started = std::chrono::steady_clock::now();
+  uint64_t tickAt = 0;
+
+  // Eventos en orden; en un mismo instante: agua, pines (ISR) y control
+  while (true) {
+    uint64_t t = min(min(tickAt, inflowNext), min(nextCrossing(), endUs));
+    t = min(t, min(spikeNext, nextFault()));
+    if (!pinEvents.empty()) {
+      t = min(t, pinEvents.top().atUs);
+    }
+    if (t >= endUs) {
+      advance(endUs);
+      break;
+    }
+
+    advance(t);
+    if (t == inflowNext) {
+      inflowStep();
+    }
+    updateFloats();
+    if (t == spikeNext) {
+      spike();
+    }
+    applyFaults();
+    while (!pinEvents.empty() && pinEvents.top().atUs <= now) {
+      applyPin(pinEvents.top());
+      pinEvents.pop();
+    }
+    if (busyUntil > now) {
+      tickAt = min(tickAt, roundUp(now, TICK_US)); // Volver a cada tick
+    }
+    if (t == tickAt) {
+      controlTick();
+      tickAt = nextTick();
+    }
+  }
+
+  double wallS = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - started)
+                     .count();
+
+  // ============================================
+  // INFORME
+  // ============================================
+
+  DayStats total = {};
+  if (sc.verbose || sc.days <= 31) {
+    printf("day  fills cycles emerg  pump_s   dry_s  inflow_l overflow\n");
+  }
+  for (size_t d = 0; d < days.size(); d++) {
+    const DayStats &day = days[d];
+    if (sc.verbose || sc.days <= 31) {
+      printf("%3zu %6d %6d %5d %7.0f %7.1f %9.2f %8d\n", d + 1, day.fills,
+             day.cycles, day.emergencies, day.pumpUs / 1e6, day.dryUs / 1e6,
+             day.inflowL, day.overflows);
+    }
+    total.fills += day.fills;
+    total.cycles += day.cycles;
+    total.emergencies += day.emergencies;
+    total.overflows += day.overflows;
+    total.pumpUs += day.pumpUs;
+    total.dryUs += day.dryUs;
+    total.inflowL += day.inflowL;
+  }
+
+  printf("\n%d cycles (%d fills), %d emergency runs (%.0f s), "
+         "%d errors\n",
+         total.cycles, total.fills, total.emergencies, emergencyUs / 1e6,
+         errorsEntered);
+  printf("pump on %.2f h (%.1f s dry), inflow %.1f L, pumped %.1f L, "
+         "%d overflows (%.2f L spilled, peak %.2f of %.2f L)\n",
+         total.pumpUs / 3.6e9, total.dryUs / 1e6, total.inflowL, pumpedL,
+         total.overflows, spilledL, maxVolume, capacity());
+
+  printf("\nlatency (ms)           n      p50      p99      max\n");
+  printLatency(&levelLatency);
+  printLatency(&fullLatency);
+  printLatency(&emptyLatency);
+
+  SensorLatencyStats edges;
+  sensors_get_latency(&edges);
+  uint32_t bounces = 0;
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    bounces += sensors_get_bounces(i);
+  }
+  printf("\n%lu edges captured (%lu dropped), %lu bounces filtered\n",
+         (unsigned long)edges.edgesCaptured,
+         (unsigned long)edges.edgesDropped, (unsigned long)bounces);
+
+  // Cada ciclo y cada fin de emergencia deja un registro en el historial
+  cyclelog_poll();
+  CycleLogStats history;
+  cyclelog_get_stats(&history);
+  int expected = total.cycles + emergenciesEnded;
+  printf("history %lu records, %lu B (%lu dropped)\n",
+         (unsigned long)history.appended, (unsigned long)history.bytes,
+         (unsigned long)history.dropped);
+  if ((int)history.appended != expected) {
+    printf("   history has %lu records, expected %d\n",
+           (unsigned long)history.appended, expected);
+    failures++;
+  }
+
+  uint64_t allTicks = endUs / TICK_US;
+  printf("%llu of %llu control ticks (%.2f%%), %d days in %.2f s "
+         "(%.0fx real time)\n",
+         (unsigned long long)ticks, (unsigned long long)allTicks,
+         100.0 * ticks / allTicks, sc.days, wallS,
+         endUs / 1e6 / max(wallS, 1e-6));
+  printf("%d failures\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * Banco de pruebas del serializador de telemetría
+ * ===============================================
+ * Codifica estados típicos de MqttData en JSON y CBOR con telemetry.cpp y
+ * el snprintf de antes (referencia), e informa bytes en el cable y tiempo
+ * de codificación en el host. Verifica además que telemetry_size() coincida
+ * con lo escrito y que el JSON completo sea idéntico al de snprintf.
+ *
+ * Uso: telemetry_bench [--iterations N] [--verbose]
+ *   --iterations N  repeticiones por medición (por defecto 200000)
+ *   --verbose       mostrar cada mensaje (JSON como texto, CBOR en hex)
+ *
+ * Los tiempos son del host: sirven para comparar formatos entre sí, no
+ * como tiempos absolutos del ESP32.
+ */
+
+#include "sim_check.h"
+#include "telemetry.h"
+#include <chrono>
+
+// Print que guarda el mensaje (como el socket del cliente MQTT)
+class BufferPrint : public Print {
+public:
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override {
+    size_t n = min(size, sizeof(data) - length);
+    memcpy(data + length, buffer, n);
+    length += n;
+    writes++;
+    return n;
+  }
+  void clear() {
+    length = 0;
+    writes = 0;
+  }
+
+  uint8_t data[512];
+  size_t length = 0;
+  uint32_t writes = 0;
+};
+
+struct Case {
+  const char *name;
+  MqttData data;
+  const MqttData *prev; // nullptr: mensaje completo
+};
+
+static const MqttData idle = {0, 7, "off", false, 0, false, "idle", 12, 180,
+                              2160};
+static const MqttData emptying = {5, 7, "on", true, 45, false, "emptying", 12,
+                                  180, 2160};
+static const MqttData filled = {1, 7, "off", false, 0, false, "idle", 12, 180,
+                                2160};
+static const MqttData cycleDone = {0, 7, "off", false, 0, false, "idle", 13,
+                                   210, 2370};
+
+static const Case cases[] = {
+    {"full-idle", idle, nullptr},
+    {"full-pumping", emptying, nullptr},
+    {"delta-level", filled, &idle},
+    {"delta-pump", emptying, &idle},
+    {"delta-cycle", cycleDone, &idle},
+};
+
+static long iterations = 200000;
+static bool verbose = false;
+
+// El formato de antes, para comparar
+static int formatSnprintf(char *payload, size_t size, const MqttData *data) {
+  return snprintf(payload, size,
+                  "{"
+                  "\"level\":%d,"
+                  "\"max_level\":%d,"
+                  "\"pump\":{"
+                  "\"state\":\"%s\","
+                  "\"running\":%s,"
+                  "\"runtime_s\":%lu"
+                  "},"
+                  "\"error\":%s,"
+                  "\"sequence\":\"%s\","
+                  "\"stats\":{"
+                  "\"cycles_today\":%d,"
+                  "\"last_cycle_s\":%lu,"
+                  "\"total_runtime_s\":%lu"
+                  "}"
+                  "}",
+                  data->level, data->maxLevel, data->pumpState,
+                  data->pumpRunning ? "true" : "false", data->pumpRuntime,
+                  data->hasError ? "true" : "false", data->sequenceState,
+                  data->cyclesCompleted, data->lastCycleDuration,
+                  data->totalRuntime);
+}
+
+template <class F> static double nsPerCall(F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < iterations; i++) {
+    f();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         iterations;
+}
+
+static void show(const char *label, const BufferPrint &out, bool text) {
+  printf("   %s: ", label);
+  for (size_t i = 0; i < out.length; i++) {
+    if (text) {
+      putchar(out.data[i]);
+    } else {
+      printf("%02x", out.data[i]);
+    }
+  }
+  putchar('\n');
+}
+
+static void runCase(const Case *c) {
+  uint32_t fields = c->prev ? telemetry_delta_fields(&c->data, c->prev)
+                            : TELEMETRY_ALL_FIELDS;
+  BufferPrint out;
+  size_t sizes[2];
+  double times[2];
+  uint32_t writes[2];
+
+  for (int f = 0; f < 2; f++) {
+    TelemetryFormat format = f == 0 ? TELEMETRY_JSON : TELEMETRY_CBOR;
+    out.clear();
+    sizes[f] = telemetry_size(format, &c->data, fields);
+    size_t written = telemetry_write(&out, format, &c->data, fields);
+    writes[f] = out.writes;
+    if (written != sizes[f]) {
+      printf("   %s %s: size %zu, written %zu\n", c->name,
+             telemetry_format_name(format), sizes[f], written);
+      failures++;
+    }
+    if (verbose) {
+      show(telemetry_format_name(format), out, format == TELEMETRY_JSON);
+    }
+
+    // Como en mqtt.cpp: largo primero y después la escritura
+    times[f] = nsPerCall([&] {
+      out.clear();
+      size_t len = telemetry_size(format, &c->data, fields);
+      telemetry_write(&out, format, &c->data, fields);
+      asm volatile("" : : "r"(len) : "memory");
+    });
+  }
+
+  const char *oldSize = "-";
+  const char *oldTime = "-";
+  char sizeText[16], timeText[16];
+  if (!c->prev) {
+    char payload[512];
+    int len = formatSnprintf(payload, sizeof(payload), &c->data);
+    out.clear();
+    telemetry_write(&out, TELEMETRY_JSON, &c->data, fields);
+    if ((size_t)len != out.length || memcmp(payload, out.data, len) != 0) {
+      printf("   %s: JSON differs from snprintf\n", c->name);
+      failures++;
+    }
+    double ns = nsPerCall([&] {
+      int n = formatSnprintf(payload, sizeof(payload), &c->data);
+      asm volatile("" : : "r"(n) : "memory");
+    });
+    snprintf(sizeText, sizeof(sizeText), "%d", len);
+    snprintf(timeText, sizeof(timeText), "%.0f", ns);
+    oldSize = sizeText;
+    oldTime = timeText;
+  }
+
+  printf("%-13s %6zu %6zu %5.0f%% %6s | %7.0f %7.0f %7s | %3lu %3lu\n",
+         c->name, sizes[0], sizes[1], 100.0 * sizes[1] / sizes[0], oldSize,
+         times[0], times[1], oldTime, (unsigned long)writes[0],
+         (unsigned long)writes[1]);
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+      iterations = atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--verbose")) {
+      verbose = true;
+    } else {
+      printf("usage: %s [--iterations N] [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (iterations <= 0) {
+    iterations = 1;
+  }
+
+  printf("%-13s %6s %6s %6s %6s | %7s %7s %7s | %7s\n", "case", "json B",
+         "cbor B", "cbor", "old B", "json ns", "cbor ns", "old ns", "writes");
+  for (const Case &c : cases) {
+    runCase(&c);
+  }
+
+  printf("%d failures\n", failures);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+#ifndef TFT_EMU_TFT_ESPI_H
+#define TFT_EMU_TFT_ESPI_H
+
+// ============================================
+// TFT_eSPI EN MEMORIA (EMULADOR DE HOST)
+// ============================================
+// La parte de la API de TFT_eSPI que usa display.cpp, dibujando en un
+// framebuffer RGB565 de 240x320 en RAM. Cada primitiva se descompone en
+// ventanas (CASET/RASET/RAMWR) y píxeles, igual que en el ILI9341, y se
+// cuentan en tft_emu.h. Los sprites guardan los colores con los bytes
+// invertidos, como TFT_eSPI, así las copias directas de display.cpp
+// (atlas, DMA) ven el mismo formato que en el ESP32.
+
+#include <Arduino.h>
+#include <vector>
+
+#ifndef TFT_WIDTH
+#define TFT_WIDTH 240
+#endif
+#ifndef TFT_HEIGHT
+#define TFT_HEIGHT 320
+#endif
+
+// Referencias de texto (setTextDatum)
+#define TL_DATUM 0
+#define TC_DATUM 1
+#define TR_DATUM 2
+#define ML_DATUM 3
+#define MC_DATUM 4
+#define MR_DATUM 5
+#define BL_DATUM 6
+#define BC_DATUM 7
+#define BR_DATUM 8
+
+#define TFT_BLACK 0x0000
+#define TFT_WHITE 0xFFFF
+
+class TFT_eSPI : public Print {
+  friend class TFT_eSprite;
+
+public:
+  TFT_eSPI(int16_t w = TFT_WIDTH, int16_t h = TFT_HEIGHT);
+
+  void init();
+  void setRotation(uint8_t rotation);
+  int16_t width() const { return _width; }
+  int16_t height() const { return _height; }
+
+  // Primitivas
+  void fillScreen(uint32_t color);
+  void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+  void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
+  void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r,
+                     uint32_t color);
+  void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r,
+                     uint32_t color);
+  void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+  void drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color);
+  void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                    int32_t x2, int32_t y2, uint32_t color);
+  void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t color);
+  void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t color);
+  void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                uint32_t color);
+  void drawPixel(int32_t x, int32_t y, uint32_t color);
+
+  // Texto: los glifos se dibujan como bloques con las medidas aproximadas
+  // de cada fuente (alcanza para ubicar y contar, no para leer)
+  void setTextFont(uint8_t font) { _font = font; }
+  void setTextColor(uint16_t fg) { _fg = _bg = fg; }
+  void setTextColor(uint16_t fg, uint16_t bg) {
+    _fg = fg;
+    _bg = bg;
+  }
+  void setTextDatum(uint8_t datum) { _datum = datum; }
+  void setCursor(int16_t x, int16_t y) {
+    _cursorX = x;
+    _cursorY = y;
+  }
+  int16_t textWidth(const char *text) { return textWidth(text, _font); }
+  int16_t textWidth(const char *text, uint8_t font);
+  int16_t fontHeight() { return fontHeight(_font); }
+  int16_t fontHeight(int16_t font);
+  int16_t drawString(const char *text, int32_t x, int32_t y) {
+    return drawString(text, x, y, _font);
+  }
+  int16_t drawString(const char *text, int32_t x, int32_t y, uint8_t font);
+  size_t write(uint8_t c) override;
+
+  // Viewport: origen y recorte
+  void setViewport(int32_t x, int32_t y, int32_t w, int32_t h,
+                   bool vpDatum = true);
+  void resetViewport();
+
+  // Bus y DMA (el DMA termina en el acto)
+  void startWrite() {}
+  void endWrite() {}
+  bool initDMA(bool ctrlCs = false);
+  bool dmaBusy() { return false; }
+  void dmaWait() {}
+  void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h,
+                    uint16_t *data, uint16_t *buffer = nullptr);
+  void writecommand(uint8_t command);
+  void writedata(uint8_t data);
+
+protected:
+  // Rectángulo ya recortado, en coordenadas absolutas
+  virtual void writeRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                         uint16_t color);
+  virtual void writeBlock(int32_t x, int32_t y, int32_t w, int32_t h,
+                          const uint16_t *src, int32_t stride, bool swapped);
+  virtual void countCall();
+
+  void span(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+  void hline(int32_t x, int32_t y, int32_t w, uint16_t color) {
+    span(x, y, w, 1, color);
+  }
+  void pixel(int32_t x, int32_t y, uint16_t color) {
+    span(x, y, 1, 1, color);
+  }
+  void block(int32_t x, int32_t y, int32_t w, int32_t h,
+             const uint16_t *src, int32_t stride, bool swapped);
+  void arcs(int32_t cx, int32_t cy, int32_t r, uint8_t corners,
+            uint16_t color);
+  void drawGlyph(char c);
+
+  int16_t _width, _height;
+  int32_t _vpX, _vpY, _vpW, _vpH; // Viewport en coordenadas absolutas
+  bool _vpDatum;
+  uint8_t _font;
+  uint16_t _fg, _bg;
+  uint8_t _datum;
+  int32_t _cursorX, _cursorY;
+
+  // Comando en curso y sus datos (scroll vertical)
+  uint8_t _command;
+  uint8_t _data[8];
+  int _dataCount;
+};
+
+class TFT_eSprite : public TFT_eSPI {
+public:
+  explicit TFT_eSprite(TFT_eSPI *tft);
+
+  void *createSprite(int16_t w, int16_t h, uint8_t frames = 1);
+  void deleteSprite();
+  bool created() const { return !_pixels.empty(); }
+  void fillSprite(uint32_t color);
+  uint16_t *getPointer() { return _pixels.empty() ? nullptr : &_pixels[0]; }
+  uint16_t readPixel(int32_t x, int32_t y);
+
+  void pushSprite(int32_t x, int32_t y);
+  bool pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy, int32_t sw,
+                  int32_t sh);
+
+protected:
+  void writeRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                 uint16_t color) override;
+  void writeBlock(int32_t x, int32_t y, int32_t w, int32_t h,
+                  const uint16_t *src, int32_t stride, bool swapped) override;
+  void countCall() override;
+
+private:
+  TFT_eSPI *_tft;
+  std::vector<uint16_t> _pixels; // Bytes invertidos, como TFT_eSPI
+};
+
+#endif // TFT_EMU_TFT_ESPI_H
@@ -0,0 +1,210 @@
+/*
+ * Emulador de display en el host
+ * ===============================
+ * Corre display.cpp contra un TFT_eSPI en memoria (240x320 RGB565) a
+ * través de un guion fijo: arranque, subida de nivel, bomba, animación,
+ * error y pantalla de tendencia. Por cada paso informa llamadas de dibujo,
+ * ventanas, píxeles y bytes SPI estimados, y falla si un paso supera su
+ * presupuesto de píxeles (p. ej. un cambio que vuelve a redibujar todo).
+ *
+ * Uso: tft_emu [--dump DIR] [--golden DIR] [--no-sprites] [--quiet]
+ *   --dump DIR    guarda DIR/NN-paso.ppm de cada paso
+ *   --golden DIR  compara cada paso con DIR/NN-paso.ppm
+ *   --no-sprites  simula falta de RAM (dibujo directo, sin presupuestos)
+ *   --quiet       sin los mensajes de Serial de display.cpp
+ */
+
+#include "clock.h"
+#include "display.h"
+#include "history.h"
+#include "sim_check.h"
+#include "tft_emu.h"
+
+#define SCREEN_PIXELS (TFT_WIDTH * TFT_HEIGHT)
+#define NO_BUDGET 0xFFFFFFFFUL
+
+static const char *dumpDir = nullptr;
+static const char *goldenDir = nullptr;
+static bool checkBudgets = true; // Los presupuestos son del camino con sprites
+static int stepCount = 0;
+
+#if MULTI_TANK_ENABLED
+static DisplayData tiles[NUM_TANKS];
+static DisplayData &data = tiles[0];
+#else
+static DisplayData data;
+#endif
+
+// Terminar el envío por DMA, si quedó en curso
+static void settle() {
+  while (display_poll()) {
+  }
+}
+
+// Cerrar un paso: fila de la tabla, presupuesto y capturas
+static void endStep(const char *name, uint32_t maxPixels) {
+  settle();
+  stepCount++;
+
+  const TftEmuCounters *c = tft_emu_counters();
+  DisplayStats stats;
+  display_get_stats(&stats);
+
+  bool overBudget =
+      checkBudgets && maxPixels != NO_BUDGET && c->pixels > maxPixels;
+  printf("%2d %-14s %6lu %6lu %7lu %8lu %5lu %7lu %8lu%s\n", stepCount, name,
+         (unsigned long)c->drawCalls, (unsigned long)c->windows,
+         (unsigned long)c->pixels, (unsigned long)c->spiBytes,
+         (unsigned long)c->dmaTransfers, (unsigned long)c->spriteCalls,
+         (unsigned long)stats.lastBytes,
+         overBudget ? "  <-- OVER BUDGET" : "");
+  if (overBudget) {
+    printf("   %s: %lu px, budget %lu px (%lu%% of the screen)\n", name,
+           (unsigned long)c->pixels, (unsigned long)maxPixels,
+           (unsigned long)(c->pixels * 100UL / SCREEN_PIXELS));
+    failures++;
+  }
+
+  char path[512];
+  if (dumpDir) {
+    snprintf(path, sizeof(path), "%s/%02d-%s.ppm", dumpDir, stepCount, name);
+    if (!tft_emu_write_ppm(path)) {
+      printf("   cannot write %s\n", path);
+      failures++;
+    }
+  }
+  if (goldenDir) {
+    snprintf(path, sizeof(path), "%s/%02d-%s.ppm", goldenDir, stepCount,
+             name);
+    long different = tft_emu_compare_ppm(path);
+    if (different != 0) {
+      if (different < 0) {
+        printf("   cannot read golden %s\n", path);
+      } else {
+        printf("   %ld px differ from %s\n", different, path);
+      }
+      failures++;
+    }
+  }
+
+  tft_emu_reset_counters();
+  display_reset_stats();
+}
+
+static void update(const char *name, uint32_t maxPixels) {
+#if MULTI_TANK_ENABLED
+  display_update_tiles(tiles, NUM_TANKS);
+#else
+  display_update(&data);
+#endif
+  endStep(name, maxPixels);
+}
+
+#if !MULTI_TANK_ENABLED
+static void animate(const char *name, uint32_t maxPixels) {
+  clock_fake_advance(1000000 / DISPLAY_ANIM_FPS);
+  display_animate();
+  endStep(name, maxPixels);
+}
+#endif
+
+static void runScript() {
+  char name[32];
+
+  update("boot", NO_BUDGET);
+  update("idle", 0);
+
+  // Llenado: solo la franja nueva y el número
+  data.sequenceState = SEQ_FILLING;
+  for (int level = 1; level <= NUM_SENSORS; level++) {
+    data.level = level;
+    snprintf(name, sizeof(name), "level-%d", level);
+    update(name, 12000);
+  }
+
+  // Bomba: cambio de estado completo, después solo el cronómetro
+  data.pumpState = PUMP_ON;
+  data.sequenceState = SEQ_EMPTYING;
+  data.pumpRunTime = 0;
+  update("pump-on", 30000);
+  for (int i = 1; i <= 3; i++) {
+    clock_fake_advance(1000000);
+    data.pumpRunTime += 1000;
+    snprintf(name, sizeof(name), "pump-tick-%d", i);
+    update(name, 1500);
+  }
+
+#if !MULTI_TANK_ENABLED
+  data.level = NUM_SENSORS / 2;
+  update("draining", 12000);
+  for (int i = 1; i <= 3; i++) {
+    snprintf(name, sizeof(name), "anim-%d", i);
+    animate(name, 3000);
+  }
+#endif
+
+  // Fin de ciclo
+  data.level = 0;
+  data.pumpState = PUMP_OFF;
+  data.sequenceState = SEQ_IDLE;
+  data.cyclesCompleted = 1;
+  data.lastCycleDuration = 95000;
+  update("pump-off", 40000);
+
+  data.hasError = true;
+  data.sequenceState = SEQ_ERROR;
+  update("error", 20000);
+  data.hasError = false;
+  data.sequenceState = SEQ_IDLE;
+  update("error-clear", 20000);
+
+  data.wifiConnected = true;
+  update("wifi", 15000);
+
+#if !MULTI_TANK_ENABLED
+  // Tendencia: repintado al entrar, después una fila por muestra
+  for (int i = 0; i < 3 * HISTORY_SAMPLES / 4; i++) {
+    int phase = i % 120;
+    int level = phase < 100 ? phase * NUM_SENSORS / 100 : 0;
+    history_add(level, phase >= 100 ? PUMP_ON : PUMP_OFF);
+  }
+  display_toggle_page();
+  update("trend", NO_BUDGET);
+  history_add(2, PUMP_OFF);
+  update("trend-row", 2 * TFT_WIDTH);
+  display_toggle_page();
+  update("main-again", NO_BUDGET);
+#endif
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--dump") && i + 1 < argc) {
+      dumpDir = argv[++i];
+    } else if (!strcmp(argv[i], "--golden") && i + 1 < argc) {
+      goldenDir = argv[++i];
+    } else if (!strcmp(argv[i], "--no-sprites")) {
+      tft_emu_fail_sprites(true);
+      checkBudgets = false;
+    } else if (!strcmp(argv[i], "--quiet")) {
+      Serial.enabled = false;
+    } else {
+      printf("usage: %s [--dump DIR] [--golden DIR] [--no-sprites] "
+             "[--quiet]\n",
+             argv[0]);
+      return 2;
+    }
+  }
+
+  clock_fake_start(1000000);
+  display_init();
+  history_init();
+  tft_emu_reset_counters();
+
+  printf(" # %-14s %6s %6s %7s %8s %5s %7s %8s\n", "step", "calls", "wins",
+         "pixels", "spi B", "dma", "sprite", "self B");
+  runScript();
+
+  printf("%d steps, %d failures\n", stepCount, failures);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,609 @@
+#include "tft_emu.h"
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+
+// Comandos de scroll vertical del ILI9341
+#define CMD_VSCRDEF 0x33
+#define CMD_VSCRSADD 0x37
+
+// Memoria del ILI9341 (filas en orden de memoria, sin scroll)
+static uint16_t screen[TFT_WIDTH * TFT_HEIGHT];
+static TftEmuCounters counters;
+static bool failSprites = false;
+
+// Scroll vertical: zona fija arriba, zona que rota y zona fija abajo
+static int scrollTop = 0;
+static int scrollRows = TFT_HEIGHT;
+static int scrollStart = 0;
+
+static uint16_t swap16(uint16_t color) { return (color >> 8) | (color << 8); }
+
+static int32_t isqrt(int32_t value) {
+  int32_t root = 0;
+  while ((root + 1) * (root + 1) <= value) {
+    root++;
+  }
+  return root;
+}
+
+// ============================================
+// PANTALLA
+// ============================================
+
+TFT_eSPI::TFT_eSPI(int16_t w, int16_t h)
+    : _width(w), _height(h), _vpX(0), _vpY(0), _vpW(w), _vpH(h),
+      _vpDatum(false), _font(1), _fg(TFT_WHITE), _bg(TFT_WHITE),
+      _datum(TL_DATUM), _cursorX(0), _cursorY(0), _command(0), _dataCount(0) {
+}
+
+void TFT_eSPI::init() {
+  memset(screen, 0, sizeof(screen));
+  scrollTop = 0;
+  scrollRows = TFT_HEIGHT;
+  scrollStart = 0;
+}
+
+void TFT_eSPI::setRotation(uint8_t rotation) {
+  if (rotation != 0) {
+    Serial.println("[TFT_EMU] Only rotation 0 (portrait) is emulated");
+  }
+}
+
+void TFT_eSPI::countCall() { counters.drawCalls++; }
+
+void TFT_eSPI::writeRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                         uint16_t color) {
+  for (int32_t row = y; row < y + h; row++) {
+    for (int32_t col = x; col < x + w; col++) {
+      screen[row * TFT_WIDTH + col] = color;
+    }
+  }
+  counters.windows++;
+  counters.pixels += w * h;
+  counters.spiBytes += TFT_EMU_WINDOW_BYTES + w * h * 2;
+}
+
+void TFT_eSPI::writeBlock(int32_t x, int32_t y, int32_t w, int32_t h,
+                          const uint16_t *src, int32_t stride, bool swapped) {
+  for (int32_t row = 0; row < h; row++) {
+    for (int32_t col = 0; col < w; col++) {
+      uint16_t color = src[row * stride + col];
+      screen[(y + row) * TFT_WIDTH + x + col] = swapped ? swap16(color) : color;
+    }
+  }
+  counters.windows++;
+  counters.pixels += w * h;
+  counters.spiBytes += TFT_EMU_WINDOW_BYTES + w * h * 2;
+}
+
+// Trasladar al viewport y recortar
+void TFT_eSPI::span(int32_t x, int32_t y, int32_t w, int32_t h,
+                    uint16_t color) {
+  if (_vpDatum) {
+    x += _vpX;
+    y += _vpY;
+  }
+  int32_t x1 = max(x, _vpX);
+  int32_t y1 = max(y, _vpY);
+  int32_t x2 = min(x + w, _vpX + _vpW);
+  int32_t y2 = min(y + h, _vpY + _vpH);
+  if (x2 > x1 && y2 > y1) {
+    writeRect(x1, y1, x2 - x1, y2 - y1, color);
+  }
+}
+
+void TFT_eSPI::block(int32_t x, int32_t y, int32_t w, int32_t h,
+                     const uint16_t *src, int32_t stride, bool swapped) {
+  if (_vpDatum) {
+    x += _vpX;
+    y += _vpY;
+  }
+  int32_t x1 = max(x, _vpX);
+  int32_t y1 = max(y, _vpY);
+  int32_t x2 = min(x + w, _vpX + _vpW);
+  int32_t y2 = min(y + h, _vpY + _vpH);
+  if (x2 > x1 && y2 > y1) {
+    writeBlock(x1, y1, x2 - x1, y2 - y1, src + (y1 - y) * stride + (x1 - x),
+               stride, swapped);
+  }
+}
+
+void TFT_eSPI::fillScreen(uint32_t color) {
+  countCall();
+  span(_vpDatum ? 0 : _vpX, _vpDatum ? 0 : _vpY, _vpW, _vpH, color);
+}
+
+void TFT_eSPI::fillRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                        uint32_t color) {
+  countCall();
+  span(x, y, w, h, color);
+}
+
+void TFT_eSPI::drawRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                        uint32_t color) {
+  countCall();
+  hline(x, y, w, color);
+  hline(x, y + h - 1, w, color);
+  span(x, y + 1, 1, h - 2, color);
+  span(x + w - 1, y + 1, 1, h - 2, color);
+}
+
+void TFT_eSPI::fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                             int32_t r, uint32_t color) {
+  countCall();
+  r = min(r, min(w / 2, h / 2));
+  span(x, y + r, w, h - 2 * r, color);
+  for (int32_t i = 0; i < r; i++) {
+    int32_t inset = r - isqrt(r * r - (r - i) * (r - i));
+    hline(x + inset, y + i, w - 2 * inset, color);
+    hline(x + inset, y + h - 1 - i, w - 2 * inset, color);
+  }
+}
+
+// Cuartos de circunferencia: 1 arriba-izq, 2 arriba-der, 4 abajo-der,
+// 8 abajo-izq
+void TFT_eSPI::arcs(int32_t cx, int32_t cy, int32_t r, uint8_t corners,
+                    uint16_t color) {
+  int32_t f = 1 - r;
+  int32_t ddx = 1;
+  int32_t ddy = -2 * r;
+  int32_t px = 0;
+  int32_t py = r;
+
+  while (px < py) {
+    if (f >= 0) {
+      py--;
+      ddy += 2;
+      f += ddy;
+    }
+    px++;
+    ddx += 2;
+    f += ddx;
+
+    if (corners & 1) {
+      pixel(cx - py, cy - px, color);
+      pixel(cx - px, cy - py, color);
+    }
+    if (corners & 2) {
+      pixel(cx + px, cy - py, color);
+      pixel(cx + py, cy - px, color);
+    }
+    if (corners & 4) {
+      pixel(cx + px, cy + py, color);
+      pixel(cx + py, cy + px, color);
+    }
+    if (corners & 8) {
+      pixel(cx - py, cy + px, color);
+      pixel(cx - px, cy + py, color);
+    }
+  }
+}
+
+void TFT_eSPI::drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                             int32_t r, uint32_t color) {
+  countCall();
+  r = min(r, min(w / 2, h / 2));
+  hline(x + r, y, w - 2 * r, color);
+  hline(x + r, y + h - 1, w - 2 * r, color);
+  span(x, y + r, 1, h - 2 * r, color);
+  span(x + w - 1, y + r, 1, h - 2 * r, color);
+  arcs(x + r, y + r, r, 1, color);
+  arcs(x + w - r - 1, y + r, r, 2, color);
+  arcs(x + w - r - 1, y + h - r - 1, r, 4, color);
+  arcs(x + r, y + h - r - 1, r, 8, color);
+}
+
+void TFT_eSPI::fillCircle(int32_t x, int32_t y, int32_t r, uint32_t color) {
+  countCall();
+  for (int32_t dy = -r; dy <= r; dy++) {
+    int32_t dx = isqrt(r * r - dy * dy);
+    hline(x - dx, y + dy, 2 * dx + 1, color);
+  }
+}
+
+void TFT_eSPI::drawCircle(int32_t x, int32_t y, int32_t r, uint32_t color) {
+  countCall();
+  pixel(x, y - r, color);
+  pixel(x, y + r, color);
+  pixel(x - r, y, color);
+  pixel(x + r, y, color);
+  arcs(x, y, r, 15, color);
+}
+
+void TFT_eSPI::fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                            int32_t x2, int32_t y2, uint32_t color) {
+  countCall();
+  // Ordenar por y
+  if (y0 > y1) {
+    std::swap(y0, y1);
+    std::swap(x0, x1);
+  }
+  if (y1 > y2) {
+    std::swap(y1, y2);
+    std::swap(x1, x2);
+  }
+  if (y0 > y1) {
+    std::swap(y0, y1);
+    std::swap(x0, x1);
+  }
+
+  for (int32_t y = y0; y <= y2; y++) {
+    // Lado largo (0→2) y el lado corto que corresponda
+    int32_t xa = y2 == y0 ? x0 : x0 + (x2 - x0) * (y - y0) / (y2 - y0);
+    int32_t xb;
+    if (y < y1) {
+      xb = x0 + (x1 - x0) * (y - y0) / (y1 - y0);
+    } else {
+      xb = y2 == y1 ? x1 : x1 + (x2 - x1) * (y - y1) / (y2 - y1);
+    }
+    if (xa > xb) {
+      std::swap(xa, xb);
+    }
+    hline(xa, y, xb - xa + 1, color);
+  }
+}
+
+void TFT_eSPI::drawFastHLine(int32_t x, int32_t y, int32_t w,
+                             uint32_t color) {
+  countCall();
+  hline(x, y, w, color);
+}
+
+void TFT_eSPI::drawFastVLine(int32_t x, int32_t y, int32_t h,
+                             uint32_t color) {
+  countCall();
+  span(x, y, 1, h, color);
+}
+
+void TFT_eSPI::drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                        uint32_t color) {
+  countCall();
+  int32_t dx = abs(x1 - x0);
+  int32_t dy = -abs(y1 - y0);
+  int32_t sx = x0 < x1 ? 1 : -1;
+  int32_t sy = y0 < y1 ? 1 : -1;
+  int32_t err = dx + dy;
+
+  for (;;) {
+    pixel(x0, y0, color);
+    if (x0 == x1 && y0 == y1) {
+      break;
+    }
+    int32_t e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x0 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y0 += sy;
+    }
+  }
+}
+
+void TFT_eSPI::drawPixel(int32_t x, int32_t y, uint32_t color) {
+  countCall();
+  pixel(x, y, color);
+}
+
+// ============================================
+// TEXTO
+// ============================================
+
+// Medidas aproximadas de cada fuente de TFT_eSPI (ancho medio, alto)
+static void glyphSize(uint8_t font, int32_t *w, int32_t *h) {
+  switch (font) {
+  case 2:
+    *w = 8;
+    *h = 16;
+    break;
+  case 4:
+    *w = 14;
+    *h = 26;
+    break;
+  case 6:
+    *w = 24;
+    *h = 48;
+    break;
+  case 7:
+    *w = 32;
+    *h = 48;
+    break;
+  case 8:
+    *w = 55;
+    *h = 75;
+    break;
+  default:
+    *w = 6;
+    *h = 8;
+    break;
+  }
+}
+
+int16_t TFT_eSPI::textWidth(const char *text, uint8_t font) {
+  int32_t w, h;
+  glyphSize(font, &w, &h);
+  return (int16_t)(strlen(text) * w);
+}
+
+int16_t TFT_eSPI::fontHeight(int16_t font) {
+  int32_t w, h;
+  glyphSize((uint8_t)font, &w, &h);
+  return (int16_t)h;
+}
+
+// Un glifo: celda con fondo (si es opaco, en una sola ventana, como
+// TFT_eSPI) y franjas según el código del carácter
+void TFT_eSPI::drawGlyph(char c) {
+  int32_t w, h;
+  glyphSize(_font, &w, &h);
+  int32_t band = max(1, h / 6);
+
+  bool opaque = _bg != _fg;
+  if (opaque) {
+    std::vector<uint16_t> cell(w * h, swap16(_bg));
+    if (c != ' ') {
+      for (int i = 0; i < 5; i++) {
+        if (i == 2 || ((uint8_t)c >> i) & 1) {
+          for (int32_t row = band * (i + 0) + band / 2;
+               row < band * (i + 1) + band / 2 && row < h; row++) {
+            for (int32_t col = 1; col < w - 1; col++) {
+              cell[row * w + col] = swap16(_fg);
+            }
+          }
+        }
+      }
+    }
+    block(_cursorX, _cursorY, w, h, &cell[0], w, true);
+  } else if (c != ' ') {
+    for (int i = 0; i < 5; i++) {
+      if (i == 2 || ((uint8_t)c >> i) & 1) {
+        span(_cursorX + 1, _cursorY + band * i + band / 2, w - 2, band, _fg);
+      }
+    }
+  }
+  _cursorX += w;
+}
+
+size_t TFT_eSPI::write(uint8_t c) {
+  if (c == '\n') {
+    _cursorX = 0;
+    _cursorY += fontHeight();
+    return 1;
+  }
+  countCall();
+  drawGlyph((char)c);
+  return 1;
+}
+
+int16_t TFT_eSPI::drawString(const char *text, int32_t x, int32_t y,
+                             uint8_t font) {
+  uint8_t savedFont = _font;
+  _font = font;
+  int32_t w = textWidth(text);
+  int32_t h = fontHeight();
+
+  // Columna (izq/centro/der) y fila (arriba/medio/abajo) de la referencia
+  x -= (_datum % 3) * w / 2;
+  y -= (_datum / 3) * h / 2;
+  setCursor((int16_t)x, (int16_t)y);
+  print(text);
+
+  _font = savedFont;
+  return (int16_t)w;
+}
+
+// ============================================
+// VIEWPORT, DMA Y COMANDOS
+// ============================================
+
+void TFT_eSPI::setViewport(int32_t x, int32_t y, int32_t w, int32_t h,
+                           bool vpDatum) {
+  _vpX = max(x, (int32_t)0);
+  _vpY = max(y, (int32_t)0);
+  _vpW = min(x + w, (int32_t)_width) - _vpX;
+  _vpH = min(y + h, (int32_t)_height) - _vpY;
+  _vpDatum = vpDatum;
+}
+
+void TFT_eSPI::resetViewport() {
+  _vpX = 0;
+  _vpY = 0;
+  _vpW = _width;
+  _vpH = _height;
+  _vpDatum = false;
+}
+
+bool TFT_eSPI::initDMA(bool ctrlCs) {
+  (void)ctrlCs;
+  return true;
+}
+
+void TFT_eSPI::pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h,
+                            uint16_t *data, uint16_t *buffer) {
+  (void)buffer;
+  countCall();
+  counters.dmaTransfers++;
+  // display.cpp copia desde sprites: los datos ya vienen en orden SPI
+  block(x, y, w, h, data, w, true);
+}
+
+void TFT_eSPI::writecommand(uint8_t command) {
+  _command = command;
+  _dataCount = 0;
+  counters.spiBytes++;
+}
+
+void TFT_eSPI::writedata(uint8_t data) {
+  counters.spiBytes++;
+  if (_dataCount < (int)sizeof(_data)) {
+    _data[_dataCount++] = data;
+  }
+
+  if (_command == CMD_VSCRDEF && _dataCount == 6) {
+    scrollTop = (_data[0] << 8) | _data[1];
+    scrollRows = (_data[2] << 8) | _data[3];
+  } else if (_command == CMD_VSCRSADD && _dataCount == 2) {
+    scrollStart = (_data[0] << 8) | _data[1];
+  }
+}
+
+// ============================================
+// SPRITES
+// ============================================
+
+TFT_eSprite::TFT_eSprite(TFT_eSPI *tft) : TFT_eSPI(0, 0), _tft(tft) {}
+
+void *TFT_eSprite::createSprite(int16_t w, int16_t h, uint8_t frames) {
+  (void)frames;
+  if (failSprites) {
+    return nullptr;
+  }
+  _pixels.assign(w * h, 0);
+  _width = w;
+  _height = h;
+  resetViewport();
+  return &_pixels[0];
+}
+
+void TFT_eSprite::deleteSprite() {
+  _pixels.clear();
+  _width = 0;
+  _height = 0;
+  resetViewport();
+}
+
+void TFT_eSprite::countCall() { counters.spriteCalls++; }
+
+void TFT_eSprite::writeRect(int32_t x, int32_t y, int32_t w, int32_t h,
+                            uint16_t color) {
+  uint16_t stored = swap16(color);
+  for (int32_t row = y; row < y + h; row++) {
+    for (int32_t col = x; col < x + w; col++) {
+      _pixels[row * _width + col] = stored;
+    }
+  }
+  counters.spritePixels += w * h;
+}
+
+void TFT_eSprite::writeBlock(int32_t x, int32_t y, int32_t w, int32_t h,
+                             const uint16_t *src, int32_t stride,
+                             bool swapped) {
+  for (int32_t row = 0; row < h; row++) {
+    for (int32_t col = 0; col < w; col++) {
+      uint16_t color = src[row * stride + col];
+      _pixels[(y + row) * _width + x + col] = swapped ? color : swap16(color);
+    }
+  }
+  counters.spritePixels += w * h;
+}
+
+void TFT_eSprite::fillSprite(uint32_t color) {
+  countCall();
+  uint16_t stored = swap16(color);
+  std::fill(_pixels.begin(), _pixels.end(), stored);
+  counters.spritePixels += _pixels.size();
+}
+
+uint16_t TFT_eSprite::readPixel(int32_t x, int32_t y) {
+  if (x < 0 || y < 0 || x >= _width || y >= _height) {
+    return 0;
+  }
+  return swap16(_pixels[y * _width + x]);
+}
+
+void TFT_eSprite::pushSprite(int32_t x, int32_t y) {
+  pushSprite(x, y, 0, 0, _width, _height);
+}
+
+bool TFT_eSprite::pushSprite(int32_t tx, int32_t ty, int32_t sx, int32_t sy,
+                             int32_t sw, int32_t sh) {
+  if (!created() || sx < 0 || sy < 0 || sx + sw > _width ||
+      sy + sh > _height) {
+    return false;
+  }
+  _tft->countCall();
+  _tft->block(tx, ty, sw, sh, &_pixels[sy * _width + sx], _width, true);
+  return true;
+}
+
+// ============================================
+// CONTADORES Y CAPTURAS
+// ============================================
+
+const TftEmuCounters *tft_emu_counters() { return &counters; }
+
+void tft_emu_reset_counters() { memset(&counters, 0, sizeof(counters)); }
+
+void tft_emu_fail_sprites(bool fail) { failSprites = fail; }
+
+void tft_emu_capture(uint16_t *out) {
+  for (int row = 0; row < TFT_HEIGHT; row++) {
+    int source = row;
+    if (row >= scrollTop && row < scrollTop + scrollRows && scrollRows > 0) {
+      source = scrollTop +
+               (row - scrollTop + scrollStart - scrollTop + scrollRows) %
+                   scrollRows;
+    }
+    memcpy(out + row * TFT_WIDTH, screen + source * TFT_WIDTH,
+           TFT_WIDTH * sizeof(uint16_t));
+  }
+}
+
+static void toRgb(uint16_t color, uint8_t *rgb) {
+  rgb[0] = ((color >> 11) & 0x1F) * 255 / 31;
+  rgb[1] = ((color >> 5) & 0x3F) * 255 / 63;
+  rgb[2] = (color & 0x1F) * 255 / 31;
+}
+
+bool tft_emu_write_ppm(const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+
+  static uint16_t image[TFT_WIDTH * TFT_HEIGHT];
+  tft_emu_capture(image);
+
+  fprintf(file, "P6\n%d %d\n255\n", TFT_WIDTH, TFT_HEIGHT);
+  for (int i = 0; i < TFT_WIDTH * TFT_HEIGHT; i++) {
+    uint8_t rgb[3];
+    toRgb(image[i], rgb);
+    fwrite(rgb, 1, 3, file);
+  }
+  return fclose(file) == 0;
+}
+
+long tft_emu_compare_ppm(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return -1;
+  }
+
+  int w = 0;
+  int h = 0;
+  int maxValue = 0;
+  if (fscanf(file, "P6 %d %d %d", &w, &h, &maxValue) != 3 ||
+      w != TFT_WIDTH || h != TFT_HEIGHT || maxValue != 255) {
+    fclose(file);
+    return -1;
+  }
+  fgetc(file); // Separador antes de los datos
+
+  static uint16_t image[TFT_WIDTH * TFT_HEIGHT];
+  tft_emu_capture(image);
+
+  long different = 0;
+  for (int i = 0; i < TFT_WIDTH * TFT_HEIGHT; i++) {
+    uint8_t expected[3];
+    uint8_t actual[3];
+    if (fread(expected, 1, 3, file) != 3) {
+      fclose(file);
+      return -1;
+    }
+    toRgb(image[i], actual);
+    different += memcmp(expected, actual, 3) != 0;
+  }
+  fclose(file);
+  return different;
+}
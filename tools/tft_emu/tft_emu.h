@@ -0,0 +1,40 @@
+#ifndef TFT_EMU_H
+#define TFT_EMU_H
+
+#include <stdint.h>
+
+// ============================================
+// CONTABILIDAD Y CAPTURAS DEL EMULADOR
+// ============================================
+
+// Costo SPI de abrir una ventana: CASET, RASET y RAMWR con sus datos
+#define TFT_EMU_WINDOW_BYTES 11
+
+struct TftEmuCounters {
+  uint32_t drawCalls;    // Llamadas de dibujo sobre la pantalla
+  uint32_t windows;      // Ventanas abiertas en el ILI9341
+  uint32_t pixels;       // Píxeles escritos en la pantalla
+  uint32_t spiBytes;     // Estimación: ventanas + 2 B por píxel + comandos
+  uint32_t dmaTransfers; // pushImageDMA()
+  uint32_t spriteCalls;  // Llamadas de dibujo sobre sprites (composición)
+  uint32_t spritePixels; // Píxeles escritos en sprites
+};
+
+// Contadores desde el último tft_emu_reset_counters()
+const TftEmuCounters *tft_emu_counters();
+void tft_emu_reset_counters();
+
+// Simular falta de RAM: createSprite() devuelve nullptr
+void tft_emu_fail_sprites(bool fail);
+
+// Imagen visible (con el scroll vertical aplicado), RGB565
+void tft_emu_capture(uint16_t *out);
+
+// Guardar la imagen visible como PPM (P6). Devuelve false si falla.
+bool tft_emu_write_ppm(const char *path);
+
+// Comparar con un PPM guardado. Devuelve los píxeles distintos o -1 si no
+// se pudo leer.
+long tft_emu_compare_ppm(const char *path);
+
+#endif // TFT_EMU_H